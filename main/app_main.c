@@ -2,227 +2,922 @@
 #include "config.h"
 #include "serial_cboard.h"
 #include "simulator.h"
+#include "link_emu.h"
 #include "ui_state.h"
 #include "display_uart.h"
 #include "webserver.h"
+#include "uart_capture.h"
+#include "flight_recorder.h"
+#include "task_topology.h"
+#include "mem_budget.h"
+#include "motion_profile.h"
+#include "time_sync.h"
+#include "udp_ctrl.h"
+#include "rate_gov.h"
+#include "cli.h"
+#include "bench.h"
+#include "boot_prof.h"
+#include "sched.h"
+#include "telem_bus.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/uart.h"
 #include "string.h"
+#include <stdlib.h>
 #include <math.h>
+#include <stdint.h>
 
 static const char *TAG = "app_main";
 
-// 预设任务句柄（单例）
-static TaskHandle_t s_preset_task = NULL;
+// 预设运行上下文：预设逻辑写成按时间推进的步进函数，
+// 实机下由预设任务以真实时间驱动；TEST_MODE 下由模拟器虚拟时钟锁步驱动，
+// 使预设与复位行为可以加速回放并得到可重复的结果。
+// 步进函数只依赖 now_us 与起始时刻 start_us（而非调用次数），
+// 多个机架在同步时间轴上给定同一起始时刻即可运行同相的预设。
+typedef struct {
+	bool started;
+	int64_t start_us; // 预设时间轴的起点
+	int64_t next_us;  // 下一次需要执行的时间
+} preset_ctx_t;
 
-static void stop_preset_task(void)
+#define PRESET1_PERIOD_US (2000 * 1000)
+#define PRESET2_PERIOD_US (4000 * 1000)
+#define PRESET2_UPDATE_US (100 * 1000)
+
+// 预设时间轴 -> motion_tick 时间基准：TEST_MODE 下两者都是模拟器虚拟时钟；
+// 实机下预设运行在同步时间轴上，而运动节拍使用本地 esp_timer
+static int64_t preset_motion_time(int64_t preset_us)
 {
-	if (s_preset_task) {
-		vTaskDelete(s_preset_task);
-		s_preset_task = NULL;
-	}
+#if TEST_MODE
+	return preset_us;
+#else
+	return time_sync_to_local_us(preset_us);
+#endif
 }
 
-// PRESET1: GM6020 角度在 0,90,180,270 之间每 2s 跳变一次；
-// M3508 在 0 <-> 8191 循环，尝试设置速度为 5
-static void preset1_task(void *arg)
+// PRESET1: GM6020 角度在 0,90,180,270 之间每 2s 切换一次；
+// M3508 在 0 <-> 8191 循环。两者经运动规划以 S 曲线同步移动、同时到达，
+// 不再把位置跳变直接交给 C 板
+static int64_t preset1_step(preset_ctx_t *ctx, int64_t now_us)
 {
-	(void)arg;
-	const int degs[4] = {0, 90, 180, 270};
-	int idx = 0;
-	while (ui_state_get_mode() == MODE_PRESET1) {
-		// GM6020 目标角度 -> 转换为 0-8191 范围
-		int deg = degs[idx % 4];
-		int pos1 = (int)roundf((deg / 360.0f) * 8191.0f);
-		send_motor_command(1, 0, (int16_t)pos1, 1); // mode 1 = position
-
-		// M3508: 设定速度为 5（速度模式），并设置交替位置
-		send_motor_command(2, 5, 0, 0); // 尝试设置速度为 5
-		// 交替位置 0 / 8191
-		int pos2 = (idx % 2 == 0) ? 0 : 8191;
-		send_motor_command(2, 0, (int16_t)pos2, 1);
-
-		idx++;
-		vTaskDelay(pdMS_TO_TICKS(2000));
-	}
-	stop_preset_task();
-	vTaskDelete(NULL);
+	static const int degs[4] = {0, 90, 180, 270};
+	if (!ctx->started) {
+		// 中途加入时间轴：等到下一个段边界再开始，不从半段处跳入
+		ctx->started = true;
+		ctx->next_us = ctx->start_us;
+		if (now_us > ctx->start_us) {
+			ctx->next_us += (now_us - ctx->start_us + PRESET1_PERIOD_US - 1) / PRESET1_PERIOD_US * PRESET1_PERIOD_US;
+		}
+	}
+	if (now_us < ctx->next_us) return ctx->next_us;
+
+	// 第几个 2s 段由时间轴决定：迟到的唤醒不会累积相位误差
+	int64_t idx = (now_us - ctx->start_us) / PRESET1_PERIOD_US;
+	int64_t seg_us = ctx->start_us + idx * PRESET1_PERIOD_US;
+	// GM6020 目标角度 -> 转换为 0-8191 范围
+	int deg = degs[idx % 4];
+	int pos1 = (int)roundf((deg / 360.0f) * 8191.0f);
+	// M3508: 交替位置 0 / 8191（速度由运动规划限制）
+	int pos2 = (idx % 2 == 0) ? 0 : 8191;
+	const motion_target_t targets[2] = {
+		{ .motor_id = 1, .position = (int16_t)pos1 },
+		{ .motor_id = 2, .position = (int16_t)pos2 },
+	};
+	motion_move_at(targets, 2, MOTION_PROFILE_SCURVE, preset_motion_time(seg_us), NULL);
+
+	ctx->next_us = seg_us + PRESET1_PERIOD_US;
+	return ctx->next_us;
 }
 
 // PRESET2: GM6020 速度设为 10；M3508 做正弦波运动（周期 4s），每 100ms 更新一次
-static void preset2_task(void *arg)
+static int64_t preset2_step(preset_ctx_t *ctx, int64_t now_us)
 {
-	(void)arg;
-	const float period_ms = 4000.0f; // 4 秒周期
-	const TickType_t delay_ticks = pdMS_TO_TICKS(100);
-	// 设置 GM6020 速度为 10
-	send_motor_command(1, 10, 0, 0);
-	int64_t start = esp_timer_get_time(); // us
-	while (ui_state_get_mode() == MODE_PRESET2) {
-		int64_t now = esp_timer_get_time();
-		float t = (now - start) / 1000.0f; // ms
-		float phase = fmodf(t, period_ms) / period_ms; // 0..1
-		float s = sinf(2.0f * M_PI * phase);
-		float norm = (s * 0.5f) + 0.5f; // 0..1
-		int pos = (int)roundf(norm * 8191.0f);
-		send_motor_command(2, 0, (int16_t)pos, 1);
-		vTaskDelay(delay_ticks);
-	}
-	stop_preset_task();
-	vTaskDelete(NULL);
+	if (!ctx->started) {
+		ctx->started = true;
+		ctx->next_us = ctx->start_us;
+		// 设置 GM6020 速度为 10
+		send_motor_command(1, 10, 0, 0);
+	}
+	if (now_us < ctx->next_us) return ctx->next_us;
+
+	// 相位取自时间轴，各机架同一时刻得到同一设定点
+	int64_t el = now_us - ctx->start_us;
+	float phase = (float)(el % PRESET2_PERIOD_US) / PRESET2_PERIOD_US; // 0..1
+	float s = sinf(2.0f * M_PI * phase);
+	float norm = (s * 0.5f) + 0.5f; // 0..1
+	int pos = (int)roundf(norm * 8191.0f);
+	send_motor_command(2, 0, (int16_t)pos, 1);
+
+	ctx->next_us = ctx->start_us + (el / PRESET2_UPDATE_US + 1) * PRESET2_UPDATE_US;
+	return ctx->next_us;
+}
+
+// 按模式分发到对应的步进函数；非预设模式返回 INT64_MAX
+static int64_t preset_step(control_mode_t mode, preset_ctx_t *ctx, int64_t now_us)
+{
+	switch (mode) {
+	case MODE_PRESET1: return preset1_step(ctx, now_us);
+	case MODE_PRESET2: return preset2_step(ctx, now_us);
+	default: return INT64_MAX;
+	}
+}
+
+#if TEST_MODE
+// TEST_MODE：预设由模拟器步进钩子在虚拟时钟下驱动
+static volatile control_mode_t s_sim_preset_mode = MODE_MANUAL;
+static volatile bool s_sim_preset_restart = false;
+static preset_ctx_t s_sim_preset_ctx;
+
+static void preset_sim_hook(uint64_t now_us)
+{
+	if (s_sim_preset_restart) {
+		s_sim_preset_restart = false;
+		memset(&s_sim_preset_ctx, 0, sizeof(s_sim_preset_ctx));
+		s_sim_preset_ctx.start_us = (int64_t)now_us;
+	}
+	preset_step(s_sim_preset_mode, &s_sim_preset_ctx, (int64_t)now_us);
+	if (motion_busy()) motion_tick((int64_t)now_us);
+}
+#else
+// 预设时间轴起点（同步时间）。默认 0：所有机架共享同一个绝对网格，
+// 各自切换到同一预设后自动同相；收到 START 命令时为命令给出的 epoch
+static int64_t s_preset_origin = 0;
+static volatile int64_t s_pending_epoch = -1;
+
+// 实机：预设作为调度器 CTRL 执行任务上的作业，在同步时间轴上驱动步进函数，
+// 每次返回下一步的截止时刻（换算为本地时间）。esp_timer 按微秒对准截止时刻，
+// 不再需要睡到节拍边界再忙等。两份上下文交替使用：被注销的作业可能还在执行本次步进
+typedef struct {
+	control_mode_t mode;
+	preset_ctx_t ctx;
+} preset_run_t;
+
+static preset_run_t s_preset_runs[2];
+static int s_preset_run_idx;
+static int s_preset_job = -1;
+
+static int64_t preset_job(void *arg, int64_t deadline_us)
+{
+	(void)deadline_us;
+	preset_run_t *run = arg;
+	if (ui_state_get_mode() != run->mode) return SCHED_STOP;
+	int64_t next = preset_step(run->mode, &run->ctx, time_sync_now_us());
+	if (next == INT64_MAX) return SCHED_STOP;
+	return time_sync_to_local_us(next);
+}
+
+static void stop_preset_job(void)
+{
+	if (s_preset_job >= 0) {
+		sched_cancel(s_preset_job);
+		s_preset_job = -1;
+	}
+}
+#endif
+
+// 在同步时间 epoch_us 时刻启动预设（来自 CLI 或主机的 START 命令）
+static void preset_start_at(uint8_t mode, int64_t epoch_us)
+{
+	if (mode > MODE_PRESET2) return;
+#if TEST_MODE
+	(void)epoch_us; // 模拟器虚拟时钟不参与同步，立即开始
+#else
+	s_pending_epoch = epoch_us;
+#endif
+	ui_state_set_mode((control_mode_t)mode);
+}
+
+// 急停命令发出后（急停任务中）：停止所有设定点来源，解除后保持手动模式、不恢复运动
+static void estop_cb(estop_source_t src)
+{
+	(void)src;
+	motion_stop();
+	if (ui_state_get_mode() != MODE_MANUAL) ui_state_set_mode(MODE_MANUAL);
 }
 
 static void mode_change_cb(control_mode_t new_mode)
 {
 	const char *names[] = {"MANUAL", "PRESET1", "PRESET2"};
 	printf("[MODE_CB] new mode = %s\n", names[new_mode]);
+	// 模式切换时放弃未完成的移动（C 板保持最后的设定点）
+	motion_stop();
+
+#if TEST_MODE
+	// 由模拟器钩子在下一步重新开始对应预设
+	s_sim_preset_mode = new_mode;
+	s_sim_preset_restart = true;
+#else
+	// 预设时间轴起点：待执行的 START 命令给出的 epoch，否则为同步时间 0
+	int64_t epoch = s_pending_epoch;
+	s_pending_epoch = -1;
+	s_preset_origin = epoch >= 0 ? epoch : 0;
+	// 切换作业：注销已有预设，新预设立即开始第一步
+	stop_preset_job();
+	if (new_mode == MODE_PRESET1 || new_mode == MODE_PRESET2) {
+		s_preset_run_idx ^= 1;
+		preset_run_t *run = &s_preset_runs[s_preset_run_idx];
+		*run = (preset_run_t){ .mode = new_mode, .ctx = { .start_us = s_preset_origin } };
+		s_preset_job = sched_add(new_mode == MODE_PRESET1 ? "preset1" : "preset2", SCHED_EXEC_CTRL, 0,
+								 esp_timer_get_time(), preset_job, run);
+	} else {
+		// 切回手动：不做任何自动命令（用户可通过 UI 控制）
+	}
+#endif
+}
 
-	// 切换任务
-	if (s_preset_task) {
-		// 先停止已有预设任务
-		stop_preset_task();
-		// 让短暂时间让任务清理
-		vTaskDelay(pdMS_TO_TICKS(10));
+#if TEST_MODE
+// CLI：模拟器控制命令
+// sim status | sim speed <n> | sim run <ms> | sim reset | sim motor <id>
+static void cli_handle_sim(const char *buf)
+{
+	char sub[16];
+	unsigned value = 0;
+	int n = sscanf(buf, "sim %15s %u", sub, &value);
+	if (n >= 1 && strcmp(sub, "speed") == 0 && n == 2) {
+		simulator_set_speed(value);
+		printf("Simulator speed: %u%s\n", value, value == 0 ? " (max)" : "x");
+	} else if (n >= 1 && strcmp(sub, "run") == 0 && n == 2) {
+		int64_t t0 = esp_timer_get_time();
+		bool ok = simulator_run_for(value, value + 10000);
+		int64_t wall_ms = (esp_timer_get_time() - t0) / 1000;
+		sim_stats_t st;
+		simulator_get_stats(&st);
+		printf("Simulated %u ms in %lld ms wall%s: t=%llu us steps=%llu trace=%08lx\n",
+			   value, (long long)wall_ms, ok ? "" : " (timeout)",
+			   (unsigned long long)st.time_us, (unsigned long long)st.steps, (unsigned long)st.trace_hash);
+	} else if (n >= 1 && strcmp(sub, "reset") == 0) {
+		ui_state_set_mode(MODE_MANUAL);
+		serial_cboard_reset_homing();
+		simulator_reset();
+		printf("Simulator reset\n");
+	} else if (n >= 1 && strcmp(sub, "status") == 0) {
+		sim_stats_t st;
+		simulator_get_stats(&st);
+		printf("sim: t=%llu us steps=%llu speed=%u trace=%08lx overruns=%lu\n",
+			   (unsigned long long)st.time_us, (unsigned long long)st.steps, (unsigned)st.speed,
+			   (unsigned long)st.trace_hash, (unsigned long)st.overruns);
+		printf("sim: plant %lu motors @ %lu Hz, cycles/step=%lu max=%lu\n", (unsigned long)st.motors,
+			   (unsigned long)st.plant_hz, (unsigned long)st.plant_cycles_avg, (unsigned long)st.plant_cycles_max);
+	} else if (n == 2 && strcmp(sub, "motor") == 0) {
+		sim_motor_fb_t fb;
+		if (!simulator_get_motor((uint8_t)value, &fb)) {
+			printf("motor %u is not simulated\n", value);
+			return;
+		}
+		printf("motor %u: angle=%u speed=%d rpm (ref %d) current=%ld mA (cmd %ld) temp=%u C%s\n", value, fb.angle,
+			   fb.speed, fb.speed_ref, (long)fb.current_ma, (long)fb.current_cmd_ma, fb.temp,
+			   fb.at_stop ? " at stop" : "");
+	} else {
+		printf("Usage: sim status | sim speed <n, 0=max> | sim run <ms> | sim reset | sim motor <id>\n");
 	}
+}
+#endif
 
-	if (new_mode == MODE_PRESET1) {
-		xTaskCreate(preset1_task, "preset1", 4096, NULL, 5, &s_preset_task);
-	} else if (new_mode == MODE_PRESET2) {
-		xTaskCreate(preset2_task, "preset2", 4096, NULL, 5, &s_preset_task);
+#if TEST_MODE
+// CLI：C 板链路字节级仿真
+// link on|off | link stats | link reset | link <baud|ber|drop|garbage|gmax|split|burst|seed> <value>
+static void cli_handle_link(const char *buf)
+{
+	char sub[16];
+	unsigned value = 0;
+	int n = sscanf(buf, "link %15s %u", sub, &value);
+	link_emu_config_t cfg;
+	link_emu_get_config(&cfg);
+	if (n < 1) {
+		printf("Usage: link on|off|stats|reset | link <baud|ber|drop|garbage|gmax|split|burst|seed> <value>\n");
+	} else if (strcmp(sub, "on") == 0 || strcmp(sub, "off") == 0) {
+		link_emu_set_enabled(strcmp(sub, "on") == 0);
+		printf("Link emulation %s\n", sub);
+	} else if (strcmp(sub, "reset") == 0) {
+		link_emu_reset_stats();
+		serial_cboard_reset_rx_stats();
+		printf("Link stats reset\n");
+	} else if (strcmp(sub, "stats") == 0) {
+		link_emu_stats_t ls;
+		serial_rx_stats_t rs;
+		link_emu_get_stats(&ls);
+		serial_cboard_get_rx_stats(&rs);
+		uint32_t lost = ls.frames_in > rs.frames_ok ? ls.frames_in - rs.frames_ok : 0;
+		printf("link: baud=%lu ber=%luppm drop=%luppm garbage=%luppm/%u split=%u burst=%u seed=%lu\n",
+			   (unsigned long)cfg.baud, (unsigned long)cfg.bit_error_ppm, (unsigned long)cfg.drop_ppm,
+			   (unsigned long)cfg.garbage_ppm, cfg.garbage_max, cfg.split_max, cfg.burst, (unsigned long)cfg.seed);
+		printf("tx: frames=%lu impaired=%lu bytes=%lu flipped=%lu dropped=%lu garbage=%lu overflow=%lu oversize=%lu delivered=%lu\n",
+			   (unsigned long)ls.frames_in, (unsigned long)ls.frames_impaired, (unsigned long)ls.bytes_in,
+			   (unsigned long)ls.bits_flipped, (unsigned long)ls.bytes_dropped, (unsigned long)ls.garbage_bytes,
+			   (unsigned long)ls.overflow_bytes, (unsigned long)ls.frames_oversize, (unsigned long)ls.bytes_out);
+		printf("rx: bytes=%lu frames_ok=%lu cksum_err=%lu discarded=%lu loss=%lu.%02lu%%\n",
+			   (unsigned long)rs.bytes_in, (unsigned long)rs.frames_ok, (unsigned long)rs.cksum_errors,
+			   (unsigned long)rs.bytes_discarded,
+			   (unsigned long)(ls.frames_in ? lost * 100 / ls.frames_in : 0),
+			   (unsigned long)(ls.frames_in ? (lost * 10000 / ls.frames_in) % 100 : 0));
+		printf("rx: cycles/byte=%lu recoveries=%lu recovery_avg=%lu us recovery_max=%lu us msgs_unknown=%lu msgs_bad_len=%lu frames_bad_len=%lu\n",
+			   (unsigned long)(rs.bytes_in ? rs.parse_cycles / rs.bytes_in : 0), (unsigned long)rs.recoveries,
+			   (unsigned long)(rs.recoveries ? rs.recovery_us_total / rs.recoveries : 0),
+			   (unsigned long)rs.recovery_us_max, (unsigned long)rs.msgs_unknown, (unsigned long)rs.msgs_bad_len,
+			   (unsigned long)rs.frames_bad_len);
+		if (rs.telem_batches || rs.telem_sync_drops) {
+			// 每电机样本的平均线路字节数（8 字节状态 + 帧头分摊为对照）
+			uint32_t bps100 = rs.telem_samples ? (uint32_t)((uint64_t)rs.telem_bytes * 100 / rs.telem_samples) : 0;
+			printf("rx: telem batches=%lu samples=%lu bytes/sample=%lu.%02lu sync_drops=%lu\n",
+				   (unsigned long)rs.telem_batches, (unsigned long)rs.telem_samples, (unsigned long)(bps100 / 100),
+				   (unsigned long)(bps100 % 100), (unsigned long)rs.telem_sync_drops);
+		}
+	} else if (n == 2) {
+		if (strcmp(sub, "baud") == 0) cfg.baud = value;
+		else if (strcmp(sub, "ber") == 0) cfg.bit_error_ppm = value;
+		else if (strcmp(sub, "drop") == 0) cfg.drop_ppm = value;
+		else if (strcmp(sub, "garbage") == 0) cfg.garbage_ppm = value;
+		else if (strcmp(sub, "gmax") == 0) cfg.garbage_max = (uint16_t)value;
+		else if (strcmp(sub, "split") == 0) cfg.split_max = (uint16_t)value;
+		else if (strcmp(sub, "burst") == 0) cfg.burst = (uint16_t)value;
+		else if (strcmp(sub, "seed") == 0) cfg.seed = value;
+		else {
+			printf("Unknown link param: %s\n", sub);
+			return;
+		}
+		link_emu_set_config(&cfg);
+		printf("link %s = %u\n", sub, value);
 	} else {
-		// 切回手动：不做任何自动命令（用户可通过 UI 控制）
+		printf("Invalid link command\n");
 	}
 }
+#endif
 
-// CLI 任务：读取 UART0 输入并解析命令
-static void cli_task(void *arg)
-{
-	char buf[128];
-	int idx = 0;
-	while (1) {
-		char c;
-		int len = uart_read_bytes(UART_NUM_0, (uint8_t*)&c, 1, pdMS_TO_TICKS(100));
-		if (len > 0) {
-			if (c == '\n' || c == '\r') {
-				buf[idx] = '\0';
-				if (idx > 0) {
-					// 解析命令
-					if (strncmp(buf, "set motor", 9) == 0) {
-						char motor[10];
-						char param[10];
-						int value;
-						if (sscanf(buf, "set %s %s %d", motor, param, &value) == 3) {
-							uint8_t id = (strcmp(motor, "motor1") == 0) ? 1 : (strcmp(motor, "motor2") == 0) ? 2 : 0;
-							if (id == 0) {
-								printf("Invalid motor: %s\n", motor);
-							} else {
-								if (strcmp(param, "speed") == 0) {
-									send_motor_command(id, (int16_t)value, 0, 0); // mode 0 for speed
-									printf("Set motor%u speed to %d\n", id, value);
-								} else if (strcmp(param, "pos") == 0) {
-									send_motor_command(id, 0, (int16_t)value, 1); // mode 1 for position
-									printf("Set motor%u pos to %d\n", id, value);
-								} else {
-									printf("Invalid param: %s\n", param);
-								}
-							}
-						} else {
-							printf("Invalid command format\n");
-						}
-					} else {
-						// 支持测试模式下的按键模拟："press up" / "press down" / "press ok"
-						if (strncmp(buf, "press ", 6) == 0) {
-							char which[16];
-							if (sscanf(buf, "press %15s", which) == 1) {
-								if (strcmp(which, "up") == 0) {
-									ui_state_button_event_up();
-									printf("Simulated button: UP\n");
-								} else if (strcmp(which, "down") == 0) {
-									ui_state_button_event_down();
-									printf("Simulated button: DOWN\n");
-								} else if (strcmp(which, "ok") == 0) {
-									ui_state_button_event_ok();
-									printf("Simulated button: OK\n");
-								} else {
-									printf("Unknown press target: %s\n", which);
-								}
-							} else {
-								printf("Invalid press command\n");
-							}
-						} else {
-							printf("Unknown command: %s\n", buf);
-						}
-					}
-				}
-				idx = 0;
-			} else if (idx < sizeof(buf) - 1) {
-				buf[idx++] = c;
-			}
+// CLI：C 板串口抓包与回放
+// capture start|stop|status | capture replay <speed, 0=max> | capture replay stop
+static void cli_handle_capture(const char *buf)
+{
+	char sub[16], arg[16] = "";
+	int n = sscanf(buf, "capture %15s %15s", sub, arg);
+	esp_err_t err = ESP_OK;
+	if (n < 1) {
+		printf("Usage: capture start|stop|status | capture replay <speed, 0=max>|stop\n");
+		return;
+	} else if (strcmp(sub, "start") == 0) {
+		err = uart_capture_start();
+	} else if (strcmp(sub, "stop") == 0) {
+		err = uart_capture_stop();
+	} else if (strcmp(sub, "replay") == 0) {
+		if (n == 2 && strcmp(arg, "stop") == 0) {
+			uart_capture_replay_stop();
+		} else {
+			err = uart_capture_replay_start(n == 2 ? (uint32_t)atoi(arg) : 1);
 		}
+	} else if (strcmp(sub, "status") != 0) {
+		printf("Unknown capture command: %s\n", sub);
+		return;
+	}
+	if (err != ESP_OK) {
+		printf("capture %s failed: %s\n", sub, esp_err_to_name(err));
+		return;
+	}
+	uart_capture_status_t st;
+	uart_capture_get_status(&st);
+	printf("capture: available=%d recording=%d replaying=%d length=%lu/%lu records=%lu dropped=%lu replayed=%lu speed=%lu\n",
+		   st.available, st.recording, st.replaying, (unsigned long)st.length, (unsigned long)st.capacity,
+		   (unsigned long)st.records, (unsigned long)st.dropped, (unsigned long)st.replay_records,
+		   (unsigned long)st.replay_speed);
+}
+
+// CLI：飞行记录仪
+// rec status | rec flush
+static void cli_handle_recorder(const char *buf)
+{
+	char sub[16] = "status";
+	sscanf(buf, "rec %15s", sub);
+	if (strcmp(sub, "flush") == 0) {
+		recorder_flush();
+		printf("Recorder flush requested\n");
+		return;
+	} else if (strcmp(sub, "status") != 0) {
+		printf("Usage: rec status|flush\n");
+		return;
+	}
+	recorder_stats_t st;
+	recorder_get_stats(&st);
+	printf("rec: mounted=%d session=%08lx samples=%lu commands=%lu dropped=%lu blocks=%lu\n",
+		   st.mounted, (unsigned long)st.session, (unsigned long)st.samples, (unsigned long)st.commands,
+		   (unsigned long)st.dropped, (unsigned long)st.blocks);
+	printf("rec: written=%lu raw=%lu ratio=%lu%% fs=%u/%u segments_deleted=%lu\n",
+		   (unsigned long)st.bytes_written, (unsigned long)st.raw_bytes,
+		   (unsigned long)(st.raw_bytes ? (uint64_t)st.bytes_written * 100 / st.raw_bytes : 0),
+		   (unsigned)st.fs_used, (unsigned)st.fs_total, (unsigned long)st.segments_deleted);
+}
+
+// CLI：运动规划
+// motion status | motion stop | motion move [trap|s] <id> <pos> [<id> <pos> ...]
+static void cli_handle_motion(const char *buf)
+{
+	char line[128];
+	strlcpy(line, buf, sizeof(line));
+	char *save = NULL;
+	strtok_r(line, " ", &save); // "motion"
+	const char *sub = strtok_r(NULL, " ", &save);
+	if (sub && strcmp(sub, "stop") == 0) {
+		motion_stop();
+		printf("Motion stopped\n");
+		return;
+	} else if (sub && strcmp(sub, "move") == 0) {
+		motion_profile_t type = MOTION_PROFILE_SCURVE;
+		motion_target_t targets[MOTION_MAX_AXES];
+		size_t n = 0;
+		char *tok = strtok_r(NULL, " ", &save);
+		if (tok && (strcmp(tok, "trap") == 0 || strcmp(tok, "s") == 0)) {
+			type = (tok[0] == 't') ? MOTION_PROFILE_TRAPEZOID : MOTION_PROFILE_SCURVE;
+			tok = strtok_r(NULL, " ", &save);
+		}
+		while (tok && n < MOTION_MAX_AXES) {
+			char *pos = strtok_r(NULL, " ", &save);
+			if (!pos) break;
+			targets[n].motor_id = (uint8_t)atoi(tok);
+			targets[n].position = (int16_t)atoi(pos);
+			n++;
+			tok = strtok_r(NULL, " ", &save);
+		}
+		uint32_t ms = 0;
+		esp_err_t err = n ? motion_move(targets, n, type, &ms) : ESP_ERR_INVALID_ARG;
+		if (err != ESP_OK) {
+			printf("Usage: motion move [trap|s] <id> <pos> [<id> <pos> ...] (%s)\n", esp_err_to_name(err));
+		} else {
+			printf("Motion: %u axes, %lu ms\n", (unsigned)n, (unsigned long)ms);
+		}
+		return;
+	} else if (sub && strcmp(sub, "status") != 0) {
+		printf("Usage: motion status|stop|move\n");
+		return;
+	}
+	motion_stats_t st;
+	motion_get_stats(&st);
+	printf("motion: rate=%luHz busy=%d active=%lu moves=%lu ticks=%lu frames=%lu last_move=%lums kernel=%lu/%lu cycles\n",
+		   (unsigned long)st.rate_hz, motion_busy(), (unsigned long)st.active_axes, (unsigned long)st.moves,
+		   (unsigned long)st.ticks, (unsigned long)st.frames, (unsigned long)st.last_move_ms,
+		   (unsigned long)st.kernel_cycles_last, (unsigned long)st.kernel_cycles_max);
+}
+
+// CLI：多机架时间同步
+// sync status | sync master | sync slave <ip> | sync off | sync start <mode 1|2> [lead_ms]
+static void cli_handle_sync(const char *buf)
+{
+	char sub[16] = "status", arg[24] = "";
+	unsigned lead_ms = PRESET_START_LEAD_MS;
+	int n = sscanf(buf, "sync %15s %23s %u", sub, arg, &lead_ms);
+	if (strcmp(sub, "master") == 0 || strcmp(sub, "off") == 0) {
+		if (time_sync_start(sub[0] == 'm' ? TIME_SYNC_MASTER : TIME_SYNC_OFF, NULL) != 0) {
+			printf("sync %s failed\n", sub);
+			return;
+		}
+	} else if (strcmp(sub, "slave") == 0) {
+		if (n < 2 || time_sync_start(TIME_SYNC_SLAVE, arg) != 0) {
+			printf("Usage: sync slave <master ip>\n");
+			return;
+		}
+	} else if (strcmp(sub, "start") == 0) {
+		int mode = atoi(arg);
+		if (n < 2 || mode < MODE_PRESET1 || mode > MODE_PRESET2) {
+			printf("Usage: sync start <1|2> [lead_ms]\n");
+			return;
+		}
+		// 主机：先下发给从机再本地执行，所有机架在同一同步时刻开始
+		int64_t epoch = time_sync_now_us() + (int64_t)lead_ms * 1000;
+		int peers = time_sync_broadcast_start((uint8_t)mode, epoch);
+		preset_start_at((uint8_t)mode, epoch);
+		printf("Preset %d starts in %u ms on this rack and %d peer(s)\n", mode, lead_ms, peers);
+		return;
+	} else if (strcmp(sub, "status") != 0) {
+		printf("Usage: sync status|master|off|slave <ip>|start <mode> [lead_ms]\n");
+		return;
+	}
+	time_sync_status_t st;
+	time_sync_get_status(&st);
+	const char *roles[] = {"off", "master", "slave"};
+	printf("sync: role=%s locked=%d offset=%lld us drift=%ld ppb delay=%lu/%lu us samples=%lu rejected=%lu resets=%lu peers=%lu age=%lld ms\n",
+		   roles[st.role], st.locked, (long long)st.offset_us, (long)st.drift_ppb, (unsigned long)st.delay_us,
+		   (unsigned long)st.delay_min_us, (unsigned long)st.samples, (unsigned long)st.rejected,
+		   (unsigned long)st.resets, (unsigned long)st.peers, (long long)st.last_sample_age_ms);
+}
+
+// CLI：上位机 UDP 通道统计与客户端
+static void cli_handle_udp(const char *buf)
+{
+	(void)buf;
+	udp_ctrl_stats_t st;
+	udp_ctrl_get_stats(&st);
+	printf("udp: port=%d clients=%lu subscribers=%lu rx=%lu bad=%lu cmds=%lu lost=%lu stale=%lu tx=%lu tx_err=%lu timeouts=%lu failsafes=%lu\n",
+		   UDP_CTRL_PORT, (unsigned long)st.clients, (unsigned long)st.subscribers, (unsigned long)st.rx_packets,
+		   (unsigned long)st.rx_bad, (unsigned long)st.cmds, (unsigned long)st.cmd_lost, (unsigned long)st.cmd_stale,
+		   (unsigned long)st.tx_frames, (unsigned long)st.tx_errors, (unsigned long)st.timeouts,
+		   (unsigned long)st.failsafes);
+	for (int i = 0; i < UDP_CTRL_MAX_CLIENTS; ++i) {
+		udp_ctrl_client_info_t c;
+		if (!udp_ctrl_get_client(i, &c)) continue;
+		const uint8_t *ip = (const uint8_t *)&c.ip;
+		printf("  client %u.%u.%u.%u:%u sub=%d decim=%u idle=%lums cmds=%lu lost=%lu telem_seq=%lu\n",
+			   ip[0], ip[1], ip[2], ip[3], c.port, c.subscribed, c.decim, (unsigned long)c.idle_ms,
+			   (unsigned long)c.cmds, (unsigned long)c.cmd_lost, (unsigned long)c.tx_seq);
 	}
-	vTaskDelete(NULL);
 }
 
-	// 周期性刷新显示任务（移至文件作用域，避免在函数内定义）
-	static void display_task(void *arg)
-	{
-		(void)arg;
-		while (1) {
-			const motor_status_t *m1 = get_motor_status(1);
-			const motor_status_t *m2 = get_motor_status(2);
-			control_mode_t cm = ui_state_get_mode();
-			display_update(m1, m2, cm);
-			vTaskDelay(pdMS_TO_TICKS(1000));
+// CLI：急停
+// estop | estop release | estop status | estop reset
+static void cli_handle_estop(const char *buf)
+{
+	char sub[12] = "";
+	sscanf(buf, "estop %11s", sub);
+	if (sub[0] == '\0') {
+		serial_cboard_estop(ESTOP_SRC_CLI);
+		printf("estop: triggered\n");
+		return;
+	}
+	if (strcmp(sub, "release") == 0) {
+		if (ui_state_estop_held()) {
+			printf("estop: button still pressed, not released\n");
+			return;
 		}
-		vTaskDelete(NULL);
+		serial_cboard_estop_release();
+	} else if (strcmp(sub, "reset") == 0) {
+		serial_cboard_reset_estop_stats();
+	} else if (strcmp(sub, "status") != 0) {
+		printf("usage: estop [release|status|reset]\n");
+		return;
 	}
+	serial_estop_stats_t st;
+	serial_cboard_get_estop_stats(&st);
+	printf("estop: latched=%d triggers=%lu sent=%lu dropped_cmds=%lu last_src=%s latency last=%luus avg=%luus max=%luus\n",
+		   st.latched, (unsigned long)st.triggers, (unsigned long)st.sent, (unsigned long)st.dropped_cmds,
+		   serial_cboard_estop_source_name(st.last_source), (unsigned long)st.last_us,
+		   (unsigned long)(st.sent ? st.total_us / st.sent : 0), (unsigned long)st.max_us);
+}
+
+// CLI：速率调节器
+// rates | rates <name> <ms|auto>
+static void cli_handle_rates(const char *buf)
+{
+	char name[16], val[12];
+	if (sscanf(buf, "rates %15s %11s", name, val) == 2) {
+		uint32_t ms = strcmp(val, "auto") == 0 ? 0 : (uint32_t)atoi(val);
+		if (!rate_gov_override(name, ms)) {
+			printf("Unknown consumer: %s\n", name);
+			return;
+		}
+	}
+	rate_gov_signals_t sig;
+	rate_gov_get_signals(&sig);
+	printf("rates: viewers=%lu udp_subs=%lu active=%d idle=%u%%/%u%% throttle=%lu%%\n",
+		   (unsigned long)sig.web_viewers, (unsigned long)sig.udp_subscribers, sig.active,
+		   sig.idle_pct[0], sig.idle_pct[1], (unsigned long)sig.throttle_pct);
+	for (int i = 0; i < RATE_GOV_COUNT; ++i) {
+		rate_gov_entry_t e;
+		rate_gov_get((rate_gov_id_t)i, &e);
+		printf("  %-12s current=%lums target=%lums range=%lu..%lums%s\n", e.name, (unsigned long)e.current_ms,
+			   (unsigned long)e.target_ms, (unsigned long)e.min_ms, (unsigned long)e.max_ms,
+			   e.override_ms ? " (override)" : "");
+	}
+}
+
+// CLI：C 板链路与板状态（全局电机 id = 板号 * CBOARD_MOTORS_PER_BOARD + 本地 id）
+static void cli_handle_boards(const char *buf)
+{
+	(void)buf;
+	for (int b = 0; b < serial_cboard_board_count(); ++b) {
+		cboard_board_stats_t st;
+		if (!serial_cboard_get_board_stats((uint8_t)b, &st)) continue;
+		const cboard_link_cfg_t *cfg = serial_cboard_link_cfg(st.channel);
+		printf("board %d: link=%s addr=%u ids=%u..%u online=%d polls=%lu replies=%lu timeouts=%lu rtt=%lu/%lu us\n",
+			   b, cfg ? cfg->name : "?", st.address, serial_cboard_global_id((uint8_t)b, 1),
+			   serial_cboard_global_id((uint8_t)b, CBOARD_MOTORS_PER_BOARD - 1), st.online,
+			   (unsigned long)st.polls, (unsigned long)st.replies, (unsigned long)st.timeouts,
+			   (unsigned long)st.rtt_us_last, (unsigned long)st.rtt_us_max);
+		if (st.voltage_mv || st.errors || st.acks || st.param_reads) {
+			printf("  power=%u mV %d mA errors=%lu last=0x%02x motor=%u detail=0x%04x acks=%lu seq=%u/%u params=%lu last=%u:%ld\n",
+				   st.voltage_mv, st.current_ma, (unsigned long)st.errors, st.last_error, st.last_error_motor,
+				   st.last_error_detail, (unsigned long)st.acks, st.last_ack_seq, st.last_ack_status,
+				   (unsigned long)st.param_reads, st.last_param_id, (long)st.last_param_value);
+		}
+	}
+}
+
+static void print_bench(const bench_result_t *r)
+{
+	printf("bench %-8s iters=%lu cycles/op=%lu (min %lu max %lu) us/op=%lu.%02lu bytes=%lu heap_delta=%ld stack=%lu/%lu\n",
+		   r->name, (unsigned long)r->iters, (unsigned long)r->cycles_avg, (unsigned long)r->cycles_min,
+		   (unsigned long)r->cycles_max, (unsigned long)(r->us_total / r->iters),
+		   (unsigned long)(r->us_total * 100ull / r->iters % 100), (unsigned long)r->bytes_per_op,
+		   (long)r->heap_delta, (unsigned long)r->stack_used, (unsigned long)r->stack_size);
+}
+
+// CLI：设备自测基准
+// bench <parser|tx|json|display|all> [iters]
+static void cli_handle_bench(const char *buf)
+{
+	char name[16] = "";
+	unsigned iters = 0;
+	if (sscanf(buf, "bench %15s %u", name, &iters) < 1) {
+		printf("Usage: bench <parser|tx|json|display|all> [iters]\n");
+		return;
+	}
+	for (int i = 0; ; ++i) {
+		const char *n = strcmp(name, "all") == 0 ? bench_name(i) : (i == 0 ? name : NULL);
+		if (!n) break;
+		bench_result_t r;
+		esp_err_t err = bench_run(n, iters, &r);
+		if (err != ESP_OK) {
+			printf("bench %s: %s\n", n, esp_err_to_name(err));
+			return;
+		}
+		print_bench(&r);
+	}
+}
+
+// CLI：C 板链路质量（被动统计）
+// linktest [ms]
+static void cli_handle_linktest(const char *buf)
+{
+	unsigned ms = 1000;
+	sscanf(buf, "linktest %u", &ms);
+	linktest_result_t r;
+	esp_err_t err = linktest_run(ms, &r);
+	if (err != ESP_OK) {
+		printf("linktest: %s\n", esp_err_to_name(err));
+		return;
+	}
+	printf("linktest %lu ms: bytes=%lu frames=%lu cksum_err=%lu discarded=%lu\n",
+		   (unsigned long)r.ms, (unsigned long)r.bytes_in, (unsigned long)r.frames_ok,
+		   (unsigned long)r.cksum_errors, (unsigned long)r.bytes_discarded);
+	printf("linktest: goodput=%lu B/s of %lu B/s (%lu.%lu%%) frame_err=%lu ppm byte_err=%lu ppm polls=%lu replies=%lu timeouts=%lu\n",
+		   (unsigned long)r.goodput_Bps, (unsigned long)r.line_Bps, (unsigned long)(r.util_permille / 10),
+		   (unsigned long)(r.util_permille % 10), (unsigned long)r.frame_err_ppm, (unsigned long)r.byte_err_ppm,
+		   (unsigned long)r.polls, (unsigned long)r.replies, (unsigned long)r.timeouts);
+}
+
+// CLI：set motor1|motor2 speed|pos <value>
+static void cli_handle_set(const char *buf)
+{
+	char motor[10];
+	char param[10];
+	int value;
+	if (sscanf(buf, "set %9s %9s %d", motor, param, &value) != 3) {
+		printf("Invalid command format\n");
+		return;
+	}
+	uint8_t id = (strcmp(motor, "motor1") == 0) ? 1 : (strcmp(motor, "motor2") == 0) ? 2 : 0;
+	if (id == 0) {
+		printf("Invalid motor: %s\n", motor);
+	} else if (strcmp(param, "speed") == 0) {
+		send_motor_command(id, (int16_t)value, 0, 0); // mode 0 for speed
+		printf("Set motor%u speed to %d\n", id, value);
+	} else if (strcmp(param, "pos") == 0) {
+		send_motor_command(id, 0, (int16_t)value, 1); // mode 1 for position
+		printf("Set motor%u pos to %d\n", id, value);
+	} else {
+		printf("Invalid param: %s\n", param);
+	}
+}
+
+// CLI：按键模拟 press up|down|ok
+static void cli_handle_press(const char *buf)
+{
+	char which[16];
+	if (sscanf(buf, "press %15s", which) != 1) {
+		printf("Invalid press command\n");
+	} else if (strcmp(which, "up") == 0) {
+		ui_state_button_event_up();
+		printf("Simulated button: UP\n");
+	} else if (strcmp(which, "down") == 0) {
+		ui_state_button_event_down();
+		printf("Simulated button: DOWN\n");
+	} else if (strcmp(which, "ok") == 0) {
+		ui_state_button_event_ok();
+		printf("Simulated button: OK\n");
+	} else if (strcmp(which, "page") == 0) {
+		ui_state_button_event_page();
+		printf("Simulated button: OK (long) -> page %d\n", (int)ui_state_get_page());
+	} else {
+		printf("Unknown press target: %s\n", which);
+	}
+}
+
+static void cli_handle_tasks(const char *buf)
+{
+	(void)buf;
+	task_topology_report();
+}
+
+static void cli_handle_mem(const char *buf)
+{
+	(void)buf;
+	mem_budget_report();
+}
+
+// CLI：串口屏页面与链路字节统计
+static void cli_handle_disp(const char *buf)
+{
+	(void)buf;
+	display_stats_t st;
+	display_get_stats(&st);
+	printf("display: page=%d refreshes=%lu full_redraws=%lu bytes=%lu last=%lu\n", (int)ui_state_get_page(),
+		   (unsigned long)st.refreshes, (unsigned long)st.full_redraws, (unsigned long)st.bytes,
+		   (unsigned long)st.last_bytes);
+}
+
+static void cli_handle_boot(const char *buf)
+{
+	(void)buf;
+	boot_prof_report();
+}
+
+static void cli_handle_sched(const char *buf)
+{
+	(void)buf;
+	sched_report();
+}
+
+static void cli_handle_bus(const char *buf)
+{
+	(void)buf;
+	telem_bus_report();
+}
+
+// CLI 命令表（内置的 help/wait/script/bin 见 cli.h）
+static const cli_cmd_t s_cli_cmds[] = {
+	{ "set",     cli_handle_set,      "set motor1|motor2 speed|pos <value>" },
+	{ "press",   cli_handle_press,    "press up|down|ok|page" },
+	{ "rec",     cli_handle_recorder, "rec [status|flush]" },
+	{ "tasks",   cli_handle_tasks,    "tasks" },
+	{ "mem",     cli_handle_mem,      "mem" },
+	{ "boot",    cli_handle_boot,     "boot" },
+	{ "sched",   cli_handle_sched,    "sched" },
+	{ "bus",     cli_handle_bus,      "bus" },
+	{ "disp",    cli_handle_disp,     "disp" },
+	{ "sync",    cli_handle_sync,     "sync status|master|off|slave <ip>|start <mode> [lead_ms]" },
+	{ "rates",   cli_handle_rates,    "rates [<name> <ms|auto>]" },
+	{ "estop",   cli_handle_estop,    "estop [release|status|reset]" },
+	{ "udp",     cli_handle_udp,      "udp" },
+	{ "boards",  cli_handle_boards,   "boards" },
+	{ "motion",  cli_handle_motion,   "motion status|stop|move [trap|s] <id> <pos> ..." },
+	{ "capture", cli_handle_capture,  "capture start|stop|status|replay <speed>|replay stop" },
+	{ "bench",   cli_handle_bench,    "bench <parser|tx|json|display|all> [iters]" },
+	{ "linktest", cli_handle_linktest, "linktest [ms]" },
+#if TEST_MODE
+	{ "sim",     cli_handle_sim,      "sim status|speed <n>|run <ms>|reset|motor <id>" },
+	{ "link",    cli_handle_link,     "link on|off|stats|reset|<param> <value>" },
+#endif
+};
+
+// 串口屏刷新作业（调度器 UI 执行任务）：订阅电机 1、2 的遥测，由总线按速率调节器给出的间隔触发；
+// 遥测中断时按兜底间隔刷新（页面切换、模式变化仍会显示）
+static int s_disp_sub = -1;
+
+// 串口屏显示的一个电机：滤波后的速度与电流（遥测处理阶段已算好），其余为原始值。
+// 两者取自总线上的同一样本
+static const motor_status_t *display_sample(uint8_t id, motor_status_t *out)
+{
+	motor_derived_t d;
+	if (!telem_bus_get_sample(s_disp_sub, id, out, &d)) return NULL;
+	if (d.samples) {
+		out->speed = d.speed_filt;
+		out->current = d.current_filt;
+	}
+	return out;
+}
+
+static int64_t display_job(void *arg, int64_t deadline_us)
+{
+	(void)arg;
+	control_mode_t cm = ui_state_get_mode();
+	motor_status_t f1, f2;
+	const motor_status_t *m1 = display_sample(1, &f1);
+	const motor_status_t *m2 = display_sample(2, &f2);
+	ui_page_t page = ui_state_get_page();
+	display_show(page, m1, m2, cm);
+	// 刷新间隔由速率调节器给出（运动中加快，空闲时 1Hz）；趋势页每次追加一列，固定 5–10 Hz
+	uint32_t period_ms = rate_gov_period_ms(RATE_GOV_DISPLAY);
+	if (page != UI_PAGE_NUMBERS && period_ms > DISP_TREND_PERIOD_MS) period_ms = DISP_TREND_PERIOD_MS;
+	telem_bus_set_rate(s_disp_sub, 1, period_ms * 1000);
+	uint32_t fallback_ms = period_ms > TELEM_BUS_FALLBACK_MS ? period_ms : TELEM_BUS_FALLBACK_MS;
+	return deadline_us + (int64_t)fallback_ms * 1000;
+}
+
+// 启动第二阶段：存储与网络。在独立任务中初始化，控制路径不等待 NVS/Wi-Fi/httpd
+static void boot_net_task(void *arg)
+{
+	(void)arg;
+	boot_stage_begin(BOOT_STAGE_NET);
+
+	// 初始化 Web Server（NVS + Wi-Fi AP + HTTP Server，内部分步计时）
+	webserver_init();
+#if UDP_CTRL_ENABLE
+	// 上位机 UDP 二进制控制/遥测通道
+	udp_ctrl_init();
+	boot_mark(BOOT_STAGE_NET, "udp_ctrl");
+#endif
+
+	// 多机架时间同步：从机收到主机的启动命令后在约定时刻进入对应预设
+	if (TIME_SYNC_ROLE != TIME_SYNC_OFF) {
+		time_sync_start((time_sync_role_t)TIME_SYNC_ROLE, TIME_SYNC_MASTER_IP);
+		boot_mark(BOOT_STAGE_NET, "time_sync");
+	}
+
+	// 飞行记录仪（挂载 SPIFFS，首次使用需格式化，耗时最长，放在网络之后）；挂载前的遥测不记录
+	recorder_init();
+	boot_mark(BOOT_STAGE_NET, "recorder");
+	boot_event(BOOT_EV_NET_READY);
+
+	ESP_LOGI(TAG, "network ready. Access web interface at http://192.168.%d.1", WIFI_AP_SUBNET);
+	boot_prof_report();
+	mem_budget_report();
+	vTaskDelete(NULL);
+}
 
 void app_main(void)
 {
     printf("System Booting... [TEST_MODE=%d]\n", TEST_MODE);
+    mem_budget_boot_mark();
+    boot_stage_begin(BOOT_STAGE_CONTROL);
     esp_log_level_set("serial_cboard", ESP_LOG_INFO);
     esp_log_level_set("simulator", ESP_LOG_INFO);
 
     // 初始化 UART0 用于 CLI
     const uart_config_t uart0_config = {
-        .baud_rate = 115200,
+        .baud_rate = CLI_UART_BAUD,
         .data_bits = UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
         .stop_bits = UART_STOP_BITS_1,
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
         .source_clk = UART_SCLK_APB,
     };
-    uart_driver_install(UART_NUM_0, 1024, 0, 0, NULL, 0);
+    uart_driver_install(UART_NUM_0, CLI_UART_RX_BUF, 0, 0, NULL, 0);
     uart_param_config(UART_NUM_0, &uart0_config);
+    boot_mark(BOOT_STAGE_CONTROL, "uart0");
+
+    // 第一阶段：控制路径。C 板链路、复位检测、串口屏与 CLI 不依赖网络，先行启动
+
+    // 周期作业调度器（按键、预设、串口屏等作业在各模块初始化时登记）
+    sched_init();
+    boot_mark(BOOT_STAGE_CONTROL, "sched");
+
+    // 遥测发布/订阅总线（解析器发布，串口屏、滑块同步、复位检测、上位机 UDP 订阅）
+    telem_bus_init();
+
+    // 初始化串口抓包（需在串口模块之前，以便记录最早的收发）
+    uart_capture_init();
+    boot_mark(BOOT_STAGE_CONTROL, "uart_capture");
 
     // 初始化串口通信模块
     serial_cboard_init();
+    boot_mark(BOOT_STAGE_CONTROL, "serial_cboard");
+
+	// 运动规划：GM6020 为单圈绝对角度，走最短路径；M3508 使用默认限制、不环绕
+	motion_init();
+	const motion_axis_cfg_t gm6020_cfg = {
+		.vmax = MOTION_DEFAULT_VMAX,
+		.amax = MOTION_DEFAULT_AMAX,
+		.jmax = MOTION_DEFAULT_JMAX,
+		.wrap = 8192,
+	};
+	motion_config_axis(1, &gm6020_cfg);
+	boot_mark(BOOT_STAGE_CONTROL, "motion");
 
     // 在测试模式下启动模拟器任务以生成并注入模拟帧
     #if TEST_MODE
     simulator_start();
+    boot_mark(BOOT_STAGE_CONTROL, "simulator");
     #endif
 
 	// 初始化 UI 状态机（按键逻辑）
 	ui_state_init();
 	ui_state_register_mode_change_cb(mode_change_cb);
+	serial_cboard_set_estop_cb(estop_cb);
+#if TEST_MODE
+	simulator_register_step_hook(preset_sim_hook);
+#endif
+	time_sync_set_start_cb(preset_start_at);
+	boot_mark(BOOT_STAGE_CONTROL, "ui_state");
 
     // 启动 CLI 任务
-    xTaskCreate(cli_task, "cli_task", 4096, NULL, 5, NULL);
+    cli_start(s_cli_cmds, sizeof(s_cli_cmds) / sizeof(s_cli_cmds[0]));
 
 	// 初始化并启动显示模块（会在 TEST_MODE 下仅打印显示命令）
 	display_init();
 
-	// 周期性刷新显示（1Hz）
-	xTaskCreate(display_task, "display_task", 4096, NULL, 5, NULL);
+	// 周期性刷新显示（周期由速率调节器决定）
+	rate_gov_init();
+	const telem_bus_sub_cfg_t disp = {
+		.name = "display",
+		.sched_job = sched_add("display", SCHED_EXEC_UI, 0, esp_timer_get_time(), display_job, NULL),
+		.ids = { 1, 2 },
+		.nids = 2,
+		.min_period_us = (uint32_t)rate_gov_period_ms(RATE_GOV_DISPLAY) * 1000,
+		.enabled = true,
+	};
+	if (disp.sched_job >= 0) s_disp_sub = telem_bus_subscribe(&disp);
+	boot_mark(BOOT_STAGE_CONTROL, "display");
+	boot_event(BOOT_EV_CONTROL_READY);
 
-	// 初始化 Web Server（Wi-Fi AP + HTTP Server）
-	webserver_init();
+	// 第二阶段：存储与网络，与已运行的控制路径并行初始化
+	task_topology_create(TASK_ID_BOOT_NET, boot_net_task, NULL, NULL, NULL);
 
-    ESP_LOGI(TAG, "app_main finished init. Access web interface at http://192.168.4.1");
-    // 主任务不退出
-    while (1) vTaskDelay(pdMS_TO_TICKS(10000));
-}
\ No newline at end of file
+    ESP_LOGI(TAG, "app_main finished control init; network starting in background");
+    // 所有工作都在各自任务中进行；返回后主任务被删除，其栈归还堆
+}
@@ -0,0 +1,252 @@
+#include "bench.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_system.h"
+#include "config.h"
+#include "serial_cboard.h"
+#include "display_uart.h"
+#include "webserver.h"
+#include "ui_state.h"
+#include "task_topology.h"
+
+static const char *TAG = "bench";
+
+// 每次操作的上下文：放在基准任务栈上（与真实调用者一样在栈上持有缓冲）
+typedef struct {
+	uint8_t frame[3 + 2 * 8 + 1];
+	size_t frame_len;
+	motor_command_t cmds[2];
+	motor_status_t m1, m2;
+	char out[640];
+} bench_ctx_t;
+
+typedef struct {
+	const char *name;
+	void (*prep)(bench_ctx_t *c, uint32_t i); // 不计时：生成第 i 次的合成输入
+	size_t (*run)(bench_ctx_t *c);            // 计时：被测路径，返回字节数
+} bench_def_t;
+
+static void put_status(uint8_t *p, uint16_t angle, int16_t speed, int16_t current, uint8_t temp, uint8_t id)
+{
+	p[0] = (uint8_t)(angle >> 8);
+	p[1] = (uint8_t)angle;
+	p[2] = (uint8_t)((uint16_t)speed >> 8);
+	p[3] = (uint8_t)speed;
+	p[4] = (uint8_t)((uint16_t)current >> 8);
+	p[5] = (uint8_t)current;
+	p[6] = temp;
+	p[7] = id;
+}
+
+// 状态帧 [0xAA][0x55][len][2 * 8 字节][cksum]，角度逐次前进，使遥测滤波走完整路径。
+// 解析结果进入基准的私有状态，电机 id 不会与实时电机冲突
+static void prep_parser(bench_ctx_t *c, uint32_t i)
+{
+	uint8_t *payload = c->frame + 3;
+	put_status(payload, (uint16_t)((i * 37) & 0x1FFF), (int16_t)(i % 200), (int16_t)(i % 500), 30, 1);
+	put_status(payload + 8, (uint16_t)((i * 91) & 0x1FFF), (int16_t)-(int16_t)(i % 200), 100, 31, 2);
+	uint32_t sum = 0;
+	for (int k = 0; k < 16; ++k) sum += payload[k];
+	c->frame[0] = 0xAA;
+	c->frame[1] = 0x55;
+	c->frame[2] = 16;
+	c->frame[19] = (uint8_t)(sum & 0xFF);
+	c->frame_len = 20;
+}
+
+static size_t run_parser(bench_ctx_t *c)
+{
+	serial_cboard_bench_parse(c->frame, c->frame_len);
+	return c->frame_len;
+}
+
+static void prep_tx(bench_ctx_t *c, uint32_t i)
+{
+	c->cmds[0] = (motor_command_t){ .motor_id = 1, .control_mode = 1, .target_position = (int16_t)(i & 0x1FFF) };
+	c->cmds[1] = (motor_command_t){ .motor_id = 2, .control_mode = 0, .target_speed = (int16_t)(i % 1000) };
+}
+
+static size_t run_tx(bench_ctx_t *c)
+{
+	return serial_cboard_encode_frame(c->frame, sizeof(c->frame), c->cmds, 2);
+}
+
+static void prep_json(bench_ctx_t *c, uint32_t i)
+{
+	(void)c;
+	(void)i;
+}
+
+static size_t run_json(bench_ctx_t *c)
+{
+	return (size_t)webserver_status_json(c->out, sizeof(c->out));
+}
+
+static void prep_display(bench_ctx_t *c, uint32_t i)
+{
+	c->m1 = (motor_status_t){ .angle = (uint16_t)(i & 0x1FFF), .speed = (int16_t)(i % 300), .current = -1200, .temperature = 35, .motor_id = 1 };
+	c->m2 = (motor_status_t){ .angle = (uint16_t)((i * 7) & 0x1FFF), .speed = -250, .current = (int16_t)(i % 4000), .temperature = 41, .motor_id = 2 };
+}
+
+static size_t run_display(bench_ctx_t *c)
+{
+	return (size_t)display_format(c->out, sizeof(c->out), &c->m1, &c->m2, MODE_PRESET1);
+}
+
+static const bench_def_t s_benches[] = {
+	{ "parser",  prep_parser,  run_parser },
+	{ "tx",      prep_tx,      run_tx },
+	{ "json",    prep_json,    run_json },
+	{ "display", prep_display, run_display },
+};
+#define BENCH_COUNT (sizeof(s_benches) / sizeof(s_benches[0]))
+
+typedef struct {
+	const bench_def_t *def;
+	uint32_t iters;
+	bench_result_t *out;
+	TaskHandle_t caller;
+} bench_job_t;
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool s_busy;
+
+static bool bench_acquire(void)
+{
+	bool ok;
+	portENTER_CRITICAL(&s_mux);
+	ok = !s_busy;
+	s_busy = true;
+	portEXIT_CRITICAL(&s_mux);
+	return ok;
+}
+
+static void bench_release(void)
+{
+	portENTER_CRITICAL(&s_mux);
+	s_busy = false;
+	portEXIT_CRITICAL(&s_mux);
+}
+
+static void bench_task(void *arg)
+{
+	bench_job_t *job = (bench_job_t *)arg;
+	bench_result_t *r = job->out;
+	bench_ctx_t ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	uint64_t total = 0;
+	uint32_t cmin = UINT32_MAX, cmax = 0;
+	size_t bytes = 0;
+
+	uint32_t heap0 = esp_get_free_heap_size();
+	int64_t t0 = esp_timer_get_time();
+	for (uint32_t i = 0; i < job->iters; ++i) {
+		job->def->prep(&ctx, i);
+		uint32_t c0 = esp_cpu_get_cycle_count();
+		bytes = job->def->run(&ctx);
+		uint32_t dc = (uint32_t)(esp_cpu_get_cycle_count() - c0);
+		total += dc;
+		if (dc < cmin) cmin = dc;
+		if (dc > cmax) cmax = dc;
+	}
+	r->us_total = (uint32_t)(esp_timer_get_time() - t0);
+	r->heap_delta = (int32_t)(esp_get_free_heap_size() - heap0);
+	r->name = job->def->name;
+	r->iters = job->iters;
+	r->cycles_avg = (uint32_t)(total / job->iters);
+	r->cycles_min = cmin;
+	r->cycles_max = cmax;
+	r->bytes_per_op = (uint32_t)bytes;
+	r->stack_size = task_topology_get(TASK_ID_BENCH)->stack;
+	r->stack_used = r->stack_size - (uint32_t)uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t);
+
+	xTaskNotifyGive(job->caller);
+	vTaskDelete(NULL);
+}
+
+const char *bench_name(int idx)
+{
+	return (idx >= 0 && idx < (int)BENCH_COUNT) ? s_benches[idx].name : NULL;
+}
+
+esp_err_t bench_run(const char *name, uint32_t iters, bench_result_t *out)
+{
+	if (!name || !out) return ESP_ERR_INVALID_ARG;
+	const bench_def_t *def = NULL;
+	for (size_t i = 0; i < BENCH_COUNT; ++i) {
+		if (strcmp(name, s_benches[i].name) == 0) def = &s_benches[i];
+	}
+	if (!def) return ESP_ERR_NOT_FOUND;
+	if (iters == 0) iters = BENCH_DEFAULT_ITERS;
+	if (iters > BENCH_MAX_ITERS) iters = BENCH_MAX_ITERS;
+	if (!bench_acquire()) return ESP_ERR_INVALID_STATE;
+
+	// 任务每次新建，栈高水位只反映本次基准；job 在调用者栈上，调用者一直等到任务结束
+	bench_job_t job = { .def = def, .iters = iters, .out = out, .caller = xTaskGetCurrentTaskHandle() };
+	memset(out, 0, sizeof(*out));
+	esp_err_t err = ESP_OK;
+	if (task_topology_create(TASK_ID_BENCH, bench_task, &job, NULL, NULL) == pdPASS) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+	} else {
+		err = ESP_ERR_NO_MEM;
+	}
+	bench_release();
+	if (err == ESP_OK) {
+		ESP_LOGI(TAG, "%s: %lu iters, %lu cycles/op", name, (unsigned long)iters, (unsigned long)out->cycles_avg);
+	}
+	return err;
+}
+
+esp_err_t linktest_run(uint32_t ms, linktest_result_t *out)
+{
+	if (!out) return ESP_ERR_INVALID_ARG;
+	if (ms == 0) ms = 1000;
+	if (!bench_acquire()) return ESP_ERR_INVALID_STATE;
+	memset(out, 0, sizeof(*out));
+
+	serial_rx_stats_t a, b;
+	cboard_board_stats_t bs;
+	int nboards = serial_cboard_board_count();
+	serial_cboard_get_rx_stats(&a);
+	for (int i = 0; i < nboards; ++i) {
+		if (!serial_cboard_get_board_stats((uint8_t)i, &bs)) continue;
+		out->polls -= bs.polls;
+		out->replies -= bs.replies;
+		out->timeouts -= bs.timeouts;
+	}
+	int64_t t0 = esp_timer_get_time();
+	vTaskDelay(pdMS_TO_TICKS(ms));
+	uint32_t el_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+	serial_cboard_get_rx_stats(&b);
+	for (int i = 0; i < nboards; ++i) {
+		if (!serial_cboard_get_board_stats((uint8_t)i, &bs)) continue;
+		out->polls += bs.polls;
+		out->replies += bs.replies;
+		out->timeouts += bs.timeouts;
+	}
+	bench_release();
+
+	uint32_t line_Bps = 0;
+	for (uint8_t ch = 0; ; ++ch) {
+		const cboard_link_cfg_t *cfg = serial_cboard_link_cfg(ch);
+		if (!cfg) break;
+		line_Bps += cfg->baud / 10; // 8N1：每字节 10 位
+	}
+	out->ms = el_ms ? el_ms : 1;
+	out->line_Bps = line_Bps;
+	out->bytes_in = b.bytes_in - a.bytes_in;
+	out->frames_ok = b.frames_ok - a.frames_ok;
+	out->cksum_errors = b.cksum_errors - a.cksum_errors;
+	out->bytes_discarded = b.bytes_discarded - a.bytes_discarded;
+	uint32_t good = out->bytes_in > out->bytes_discarded ? out->bytes_in - out->bytes_discarded : 0;
+	out->goodput_Bps = (uint32_t)((uint64_t)good * 1000 / out->ms);
+	out->util_permille = line_Bps ? (uint32_t)((uint64_t)out->goodput_Bps * 1000 / line_Bps) : 0;
+	uint32_t frames = out->frames_ok + out->cksum_errors;
+	out->frame_err_ppm = frames ? (uint32_t)((uint64_t)out->cksum_errors * 1000000 / frames) : 0;
+	out->byte_err_ppm = out->bytes_in ? (uint32_t)((uint64_t)out->bytes_discarded * 1000000 / out->bytes_in) : 0;
+	return ESP_OK;
+}
@@ -0,0 +1,56 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+// 设备上的自测基准：在部署的机器上对真实固件代码路径跑 N 次合成数据，不向电机发送任何命令。
+//   parser   serial_cboard_bench_parse 解析一帧两电机的状态报文（与实时帧相同的校验、解码、加锁与滤波；
+//            结果写入基准的私有状态，实时遥测照常，不受影响）
+//   tx       serial_cboard_encode_frame 组一帧两电机命令（只组帧不发送）
+//   json     /api/status 的 JSON 序列化（webserver_status_json，不经缓存）
+//   display  串口屏指令格式化（display_format，不发送）
+// 基准在独立的低优先级任务中运行（新建任务的栈峰值即该路径的栈用量），同一时间只允许一个基准/链路测试。
+//
+// linktest：在给定时间窗内统计 C 板串口接收的有效字节率与错误率（被动测量，不发送）。
+
+typedef struct {
+	const char *name;
+	uint32_t iters;
+	uint32_t cycles_avg;   // 每次操作的 CPU 周期
+	uint32_t cycles_min;
+	uint32_t cycles_max;   // 含被抢占的时间
+	uint32_t us_total;
+	uint32_t bytes_per_op; // 输入（parser）或输出字节数
+	int32_t heap_delta;    // 运行后减运行前的空闲堆（负数 = 仍占用）
+	uint32_t stack_used;   // 基准任务栈峰值（字节）
+	uint32_t stack_size;
+} bench_result_t;
+
+typedef struct {
+	uint32_t ms;
+	uint32_t line_Bps;       // 所有通道线路容量（波特率 / 10）
+	uint32_t bytes_in;
+	uint32_t frames_ok;
+	uint32_t cksum_errors;
+	uint32_t bytes_discarded;
+	uint32_t goodput_Bps;    // 有效字节（输入减去重新同步丢弃的字节）/ 秒
+	uint32_t util_permille;  // goodput 占线路容量的千分比
+	uint32_t frame_err_ppm;  // 校验失败帧 / (有效 + 失败)
+	uint32_t byte_err_ppm;   // 丢弃字节 / 输入字节
+	uint32_t polls;          // RS-485 总线轮询（所有板合计）
+	uint32_t replies;
+	uint32_t timeouts;
+} linktest_result_t;
+
+// 运行指定基准（parser|tx|json|display），iters 为 0 时使用 BENCH_DEFAULT_ITERS；
+// 未知名称返回 ESP_ERR_NOT_FOUND，已有测试在运行返回 ESP_ERR_INVALID_STATE
+esp_err_t bench_run(const char *name, uint32_t iters, bench_result_t *out);
+
+// 基准名称（idx 越界返回 NULL），用于 `bench all` 与帮助信息
+const char *bench_name(int idx);
+
+// 阻塞 ms 毫秒统计链路质量（ms 为 0 时使用 1000）
+esp_err_t linktest_run(uint32_t ms, linktest_result_t *out);
+
+#endif // BENCH_H
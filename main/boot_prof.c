@@ -0,0 +1,124 @@
+#include "boot_prof.h"
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "config.h"
+
+typedef struct {
+	const char *stage;
+	const char *step;
+	int64_t start_us;
+	int64_t end_us;
+	uint8_t core;
+} boot_step_t;
+
+typedef struct {
+	const char *stage;
+	int64_t begin_us;
+	int64_t last_us;
+} boot_stage_rt_t;
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static boot_step_t s_steps[BOOT_PROF_MAX_STEPS];
+static size_t s_nsteps;
+static uint32_t s_dropped;
+static boot_stage_rt_t s_stages[4];
+static size_t s_nstages;
+static volatile int64_t s_events[BOOT_EV_COUNT];
+
+static const char *const s_event_names[BOOT_EV_COUNT] = {
+	[BOOT_EV_CONTROL_READY]   = "control ready",
+	[BOOT_EV_FIRST_TELEMETRY] = "first telemetry frame",
+	[BOOT_EV_NET_READY]       = "network ready",
+	[BOOT_EV_FIRST_HTTP]      = "first HTTP response",
+};
+
+// 调用者持有 s_mux
+static boot_stage_rt_t *find_stage(const char *stage)
+{
+	for (size_t i = 0; i < s_nstages; ++i) {
+		if (strcmp(s_stages[i].stage, stage) == 0) return &s_stages[i];
+	}
+	return NULL;
+}
+
+void boot_stage_begin(const char *stage)
+{
+	int64_t now = esp_timer_get_time();
+	portENTER_CRITICAL(&s_mux);
+	boot_stage_rt_t *s = find_stage(stage);
+	if (!s && s_nstages < sizeof(s_stages) / sizeof(s_stages[0])) s = &s_stages[s_nstages++];
+	if (s) {
+		s->stage = stage;
+		s->begin_us = now;
+		s->last_us = now;
+	}
+	portEXIT_CRITICAL(&s_mux);
+}
+
+void boot_mark(const char *stage, const char *step)
+{
+	int64_t now = esp_timer_get_time();
+	uint8_t core = (uint8_t)esp_cpu_get_core_id();
+	portENTER_CRITICAL(&s_mux);
+	boot_stage_rt_t *s = find_stage(stage);
+	int64_t start = s ? s->last_us : now;
+	if (s) s->last_us = now;
+	if (s_nsteps < BOOT_PROF_MAX_STEPS) {
+		s_steps[s_nsteps++] = (boot_step_t){ stage, step, start, now, core };
+	} else {
+		s_dropped++;
+	}
+	portEXIT_CRITICAL(&s_mux);
+}
+
+void boot_event(boot_event_t ev)
+{
+	if (ev >= BOOT_EV_COUNT || s_events[ev]) return;
+	int64_t now = esp_timer_get_time();
+	portENTER_CRITICAL(&s_mux);
+	if (!s_events[ev]) s_events[ev] = now;
+	portEXIT_CRITICAL(&s_mux);
+}
+
+int64_t boot_event_us(boot_event_t ev)
+{
+	return ev < BOOT_EV_COUNT ? s_events[ev] : 0;
+}
+
+void boot_prof_report(void)
+{
+	boot_step_t steps[BOOT_PROF_MAX_STEPS];
+	boot_stage_rt_t stages[4];
+	size_t n, ns;
+	portENTER_CRITICAL(&s_mux);
+	n = s_nsteps;
+	ns = s_nstages;
+	memcpy(steps, s_steps, n * sizeof(steps[0]));
+	memcpy(stages, s_stages, ns * sizeof(stages[0]));
+	portEXIT_CRITICAL(&s_mux);
+
+	printf("boot: %-8s %-16s %10s %10s core\n", "stage", "step", "at(ms)", "took(ms)");
+	for (size_t i = 0; i < n; ++i) {
+		int64_t took = steps[i].end_us - steps[i].start_us;
+		printf("boot: %-8s %-16s %6lld.%03lld %6lld.%03lld  %u\n", steps[i].stage, steps[i].step,
+			   (long long)(steps[i].end_us / 1000), (long long)(steps[i].end_us % 1000),
+			   (long long)(took / 1000), (long long)(took % 1000), steps[i].core);
+	}
+	for (size_t i = 0; i < ns; ++i) {
+		int64_t took = stages[i].last_us - stages[i].begin_us;
+		printf("boot: stage %-8s %lld.%03lld ms -> %lld.%03lld ms (%lld.%03lld ms)\n", stages[i].stage,
+			   (long long)(stages[i].begin_us / 1000), (long long)(stages[i].begin_us % 1000),
+			   (long long)(stages[i].last_us / 1000), (long long)(stages[i].last_us % 1000),
+			   (long long)(took / 1000), (long long)(took % 1000));
+	}
+	for (int e = 0; e < BOOT_EV_COUNT; ++e) {
+		int64_t t = s_events[e];
+		if (t) printf("boot: %-22s %lld.%03lld ms\n", s_event_names[e], (long long)(t / 1000), (long long)(t % 1000));
+		else printf("boot: %-22s -\n", s_event_names[e]);
+	}
+	if (s_dropped) printf("boot: %lu steps dropped (BOOT_PROF_MAX_STEPS)\n", (unsigned long)s_dropped);
+}
@@ -0,0 +1,38 @@
+#ifndef BOOT_PROF_H
+#define BOOT_PROF_H
+
+#include <stdint.h>
+
+// 启动阶段计时：分阶段启动，控制路径（C 板链路、复位检测、串口屏、CLI）在 app_main 中先完成，
+// 存储与网络（NVS、Wi-Fi、httpd、UDP、时间同步、飞行记录仪）随后在独立任务中初始化，二者并行。
+// 各初始化步骤完成时调用 boot_mark 记录时间（自上电起的 esp_timer 时间）与耗时，
+// 关键事件（控制就绪、首个遥测帧、网络就绪、首个 HTTP 响应）只记录第一次发生的时刻。
+// CLI `boot` 打印报告。
+
+#define BOOT_STAGE_CONTROL "control"
+#define BOOT_STAGE_NET     "net"
+
+typedef enum {
+	BOOT_EV_CONTROL_READY = 0, // 控制路径初始化完成
+	BOOT_EV_FIRST_TELEMETRY,   // 解析出第一帧 C 板状态
+	BOOT_EV_NET_READY,         // 网络阶段初始化完成
+	BOOT_EV_FIRST_HTTP,        // 第一次响应网页请求
+	BOOT_EV_COUNT
+} boot_event_t;
+
+// 开始一个阶段（stage 须为常量字符串）；该阶段第一个步骤的耗时从此刻算起
+void boot_stage_begin(const char *stage);
+
+// 记录阶段内一个步骤完成（耗时 = 距同一阶段上一个标记）
+void boot_mark(const char *stage, const char *step);
+
+// 记录事件首次发生的时刻（之后的调用只做一次读取，可放在热路径上）
+void boot_event(boot_event_t ev);
+
+// 事件时刻（微秒，未发生返回 0）
+int64_t boot_event_us(boot_event_t ev);
+
+// 打印各阶段步骤与关键事件
+void boot_prof_report(void);
+
+#endif // BOOT_PROF_H
@@ -0,0 +1,402 @@
+#include "cli.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "serial_cboard.h"
+#include "ui_state.h"
+#include "task_topology.h"
+#include "mem_budget.h"
+
+static const char *TAG = "cli";
+
+#define CLI_BIN_REC_LEN 6
+
+static const cli_cmd_t *s_table;
+static size_t s_table_n;
+static cli_stats_t s_stats;
+
+// 当前正在拼接的文本行
+static char s_line[CLI_LINE_MAX];
+static size_t s_line_len;
+static bool s_line_overflow;
+
+// 录制的脚本：以 '\n' 分隔的命令行
+static char s_script[CLI_SCRIPT_BUF];
+static size_t s_script_len;
+static bool s_recording;
+static bool s_script_running;
+
+// 二进制帧解析状态
+typedef enum {
+	BIN_SOF = 0,
+	BIN_TYPE,
+	BIN_LEN,
+	BIN_PAYLOAD,
+	BIN_CKSUM,
+} bin_state_t;
+
+static bool s_bin;
+static bin_state_t s_bin_state;
+static uint8_t s_bin_type;
+static uint8_t s_bin_len;
+static uint8_t s_bin_pos;
+static uint8_t s_bin_payload[255];
+static int64_t s_bin_last_us;
+
+// 待下发的设定点（一次读取内按电机合并）
+static motor_command_t s_pend[CLI_BIN_MAX_PENDING];
+static size_t s_pend_n;
+
+static void cli_exec_line(char *line);
+
+static void bin_reply(uint8_t type, const uint8_t *payload, uint8_t len)
+{
+	uint8_t frame[4 + 16];
+	if (len > sizeof(frame) - 4) return;
+	uint32_t sum = 0;
+	frame[0] = CLI_BIN_SOF;
+	frame[1] = type;
+	frame[2] = len;
+	for (uint8_t i = 0; i < len; ++i) {
+		frame[3 + i] = payload[i];
+		sum += payload[i];
+	}
+	frame[3 + len] = (uint8_t)(sum & 0xFF);
+	uart_write_bytes(UART_NUM_0, frame, 4 + len);
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static void bin_flush(void)
+{
+	if (!s_pend_n) return;
+	// 与网页/UDP 手动控制一致：外部命令接管控制，退出预设
+	if (ui_state_get_mode() != MODE_MANUAL) ui_state_set_mode(MODE_MANUAL);
+	serial_cboard_send(s_pend, s_pend_n);
+	s_stats.bin_sends++;
+	s_pend_n = 0;
+}
+
+static void bin_queue(const motor_command_t *cmd)
+{
+	for (size_t i = 0; i < s_pend_n; ++i) {
+		if (s_pend[i].motor_id == cmd->motor_id) {
+			s_pend[i] = *cmd;
+			return;
+		}
+	}
+	if (s_pend_n >= CLI_BIN_MAX_PENDING) bin_flush();
+	s_pend[s_pend_n++] = *cmd;
+}
+
+static void bin_exit(const char *why)
+{
+	bin_flush();
+	s_bin = false;
+	printf("bin: back to text mode (%s)\n", why);
+}
+
+static void bin_frame(void)
+{
+	s_stats.bin_frames++;
+	s_bin_last_us = esp_timer_get_time();
+	if (s_bin_type == CLI_BIN_SETPOINTS) {
+		if (s_bin_len % CLI_BIN_REC_LEN != 0) {
+			s_stats.bin_errors++;
+			return;
+		}
+		for (size_t i = 0; i < s_bin_len; i += CLI_BIN_REC_LEN) {
+			const uint8_t *p = s_bin_payload + i;
+			motor_command_t cmd = {
+				.motor_id = p[0],
+				.control_mode = p[1],
+				.target_speed = (int16_t)(p[2] | p[3] << 8),
+				.target_position = (int16_t)(p[4] | p[5] << 8),
+			};
+			bin_queue(&cmd);
+			s_stats.bin_setpoints++;
+		}
+	} else if (s_bin_type == CLI_BIN_PING) {
+		bin_flush();
+		uint8_t body[16];
+		put_le32(body, s_stats.bin_frames);
+		put_le32(body + 4, s_stats.bin_setpoints);
+		put_le32(body + 8, s_stats.bin_sends);
+		put_le32(body + 12, s_stats.bin_errors);
+		bin_reply(CLI_BIN_PING | CLI_BIN_REPLY, body, sizeof(body));
+	} else if (s_bin_type == CLI_BIN_EXIT) {
+		bin_reply(CLI_BIN_EXIT | CLI_BIN_REPLY, NULL, 0);
+		bin_exit("exit frame");
+	} else {
+		s_stats.bin_errors++;
+	}
+}
+
+static void bin_feed(uint8_t c)
+{
+	switch (s_bin_state) {
+	case BIN_SOF:
+		if (c == CLI_BIN_SOF) s_bin_state = BIN_TYPE;
+		break;
+	case BIN_TYPE:
+		s_bin_type = c;
+		s_bin_state = BIN_LEN;
+		break;
+	case BIN_LEN:
+		s_bin_len = c;
+		s_bin_pos = 0;
+		s_bin_state = c ? BIN_PAYLOAD : BIN_CKSUM;
+		break;
+	case BIN_PAYLOAD:
+		s_bin_payload[s_bin_pos++] = c;
+		if (s_bin_pos == s_bin_len) s_bin_state = BIN_CKSUM;
+		break;
+	case BIN_CKSUM: {
+		uint32_t sum = 0;
+		for (uint8_t i = 0; i < s_bin_len; ++i) sum += s_bin_payload[i];
+		s_bin_state = BIN_SOF;
+		if ((uint8_t)(sum & 0xFF) == c) bin_frame();
+		else s_stats.bin_errors++;
+		break;
+	}
+	}
+}
+
+static void text_feed(uint8_t c)
+{
+	if (c == '\n' || c == '\r') {
+		s_line[s_line_len] = '\0';
+		if (s_line_overflow) {
+			s_stats.overflows++;
+			printf("Line too long (max %d)\n", CLI_LINE_MAX - 1);
+		} else if (s_line_len > 0) {
+			cli_exec_line(s_line);
+		}
+		s_line_len = 0;
+		s_line_overflow = false;
+	} else if (s_line_len < sizeof(s_line) - 1) {
+		s_line[s_line_len++] = (char)c;
+	} else {
+		s_line_overflow = true;
+	}
+}
+
+// 睡到 esp_timer 时刻 t_us：先睡到约 1 ms 前，再忙等
+static void sleep_until(int64_t t_us)
+{
+	int64_t wait_us = t_us - esp_timer_get_time();
+	if (wait_us > 2000) vTaskDelay(pdMS_TO_TICKS((wait_us - 1000) / 1000));
+	while (esp_timer_get_time() < t_us) {
+	}
+}
+
+static void script_run(unsigned repeat)
+{
+	char line[CLI_LINE_MAX];
+	int64_t t = esp_timer_get_time();
+	int64_t t0 = t;
+	s_script_running = true;
+	for (unsigned r = 0; r < repeat; ++r) {
+		const char *p = s_script;
+		const char *end = s_script + s_script_len;
+		while (p < end) {
+			const char *nl = memchr(p, '\n', (size_t)(end - p));
+			size_t len = nl ? (size_t)(nl - p) : (size_t)(end - p);
+			memcpy(line, p, len);
+			line[len] = '\0';
+			p += len + 1;
+			unsigned ms;
+			if (sscanf(line, "wait %u", &ms) == 1) {
+				// 绝对时间轴：wait 之间的命令执行时间不累积
+				t += (int64_t)ms * 1000;
+				sleep_until(t);
+			} else {
+				cli_exec_line(line);
+			}
+		}
+	}
+	s_script_running = false;
+	printf("script: %u run(s) in %lld ms\n", repeat, (long long)((esp_timer_get_time() - t0) / 1000));
+}
+
+// script begin|end|run [n]|show|clear
+static void cli_cmd_script(const char *line)
+{
+	char sub[16] = "show";
+	unsigned repeat = 1;
+	sscanf(line, "script %15s %u", sub, &repeat);
+	if (s_script_running) {
+		printf("script: nested script commands are not allowed\n");
+	} else if (strcmp(sub, "begin") == 0) {
+		s_script_len = 0;
+		s_recording = true;
+		printf("script: recording, end with 'script end'\n");
+	} else if (strcmp(sub, "end") == 0) {
+		s_recording = false;
+		printf("script: %u bytes\n", (unsigned)s_script_len);
+	} else if (strcmp(sub, "run") == 0) {
+		if (!s_script_len) printf("script: empty\n");
+		else script_run(repeat ? repeat : 1);
+	} else if (strcmp(sub, "clear") == 0) {
+		s_script_len = 0;
+		printf("script: cleared\n");
+	} else if (strcmp(sub, "show") == 0) {
+		printf("%.*s", (int)s_script_len, s_script);
+		printf("script: %u/%u bytes\n", (unsigned)s_script_len, (unsigned)sizeof(s_script));
+	} else {
+		printf("Usage: script begin|end|run [n]|show|clear\n");
+	}
+}
+
+static void script_record(const char *line)
+{
+	if (strcmp(line, "script end") == 0) {
+		cli_cmd_script(line);
+		return;
+	}
+	size_t len = strlen(line);
+	if (s_script_len + len + 1 > sizeof(s_script)) {
+		s_recording = false;
+		s_script_len = 0;
+		printf("script: buffer full (%u bytes), recording discarded\n", (unsigned)sizeof(s_script));
+		return;
+	}
+	memcpy(s_script + s_script_len, line, len);
+	s_script_len += len;
+	s_script[s_script_len++] = '\n';
+}
+
+static void cli_cmd_wait(const char *line)
+{
+	unsigned ms = 0;
+	if (sscanf(line, "wait %u", &ms) != 1) {
+		printf("Usage: wait <ms>\n");
+		return;
+	}
+	vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+// bin | bin stats
+static void cli_cmd_bin(const char *line)
+{
+	if (strcmp(line, "bin stats") == 0) {
+		cli_stats_t st;
+		cli_get_stats(&st);
+		printf("cli: lines=%lu unknown=%lu overflows=%lu bin_frames=%lu bin_errors=%lu setpoints=%lu sends=%lu\n",
+			   (unsigned long)st.lines, (unsigned long)st.unknown, (unsigned long)st.overflows,
+			   (unsigned long)st.bin_frames, (unsigned long)st.bin_errors, (unsigned long)st.bin_setpoints,
+			   (unsigned long)st.bin_sends);
+		return;
+	}
+	if (s_script_running) {
+		printf("bin: not allowed in scripts\n");
+		return;
+	}
+	printf("bin: binary mode, idle timeout %d ms\n", CLI_BIN_IDLE_MS);
+	s_bin = true;
+	s_bin_state = BIN_SOF;
+	s_bin_last_us = esp_timer_get_time();
+}
+
+static void cli_cmd_help(const char *line)
+{
+	(void)line;
+	printf("help | wait <ms> | script begin|end|run [n]|show|clear | bin [stats]\n");
+	for (size_t i = 0; i < s_table_n; ++i) {
+		printf("%s\n", s_table[i].usage ? s_table[i].usage : s_table[i].name);
+	}
+}
+
+static const cli_cmd_t s_builtin[] = {
+	{ "help",   cli_cmd_help,   NULL },
+	{ "wait",   cli_cmd_wait,   NULL },
+	{ "script", cli_cmd_script, NULL },
+	{ "bin",    cli_cmd_bin,    NULL },
+};
+
+static const cli_cmd_t *find_cmd(const cli_cmd_t *table, size_t n, const char *word, size_t len)
+{
+	for (size_t i = 0; i < n; ++i) {
+		if (strncmp(table[i].name, word, len) == 0 && table[i].name[len] == '\0') return &table[i];
+	}
+	return NULL;
+}
+
+static void cli_exec_line(char *line)
+{
+	if (s_recording) {
+		script_record(line);
+		return;
+	}
+	s_stats.lines++;
+	size_t len = strcspn(line, " ");
+	const cli_cmd_t *cmd = find_cmd(s_builtin, sizeof(s_builtin) / sizeof(s_builtin[0]), line, len);
+	if (!cmd) cmd = find_cmd(s_table, s_table_n, line, len);
+	if (cmd) {
+		cmd->fn(line);
+	} else {
+		s_stats.unknown++;
+		printf("Unknown command: %s\n", line);
+	}
+}
+
+// 阻塞等待第一个字节，随后把驱动缓冲区中已有的数据一次读出，避免逐字节调用驱动
+static size_t cli_read(uint8_t *buf, size_t size, TickType_t wait)
+{
+	int n = uart_read_bytes(UART_NUM_0, buf, 1, wait);
+	if (n <= 0) return 0;
+	size_t avail = 0;
+	uart_get_buffered_data_len(UART_NUM_0, &avail);
+	if (avail > size - 1) avail = size - 1;
+	if (avail) {
+		int m = uart_read_bytes(UART_NUM_0, buf + 1, avail, 0);
+		if (m > 0) n += m;
+	}
+	return (size_t)n;
+}
+
+static void cli_task(void *arg)
+{
+	(void)arg;
+	static uint8_t rx[CLI_READ_CHUNK];
+	while (1) {
+		size_t n = cli_read(rx, sizeof(rx), s_bin ? pdMS_TO_TICKS(CLI_BIN_IDLE_MS) : portMAX_DELAY);
+		for (size_t i = 0; i < n; ++i) {
+			// 命令可能在同一块数据中途切换模式（如 "bin" 之后紧跟帧）
+			if (s_bin) bin_feed(rx[i]);
+			else text_feed(rx[i]);
+		}
+		if (s_bin) {
+			bin_flush();
+			if (esp_timer_get_time() - s_bin_last_us > (int64_t)CLI_BIN_IDLE_MS * 1000) bin_exit("idle timeout");
+		}
+	}
+}
+
+void cli_start(const cli_cmd_t *table, size_t n)
+{
+	s_table = table;
+	s_table_n = n;
+	mem_budget_add("cli", "line/script/frame buffers",
+				   sizeof(s_line) + sizeof(s_script) + sizeof(s_bin_payload) + sizeof(s_pend) + CLI_READ_CHUNK);
+	if (task_topology_create(TASK_ID_CLI, cli_task, NULL, NULL, NULL) != pdPASS) {
+		ESP_LOGE(TAG, "failed to create CLI task");
+	}
+}
+
+void cli_get_stats(cli_stats_t *out)
+{
+	if (out) *out = s_stats;
+}
@@ -0,0 +1,54 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// UART0 命令行：按行缓冲批量读取，按命令表分发（首个单词精确匹配）。
+// 内置命令：
+//   help                  列出命令表
+//   wait <ms>             暂停 ms 毫秒（批量粘贴/脚本中用于控制节奏）
+//   script begin|end|run [n]|show|clear
+//                         录制脚本（begin 与 end 之间的行只保存不执行），run 执行 n 遍；
+//                         脚本中的 wait 按绝对时间轴累加，命令执行时间不会拉长整体节奏
+//   bin                   进入二进制帧模式（见下），供测试台高速下发设定点
+//   bin stats             命令行与二进制模式统计
+//
+// 二进制帧（与 C 板帧同构）：[0xA5][type][len][payload(len)][cksum = payload 字节和 & 0xFF]
+//   0x01 SETPOINTS  payload: n * { u8 id, u8 mode, i16 speed(LE), i16 pos(LE) }（与 UDP CMD 的记录相同）
+//   0x02 PING       无 payload；应答 0x82: u32 frames, u32 setpoints, u32 sends, u32 errors（LE）
+//   0x03 EXIT       回到文本模式；应答 0x83（无 payload）
+// 一次读取到的多帧设定点按电机合并（同一电机只保留最新值）后一次性下发给 C 板。
+// 超过 CLI_BIN_IDLE_MS 没有收到完整帧时自动回到文本模式。
+// 注意：其它任务的日志仍会输出到 UART0，上位机须按帧头与校验和同步应答帧。
+
+#define CLI_BIN_SOF          0xA5
+#define CLI_BIN_SETPOINTS    0x01
+#define CLI_BIN_PING         0x02
+#define CLI_BIN_EXIT         0x03
+#define CLI_BIN_REPLY        0x80 // 应答类型 = 请求类型 | 0x80
+
+typedef void (*cli_handler_t)(const char *line);
+
+typedef struct {
+	const char *name;    // 命令名（行首单词）
+	cli_handler_t fn;    // 收到整行（含命令名）
+	const char *usage;   // help 显示
+} cli_cmd_t;
+
+typedef struct {
+	uint32_t lines;        // 执行的文本命令行
+	uint32_t unknown;      // 未知命令
+	uint32_t overflows;    // 超长被截断的行
+	uint32_t bin_frames;   // 校验通过的二进制帧
+	uint32_t bin_errors;   // 校验失败/长度非法的二进制帧
+	uint32_t bin_setpoints;// 收到的设定点
+	uint32_t bin_sends;    // 合并后实际下发给 C 板的批次
+} cli_stats_t;
+
+// 安装命令表并创建 CLI 任务（UART0 驱动需已安装）；table 需在整个运行期间有效
+void cli_start(const cli_cmd_t *table, size_t n);
+
+void cli_get_stats(cli_stats_t *out);
+
+#endif // CLI_H
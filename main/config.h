@@ -19,8 +19,24 @@
 #define BUTTON_ACTIVE_LEVEL 0
 #endif
 
+// 急停按键：进入有效电平的边沿立即触发（GPIO 中断，不经按键轮询）；-1 = 未接
+#ifndef ESTOP_GPIO
+#define ESTOP_GPIO 3
+#endif
+#ifndef ESTOP_ACTIVE_LEVEL
+#define ESTOP_ACTIVE_LEVEL 0
+#endif
+// 急停命令的控制模式（速度 0）；C 板固件支持零力矩模式时改为对应值
+#ifndef ESTOP_CONTROL_MODE
+#define ESTOP_CONTROL_MODE 0
+#endif
+
 #define BUTTON_DEBOUNCE_MS 50
 #define BUTTON_POLL_INTERVAL_MS 50
+// 长按 OK 切换串口屏页面
+#ifndef UI_LONG_PRESS_MS
+#define UI_LONG_PRESS_MS 800
+#endif
 
 #endif // CONFIG_H
 
@@ -54,3 +70,385 @@
 #ifndef RESET_SWITCH_ANGLE_THRESHOLD
 #define RESET_SWITCH_ANGLE_THRESHOLD 2
 #endif
+
+// 模拟器时间倍率默认值：1 = 实时，N = N 倍速，0 = 尽可能快
+#ifndef SIM_DEFAULT_SPEED
+#define SIM_DEFAULT_SPEED 1
+#endif
+
+// 模拟器最大加速度（RPM/s）：仿真 C 板速度参考的斜坡限幅
+#ifndef SIM_MAX_ACCEL_RPM_PER_SEC
+#define SIM_MAX_ACCEL_RPM_PER_SEC 2000
+#endif
+
+// 模拟电机数：按每板 CBOARD_MOTORS_PER_BOARD-1 个依次分配到 0 号板起的各板（全局 id 与实机编址一致），
+// 多于一板时需 SIM_TYPED_FRAMES。压力测试可设为 64 以上并将 SIM_UPDATE_HZ 提高到 1000
+#ifndef SIM_MOTORS
+#define SIM_MOTORS 2
+#endif
+// 电机模型步进频率（Hz），需为 SIM_UPDATE_HZ 的整数倍；状态帧与步进钩子仍按 SIM_UPDATE_HZ
+#ifndef SIM_PLANT_HZ
+#define SIM_PLANT_HZ 1000
+#endif
+// 电机模型参数（默认近似 M3508 转子侧加负载惯量，24 V 供电），反电动势常数由 Kt 推出
+#ifndef SIM_VBUS_MV
+#define SIM_VBUS_MV 24000
+#endif
+#ifndef SIM_R_MOHM
+#define SIM_R_MOHM 194
+#endif
+#ifndef SIM_KT_MNM_PER_A
+#define SIM_KT_MNM_PER_A 25
+#endif
+// 电流环闭环时间常数
+#ifndef SIM_TAU_I_US
+#define SIM_TAU_I_US 1000
+#endif
+// 转动惯量（g·cm²），各电机依次乘 1 / 1.25 / 1.5 / 1.75
+#ifndef SIM_J_GCM2
+#define SIM_J_GCM2 500
+#endif
+// 粘滞摩擦（µNm / 1000 rpm）与库仑摩擦（µNm）
+#ifndef SIM_B_UNM_PER_KRPM
+#define SIM_B_UNM_PER_KRPM 3300
+#endif
+#ifndef SIM_TC_UNM
+#define SIM_TC_UNM 10000
+#endif
+// 绕组热阻（mK/W）、热时间常数（s）与环境温度（°C）
+#ifndef SIM_RTH_MK_PER_W
+#define SIM_RTH_MK_PER_W 1200
+#endif
+#ifndef SIM_TAU_TH_S
+#define SIM_TAU_TH_S 300
+#endif
+#ifndef SIM_AMBIENT_C
+#define SIM_AMBIENT_C 30
+#endif
+// 仿真 C 板控制器：电流限幅（mA）、速度环 Kp（mA/rpm）与 Ki（mA/(rpm·s)）、
+// 位置环 Kp（rpm/计数，Q8）与速度参考上限（rpm）
+#ifndef SIM_CB_I_MAX_MA
+#define SIM_CB_I_MAX_MA 16000
+#endif
+#ifndef SIM_CB_SPEED_KP
+#define SIM_CB_SPEED_KP 40
+#endif
+#ifndef SIM_CB_SPEED_KI
+#define SIM_CB_SPEED_KI 4000
+#endif
+#ifndef SIM_CB_POS_KP_Q8
+#define SIM_CB_POS_KP_Q8 128
+#endif
+#ifndef SIM_CB_MAX_RPM
+#define SIM_CB_MAX_RPM 4000
+#endif
+
+// 模拟器输出的帧格式：1 = 类型化消息帧（状态 + 每秒一条板供电消息），0 = 旧的 0x55 状态帧
+#ifndef SIM_TYPED_FRAMES
+#define SIM_TYPED_FRAMES 1
+#endif
+
+// 批量差分遥测（需 SIM_TYPED_FRAMES）：每帧打包的连续样本数，0 = 每步一条 8 字节/电机的状态消息。
+// 样本率仍为 SIM_UPDATE_HZ，帧率降为 1/N；每 SIM_TELEM_KEYFRAME 帧一个关键帧（丢帧后最多等这么多帧恢复）
+#ifndef SIM_TELEM_BATCH
+#define SIM_TELEM_BATCH 0
+#endif
+#ifndef SIM_TELEM_KEYFRAME
+#define SIM_TELEM_KEYFRAME 16
+#endif
+
+// 尽可能快模式下每运行多少步让出 1 tick（喂看门狗）
+#ifndef SIM_FAST_YIELD_STEPS
+#define SIM_FAST_YIELD_STEPS 1000
+#endif
+
+// C 板链路字节级仿真（TEST_MODE）：默认关闭，模拟帧直接交给解析器；
+// 开启后模拟帧经仿真链路（分片/误码/丢字节/垃圾/限速）进入 serial_task 的真实接收路径
+#ifndef LINK_EMU_DEFAULT_ENABLED
+#define LINK_EMU_DEFAULT_ENABLED 0
+#endif
+
+#ifndef LINK_EMU_DEFAULT_BAUD
+#define LINK_EMU_DEFAULT_BAUD 115200
+#endif
+
+// 仿真链路缓冲大小（字节），超过波特率承载能力的数据在此溢出
+#ifndef LINK_EMU_BUF_SIZE
+#define LINK_EMU_BUF_SIZE 4096
+#endif
+
+// 仿真链路单帧上限：最长的类型化帧（帧头 6 + payload + 校验 1），批量遥测帧可达此长度
+#define LINK_EMU_MAX_FRAME (6 + CBOARD_MSG_MAX_PAYLOAD + 1)
+#define LINK_EMU_MAX_GARBAGE 64
+
+// C 板串口抓包分区名（见 partitions.csv）
+#ifndef CAPTURE_PARTITION_LABEL
+#define CAPTURE_PARTITION_LABEL "capture"
+#endif
+
+// 飞行记录仪（SPIFFS 分区，见 partitions.csv）
+#ifndef RECORDER_PARTITION_LABEL
+#define RECORDER_PARTITION_LABEL "recorder"
+#endif
+#ifndef RECORDER_BASE_PATH
+#define RECORDER_BASE_PATH "/rec"
+#endif
+// 分段文件大小：空间不足时按分段删除最旧数据
+#ifndef RECORDER_SEGMENT_SIZE
+#define RECORDER_SEGMENT_SIZE (64 * 1024)
+#endif
+// 保留时长：最新块早于该窗口的分段被删除（0 = 只按空闲空间删除）。
+// 没有实时时钟，按上电时间计龄，之前上电写入的分段从本次上电起计（停机时间不计）
+#ifndef RECORDER_RETENTION_HOURS
+#define RECORDER_RETENTION_HOURS 24
+#endif
+// 每个压缩块的样本数上限（<= 255）
+#ifndef RECORDER_BLOCK_SAMPLES
+#define RECORDER_BLOCK_SAMPLES 128
+#endif
+// 生产者到写入任务的队列深度（满时丢弃，不阻塞解析与发送）
+#ifndef RECORDER_QUEUE_LEN
+#define RECORDER_QUEUE_LEN 256
+#endif
+// 未满块与文件缓冲的最长落盘间隔
+#ifndef RECORDER_FLUSH_MS
+#define RECORDER_FLUSH_MS 10000
+#endif
+
+// HTTP 服务器 socket 数（需 <= CONFIG_LWIP_MAX_SOCKETS - 3）；
+// 服务器任务的栈、优先级与核心见 task_topology.c 中的任务拓扑表
+#ifndef HTTPD_MAX_SOCKETS
+#define HTTPD_MAX_SOCKETS 10
+#endif
+// 异步处理 worker 池大小（处理大页面与文件上传/下载）
+#ifndef HTTPD_ASYNC_WORKERS
+#define HTTPD_ASYNC_WORKERS 2
+#endif
+// worker 全忙时最多排队的异步请求数；再多则回 503（每个排队请求占用一个 socket）
+#ifndef HTTPD_ASYNC_QUEUE
+#define HTTPD_ASYNC_QUEUE 4
+#endif
+
+// 运动规划：设定点输出频率（200-1000 Hz）。2 个电机一帧 16 字节，
+// 250 Hz 约占 115200 波特率链路的 35%；TEST_MODE 下以模拟器频率 SIM_UPDATE_HZ 运行
+#ifndef MOTION_RATE_HZ
+#define MOTION_RATE_HZ 250
+#endif
+// 可同时规划的电机数
+#ifndef MOTION_MAX_AXES
+#define MOTION_MAX_AXES 8
+#endif
+// 默认运动限制（编码器计数，8192 计数/圈）：2 圈/s、8 圈/s²、64 圈/s³
+#ifndef MOTION_DEFAULT_VMAX
+#define MOTION_DEFAULT_VMAX 16384
+#endif
+#ifndef MOTION_DEFAULT_AMAX
+#define MOTION_DEFAULT_AMAX 65536
+#endif
+#ifndef MOTION_DEFAULT_JMAX
+#define MOTION_DEFAULT_JMAX 524288
+#endif
+// 单次移动的最长时长
+#ifndef MOTION_MAX_MOVE_MS
+#define MOTION_MAX_MOVE_MS 60000
+#endif
+
+// C 板链路：0 = UART1 点对点连接一块 C 板；1 = UART1 作为 RS-485 半双工总线，按地址轮询多块 C 板
+#ifndef CBOARD_BUS_RS485
+#define CBOARD_BUS_RS485 0
+#endif
+// 每块板的电机 id 空间（本地 id 1..N-1，需 <= 32），全局 id = 板号 * N + 本地 id
+#ifndef CBOARD_MOTORS_PER_BOARD
+#define CBOARD_MOTORS_PER_BOARD 16
+#endif
+// 板数上限（所有通道合计，需 <= 32 且 CBOARD_MAX_BOARDS * CBOARD_MOTORS_PER_BOARD <= 256）
+#ifndef CBOARD_MAX_BOARDS
+#define CBOARD_MAX_BOARDS 8
+#endif
+#ifndef CBOARD_RS485_BOARDS
+#define CBOARD_RS485_BOARDS 4
+#endif
+#ifndef CBOARD_RS485_DE_GPIO
+#define CBOARD_RS485_DE_GPIO 8
+#endif
+#ifndef CBOARD_RS485_BAUD
+#define CBOARD_RS485_BAUD 1000000
+#endif
+// 从机收到请求到开始应答的最长时间（含收发器切换）
+#ifndef CBOARD_RS485_TURNAROUND_US
+#define CBOARD_RS485_TURNAROUND_US 300
+#endif
+// 连续超时多少次视为离线；离线后每隔多少个轮询周期试探一次
+#ifndef CBOARD_RS485_OFFLINE_MISSES
+#define CBOARD_RS485_OFFLINE_MISSES 3
+#endif
+#ifndef CBOARD_RS485_OFFLINE_RETRY
+#define CBOARD_RS485_OFFLINE_RETRY 50
+#endif
+// 类型化消息帧的最大 payload（16 位长度字段；超出视为损坏的帧头，需小于通道接收缓冲 2048）
+#ifndef CBOARD_MSG_MAX_PAYLOAD
+#define CBOARD_MSG_MAX_PAYLOAD 1024
+#endif
+
+// Wi-Fi 上行：非空时以 AP+STA 模式运行，STA 接入该网络（如主机架的热点），用于多机架时间同步。
+// 各机架自身热点的网段需互不相同：192.168.<WIFI_AP_SUBNET>.1
+#ifndef WIFI_UPLINK_SSID
+#define WIFI_UPLINK_SSID ""
+#endif
+#ifndef WIFI_UPLINK_PASS
+#define WIFI_UPLINK_PASS ""
+#endif
+#ifndef WIFI_AP_SUBNET
+#define WIFI_AP_SUBNET 4
+#endif
+
+// 多机架时间同步（UDP）：启动角色 0=关闭 1=主机 2=从机（运行时可用 CLI `sync` 切换）
+#ifndef TIME_SYNC_ROLE
+#define TIME_SYNC_ROLE 0
+#endif
+#ifndef TIME_SYNC_MASTER_IP
+#define TIME_SYNC_MASTER_IP "192.168.4.1"
+#endif
+#ifndef TIME_SYNC_PORT
+#define TIME_SYNC_PORT 3190
+#endif
+// 从机请求间隔
+#ifndef TIME_SYNC_INTERVAL_MS
+#define TIME_SYNC_INTERVAL_MS 250
+#endif
+// 往返延迟超过近期最小值多少即丢弃该样本
+#ifndef TIME_SYNC_DELAY_SLACK_US
+#define TIME_SYNC_DELAY_SLACK_US 300
+#endif
+// 偏移与模型预测相差超过该值视为时钟跳变，重置模型
+#ifndef TIME_SYNC_STEP_US
+#define TIME_SYNC_STEP_US 10000
+#endif
+#ifndef TIME_SYNC_MAX_PEERS
+#define TIME_SYNC_MAX_PEERS 8
+#endif
+#ifndef TIME_SYNC_PEER_TIMEOUT_MS
+#define TIME_SYNC_PEER_TIMEOUT_MS 5000
+#endif
+// 主机下发“在 T 时刻启动预设”时的默认提前量
+#ifndef PRESET_START_LEAD_MS
+#define PRESET_START_LEAD_MS 500
+#endif
+
+// 上位机 UDP 二进制控制/遥测通道（协议见 udp_ctrl.h）
+#ifndef UDP_CTRL_ENABLE
+#define UDP_CTRL_ENABLE 1
+#endif
+#ifndef UDP_CTRL_PORT
+#define UDP_CTRL_PORT 3191
+#endif
+#ifndef UDP_CTRL_MAX_CLIENTS
+#define UDP_CTRL_MAX_CLIENTS 4
+#endif
+// 客户端在该时间内没有任何报文即被移除
+#ifndef UDP_CTRL_CLIENT_TIMEOUT_MS
+#define UDP_CTRL_CLIENT_TIMEOUT_MS 1000
+#endif
+// 客户端超时后把它置为速度模式的电机速度归零
+#ifndef UDP_CTRL_FAILSAFE
+#define UDP_CTRL_FAILSAFE 1
+#endif
+
+// 周期作业调度器：作业表容量（按键、预设、串口屏、滑块同步、速率调节、复位检测等）
+#ifndef SCHED_MAX_JOBS
+#define SCHED_MAX_JOBS 12
+#endif
+
+// 遥测总线：订阅者表容量（上位机 UDP、串口屏、滑块同步、复位检测等）
+#ifndef TELEM_BUS_MAX_SUBS
+#define TELEM_BUS_MAX_SUBS 6
+#endif
+// 由遥测触发的作业在遥测中断时的兜底刷新间隔
+#ifndef TELEM_BUS_FALLBACK_MS
+#define TELEM_BUS_FALLBACK_MS 1000
+#endif
+
+// 速率调节器：按观看者、模式与 CPU 余量调整显示/滑块同步/网页轮询周期（见 rate_gov.c 中的表）
+#ifndef RATE_GOV_ENABLE
+#define RATE_GOV_ENABLE 1
+#endif
+#ifndef RATE_GOV_PERIOD_MS
+#define RATE_GOV_PERIOD_MS 500
+#endif
+// 网页连接在该时间内没有轮询即不再计为观看者
+#ifndef RATE_GOV_VIEWER_TIMEOUT_MS
+#define RATE_GOV_VIEWER_TIMEOUT_MS 3000
+#endif
+#ifndef RATE_GOV_MAX_VIEWERS
+#define RATE_GOV_MAX_VIEWERS 8
+#endif
+// core 0 空闲占比低于该值时按比例放慢所有消费者
+#ifndef RATE_GOV_IDLE_LOW_PCT
+#define RATE_GOV_IDLE_LOW_PCT 25
+#endif
+
+// 遥测信号处理（telemetry_dsp）：EMA 系数 1/2^SHIFT、RMS 窗口样本数、可跟踪的电机数
+#ifndef TDSP_EMA_SHIFT
+#define TDSP_EMA_SHIFT 2
+#endif
+#ifndef TDSP_RMS_WINDOW
+#define TDSP_RMS_WINDOW 16
+#endif
+#ifndef TDSP_MAX_TRACKED
+#define TDSP_MAX_TRACKED 16
+#endif
+// 速度差分的最小时间间隔：约为最高遥测频率（1 kHz）的半个周期，
+// 同一读取块中解出的多帧时间戳几乎相同，差分推迟到间隔足够时
+#ifndef TDSP_MIN_DT_US
+#define TDSP_MIN_DT_US 500
+#endif
+
+// UART0 命令行（cli.c）：高速二进制设定点流需要提高波特率（上位机串口监视器同步修改）
+#ifndef CLI_UART_BAUD
+#define CLI_UART_BAUD 115200
+#endif
+// UART0 驱动接收缓冲：批量粘贴的脚本在命令执行期间暂存于此
+#ifndef CLI_UART_RX_BUF
+#define CLI_UART_RX_BUF 4096
+#endif
+#ifndef CLI_READ_CHUNK
+#define CLI_READ_CHUNK 256
+#endif
+#ifndef CLI_LINE_MAX
+#define CLI_LINE_MAX 128
+#endif
+#ifndef CLI_SCRIPT_BUF
+#define CLI_SCRIPT_BUF 2048
+#endif
+// 二进制模式：超过该时间没有完整帧即回到文本模式
+#ifndef CLI_BIN_IDLE_MS
+#define CLI_BIN_IDLE_MS 2000
+#endif
+// 一次读取内合并的不同电机数（超过时分批下发）
+#ifndef CLI_BIN_MAX_PENDING
+#define CLI_BIN_MAX_PENDING 16
+#endif
+
+// 设备自测基准（bench.c）：缺省/最大迭代次数
+#ifndef BENCH_DEFAULT_ITERS
+#define BENCH_DEFAULT_ITERS 1000
+#endif
+#ifndef BENCH_MAX_ITERS
+#define BENCH_MAX_ITERS 100000
+#endif
+
+// 启动阶段计时：最多记录的初始化步骤数
+#ifndef BOOT_PROF_MAX_STEPS
+#define BOOT_PROF_MAX_STEPS 24
+#endif
+
+// 串口屏趋势页：刷新周期（5–10 Hz）与速度（RPM）/电流（raw）满量程
+#ifndef DISP_TREND_PERIOD_MS
+#define DISP_TREND_PERIOD_MS 150
+#endif
+#ifndef DISP_TREND_SPEED_FS
+#define DISP_TREND_SPEED_FS 1000
+#endif
+#ifndef DISP_TREND_CURRENT_FS
+#define DISP_TREND_CURRENT_FS 10000
+#endif
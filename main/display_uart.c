@@ -27,16 +27,60 @@ static const char *TAG = "display_uart";
 #define DISP_TX_BUF_SIZE 1024
 #define DISP_RX_BUF_SIZE 256
 
+// 屏幕分辨率（趋势页布局用）
+#ifndef DISP_WIDTH
+#define DISP_WIDTH 220
+#endif
+#ifndef DISP_HEIGHT
+#define DISP_HEIGHT 176
+#endif
+
+// 趋势页布局：标题行下方上下两个绘图区（速度、电流），中线为 0
+#define TREND_HDR_H   20
+#define TREND_PLOT_H  ((DISP_HEIGHT - TREND_HDR_H - 6) / 2)
+#define TREND_SPD_TOP TREND_HDR_H
+#define TREND_SPD_BOT (TREND_SPD_TOP + TREND_PLOT_H - 1)
+#define TREND_CUR_TOP (TREND_SPD_BOT + 6)
+#define TREND_CUR_BOT (TREND_CUR_TOP + TREND_PLOT_H - 1)
+#define TREND_GAP     4  // 光标前擦除的列数（扫描式刷新的空隙）
+#define TREND_LABEL_EVERY 5 // 每隔几列刷新一次标题数值
+
+// 调色板索引
+#define COLOR_BG    0
+#define COLOR_RED   1
+#define COLOR_GREEN 2
+#define COLOR_GRID  8
+#define COLOR_TEXT  15
+
+static display_stats_t s_stats;
+
+// 趋势页状态：扫描式绘制，x 为下一列，写到右边缘后回到 0 覆盖最旧的数据
+typedef struct {
+	ui_page_t page;   // 当前屏幕上显示的页面
+	bool valid;       // 屏幕内容与 page 一致（否则需要整页重绘）
+	uint16_t x;
+	bool have_last;
+	int16_t last_spd_y;
+	int16_t last_cur_y;
+	uint32_t columns;
+} trend_state_t;
+
+static trend_state_t s_trend;
+
 // 发送低级字符串到屏幕（TEST_MODE 下仅打印）
 static esp_err_t display_send_raw(const char *s)
 {
 	if (!s) return ESP_ERR_INVALID_ARG;
 #if TEST_MODE
 	// 在测试模式下，直接打印要发送的指令（便于调试）
+	s_stats.bytes += (uint32_t)strlen(s);
+	s_stats.last_bytes = (uint32_t)strlen(s);
 	ESP_LOGI(TAG, "TEST_MODE: Display will send: %s", s);
 	return ESP_OK;
 #else
 	int len = strlen(s);
+	s_stats.bytes += (uint32_t)len;
+	s_stats.last_bytes = (uint32_t)len;
 	int w = uart_write_bytes(DISP_UART_NUM, s, len);
 	if (w != len) {
 		ESP_LOGW(TAG, "uart write partial (%d/%d)", w, len);
@@ -95,10 +139,9 @@ void display_init(void)
 	ESP_LOGI(TAG, "display_init (UART%d TX=%d RX=%d) TEST_MODE=%d", DISP_UART_NUM, DISP_TX_GPIO, DISP_RX_GPIO, TEST_MODE);
 }
 
-// 将电机状态与模式信息格式化为 JC 指令并发送
-void display_update(const motor_status_t* m1, const motor_status_t* m2, control_mode_t mode)
+// 将电机状态与模式信息格式化为 JC 指令，返回长度
+int display_format(char *buf, size_t size, const motor_status_t* m1, const motor_status_t* m2, control_mode_t mode)
 {
-	char buf[512];
 	const char *mode_names[] = {"MANUAL", "PRESET1", "PRESET2"};
 	const char *mode_str = "?";
 	if ((int)mode >= 0 && (int)mode < 3) mode_str = mode_names[mode];
@@ -110,34 +153,125 @@ void display_update(const motor_status_t* m1, const motor_status_t* m2, control_
 	// 行3: Motor2 ...
 
 	int n = 0;
-	n += snprintf(buf + n, sizeof(buf) - n, "DIR(0);CLR(0);");
+	n += snprintf(buf + n, size - n, "DIR(0);CLR(0);");
 	// 显示模式
-	n += snprintf(buf + n, sizeof(buf) - n, "DC16(5,5,'Mode:%s',15);", mode_str);
+	n += snprintf(buf + n, size - n, "DC16(5,5,'Mode:%s',15);", mode_str);
 
 	if (m1) {
 		// angle 0..8191 -> display raw
-		n += snprintf(buf + n, sizeof(buf) - n, "DC16(5,25,'M1 A:%u',15);", (unsigned int)m1->angle);
-		n += snprintf(buf + n, sizeof(buf) - n, "DC16(90,25,'S:%d',15);", (int)m1->speed);
-		n += snprintf(buf + n, sizeof(buf) - n, "DC16(5,45,'I:%d',15);", (int)m1->current);
-		n += snprintf(buf + n, sizeof(buf) - n, "DC16(90,45,'T:%uC',15);", (unsigned int)m1->temperature);
+		n += snprintf(buf + n, size - n, "DC16(5,25,'M1 A:%u',15);", (unsigned int)m1->angle);
+		n += snprintf(buf + n, size - n, "DC16(90,25,'S:%d',15);", (int)m1->speed);
+		n += snprintf(buf + n, size - n, "DC16(5,45,'I:%d',15);", (int)m1->current);
+		n += snprintf(buf + n, size - n, "DC16(90,45,'T:%uC',15);", (unsigned int)m1->temperature);
 	}
 	if (m2) {
-		n += snprintf(buf + n, sizeof(buf) - n, "DC16(5,65,'M2 A:%u',15);", (unsigned int)m2->angle);
-		n += snprintf(buf + n, sizeof(buf) - n, "DC16(90,65,'S:%d',15);", (int)m2->speed);
-		n += snprintf(buf + n, sizeof(buf) - n, "DC16(5,85,'I:%d',15);", (int)m2->current);
-		n += snprintf(buf + n, sizeof(buf) - n, "DC16(90,85,'T:%uC',15);", (unsigned int)m2->temperature);
+		n += snprintf(buf + n, size - n, "DC16(5,65,'M2 A:%u',15);", (unsigned int)m2->angle);
+		n += snprintf(buf + n, size - n, "DC16(90,65,'S:%d',15);", (int)m2->speed);
+		n += snprintf(buf + n, size - n, "DC16(5,85,'I:%d',15);", (int)m2->current);
+		n += snprintf(buf + n, size - n, "DC16(90,85,'T:%uC',15);", (unsigned int)m2->temperature);
 	}
 
 	// 最后发送背光设置为中等亮度（示例）并结束行结束符
-	n += snprintf(buf + n, sizeof(buf) - n, "BL(100);\r\n");
+	n += snprintf(buf + n, size - n, "BL(100);\r\n");
+	return n;
+}
 
-	// 发送
+// 格式化并发送
+void display_update(const motor_status_t* m1, const motor_status_t* m2, control_mode_t mode)
+{
+	char buf[512];
+	display_format(buf, sizeof(buf), m1, m2, mode);
 	display_send_raw(buf);
 
 	// 等待模块准备好（非必须）
 	display_wait_ok(200);
 }
 
+// 数值 -> 绘图区纵坐标（满量程 fs 对应半个绘图区高度，超出时限幅）
+static int16_t trend_y(int32_t v, int32_t fs, int top, int bot)
+{
+	int mid = (top + bot) / 2;
+	int half = (bot - top) / 2;
+	if (v > fs) v = fs;
+	if (v < -fs) v = -fs;
+	return (int16_t)(mid - v * half / fs);
+}
+
+// 整页重绘：清屏、标题与零线。只在切换到趋势页时发送一次
+static void trend_redraw(uint8_t motor_id)
+{
+	char buf[192];
+	int zs = (TREND_SPD_TOP + TREND_SPD_BOT) / 2;
+	int zc = (TREND_CUR_TOP + TREND_CUR_BOT) / 2;
+	snprintf(buf, sizeof(buf),
+			 "DIR(0);CLR(%d);DC16(2,2,'M%u trend',%d);PL(0,%d,%d,%d,%d);PL(0,%d,%d,%d,%d);BL(100);\r\n",
+			 COLOR_BG, motor_id, COLOR_TEXT, zs, DISP_WIDTH - 1, zs, COLOR_GRID, zc, DISP_WIDTH - 1, zc, COLOR_GRID);
+	display_send_raw(buf);
+	s_stats.full_redraws++;
+}
+
+// 追加一列：擦除光标前的空隙，补画零线像素，用线段连接上一列与本列（速度绿、电流红）。
+// 每次约 120 字节，与绘图宽度无关
+static void trend_column(const motor_status_t *m)
+{
+	char buf[256];
+	int n = 0;
+	int x = s_trend.x;
+	int xe = x + TREND_GAP < DISP_WIDTH ? x + TREND_GAP : DISP_WIDTH - 1;
+	int zs = (TREND_SPD_TOP + TREND_SPD_BOT) / 2;
+	int zc = (TREND_CUR_TOP + TREND_CUR_BOT) / 2;
+	int16_t ys = trend_y(m->speed, DISP_TREND_SPEED_FS, TREND_SPD_TOP, TREND_SPD_BOT);
+	int16_t yc = trend_y(m->current, DISP_TREND_CURRENT_FS, TREND_CUR_TOP, TREND_CUR_BOT);
+
+	n += snprintf(buf + n, sizeof(buf) - n, "BOXF(%d,%d,%d,%d,%d);BOXF(%d,%d,%d,%d,%d);PS(%d,%d,%d);PS(%d,%d,%d);",
+				  x, TREND_SPD_TOP, xe, TREND_SPD_BOT, COLOR_BG, x, TREND_CUR_TOP, xe, TREND_CUR_BOT, COLOR_BG,
+				  x, zs, COLOR_GRID, x, zc, COLOR_GRID);
+	if (s_trend.have_last && x > 0) {
+		n += snprintf(buf + n, sizeof(buf) - n, "PL(%d,%d,%d,%d,%d);PL(%d,%d,%d,%d,%d);",
+					  x - 1, s_trend.last_spd_y, x, ys, COLOR_GREEN, x - 1, s_trend.last_cur_y, x, yc, COLOR_RED);
+	} else {
+		n += snprintf(buf + n, sizeof(buf) - n, "PS(%d,%d,%d);PS(%d,%d,%d);", x, ys, COLOR_GREEN, x, yc, COLOR_RED);
+	}
+	if (s_trend.columns % TREND_LABEL_EVERY == 0) {
+		n += snprintf(buf + n, sizeof(buf) - n, "DC16(80,2,'S:%-6d I:%-6d',%d);", (int)m->speed, (int)m->current,
+					  COLOR_TEXT);
+	}
+	snprintf(buf + n, sizeof(buf) - n, "\r\n");
+	display_send_raw(buf);
+
+	s_trend.last_spd_y = ys;
+	s_trend.last_cur_y = yc;
+	s_trend.have_last = true;
+	s_trend.columns++;
+	s_trend.x = (uint16_t)((x + 1) % DISP_WIDTH);
+}
+
+void display_show(ui_page_t page, const motor_status_t* m1, const motor_status_t* m2, control_mode_t mode)
+{
+	s_stats.refreshes++;
+	if (page == UI_PAGE_NUMBERS || page >= UI_PAGE_COUNT) {
+		s_trend.valid = false;
+		display_update(m1, m2, mode);
+		return;
+	}
+	uint8_t motor_id = page == UI_PAGE_TREND_M1 ? 1 : 2;
+	const motor_status_t *m = motor_id == 1 ? m1 : m2;
+	if (!s_trend.valid || s_trend.page != page) {
+		trend_redraw(motor_id);
+		s_trend = (trend_state_t){ .page = page, .valid = true };
+		display_wait_ok(200);
+	}
+	if (!m) return; // 尚无遥测：不画列，时间轴暂停
+	trend_column(m);
+	// 趋势页刷新快，只短暂等待屏幕应答
+	display_wait_ok(50);
+}
+
+void display_get_stats(display_stats_t *out)
+{
+	if (out) *out = s_stats;
+}
+
 void display_refresh_now(void)
 {
 	// 便捷函数：读取当前状态并刷新
@@ -2,6 +2,7 @@
 #define DISPLAY_UART_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "serial_cboard.h"
 #include "ui_state.h"
 
@@ -13,6 +14,23 @@ void display_init(void);
 // 更新显示：展示两个电机状态与当前控制模式
 void display_update(const motor_status_t* m1, const motor_status_t* m2, control_mode_t mode);
 
+// 只格式化不发送（自测基准用）；返回写入长度
+int display_format(char *buf, size_t size, const motor_status_t* m1, const motor_status_t* m2, control_mode_t mode);
+
+// 按页面刷新：数值页同 display_update（整屏重绘）；
+// 趋势页（ui_page_t）切换时整页重绘一次，之后每次只追加最新一列（扫描式，写到右边缘后回绕），
+// 每次发送的字节数与绘图宽度无关，5–10 Hz 刷新只占串口屏链路的一小部分
+void display_show(ui_page_t page, const motor_status_t* m1, const motor_status_t* m2, control_mode_t mode);
+
+typedef struct {
+	uint32_t refreshes;
+	uint32_t full_redraws;  // 趋势页整页重绘次数
+	uint32_t bytes;         // 发送给屏幕的总字节数
+	uint32_t last_bytes;    // 最近一次发送的字节数
+} display_stats_t;
+
+void display_get_stats(display_stats_t *out);
+
 // 在需要时可调用以强制刷新（同 display_update 功能）
 void display_refresh_now(void);
 
@@ -0,0 +1,518 @@
+#include "flight_recorder.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_spiffs.h"
+#include "config.h"
+#include "task_topology.h"
+#include "mem_budget.h"
+
+static const char *TAG = "recorder";
+
+// 队列条目：生产者只做一次拷贝
+typedef struct {
+	int64_t t_us;
+	uint8_t type;
+	uint8_t id;
+	uint8_t u8;   // 遥测: temperature；命令: control_mode
+	int16_t f0;   // 遥测: angle；命令: target_speed
+	int16_t f1;   // 遥测: speed；命令: target_position
+	int16_t f2;   // 遥测: current
+} rec_item_t;
+
+// 块构建器（列式暂存）
+typedef struct {
+	uint8_t type;
+	uint16_t count;
+	int64_t t_us[RECORDER_BLOCK_SAMPLES];
+	uint8_t id[RECORDER_BLOCK_SAMPLES];
+	uint8_t u8[RECORDER_BLOCK_SAMPLES];
+	int16_t f0[RECORDER_BLOCK_SAMPLES];
+	int16_t f1[RECORDER_BLOCK_SAMPLES];
+	int16_t f2[RECORDER_BLOCK_SAMPLES];
+} block_t;
+
+// 最坏情况：time 5 字节 + id/u8 各 1 字节 + 3 列 delta 各 3 字节
+#define BLOCK_MAX_BYTES (RECORDER_BLOCK_HDR + RECORDER_BLOCK_SAMPLES * (5 + 1 + 1 + 3 * 3))
+
+static QueueHandle_t s_queue = NULL;
+static StaticQueue_t s_queue_buf;
+static uint8_t s_queue_storage[RECORDER_QUEUE_LEN * sizeof(rec_item_t)];
+static TaskHandle_t s_writer = NULL;
+static volatile bool s_flush_req = false;
+static bool s_mounted = false;
+static uint32_t s_session = 0;
+
+static block_t s_tel_block = { .type = RECORDER_TYPE_TELEMETRY };
+static block_t s_cmd_block = { .type = RECORDER_TYPE_COMMAND };
+static uint8_t s_out[BLOCK_MAX_BYTES];
+
+// 分段文件：seg%06lu.bin，编号递增；[s_seg_min, s_seg_cur] 为现存范围
+static FILE *s_file = NULL;
+static uint32_t s_seg_min = 0;
+static uint32_t s_seg_cur = 0;
+static size_t s_seg_size = 0;
+
+static recorder_stats_t s_stats;
+
+// ---- 编码工具 ----
+
+static inline uint32_t zigzag(int32_t v)
+{
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v)
+{
+	return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static inline uint8_t *put_uvarint(uint8_t *p, uint32_t v)
+{
+	while (v >= 0x80) {
+		*p++ = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (uint8_t)v;
+	return p;
+}
+
+static inline const uint8_t *get_uvarint(const uint8_t *p, const uint8_t *end, uint32_t *out)
+{
+	uint32_t v = 0;
+	int shift = 0;
+	while (p < end && shift < 35) {
+		uint8_t b = *p++;
+		v |= (uint32_t)(b & 0x7F) << shift;
+		if (!(b & 0x80)) {
+			*out = v;
+			return p;
+		}
+		shift += 7;
+	}
+	return NULL;
+}
+
+static inline void put_le(uint8_t *p, uint64_t v, int n)
+{
+	for (int i = 0; i < n; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline uint64_t get_le(const uint8_t *p, int n)
+{
+	uint64_t v = 0;
+	for (int i = 0; i < n; ++i) v |= (uint64_t)p[i] << (8 * i);
+	return v;
+}
+
+// 编码一列：相对同一电机在本块内上一个值的 delta；wrap 为 true 时按 0..8191 编码器环绕
+static uint8_t *put_delta_column(uint8_t *p, const block_t *b, const int16_t *vals, bool wrap)
+{
+	int16_t prev[256] = { 0 };
+	for (uint16_t i = 0; i < b->count; ++i) {
+		int32_t d = (int32_t)vals[i] - prev[b->id[i]];
+		if (wrap) {
+			d &= 8191;
+			if (d >= 4096) d -= 8192;
+		}
+		p = put_uvarint(p, zigzag(d));
+		prev[b->id[i]] = vals[i];
+	}
+	return p;
+}
+
+static const uint8_t *get_delta_column(const uint8_t *p, const uint8_t *end, block_t *b, int16_t *vals, bool wrap)
+{
+	int16_t prev[256] = { 0 };
+	for (uint16_t i = 0; i < b->count && p; ++i) {
+		uint32_t z;
+		p = get_uvarint(p, end, &z);
+		if (!p) break;
+		int32_t v = prev[b->id[i]] + unzigzag(z);
+		if (wrap) v &= 8191;
+		vals[i] = (int16_t)v;
+		prev[b->id[i]] = vals[i];
+	}
+	return p;
+}
+
+// 将块编码到 s_out，返回总字节数（含块头）
+static size_t encode_block(const block_t *b)
+{
+	uint8_t *p = s_out + RECORDER_BLOCK_HDR;
+	int64_t prev_t = b->t_us[0];
+	for (uint16_t i = 0; i < b->count; ++i) {
+		p = put_uvarint(p, (uint32_t)(b->t_us[i] - prev_t));
+		prev_t = b->t_us[i];
+	}
+	memcpy(p, b->id, b->count);
+	p += b->count;
+	if (b->type == RECORDER_TYPE_TELEMETRY) {
+		p = put_delta_column(p, b, b->f0, true);   // angle
+		p = put_delta_column(p, b, b->f1, false);  // speed
+		p = put_delta_column(p, b, b->f2, false);  // current
+		int16_t tmp[RECORDER_BLOCK_SAMPLES];
+		for (uint16_t i = 0; i < b->count; ++i) tmp[i] = b->u8[i];
+		p = put_delta_column(p, b, tmp, false);    // temperature
+	} else {
+		memcpy(p, b->u8, b->count);                // mode
+		p += b->count;
+		p = put_delta_column(p, b, b->f0, false);  // speed
+		p = put_delta_column(p, b, b->f1, false);  // position
+	}
+	size_t payload = (size_t)(p - (s_out + RECORDER_BLOCK_HDR));
+	uint32_t span_ms = (uint32_t)((b->t_us[b->count - 1] - b->t_us[0]) / 1000);
+	put_le(s_out + 0, RECORDER_BLOCK_MAGIC, 2);
+	s_out[2] = b->type;
+	s_out[3] = (uint8_t)b->count;
+	put_le(s_out + 4, s_session, 4);
+	put_le(s_out + 8, (uint64_t)b->t_us[0], 8);
+	put_le(s_out + 16, span_ms, 4);
+	put_le(s_out + 20, payload, 2);
+	return RECORDER_BLOCK_HDR + payload;
+}
+
+// 解码块 payload 到 b（块头已解析出 type/count），失败返回 false
+static bool decode_block(const uint8_t *hdr, const uint8_t *payload, size_t len, block_t *b)
+{
+	const uint8_t *p = payload, *end = payload + len;
+	b->type = hdr[2];
+	b->count = hdr[3];
+	if (b->count == 0 || b->count > RECORDER_BLOCK_SAMPLES) return false;
+	int64_t t = (int64_t)get_le(hdr + 8, 8);
+	for (uint16_t i = 0; i < b->count; ++i) {
+		uint32_t d;
+		if (!(p = get_uvarint(p, end, &d))) return false;
+		t += d;
+		b->t_us[i] = t;
+	}
+	if (p + b->count > end) return false;
+	memcpy(b->id, p, b->count);
+	p += b->count;
+	if (b->type == RECORDER_TYPE_TELEMETRY) {
+		int16_t tmp[RECORDER_BLOCK_SAMPLES];
+		p = get_delta_column(p, end, b, b->f0, true);
+		if (p) p = get_delta_column(p, end, b, b->f1, false);
+		if (p) p = get_delta_column(p, end, b, b->f2, false);
+		if (p) p = get_delta_column(p, end, b, tmp, false);
+		if (!p) return false;
+		for (uint16_t i = 0; i < b->count; ++i) b->u8[i] = (uint8_t)tmp[i];
+	} else if (b->type == RECORDER_TYPE_COMMAND) {
+		if (p + b->count > end) return false;
+		memcpy(b->u8, p, b->count);
+		p += b->count;
+		p = get_delta_column(p, end, b, b->f0, false);
+		if (p) p = get_delta_column(p, end, b, b->f1, false);
+		if (!p) return false;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+// ---- 分段文件管理（仅写入任务调用） ----
+
+static void segment_path(char *buf, size_t len, uint32_t idx)
+{
+	snprintf(buf, len, RECORDER_BASE_PATH "/seg%06lu.bin", (unsigned long)idx);
+}
+
+#if RECORDER_RETENTION_HOURS > 0
+// 最旧分段的最新块时刻（缓存：已关闭的分段不再变化）
+static uint32_t s_age_idx = UINT32_MAX;
+static int64_t s_age_newest_us;
+
+// 分段中本会话最新块的时刻（本次上电的时钟）；之前上电写入的块无法换算，按 0（本次上电时刻）计。
+// 只读块头，按 payload 长度跳过块体；打不开（如下载占满文件句柄）返回 -1，下次再试
+static int64_t segment_newest_us(uint32_t idx)
+{
+	char path[40];
+	segment_path(path, sizeof(path), idx);
+	FILE *f = fopen(path, "rb");
+	if (!f) return -1;
+	int64_t newest = 0;
+	uint8_t hdr[RECORDER_BLOCK_HDR];
+	while (fread(hdr, 1, sizeof(hdr), f) == sizeof(hdr) && get_le(hdr, 2) == RECORDER_BLOCK_MAGIC) {
+		if ((uint32_t)get_le(hdr + 4, 4) == s_session) {
+			int64_t t = (int64_t)get_le(hdr + 8, 8) + (int64_t)get_le(hdr + 16, 4) * 1000;
+			if (t > newest) newest = t;
+		}
+		if (fseek(f, (long)get_le(hdr + 20, 2), SEEK_CUR) != 0) break;
+	}
+	fclose(f);
+	return newest;
+}
+#endif
+
+// 分段的最新块是否已超出保留时长
+static bool segment_expired(uint32_t idx)
+{
+#if RECORDER_RETENTION_HOURS > 0
+	if (idx != s_age_idx) {
+		int64_t t = segment_newest_us(idx);
+		if (t < 0) return false;
+		s_age_newest_us = t;
+		s_age_idx = idx;
+	}
+	return esp_timer_get_time() - s_age_newest_us > (int64_t)RECORDER_RETENTION_HOURS * 3600 * 1000000;
+#else
+	(void)idx;
+	return false;
+#endif
+}
+
+// 删除超出保留时长的分段；空闲空间不足时继续删除最旧分段，保证可以再写入两个分段。
+// 正在写入的分段不删
+static void enforce_retention(void)
+{
+	while (s_seg_min < s_seg_cur) {
+		size_t total = 0, used = 0;
+		bool low = esp_spiffs_info(RECORDER_PARTITION_LABEL, &total, &used) == ESP_OK &&
+				   total - used < 2 * RECORDER_SEGMENT_SIZE;
+		if (!low && !segment_expired(s_seg_min)) break;
+		char path[40];
+		segment_path(path, sizeof(path), s_seg_min);
+		unlink(path);
+		s_seg_min++;
+		s_stats.segments_deleted++;
+	}
+}
+
+static void open_next_segment(void)
+{
+	if (s_file) {
+		fclose(s_file);
+		s_file = NULL;
+		s_seg_cur++;
+	}
+	enforce_retention();
+	char path[40];
+	segment_path(path, sizeof(path), s_seg_cur);
+	s_file = fopen(path, "ab");
+	s_seg_size = 0;
+	if (!s_file) ESP_LOGE(TAG, "cannot open %s", path);
+}
+
+static void write_block(block_t *b)
+{
+	if (b->count == 0) return;
+	size_t n = encode_block(b);
+	if (!s_file || s_seg_size + n > RECORDER_SEGMENT_SIZE) open_next_segment();
+	if (s_file && fwrite(s_out, 1, n, s_file) == n) {
+		s_seg_size += n;
+		s_stats.blocks++;
+		s_stats.bytes_written += n;
+	}
+	b->count = 0;
+}
+
+static void block_add(block_t *b, const rec_item_t *it)
+{
+	uint16_t i = b->count++;
+	b->t_us[i] = it->t_us;
+	b->id[i] = it->id;
+	b->u8[i] = it->u8;
+	b->f0[i] = it->f0;
+	b->f1[i] = it->f1;
+	b->f2[i] = it->f2;
+	if (b->count >= RECORDER_BLOCK_SAMPLES) write_block(b);
+}
+
+// 后台写入任务：攒块压缩；文件缓冲按 RECORDER_FLUSH_MS 周期落盘，使 flash 写入少而集中
+static void recorder_task(void *arg)
+{
+	(void)arg;
+	int64_t last_flush = esp_timer_get_time();
+	rec_item_t it;
+	while (1) {
+		if (xQueueReceive(s_queue, &it, pdMS_TO_TICKS(1000)) == pdTRUE) {
+			block_add(it.type == RECORDER_TYPE_TELEMETRY ? &s_tel_block : &s_cmd_block, &it);
+		}
+		int64_t now = esp_timer_get_time();
+		if (s_flush_req || now - last_flush >= (int64_t)RECORDER_FLUSH_MS * 1000) {
+			s_flush_req = false;
+			last_flush = now;
+			write_block(&s_tel_block);
+			write_block(&s_cmd_block);
+			if (s_file) fflush(s_file);
+			enforce_retention(); // 写入停顿时旧分段同样按时长过期
+		}
+	}
+}
+
+void recorder_init(void)
+{
+	s_session = esp_random();
+	s_stats.session = s_session;
+	esp_vfs_spiffs_conf_t conf = {
+		.base_path = RECORDER_BASE_PATH,
+		.partition_label = RECORDER_PARTITION_LABEL,
+		.max_files = 4,
+		.format_if_mount_failed = true,
+	};
+	esp_err_t err = esp_vfs_spiffs_register(&conf);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "mount '%s' failed (%s), recorder disabled", RECORDER_PARTITION_LABEL, esp_err_to_name(err));
+		return;
+	}
+	s_mounted = true;
+
+	// 扫描已有分段，续写在最新分段之后
+	bool any = false;
+	DIR *dir = opendir(RECORDER_BASE_PATH);
+	if (dir) {
+		struct dirent *de;
+		while ((de = readdir(dir)) != NULL) {
+			unsigned long idx;
+			if (sscanf(de->d_name, "seg%06lu.bin", &idx) != 1) continue;
+			if (!any || idx < s_seg_min) s_seg_min = (uint32_t)idx;
+			if (!any || idx > s_seg_cur) s_seg_cur = (uint32_t)idx;
+			any = true;
+		}
+		closedir(dir);
+	}
+	if (any) s_seg_cur++; // 每次上电开启新分段
+
+	s_queue = xQueueCreateStatic(RECORDER_QUEUE_LEN, sizeof(rec_item_t), s_queue_storage, &s_queue_buf);
+	mem_budget_add("recorder", "sample queue", sizeof(s_queue_storage));
+	mem_budget_add("recorder", "block buffers", sizeof(s_out) + sizeof(s_tel_block) + sizeof(s_cmd_block));
+	task_topology_create(TASK_ID_RECORDER, recorder_task, NULL, &s_writer, NULL);
+	ESP_LOGI(TAG, "recorder mounted at %s, segments %lu..%lu, session %08lx", RECORDER_BASE_PATH,
+			 (unsigned long)s_seg_min, (unsigned long)s_seg_cur, (unsigned long)s_session);
+}
+
+void recorder_log_telemetry(const motor_status_t *st)
+{
+	if (!s_queue || !st) return;
+	rec_item_t it = {
+		.t_us = esp_timer_get_time(),
+		.type = RECORDER_TYPE_TELEMETRY,
+		.id = st->motor_id,
+		.u8 = st->temperature,
+		.f0 = (int16_t)st->angle,
+		.f1 = st->speed,
+		.f2 = st->current,
+	};
+	if (xQueueSend(s_queue, &it, 0) == pdTRUE) {
+		s_stats.samples++;
+		s_stats.raw_bytes += 8;
+	} else {
+		s_stats.dropped++;
+	}
+}
+
+void recorder_log_commands(const motor_command_t *cmds, size_t count)
+{
+	if (!s_queue || !cmds) return;
+	int64_t now = esp_timer_get_time();
+	for (size_t i = 0; i < count; ++i) {
+		rec_item_t it = {
+			.t_us = now,
+			.type = RECORDER_TYPE_COMMAND,
+			.id = cmds[i].motor_id,
+			.u8 = cmds[i].control_mode,
+			.f0 = cmds[i].target_speed,
+			.f1 = cmds[i].target_position,
+		};
+		if (xQueueSend(s_queue, &it, 0) == pdTRUE) {
+			s_stats.commands++;
+			s_stats.raw_bytes += 6;
+		} else {
+			s_stats.dropped++;
+		}
+	}
+}
+
+void recorder_flush(void)
+{
+	s_flush_req = true;
+}
+
+// 逐块输出 CSV 行（只输出时间范围内的样本）
+static esp_err_t emit_csv(const block_t *b, uint32_t session, uint32_t from_ms, uint32_t to_ms,
+						  recorder_sink_t sink, void *ctx)
+{
+	char line[96];
+	for (uint16_t i = 0; i < b->count; ++i) {
+		int64_t t_ms = b->t_us[i] / 1000;
+		if (t_ms < from_ms || t_ms > to_ms) continue;
+		int n;
+		if (b->type == RECORDER_TYPE_TELEMETRY) {
+			n = snprintf(line, sizeof(line), "T,%08lx,%lld,%u,%u,%d,%d,%u\n", (unsigned long)session,
+						 (long long)b->t_us[i], b->id[i], (unsigned)(uint16_t)b->f0[i], b->f1[i], b->f2[i], b->u8[i]);
+		} else {
+			n = snprintf(line, sizeof(line), "C,%08lx,%lld,%u,%u,%d,%d,\n", (unsigned long)session,
+						 (long long)b->t_us[i], b->id[i], b->u8[i], b->f0[i], b->f1[i]);
+		}
+		esp_err_t err = sink(ctx, line, (size_t)n);
+		if (err != ESP_OK) return err;
+	}
+	return ESP_OK;
+}
+
+esp_err_t recorder_stream(uint32_t session, uint32_t from_ms, uint32_t to_ms, recorder_fmt_t fmt,
+						  recorder_sink_t sink, void *ctx)
+{
+	if (!s_mounted) return ESP_ERR_INVALID_STATE;
+	if (!sink) return ESP_ERR_INVALID_ARG;
+	// 每个下载请求只持有一个块的原始数据与解码结果
+	uint8_t *buf = malloc(BLOCK_MAX_BYTES);
+	block_t *blk = (fmt == RECORDER_FMT_CSV) ? malloc(sizeof(block_t)) : NULL;
+	if (!buf || (fmt == RECORDER_FMT_CSV && !blk)) {
+		free(buf);
+		free(blk);
+		return ESP_ERR_NO_MEM;
+	}
+	esp_err_t err = ESP_OK;
+	if (fmt == RECORDER_FMT_CSV) {
+		static const char hdr[] = "kind,session,t_us,id,angle|mode,speed,current|pos,temp\n";
+		err = sink(ctx, hdr, sizeof(hdr) - 1);
+	}
+	recorder_flush();
+
+	for (uint32_t idx = s_seg_min; err == ESP_OK && idx <= s_seg_cur; ++idx) {
+		char path[40];
+		segment_path(path, sizeof(path), idx);
+		FILE *f = fopen(path, "rb");
+		if (!f) continue;
+		while (err == ESP_OK && fread(buf, 1, RECORDER_BLOCK_HDR, f) == RECORDER_BLOCK_HDR) {
+			if (get_le(buf, 2) != RECORDER_BLOCK_MAGIC) break; // 损坏：跳过本分段剩余部分
+			size_t payload = (size_t)get_le(buf + 20, 2);
+			if (RECORDER_BLOCK_HDR + payload > BLOCK_MAX_BYTES) break;
+			uint32_t blk_session = (uint32_t)get_le(buf + 4, 4);
+			uint32_t t0_ms = (uint32_t)(get_le(buf + 8, 8) / 1000);
+			uint32_t span_ms = (uint32_t)get_le(buf + 16, 4);
+			bool match = (session == 0 || session == blk_session) && t0_ms <= to_ms && t0_ms + span_ms >= from_ms;
+			if (!match) {
+				if (fseek(f, (long)payload, SEEK_CUR) != 0) break;
+				continue;
+			}
+			if (fread(buf + RECORDER_BLOCK_HDR, 1, payload, f) != payload) break;
+			if (fmt == RECORDER_FMT_RAW) {
+				err = sink(ctx, (const char *)buf, RECORDER_BLOCK_HDR + payload);
+			} else if (decode_block(buf, buf + RECORDER_BLOCK_HDR, payload, blk)) {
+				err = emit_csv(blk, blk_session, from_ms, to_ms, sink, ctx);
+			}
+		}
+		fclose(f);
+	}
+	free(buf);
+	free(blk);
+	return err;
+}
+
+void recorder_get_stats(recorder_stats_t *out)
+{
+	if (!out) return;
+	*out = s_stats;
+	out->mounted = s_mounted;
+	if (s_mounted) esp_spiffs_info(RECORDER_PARTITION_LABEL, &out->fs_total, &out->fs_used);
+}
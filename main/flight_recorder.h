@@ -0,0 +1,63 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "serial_cboard.h"
+
+// 飞行记录仪：将每个遥测样本与每条下发命令持久化到 SPIFFS 分区，保留最近若干小时。
+// 生产者（解析器 / 发送路径）只做一次非阻塞入队；后台写入任务把样本攒成块，
+// 按列做 delta + zigzag-varint 压缩后追加到分段文件，空间不足时删除最旧分段。
+//
+// 块格式（小端）：
+//   [u16 magic 0x5246][u8 type][u8 count][u32 session][u64 t0_us][u32 span_ms][u16 payload_len][payload]
+// 遥测 payload 列：time_delta_us, id, angle_delta(环绕), speed_delta, current_delta, temp_delta
+// 命令 payload 列：time_delta_us, id, mode, speed_delta, pos_delta
+// 除 time/id/mode 外，delta 均相对同一电机在本块中的上一个样本，按 zigzag-varint 编码。
+
+#define RECORDER_BLOCK_MAGIC   0x5246
+#define RECORDER_BLOCK_HDR     22
+#define RECORDER_TYPE_TELEMETRY 1
+#define RECORDER_TYPE_COMMAND   2
+
+typedef enum {
+	RECORDER_FMT_RAW = 0, // 原样输出压缩块（客户端解码）
+	RECORDER_FMT_CSV,     // 设备端逐块解码为 CSV
+} recorder_fmt_t;
+
+typedef struct {
+	bool mounted;
+	uint32_t session;        // 本次上电的会话 ID
+	uint32_t samples;        // 已入队的遥测样本数
+	uint32_t commands;       // 已入队的命令数
+	uint32_t dropped;        // 队列满被丢弃的条目数
+	uint32_t blocks;         // 已写入的块数
+	uint32_t bytes_written;  // 已写入的压缩字节数
+	uint32_t raw_bytes;      // 对应的未压缩字节数（8 字节/样本）
+	uint32_t segments_deleted; // 因空间不足或超出保留时长删除的分段数
+	size_t fs_total;
+	size_t fs_used;
+} recorder_stats_t;
+
+// 下载输出回调：返回 ESP_OK 继续，其它值中止
+typedef esp_err_t (*recorder_sink_t)(void *ctx, const char *data, size_t len);
+
+// 挂载分区并启动后台写入任务
+void recorder_init(void);
+
+// 由解析器 / 发送路径调用：非阻塞入队，队列满时丢弃并计数
+void recorder_log_telemetry(const motor_status_t *st);
+void recorder_log_commands(const motor_command_t *cmds, size_t count);
+
+// 按时间范围（自启动以来的毫秒，session=0 表示所有会话）逐块输出记录，
+// 每次只在内存中持有一个块。RAW 格式输出与范围相交的完整块，CSV 格式逐样本过滤
+esp_err_t recorder_stream(uint32_t session, uint32_t from_ms, uint32_t to_ms, recorder_fmt_t fmt,
+						  recorder_sink_t sink, void *ctx);
+
+// 请求写入任务把未满的块与文件缓冲立即落盘
+void recorder_flush(void);
+
+void recorder_get_stats(recorder_stats_t *out);
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,201 @@
+#include "link_emu.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/stream_buffer.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "mem_budget.h"
+
+static const char *TAG = "link_emu";
+
+// 链路缓冲（相当于 C 板发送到 ESP 接收 FIFO 之间的“线缆 + 驱动缓冲”）
+static StreamBufferHandle_t s_stream = NULL;
+static StaticStreamBuffer_t s_stream_buf;
+static uint8_t s_stream_storage[LINK_EMU_BUF_SIZE + 1]; // 静态 stream buffer 需多 1 字节
+static volatile bool s_enabled = LINK_EMU_DEFAULT_ENABLED;
+
+static link_emu_config_t s_cfg = {
+	.baud = LINK_EMU_DEFAULT_BAUD,
+	.bit_error_ppm = 0,
+	.drop_ppm = 0,
+	.garbage_ppm = 0,
+	.garbage_max = 16,
+	.split_max = 0,
+	.burst = 1,
+	.seed = 1,
+};
+static portMUX_TYPE s_cfg_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static link_emu_stats_t s_stats;
+
+// 发送侧与接收侧各自的伪随机状态（xorshift32），保证相同种子下可重复
+static uint32_t s_tx_rng = 1;
+static uint32_t s_rx_rng = 1;
+
+// 接收侧波特率令牌桶：单位为 字节*1e6（避免浮点）
+static int64_t s_rx_credit = 0;
+static int64_t s_rx_last_us = 0;
+
+static inline uint32_t xorshift32(uint32_t *st)
+{
+	uint32_t x = *st;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*st = x;
+	return x;
+}
+
+// 以 ppm 概率返回 true
+static inline bool chance_ppm(uint32_t *st, uint32_t ppm)
+{
+	return ppm && (xorshift32(st) % 1000000u) < ppm;
+}
+
+void link_emu_init(void)
+{
+	if (!s_stream) {
+		s_stream = xStreamBufferCreateStatic(LINK_EMU_BUF_SIZE, 1, s_stream_storage, &s_stream_buf);
+		mem_budget_add("link_emu", "byte stream", sizeof(s_stream_storage));
+	}
+	link_emu_set_config(&s_cfg);
+	ESP_LOGI(TAG, "link emulation ready (enabled=%d baud=%u)", s_enabled, (unsigned)s_cfg.baud);
+}
+
+bool link_emu_enabled(void)
+{
+	return s_enabled && s_stream;
+}
+
+void link_emu_set_enabled(bool en)
+{
+	if (en && s_stream) xStreamBufferReset(s_stream);
+	s_rx_last_us = esp_timer_get_time();
+	s_rx_credit = 0;
+	s_enabled = en;
+}
+
+void link_emu_get_config(link_emu_config_t *out)
+{
+	if (!out) return;
+	portENTER_CRITICAL(&s_cfg_mux);
+	*out = s_cfg;
+	portEXIT_CRITICAL(&s_cfg_mux);
+}
+
+void link_emu_set_config(const link_emu_config_t *cfg)
+{
+	if (!cfg) return;
+	portENTER_CRITICAL(&s_cfg_mux);
+	s_cfg = *cfg;
+	if (s_cfg.burst == 0) s_cfg.burst = 1;
+	if (s_cfg.garbage_max > LINK_EMU_MAX_GARBAGE) s_cfg.garbage_max = LINK_EMU_MAX_GARBAGE;
+	if (s_cfg.seed == 0) s_cfg.seed = 1; // xorshift 不能为 0
+	s_tx_rng = s_cfg.seed;
+	s_rx_rng = s_cfg.seed ^ 0x9E3779B9u;
+	if (s_rx_rng == 0) s_rx_rng = 1;
+	portEXIT_CRITICAL(&s_cfg_mux);
+}
+
+void link_emu_write_frame(const uint8_t *frame, size_t len)
+{
+	if (!frame || len == 0 || !link_emu_enabled()) return;
+	if (len > LINK_EMU_MAX_FRAME) {
+		// 截断会在接收端表现为校验错误，掩盖真正的原因：整帧拒绝并单独计数
+		s_stats.frames_oversize++;
+		ESP_LOGW(TAG, "frame of %u bytes exceeds LINK_EMU_MAX_FRAME (%u), dropped", (unsigned)len,
+				 (unsigned)LINK_EMU_MAX_FRAME);
+		return;
+	}
+	link_emu_config_t cfg;
+	link_emu_get_config(&cfg);
+
+	// 仅由模拟器任务调用，静态暂存区即可
+	static uint8_t out[LINK_EMU_MAX_FRAME + LINK_EMU_MAX_GARBAGE];
+	for (uint16_t b = 0; b < cfg.burst; ++b) {
+		size_t n = 0;
+		bool impaired = false;
+		for (size_t i = 0; i < len; ++i) {
+			if (chance_ppm(&s_tx_rng, cfg.drop_ppm)) {
+				s_stats.bytes_dropped++;
+				impaired = true;
+				continue;
+			}
+			uint8_t v = frame[i];
+			// 每字节 8 个比特，按误码率近似：单字节出错概率 = 8 * BER
+			if (chance_ppm(&s_tx_rng, cfg.bit_error_ppm * 8)) {
+				v ^= (uint8_t)(1u << (xorshift32(&s_tx_rng) & 7));
+				s_stats.bits_flipped++;
+				impaired = true;
+			}
+			out[n++] = v;
+		}
+		// 帧间垃圾
+		if (chance_ppm(&s_tx_rng, cfg.garbage_ppm) && cfg.garbage_max > 0) {
+			size_t g = 1 + xorshift32(&s_tx_rng) % cfg.garbage_max;
+			if (g > sizeof(out) - n) g = sizeof(out) - n;
+			for (size_t i = 0; i < g; ++i) out[n++] = (uint8_t)xorshift32(&s_tx_rng);
+			s_stats.garbage_bytes += g;
+			impaired = true;
+		}
+
+		size_t sent = xStreamBufferSend(s_stream, out, n, 0);
+		if (sent < n) s_stats.overflow_bytes += (uint32_t)(n - sent);
+		s_stats.frames_in++;
+		s_stats.bytes_in += (uint32_t)len;
+		if (impaired) s_stats.frames_impaired++;
+	}
+}
+
+int link_emu_read(uint8_t *buf, size_t max_len, TickType_t timeout)
+{
+	if (!buf || max_len == 0 || !link_emu_enabled()) {
+		vTaskDelay(timeout);
+		return 0;
+	}
+	link_emu_config_t cfg;
+	link_emu_get_config(&cfg);
+
+	size_t want = max_len;
+	if (cfg.split_max > 0) {
+		size_t frag = 1 + xorshift32(&s_rx_rng) % cfg.split_max;
+		if (frag < want) want = frag;
+	}
+
+	if (cfg.baud > 0) {
+		// 按 baud/10 字节每秒补充令牌；线路空闲时不累积（上限为当前待收字节）
+		const int64_t bytes_per_sec = cfg.baud / 10;
+		TickType_t waited = 0;
+		while (1) {
+			int64_t now = esp_timer_get_time();
+			s_rx_credit += (now - s_rx_last_us) * bytes_per_sec;
+			s_rx_last_us = now;
+			int64_t avail = (int64_t)xStreamBufferBytesAvailable(s_stream);
+			if (s_rx_credit > avail * 1000000) s_rx_credit = avail * 1000000;
+			if (s_rx_credit >= 1000000) break;
+			if (waited >= timeout) return 0;
+			vTaskDelay(1);
+			waited++;
+		}
+		size_t allowed = (size_t)(s_rx_credit / 1000000);
+		if (allowed < want) want = allowed;
+		timeout = 0;
+	}
+
+	size_t n = xStreamBufferReceive(s_stream, buf, want, timeout);
+	if (cfg.baud > 0) s_rx_credit -= (int64_t)n * 1000000;
+	s_stats.bytes_out += (uint32_t)n;
+	return (int)n;
+}
+
+void link_emu_get_stats(link_emu_stats_t *out)
+{
+	if (out) *out = s_stats;
+}
+
+void link_emu_reset_stats(void)
+{
+	memset(&s_stats, 0, sizeof(s_stats));
+}
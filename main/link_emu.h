@@ -0,0 +1,54 @@
+#ifndef LINK_EMU_H
+#define LINK_EMU_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+// C 板串口链路字节级仿真（TEST_MODE）
+// 模拟器把完整帧写入仿真链路，链路按配置施加分片、误码、丢字节、
+// 帧间垃圾与波特率限速后，以字节流的形式交给 serial_task 的真实接收路径。
+
+typedef struct {
+	uint32_t baud;            // 波特率（8N1，每字节 10 bit），0 = 不限速
+	uint32_t bit_error_ppm;   // 误码率（每比特翻转概率，百万分之一）
+	uint32_t drop_ppm;        // 每字节丢失概率（百万分之一）
+	uint32_t garbage_ppm;     // 每帧之后插入垃圾字节的概率（百万分之一）
+	uint16_t garbage_max;     // 每次插入的垃圾字节数上限
+	uint16_t split_max;       // 接收端每次读取的最大分片字节数（随机 1..split_max），0 = 不限
+	uint16_t burst;           // 每个模拟帧连续发送的次数（>=1）
+	uint32_t seed;            // 伪随机种子（相同种子得到相同的扰动序列）
+} link_emu_config_t;
+
+typedef struct {
+	uint32_t frames_in;       // 写入链路的帧数（含 burst 重复）
+	uint32_t frames_impaired; // 至少受到一次扰动的帧数
+	uint32_t bytes_in;        // 写入字节数
+	uint32_t bytes_out;       // 交付给接收端的字节数
+	uint32_t bits_flipped;
+	uint32_t bytes_dropped;
+	uint32_t garbage_bytes;
+	uint32_t overflow_bytes;  // 缓冲区满（超过波特率承载能力）而丢弃的字节数
+	uint32_t frames_oversize; // 超过 LINK_EMU_MAX_FRAME 而整帧拒绝的帧数
+} link_emu_stats_t;
+
+// 创建仿真链路（由 simulator_start 调用）
+void link_emu_init(void);
+
+bool link_emu_enabled(void);
+void link_emu_set_enabled(bool en);
+
+void link_emu_get_config(link_emu_config_t *out);
+void link_emu_set_config(const link_emu_config_t *cfg);
+
+// 发送侧：写入一帧完整数据（施加扰动，非阻塞；溢出部分计入 overflow_bytes）
+void link_emu_write_frame(const uint8_t *frame, size_t len);
+
+// 接收侧：按波特率与分片配置读取字节，最多等待 timeout
+int link_emu_read(uint8_t *buf, size_t max_len, TickType_t timeout);
+
+void link_emu_get_stats(link_emu_stats_t *out);
+void link_emu_reset_stats(void);
+
+#endif // LINK_EMU_H
@@ -0,0 +1,55 @@
+#include "mem_budget.h"
+#include <stdio.h>
+#include "esp_heap_caps.h"
+#include "task_topology.h"
+
+#define MEM_BUDGET_MAX_ITEMS 24
+
+typedef struct {
+	const char *owner;
+	const char *what;
+	size_t bytes;
+} mem_item_t;
+
+static mem_item_t s_items[MEM_BUDGET_MAX_ITEMS];
+static int s_item_count;
+static size_t s_boot_free;
+
+void mem_budget_add(const char *owner, const char *what, size_t bytes)
+{
+	// 只在启动阶段由各模块 init 调用，不需要加锁
+	if (s_item_count >= MEM_BUDGET_MAX_ITEMS) return;
+	s_items[s_item_count++] = (mem_item_t){ owner, what, bytes };
+}
+
+void mem_budget_boot_mark(void)
+{
+	s_boot_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+
+void mem_budget_report(void)
+{
+	size_t total_static = 0;
+	printf("== static allocations ==\n");
+	printf("%-16s %-24s %s\n", "owner", "item", "bytes");
+	for (int i = 0; i < s_item_count; ++i) {
+		printf("%-16s %-24s %u\n", s_items[i].owner, s_items[i].what, (unsigned)s_items[i].bytes);
+		total_static += s_items[i].bytes;
+	}
+	size_t task_bytes = task_topology_static_bytes();
+	printf("%-16s %-24s %u\n", "task_topology", "stacks + TCBs", (unsigned)task_bytes);
+	total_static += task_bytes;
+	printf("%-16s %-24s %u\n", "total", "", (unsigned)total_static);
+
+	printf("== task stacks ==\n");
+	task_topology_stack_report();
+
+	size_t total = heap_caps_get_total_size(MALLOC_CAP_INTERNAL);
+	size_t free_now = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+	printf("== internal heap ==\n");
+	printf("total %u, free %u, min free %u, largest block %u, used since boot %d\n",
+		   (unsigned)total, (unsigned)free_now,
+		   (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+		   (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL),
+		   s_boot_free ? (int)(s_boot_free - free_now) : -1);
+}
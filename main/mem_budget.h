@@ -0,0 +1,18 @@
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#include <stddef.h>
+
+// 内存预算：汇总各模块的静态缓冲区、任务栈与堆余量，启动时打印一次，CLI `mem` 可随时查看。
+// 各模块在初始化时登记自己的静态对象（缓冲区、队列存储、信号量控制块等）。
+
+// 登记一项静态分配；owner/what 须为常量字符串
+void mem_budget_add(const char *owner, const char *what, size_t bytes);
+
+// 在 app_main 开头调用，记录初始化前的堆余量，用于计算启动期的堆消耗
+void mem_budget_boot_mark(void);
+
+// 打印内存预算表：静态分配明细、任务栈用量、内部 RAM 堆余量
+void mem_budget_report(void);
+
+#endif // MEM_BUDGET_H
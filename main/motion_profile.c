@@ -0,0 +1,320 @@
+#include "motion_profile.h"
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "config.h"
+#include "serial_cboard.h"
+#include "task_topology.h"
+
+static const char *TAG = "motion";
+
+#if MOTION_RATE_HZ < 200 || MOTION_RATE_HZ > 1000
+#error "MOTION_RATE_HZ must be within 200..1000"
+#endif
+
+#define Q16_ONE 65536
+
+// 单轴规划结果与插值状态。插值只用整数：
+//   tau = elapsed_us * inv_t >> 16         （Q16，0..1）
+//   pos = p0 + d * s(tau) >> 16            （s 为 Q16 归一化位移曲线）
+typedef struct {
+	uint8_t motor_id;      // 0 = 空槽
+	bool active;
+	bool started;          // 未指定起始时刻时，以首个节拍时间作为起点（兼容实机与模拟器虚拟时钟）
+	bool have_setpoint;
+	motion_profile_t type;
+	motion_axis_cfg_t cfg;
+	int32_t setpoint;      // 最近一次发出的设定点
+	int32_t p0;
+	int32_t d;
+	int64_t start_us;
+	uint32_t dur_us;
+	uint32_t inv_t;        // 2^32 / dur_us
+	int32_t f;             // 梯形：加速段占比（Q16）
+	int32_t k_acc;         // 梯形：1 / (2f(1-f))（Q16）
+	int32_t k_lin;         // 梯形：1 / (1-f)（Q16）
+} motion_axis_t;
+
+static motion_axis_t s_axes[MOTION_MAX_AXES];
+static SemaphoreHandle_t s_lock = NULL;
+static StaticSemaphore_t s_lock_buf;
+static motion_stats_t s_stats;
+
+#if !TEST_MODE
+static TaskHandle_t s_task = NULL;
+static esp_timer_handle_t s_timer = NULL;
+#endif
+
+static motion_axis_t *find_axis(uint8_t motor_id, bool create)
+{
+	motion_axis_t *free_slot = NULL;
+	for (int i = 0; i < MOTION_MAX_AXES; ++i) {
+		if (s_axes[i].motor_id == motor_id) return &s_axes[i];
+		if (!free_slot && s_axes[i].motor_id == 0) free_slot = &s_axes[i];
+	}
+	if (!create || !free_slot) return NULL;
+	memset(free_slot, 0, sizeof(*free_slot));
+	free_slot->motor_id = motor_id;
+	free_slot->cfg = (motion_axis_cfg_t){
+		.vmax = MOTION_DEFAULT_VMAX,
+		.amax = MOTION_DEFAULT_AMAX,
+		.jmax = MOTION_DEFAULT_JMAX,
+		.wrap = 0,
+	};
+	return free_slot;
+}
+
+esp_err_t motion_config_axis(uint8_t motor_id, const motion_axis_cfg_t *cfg)
+{
+	if (motor_id == 0 || !cfg || cfg->vmax <= 0 || cfg->amax <= 0 || cfg->jmax <= 0) return ESP_ERR_INVALID_ARG;
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	motion_axis_t *ax = find_axis(motor_id, true);
+	if (ax) ax->cfg = *cfg;
+	xSemaphoreGive(s_lock);
+	return ax ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// 按限制求单轴最短时长（秒）
+static float min_duration(const motion_axis_cfg_t *c, float dist, motion_profile_t type)
+{
+	if (type == MOTION_PROFILE_SCURVE) {
+		// 五次多项式 s = 10t³-15t⁴+6t⁵：峰值速度 1.875 D/T，峰值加速度 5.7735 D/T²，加加速度 60 D/T³
+		float tv = 1.875f * dist / c->vmax;
+		float ta = sqrtf(5.7735f * dist / c->amax);
+		float tj = cbrtf(60.0f * dist / c->jmax);
+		return fmaxf(tv, fmaxf(ta, tj));
+	}
+	float v = (float)c->vmax, a = (float)c->amax;
+	if (dist >= v * v / a) return dist / v + v / a; // 梯形
+	return 2.0f * sqrtf(dist / a);                  // 三角形（达不到最大速度）
+}
+
+// 梯形：在给定时长 T 下求加速段占比 f（保持 amax，降低巡航速度以拉长到 T）
+static void plan_trapezoid(motion_axis_t *ax, float dist, float t)
+{
+	float a = (float)ax->cfg.amax;
+	float disc = a * a * t * t - 4.0f * a * dist;
+	float v = (a * t - sqrtf(fmaxf(disc, 0.0f))) * 0.5f;
+	float f = (dist > 0.0f) ? (v / a) / t : 0.5f;
+	if (f < 1.0f / 1024) f = 1.0f / 1024;
+	if (f > 0.5f) f = 0.5f;
+	ax->f = (int32_t)(f * Q16_ONE);
+	ax->k_acc = (int32_t)(Q16_ONE / (2.0f * f * (1.0f - f)));
+	ax->k_lin = (int32_t)(Q16_ONE / (1.0f - f));
+}
+
+static int32_t feedback_position(uint8_t motor_id)
+{
+	const motor_status_t *st = get_motor_status(motor_id);
+	return st ? (int32_t)st->angle : 0;
+}
+
+esp_err_t motion_move(const motion_target_t *targets, size_t n, motion_profile_t type, uint32_t *out_duration_ms)
+{
+	return motion_move_at(targets, n, type, -1, out_duration_ms);
+}
+
+esp_err_t motion_move_at(const motion_target_t *targets, size_t n, motion_profile_t type, int64_t start_us,
+						 uint32_t *out_duration_ms)
+{
+	if (!targets || n == 0 || n > MOTION_MAX_AXES) return ESP_ERR_INVALID_ARG;
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	motion_axis_t *axes[MOTION_MAX_AXES];
+	float dist[MOTION_MAX_AXES];
+	float t = 0.0f;
+	for (size_t i = 0; i < n; ++i) {
+		motion_axis_t *ax = find_axis(targets[i].motor_id, true);
+		if (!ax) {
+			xSemaphoreGive(s_lock);
+			return ESP_ERR_NO_MEM;
+		}
+		int32_t p0 = ax->have_setpoint ? ax->setpoint : feedback_position(ax->motor_id);
+		int32_t d = targets[i].position - p0;
+		if (ax->cfg.wrap) {
+			int32_t w = ax->cfg.wrap;
+			d = ((targets[i].position % w) + w) % w - ((p0 % w) + w) % w;
+			if (d > w / 2) d -= w;
+			if (d < -w / 2) d += w;
+		}
+		ax->p0 = p0;
+		ax->d = d;
+		axes[i] = ax;
+		dist[i] = fabsf((float)d);
+		t = fmaxf(t, min_duration(&ax->cfg, dist[i], type));
+	}
+	// 统一时长：向上取整到节拍，至少一个节拍
+	uint32_t tick_us = 1000000 / MOTION_RATE_HZ;
+	uint32_t dur_us = (uint32_t)(t * 1e6f);
+	if (dur_us > MOTION_MAX_MOVE_MS * 1000) dur_us = MOTION_MAX_MOVE_MS * 1000;
+	dur_us = (dur_us + tick_us - 1) / tick_us * tick_us;
+	if (dur_us < tick_us) dur_us = tick_us;
+	for (size_t i = 0; i < n; ++i) {
+		motion_axis_t *ax = axes[i];
+		ax->type = type;
+		ax->dur_us = dur_us;
+		ax->inv_t = (uint32_t)(((uint64_t)1 << 32) / dur_us);
+		if (type == MOTION_PROFILE_TRAPEZOID) plan_trapezoid(ax, dist[i], dur_us * 1e-6f);
+		ax->started = start_us >= 0;
+		ax->start_us = start_us;
+		ax->active = true;
+	}
+	s_stats.moves++;
+	s_stats.last_move_ms = dur_us / 1000;
+	xSemaphoreGive(s_lock);
+	if (out_duration_ms) *out_duration_ms = dur_us / 1000;
+	ESP_LOGD(TAG, "move: %u axes, %s, %lu ms", (unsigned)n,
+			 type == MOTION_PROFILE_SCURVE ? "s-curve" : "trapezoid", (unsigned long)(dur_us / 1000));
+	return ESP_OK;
+}
+
+void motion_stop(void)
+{
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	for (int i = 0; i < MOTION_MAX_AXES; ++i) s_axes[i].active = false;
+	xSemaphoreGive(s_lock);
+}
+
+bool motion_busy(void)
+{
+	for (int i = 0; i < MOTION_MAX_AXES; ++i) {
+		if (s_axes[i].active) return true;
+	}
+	return false;
+}
+
+// 归一化位移曲线 s(tau)，输入输出均为 Q16
+static inline int32_t shape_q16(const motion_axis_t *ax, int32_t tau)
+{
+	if (ax->type == MOTION_PROFILE_SCURVE) {
+		// s = tau³ (10 - 15 tau + 6 tau²)
+		int64_t t2 = ((int64_t)tau * tau) >> 16;
+		int64_t t3 = (t2 * tau) >> 16;
+		int64_t inner = 10 * Q16_ONE - 15 * (int64_t)tau + 6 * t2;
+		return (int32_t)((t3 * inner) >> 16);
+	}
+	if (tau < ax->f) {
+		int64_t t2 = ((int64_t)tau * tau) >> 16;
+		return (int32_t)((t2 * ax->k_acc) >> 16);
+	}
+	if (tau <= Q16_ONE - ax->f) {
+		return (int32_t)(((int64_t)(tau - ax->f / 2) * ax->k_lin) >> 16);
+	}
+	int64_t u = Q16_ONE - tau;
+	return Q16_ONE - (int32_t)((((u * u) >> 16) * ax->k_acc) >> 16);
+}
+
+void motion_tick(int64_t now_us)
+{
+	motor_command_t cmds[MOTION_MAX_AXES];
+	size_t n = 0;
+	uint32_t active = 0;
+
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	uint32_t c0 = esp_cpu_get_cycle_count();
+	for (int i = 0; i < MOTION_MAX_AXES; ++i) {
+		motion_axis_t *ax = &s_axes[i];
+		if (!ax->active) continue;
+		if (!ax->started) {
+			ax->started = true;
+			ax->start_us = now_us;
+		}
+		int64_t el = now_us - ax->start_us;
+		if (el < 0) el = 0; // 尚未到起始时刻：保持起点
+		int32_t pos;
+		if (el >= (int64_t)ax->dur_us) {
+			pos = ax->p0 + ax->d; // 末点精确落在目标上
+			ax->active = false;
+		} else {
+			int32_t tau = (int32_t)(((uint64_t)el * ax->inv_t) >> 16);
+			pos = ax->p0 + (int32_t)(((int64_t)ax->d * shape_q16(ax, tau)) >> 16);
+			active++;
+		}
+		if (ax->cfg.wrap) {
+			pos %= ax->cfg.wrap;
+			if (pos < 0) pos += ax->cfg.wrap;
+		} else if (pos > INT16_MAX) {
+			pos = INT16_MAX;
+		} else if (pos < INT16_MIN) {
+			pos = INT16_MIN;
+		}
+		ax->setpoint = pos;
+		ax->have_setpoint = true;
+		cmds[n++] = (motor_command_t){
+			.target_speed = 0,
+			.target_position = (int16_t)pos,
+			.control_mode = 1, // 位置模式
+			.motor_id = ax->motor_id,
+		};
+	}
+	uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+	s_stats.ticks++;
+	s_stats.active_axes = active;
+	if (n) {
+		s_stats.kernel_cycles_last = cycles;
+		if (cycles > s_stats.kernel_cycles_max) s_stats.kernel_cycles_max = cycles;
+	}
+	xSemaphoreGive(s_lock);
+
+	// 所有运动轴的设定点合并为一帧发送
+	if (n && serial_cboard_send(cmds, n) == 0) s_stats.frames++;
+}
+
+void motion_get_stats(motion_stats_t *out)
+{
+	if (!out) return;
+	*out = s_stats;
+#if TEST_MODE
+	out->rate_hz = SIM_UPDATE_HZ;
+#else
+	out->rate_hz = MOTION_RATE_HZ;
+#endif
+}
+
+#if !TEST_MODE
+static void motion_timer_cb(void *arg)
+{
+	(void)arg;
+	if (s_task) xTaskNotifyGive(s_task);
+}
+
+// 节拍任务：由 esp_timer 周期唤醒，不受 FreeRTOS tick 粒度限制
+static void motion_task(void *arg)
+{
+	(void)arg;
+	const int64_t period_us = 1000000 / MOTION_RATE_HZ;
+	int64_t expected = esp_timer_get_time() + period_us;
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		int64_t now = esp_timer_get_time();
+		task_jitter_note_wake(TASK_ID_MOTION, expected);
+		expected += period_us;
+		if (now - expected > period_us) expected = now + period_us; // 长时间被抢占后重新对齐
+		if (motion_busy()) motion_tick(now);
+	}
+}
+#endif
+
+void motion_init(void)
+{
+	if (s_lock) return;
+	s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+#if TEST_MODE
+	// TEST_MODE：由模拟器步进钩子以虚拟时钟调用 motion_tick（频率 = SIM_UPDATE_HZ）
+	ESP_LOGI(TAG, "motion profiler driven by simulator at %d Hz", SIM_UPDATE_HZ);
+#else
+	task_topology_create(TASK_ID_MOTION, motion_task, NULL, &s_task, NULL);
+	const esp_timer_create_args_t args = {
+		.callback = motion_timer_cb,
+		.name = "motion",
+	};
+	if (esp_timer_create(&args, &s_timer) == ESP_OK) {
+		esp_timer_start_periodic(s_timer, 1000000 / MOTION_RATE_HZ);
+	}
+	ESP_LOGI(TAG, "motion profiler at %d Hz", MOTION_RATE_HZ);
+#endif
+}
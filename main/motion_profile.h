@@ -0,0 +1,71 @@
+#ifndef MOTION_PROFILE_H
+#define MOTION_PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// 运动规划：位于模式逻辑与 serial_cboard_send 之间，把稀疏的目标位置
+// 插值为 MOTION_RATE_HZ 的位置设定点序列，限制速度/加速度（S 曲线另限加加速度），
+// 多电机同一次移动按最慢的轴统一时长，保证同时到达。
+//
+// 规划（每次 motion_move）用浮点求解时长与形状参数；每个控制节拍的插值内核为
+// Q16 定点整数运算，每轴仅若干次乘法与移位，可在一个节拍内处理大量电机。
+// 位置单位为编码器计数（0-8191 对应一圈），速度/加速度/加加速度单位为 计数/s、/s²、/s³。
+
+typedef enum {
+	MOTION_PROFILE_TRAPEZOID = 0, // 梯形速度（加速度阶跃）
+	MOTION_PROFILE_SCURVE,        // S 曲线（五次多项式，速度/加速度连续，加加速度有界）
+} motion_profile_t;
+
+typedef struct {
+	int32_t vmax;  // 计数/s
+	int32_t amax;  // 计数/s²
+	int32_t jmax;  // 计数/s³（仅 S 曲线使用）
+	uint16_t wrap; // >0：位置在 [0, wrap) 内环绕并走最短路径（如 GM6020 的单圈角度）
+} motion_axis_cfg_t;
+
+typedef struct {
+	uint8_t motor_id;
+	int16_t position;
+} motion_target_t;
+
+typedef struct {
+	uint32_t ticks;        // 执行的控制节拍数
+	uint32_t frames;       // 发出的设定点帧数
+	uint32_t moves;        // 规划的移动次数
+	uint32_t active_axes;  // 当前运动中的轴数
+	uint32_t kernel_cycles_last; // 最近一个节拍插值内核的 CPU 周期
+	uint32_t kernel_cycles_max;
+	uint32_t last_move_ms; // 最近一次移动的统一时长
+	uint32_t rate_hz;      // 设定点输出频率
+} motion_stats_t;
+
+// 初始化（实机下创建定时节拍任务；TEST_MODE 下由模拟器步进钩子调用 motion_tick）
+void motion_init(void);
+
+// 配置某个电机的运动限制；未配置的电机使用 config.h 中的默认值
+esp_err_t motion_config_axis(uint8_t motor_id, const motion_axis_cfg_t *cfg);
+
+// 规划一次同步移动：所有目标轴从当前设定点（或最新反馈位置）静止出发，同时到达。
+// 正在运动的轴从当前设定点重新规划（速度不连续），调用者宜在上一段结束后再下发。
+// out_duration_ms 可为 NULL
+esp_err_t motion_move(const motion_target_t *targets, size_t n, motion_profile_t type, uint32_t *out_duration_ms);
+
+// 同上，但轨迹从 start_us（motion_tick 的时间基准）开始，而不是下一个节拍：
+// 设定点按绝对时间插值，与节拍相位无关，多个控制器可在同一时刻起步
+esp_err_t motion_move_at(const motion_target_t *targets, size_t n, motion_profile_t type, int64_t start_us,
+						 uint32_t *out_duration_ms);
+
+// 停止所有运动（C 板保持最后一个设定点）
+void motion_stop(void);
+
+bool motion_busy(void);
+
+// 控制节拍：按 now_us 计算所有运动轴的设定点并以一帧发送
+void motion_tick(int64_t now_us);
+
+void motion_get_stats(motion_stats_t *out);
+
+#endif // MOTION_PROFILE_H
@@ -0,0 +1,210 @@
+#include "rate_gov.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "ui_state.h"
+#include "motion_profile.h"
+#include "udp_ctrl.h"
+#include "sched.h"
+
+static const char *TAG = "rate_gov";
+
+// 每个消费者的周期范围与三档目标：
+//   fast：有人观看且数据在变化；base：有人观看但空闲；idle：无人观看。
+// 串口屏就在机架上，不依赖观看者信号（needs_viewer = false）
+typedef struct {
+	const char *name;
+	uint32_t min_ms, max_ms;
+	uint32_t fast_ms, base_ms, idle_ms;
+	bool needs_viewer;
+} rate_gov_cfg_t;
+
+static const rate_gov_cfg_t s_cfg[RATE_GOV_COUNT] = {
+	[RATE_GOV_DISPLAY]     = { "display",     100, 5000,  250, 1000, 1000, false },
+	[RATE_GOV_SLIDER_SYNC] = { "slider_sync",  50, 2000,  100, 1000, 2000, true },
+	[RATE_GOV_WEB_POLL]    = { "web_poll",    100, 2000,  150,  500, 1000, true },
+};
+
+typedef struct {
+	int fd;
+	int64_t last_us;
+} rate_gov_viewer_t;
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static rate_gov_entry_t s_entries[RATE_GOV_COUNT];
+static rate_gov_viewer_t s_viewers[RATE_GOV_MAX_VIEWERS];
+static rate_gov_signals_t s_signals;
+
+static uint32_t clamp_period(const rate_gov_cfg_t *c, uint32_t ms)
+{
+	if (ms < c->min_ms) return c->min_ms;
+	if (ms > c->max_ms) return c->max_ms;
+	return ms;
+}
+
+uint32_t rate_gov_period_ms(rate_gov_id_t id)
+{
+	if (id >= RATE_GOV_COUNT) return 1000;
+	return s_entries[id].current_ms ? s_entries[id].current_ms : s_cfg[id].base_ms;
+}
+
+void rate_gov_note_viewer(int sockfd)
+{
+	int64_t now = esp_timer_get_time();
+	portENTER_CRITICAL(&s_mux);
+	rate_gov_viewer_t *slot = &s_viewers[0];
+	for (int i = 0; i < RATE_GOV_MAX_VIEWERS; ++i) {
+		if (s_viewers[i].last_us && s_viewers[i].fd == sockfd) {
+			slot = &s_viewers[i];
+			break;
+		}
+		if (s_viewers[i].last_us < slot->last_us) slot = &s_viewers[i];
+	}
+	slot->fd = sockfd;
+	slot->last_us = now;
+	portEXIT_CRITICAL(&s_mux);
+}
+
+static uint32_t count_viewers(int64_t now)
+{
+	uint32_t n = 0;
+	portENTER_CRITICAL(&s_mux);
+	for (int i = 0; i < RATE_GOV_MAX_VIEWERS; ++i) {
+		if (s_viewers[i].last_us && now - s_viewers[i].last_us < (int64_t)RATE_GOV_VIEWER_TIMEOUT_MS * 1000) n++;
+	}
+	portEXIT_CRITICAL(&s_mux);
+	return n;
+}
+
+// 空闲任务累计运行时间（微秒，需 CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS）
+static uint32_t idle_runtime(int core)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+	return (uint32_t)ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+#else
+	(void)core;
+	return 0;
+#endif
+}
+
+static void rate_gov_update(int64_t now, int64_t dt_us, uint32_t *idle_prev)
+{
+	rate_gov_signals_t sig = { 0 };
+	sig.web_viewers = count_viewers(now);
+#if UDP_CTRL_ENABLE
+	udp_ctrl_stats_t us;
+	udp_ctrl_get_stats(&us);
+	sig.udp_subscribers = us.subscribers;
+#endif
+	sig.active = ui_state_get_mode() != MODE_MANUAL || motion_busy();
+	for (int c = 0; c < 2 && c < portNUM_PROCESSORS; ++c) {
+		uint32_t t = idle_runtime(c);
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+		uint32_t pct = dt_us > 0 ? (uint32_t)((uint64_t)(t - idle_prev[c]) * 100 / (uint64_t)dt_us) : 100;
+		sig.idle_pct[c] = (uint8_t)(pct > 100 ? 100 : pct);
+#else
+		sig.idle_pct[c] = 100;
+#endif
+		idle_prev[c] = t;
+	}
+	// core 0 承载网络与这些消费者：余量低于阈值时按比例放大所有周期（最多 4 倍）
+	uint32_t idle0 = sig.idle_pct[0] < 5 ? 5 : sig.idle_pct[0];
+	sig.throttle_pct = idle0 >= RATE_GOV_IDLE_LOW_PCT ? 100 : RATE_GOV_IDLE_LOW_PCT * 100 / idle0;
+	if (sig.throttle_pct > 400) sig.throttle_pct = 400;
+
+	bool watched = sig.web_viewers + sig.udp_subscribers > 0;
+	portENTER_CRITICAL(&s_mux);
+	s_signals = sig;
+	for (int i = 0; i < RATE_GOV_COUNT; ++i) {
+		const rate_gov_cfg_t *c = &s_cfg[i];
+		rate_gov_entry_t *e = &s_entries[i];
+		uint32_t t;
+		if (c->needs_viewer && !watched) t = c->idle_ms;
+		else t = sig.active ? c->fast_ms : c->base_ms;
+		t = clamp_period(c, t * sig.throttle_pct / 100);
+		e->target_ms = t;
+		if (e->override_ms) {
+			e->current_ms = e->override_ms;
+		} else if (t <= e->current_ms) {
+			e->current_ms = t; // 需求上升立即响应
+		} else {
+			// 需求下降逐步放慢（每次最多 +25%），避免观看者短暂停顿时来回跳变
+			uint32_t up = e->current_ms + e->current_ms / 4 + 1;
+			e->current_ms = up < t ? up : t;
+		}
+	}
+	portEXIT_CRITICAL(&s_mux);
+}
+
+#if RATE_GOV_ENABLE
+static uint32_t s_idle_prev[2];
+static int64_t s_last_us;
+
+// 调度器 UI 执行任务上的周期作业（RATE_GOV_PERIOD_MS）
+static int64_t rate_gov_job(void *arg, int64_t deadline_us)
+{
+	(void)arg;
+	(void)deadline_us;
+	int64_t now = esp_timer_get_time();
+	rate_gov_update(now, now - s_last_us, s_idle_prev);
+	s_last_us = now;
+	return SCHED_NEXT_PERIOD;
+}
+#endif
+
+void rate_gov_init(void)
+{
+	for (int i = 0; i < RATE_GOV_COUNT; ++i) {
+		s_entries[i] = (rate_gov_entry_t){
+			.name = s_cfg[i].name,
+			.min_ms = s_cfg[i].min_ms,
+			.max_ms = s_cfg[i].max_ms,
+			.target_ms = s_cfg[i].base_ms,
+			.current_ms = s_cfg[i].base_ms,
+		};
+	}
+#if RATE_GOV_ENABLE
+	s_idle_prev[0] = idle_runtime(0);
+	s_idle_prev[1] = portNUM_PROCESSORS > 1 ? idle_runtime(1) : 0;
+	s_last_us = esp_timer_get_time();
+	sched_add("rate_gov", SCHED_EXEC_UI, RATE_GOV_PERIOD_MS * 1000, 0, rate_gov_job, NULL);
+#if !CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+	ESP_LOGW(TAG, "run-time stats disabled: CPU headroom not measured");
+#endif
+#endif
+}
+
+bool rate_gov_override(const char *name, uint32_t period_ms)
+{
+	for (int i = 0; i < RATE_GOV_COUNT; ++i) {
+		if (strcmp(name, s_cfg[i].name) != 0) continue;
+		portENTER_CRITICAL(&s_mux);
+		rate_gov_entry_t *e = &s_entries[i];
+		e->override_ms = period_ms ? clamp_period(&s_cfg[i], period_ms) : 0;
+		e->current_ms = e->override_ms ? e->override_ms : e->target_ms;
+		portEXIT_CRITICAL(&s_mux);
+		ESP_LOGI(TAG, "%s: %s %lu ms", name, period_ms ? "override" : "auto", (unsigned long)e->current_ms);
+		return true;
+	}
+	return false;
+}
+
+bool rate_gov_get(rate_gov_id_t id, rate_gov_entry_t *out)
+{
+	if (id >= RATE_GOV_COUNT || !out) return false;
+	portENTER_CRITICAL(&s_mux);
+	*out = s_entries[id];
+	portEXIT_CRITICAL(&s_mux);
+	return true;
+}
+
+void rate_gov_get_signals(rate_gov_signals_t *out)
+{
+	if (!out) return;
+	portENTER_CRITICAL(&s_mux);
+	*out = s_signals;
+	portEXIT_CRITICAL(&s_mux);
+}
@@ -0,0 +1,52 @@
+#ifndef RATE_GOV_H
+#define RATE_GOV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 速率调节器：按需求与 CPU 余量调整各个周期性消费者的刷新周期。
+// 需求信号：活跃的观看者（近期轮询 /api/status 的网页连接 + UDP 遥测订阅者）、
+// 控制模式（预设/运动中数据在变化）；余量信号：core 0 空闲任务的运行时间占比。
+// 有人观看且数据在变化时缩短周期，无人观看或空闲时拉长；CPU 余量不足时整体放慢。
+// 各消费者每次循环读取 rate_gov_period_ms() 作为下一次的睡眠时长。
+
+typedef enum {
+	RATE_GOV_DISPLAY = 0, // 串口屏刷新
+	RATE_GOV_SLIDER_SYNC, // 网页滑块同步
+	RATE_GOV_WEB_POLL,    // 网页轮询 /api/status 的间隔（随 status 下发给浏览器）
+	RATE_GOV_COUNT
+} rate_gov_id_t;
+
+typedef struct {
+	const char *name;
+	uint32_t min_ms;
+	uint32_t max_ms;
+	uint32_t target_ms;   // 最近一次按信号计算的目标周期
+	uint32_t current_ms;  // 正在使用的周期（覆盖值优先）
+	uint32_t override_ms; // 0 = 自动
+} rate_gov_entry_t;
+
+typedef struct {
+	uint32_t web_viewers;
+	uint32_t udp_subscribers;
+	uint8_t idle_pct[2];  // 各核空闲占比（无运行时统计时为 100）
+	bool active;          // 预设模式或运动规划中
+	uint32_t throttle_pct; // CPU 余量不足导致的周期放大（100 = 不放大）
+} rate_gov_signals_t;
+
+// 启动调节任务
+void rate_gov_init(void);
+
+// 当前周期（毫秒），供消费者每次循环读取
+uint32_t rate_gov_period_ms(rate_gov_id_t id);
+
+// 手动覆盖周期（会被限制在 [min, max]），0 恢复自动；按名称查找，未知名称返回 false
+bool rate_gov_override(const char *name, uint32_t period_ms);
+
+bool rate_gov_get(rate_gov_id_t id, rate_gov_entry_t *out);
+void rate_gov_get_signals(rate_gov_signals_t *out);
+
+// 网页端轮询时调用：以 socket 描述符区分观看者
+void rate_gov_note_viewer(int sockfd);
+
+#endif // RATE_GOV_H
@@ -0,0 +1,294 @@
+#include "sched.h"
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "task_topology.h"
+#include "mem_budget.h"
+
+static const char *TAG = "sched";
+
+typedef enum {
+	JOB_FREE = 0,
+	JOB_IDLE,     // 等待下一次截止时刻
+	JOB_QUEUED,   // 已释放，等待执行任务
+	JOB_RUNNING,
+} job_state_t;
+
+typedef struct {
+	const char *name;
+	sched_fn_t fn;
+	void *arg;
+	int64_t next_us;     // 下一次截止时刻；INT64_MAX = 等待作业返回下一次时刻
+	int64_t release_us;  // 已释放（排队中/运行中）的那次截止时刻
+	uint32_t period_us;
+	uint8_t exec;
+	uint8_t state;
+	bool cancel;
+	bool retrigger;      // 运行期间被触发：本次返回后立即再排队
+	uint32_t runs;
+	uint32_t overruns;
+	uint32_t skipped;
+	uint32_t triggers;
+	uint32_t late_us_max;
+	uint32_t run_us_max;
+	uint64_t late_us_sum;
+	uint64_t run_us_sum;
+} sched_job_t;
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static sched_job_t s_jobs[SCHED_MAX_JOBS];
+static TaskHandle_t s_exec[SCHED_EXEC_COUNT];
+static esp_timer_handle_t s_timer;
+// 定时器当前对准的时刻（INT64_MAX = 未启动）；调整定时器由 s_arm_lock 串行化
+static int64_t s_armed_us = INT64_MAX;
+static SemaphoreHandle_t s_arm_lock;
+static StaticSemaphore_t s_arm_lock_buf;
+
+static const task_id_t s_exec_task_id[SCHED_EXEC_COUNT] = {
+	[SCHED_EXEC_CTRL] = TASK_ID_SCHED_CTRL,
+	[SCHED_EXEC_UI]   = TASK_ID_SCHED_UI,
+};
+
+// 让定时器在 when_us 触发（只会提前，不会推后：回调每次都会重新计算最早时刻）
+static void sched_arm(int64_t when_us)
+{
+	if (when_us == INT64_MAX) return;
+	xSemaphoreTake(s_arm_lock, portMAX_DELAY);
+	bool rearm;
+	portENTER_CRITICAL(&s_mux);
+	rearm = when_us < s_armed_us;
+	if (rearm) s_armed_us = when_us;
+	portEXIT_CRITICAL(&s_mux);
+	if (rearm) {
+		int64_t delay = when_us - esp_timer_get_time();
+		esp_timer_stop(s_timer);
+		esp_timer_start_once(s_timer, delay > 0 ? (uint64_t)delay : 1);
+	}
+	xSemaphoreGive(s_arm_lock);
+}
+
+// 定时器回调（esp_timer 任务）：释放所有到期作业，通知对应执行任务，再对准下一个截止时刻
+static void sched_timer_cb(void *arg)
+{
+	(void)arg;
+	uint32_t notify = 0;
+	int64_t earliest = INT64_MAX;
+	int64_t now = esp_timer_get_time();
+
+	portENTER_CRITICAL(&s_mux);
+	s_armed_us = INT64_MAX;
+	for (int j = 0; j < SCHED_MAX_JOBS; ++j) {
+		sched_job_t *job = &s_jobs[j];
+		if (job->state == JOB_FREE) continue;
+		if (job->next_us <= now) {
+			if (job->state != JOB_IDLE) {
+				job->overruns++; // 上一次还在排队或运行，本次不再释放
+			} else {
+				job->state = JOB_QUEUED;
+				job->release_us = job->next_us;
+				notify |= 1u << job->exec;
+			}
+			if (job->period_us) {
+				// 截止时刻沿周期网格推进，已经错过的周期跳过
+				job->next_us += job->period_us;
+				if (job->next_us <= now) {
+					int64_t n = (now - job->next_us) / job->period_us + 1;
+					job->skipped += (uint32_t)n;
+					job->next_us += n * job->period_us;
+				}
+			} else {
+				job->next_us = INT64_MAX;
+			}
+		}
+		if (job->next_us < earliest) earliest = job->next_us;
+	}
+	portEXIT_CRITICAL(&s_mux);
+
+	for (int e = 0; e < SCHED_EXEC_COUNT; ++e) {
+		if ((notify & (1u << e)) && s_exec[e]) xTaskNotifyGive(s_exec[e]);
+	}
+	sched_arm(earliest);
+}
+
+// 取本执行任务中截止时刻最早的已释放作业并标记为运行中，没有则返回 -1
+static int take_next(uint8_t exec)
+{
+	int best = -1;
+	portENTER_CRITICAL(&s_mux);
+	for (int j = 0; j < SCHED_MAX_JOBS; ++j) {
+		const sched_job_t *job = &s_jobs[j];
+		if (job->state != JOB_QUEUED || job->exec != exec) continue;
+		if (best < 0 || job->release_us < s_jobs[best].release_us) best = j;
+	}
+	if (best >= 0) s_jobs[best].state = JOB_RUNNING;
+	portEXIT_CRITICAL(&s_mux);
+	return best;
+}
+
+static void exec_task(void *arg)
+{
+	uint8_t exec = (uint8_t)(uintptr_t)arg;
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		int j;
+		while ((j = take_next(exec)) >= 0) {
+			sched_job_t *job = &s_jobs[j];
+			int64_t deadline = job->release_us;
+			int64_t start = esp_timer_get_time();
+			task_jitter_note_wake(s_exec_task_id[exec], deadline);
+			int64_t ret = job->fn(job->arg, deadline);
+			int64_t end = esp_timer_get_time();
+
+			uint32_t late = start > deadline ? (uint32_t)(start - deadline) : 0;
+			uint32_t run = (uint32_t)(end - start);
+			int64_t arm = INT64_MAX;
+			portENTER_CRITICAL(&s_mux);
+			job->runs++;
+			job->late_us_sum += late;
+			job->run_us_sum += run;
+			if (late > job->late_us_max) job->late_us_max = late;
+			if (run > job->run_us_max) job->run_us_max = run;
+			if (job->cancel || ret == SCHED_STOP) {
+				job->state = JOB_FREE;
+			} else {
+				job->state = JOB_IDLE;
+				if (ret != SCHED_NEXT_PERIOD) {
+					if (ret <= end) job->overruns++; // 给出的时刻已过：立即再运行
+					job->next_us = ret;
+				}
+				arm = job->next_us;
+				if (job->retrigger) {
+					// 运行期间到达的触发：直接排队，由本循环的下一次 take_next 取走
+					job->retrigger = false;
+					job->state = JOB_QUEUED;
+					job->release_us = end;
+				}
+			}
+			portEXIT_CRITICAL(&s_mux);
+			sched_arm(arm);
+		}
+	}
+}
+
+void sched_init(void)
+{
+	if (s_timer) return;
+	s_arm_lock = xSemaphoreCreateMutexStatic(&s_arm_lock_buf);
+	const esp_timer_create_args_t args = {
+		.callback = sched_timer_cb,
+		.name = "sched",
+	};
+	ESP_ERROR_CHECK(esp_timer_create(&args, &s_timer));
+	for (int e = 0; e < SCHED_EXEC_COUNT; ++e) {
+		task_topology_create(s_exec_task_id[e], exec_task, (void *)(uintptr_t)e, &s_exec[e], NULL);
+	}
+	mem_budget_add("sched", "job table", sizeof(s_jobs));
+	ESP_LOGI(TAG, "scheduler ready (%d jobs max)", SCHED_MAX_JOBS);
+}
+
+int sched_add(const char *name, sched_exec_t exec, uint32_t period_us, int64_t first_us, sched_fn_t fn, void *arg)
+{
+	if (!fn || exec >= SCHED_EXEC_COUNT || !s_timer) return -1;
+	if (first_us == 0) {
+		int64_t now = esp_timer_get_time();
+		first_us = period_us ? (now / period_us + 1) * period_us : now;
+	}
+	int job = -1;
+	portENTER_CRITICAL(&s_mux);
+	for (int j = 0; j < SCHED_MAX_JOBS; ++j) {
+		if (s_jobs[j].state != JOB_FREE) continue;
+		s_jobs[j] = (sched_job_t){
+			.name = name,
+			.fn = fn,
+			.arg = arg,
+			.next_us = first_us,
+			.period_us = period_us,
+			.exec = (uint8_t)exec,
+			.state = JOB_IDLE,
+		};
+		job = j;
+		break;
+	}
+	portEXIT_CRITICAL(&s_mux);
+	if (job < 0) {
+		ESP_LOGE(TAG, "job table full, cannot add %s", name);
+		return -1;
+	}
+	sched_arm(first_us);
+	return job;
+}
+
+void sched_trigger(int job)
+{
+	if (job < 0 || job >= SCHED_MAX_JOBS) return;
+	TaskHandle_t wake = NULL;
+	portENTER_CRITICAL(&s_mux);
+	sched_job_t *j = &s_jobs[job];
+	if (j->state == JOB_IDLE) {
+		j->state = JOB_QUEUED;
+		j->release_us = esp_timer_get_time();
+		j->triggers++;
+		wake = s_exec[j->exec];
+	} else if (j->state == JOB_RUNNING && !j->retrigger) {
+		j->retrigger = true;
+		j->triggers++;
+	}
+	portEXIT_CRITICAL(&s_mux);
+	if (wake) xTaskNotifyGive(wake);
+}
+
+void sched_cancel(int job)
+{
+	if (job < 0 || job >= SCHED_MAX_JOBS) return;
+	portENTER_CRITICAL(&s_mux);
+	sched_job_t *j = &s_jobs[job];
+	if (j->state == JOB_RUNNING) j->cancel = true;
+	else j->state = JOB_FREE;
+	portEXIT_CRITICAL(&s_mux);
+}
+
+bool sched_get_stats(int job, sched_job_stats_t *out)
+{
+	if (job < 0 || job >= SCHED_MAX_JOBS || !out) return false;
+	portENTER_CRITICAL(&s_mux);
+	const sched_job_t *j = &s_jobs[job];
+	bool used = j->state != JOB_FREE;
+	if (used) {
+		*out = (sched_job_stats_t){
+			.name = j->name,
+			.exec = j->exec,
+			.period_us = j->period_us,
+			.runs = j->runs,
+			.overruns = j->overruns,
+			.skipped = j->skipped,
+			.triggers = j->triggers,
+			.late_us_avg = j->runs ? (uint32_t)(j->late_us_sum / j->runs) : 0,
+			.late_us_max = j->late_us_max,
+			.run_us_avg = j->runs ? (uint32_t)(j->run_us_sum / j->runs) : 0,
+			.run_us_max = j->run_us_max,
+		};
+	}
+	portEXIT_CRITICAL(&s_mux);
+	return used;
+}
+
+void sched_report(void)
+{
+	static const char *const exec_names[SCHED_EXEC_COUNT] = { "ctrl", "ui" };
+	printf("%-12s %-4s %9s %8s %8s %7s %8s %13s %13s\n", "job", "exec", "period_us", "runs", "overruns", "skipped",
+		   "triggers", "late avg/max", "run avg/max");
+	for (int j = 0; j < SCHED_MAX_JOBS; ++j) {
+		sched_job_stats_t st;
+		if (!sched_get_stats(j, &st)) continue;
+		printf("%-12s %-4s %9lu %8lu %8lu %7lu %8lu %6lu/%-6lu %6lu/%-6lu\n", st.name ? st.name : "?",
+			   exec_names[st.exec], (unsigned long)st.period_us, (unsigned long)st.runs,
+			   (unsigned long)st.overruns, (unsigned long)st.skipped, (unsigned long)st.triggers,
+			   (unsigned long)st.late_us_avg,
+			   (unsigned long)st.late_us_max, (unsigned long)st.run_us_avg, (unsigned long)st.run_us_max);
+	}
+}
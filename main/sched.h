@@ -0,0 +1,64 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 周期作业调度器：一个 esp_timer（单次模式，总是对准最早的截止时刻）释放到期的作业，
+// 由两个执行任务按截止时刻先后（EDF）运行，代替各自 vTaskDelay 的周期任务。
+//   SCHED_EXEC_CTRL  core 1，高优先级：按键轮询、预设设定点、电流复位检测
+//   SCHED_EXEC_UI    core 0，低优先级：串口屏、网页滑块同步、速率调节
+// 截止时刻按 deadline += period 推进，不随执行时间漂移；默认首个截止时刻对齐到周期的整数倍，
+// 同周期（或成倍数）的作业同相运行。到期时上一次尚未执行完记为超时（overrun），
+// 错过的周期直接跳过并计数；每个作业统计释放到开始执行的延迟（抖动）与执行时间。
+// 作业函数运行在执行任务中，可以短暂阻塞（会推迟同一执行任务上的其它作业），不能无限等待。
+// 事件驱动的作业由 sched_trigger 立即释放（如遥测总线的订阅者）；period_us 为 0 且返回
+// SCHED_NEXT_PERIOD 的作业没有下一次截止时刻，只由触发释放，返回绝对时刻则作为兜底。
+
+typedef enum {
+	SCHED_EXEC_CTRL = 0,
+	SCHED_EXEC_UI,
+	SCHED_EXEC_COUNT
+} sched_exec_t;
+
+// 作业函数返回值：SCHED_NEXT_PERIOD 按周期继续；SCHED_STOP 注销作业；
+// 其它值为下一次的绝对截止时刻（esp_timer 时间，用于周期可变或自带时间轴的作业）
+#define SCHED_NEXT_PERIOD 0
+#define SCHED_STOP        (-1)
+typedef int64_t (*sched_fn_t)(void *arg, int64_t deadline_us);
+
+typedef struct {
+	const char *name;
+	uint8_t exec;
+	uint32_t period_us;   // 0 = 每次由作业给出下一次时刻
+	uint32_t runs;
+	uint32_t overruns;    // 到期时上一次尚未执行完，或作业给出的时刻已经过去
+	uint32_t skipped;     // 跳过的周期数
+	uint32_t triggers;    // sched_trigger 释放的次数（排队中合并的不计）
+	uint32_t late_us_avg; // 截止时刻 -> 开始执行
+	uint32_t late_us_max;
+	uint32_t run_us_avg;
+	uint32_t run_us_max;
+} sched_job_stats_t;
+
+// 创建定时器与执行任务（须先于任何 sched_add）
+void sched_init(void);
+
+// 添加作业，返回句柄（表满返回 -1）。first_us 为首个截止时刻（esp_timer 时间），
+// 0 表示对齐到 period_us 的下一个整数倍（period_us 为 0 时立即运行）
+int sched_add(const char *name, sched_exec_t exec, uint32_t period_us, int64_t first_us, sched_fn_t fn, void *arg);
+
+// 立即释放作业（可从任意任务调用）：空闲则按当前时刻排队；已在排队则合并；
+// 正在运行则本次返回后再运行一次，运行期间到达的事件不会丢失
+void sched_trigger(int job);
+
+// 注销作业（可从任意任务调用；正在运行的作业在本次返回后注销）
+void sched_cancel(int job);
+
+// 作业统计（job 越界或空槽返回 false），用于遍历所有作业
+bool sched_get_stats(int job, sched_job_stats_t *out);
+
+// 打印所有作业的周期、超时与抖动统计
+void sched_report(void);
+
+#endif // SCHED_H
@@ -1,62 +1,211 @@
 #include "serial_cboard.h"
+#include "boot_prof.h"
+#include "telem_bus.h"
+#include "sched.h"
+#include "telemetry_dsp.h"
+#include "telem_delta.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "driver/uart.h"
 #include "esp_log.h"
 #include "config.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_attr.h"
+#include "uart_capture.h"
+#include "flight_recorder.h"
+#include "task_topology.h"
+#include "mem_budget.h"
 #if TEST_MODE
 #include "simulator.h"
+#include "link_emu.h"
 #endif
 #include "ui_state.h"
 
 static const char *TAG = "serial_cboard";
 
-// 双电机状态维护
-static motor_status_t motor1;
-static motor_status_t motor2;
+#if TEST_MODE && CBOARD_BUS_RS485
+#error "RS-485 bus mode needs real hardware (TEST_MODE=0)"
+#endif
 
-// 用于保护对 motor1/motor2 的并发访问
-#include "freertos/semphr.h"
+// 链路表：每条链路是一个 UART 通道，点对点连接一块 C 板，或以 RS-485 半双工总线挂接多块 C 板。
+// ESP32-S3 只有 3 个 UART（UART0 为 CLI，UART2 为显示屏），因此扩展机架优先使用 RS-485 总线；
+// 释放其它 UART 后可在此追加点对点通道。板号按表中顺序连续编号。
+static const cboard_link_cfg_t s_links[] = {
+#if CBOARD_BUS_RS485
+	{ .name = "rs485", .type = CBOARD_LINK_RS485, .uart = UART_NUM_1, .tx_gpio = 17, .rx_gpio = 18,
+	  .de_gpio = CBOARD_RS485_DE_GPIO, .baud = CBOARD_RS485_BAUD, .boards = CBOARD_RS485_BOARDS },
+#elif TEST_MODE
+	// 模拟器按 SIM_MOTORS 模拟一块或多块板，状态帧以类型化消息的地址区分
+	{ .name = "sim", .type = CBOARD_LINK_UART, .uart = UART_NUM_1, .tx_gpio = 17, .rx_gpio = 18,
+	  .de_gpio = -1, .baud = 115200, .boards = SIM_BOARDS },
+#else
+	{ .name = "uart1", .type = CBOARD_LINK_UART, .uart = UART_NUM_1, .tx_gpio = 17, .rx_gpio = 18,
+	  .de_gpio = -1, .baud = 115200, .boards = 1 },
+#endif
+};
+#define CBOARD_CHANNELS (sizeof(s_links) / sizeof(s_links[0]))
+
+#define SERIAL_RX_BUF_SIZE   2048
+#define SERIAL_RX_CHUNK_SIZE 256  // 单次读取上限，读取即处理以降低延迟
+#define SERIAL_RX_ERR_LOG_US 1000000 // 每个通道接收错误告警的最小间隔
+
+// 帧定义： [0xAA][type][len][payload...][cksum]
+//   type 0x55：点对点遥测/命令，payload 为若干 8 字节电机状态或 6 字节命令
+//   type 0x56：总线请求（主 -> 从），payload 首字节为板地址，其后为命令（可为空，即纯轮询）
+//   type 0x57：总线应答（从 -> 主），payload 首字节为板地址，其后为电机状态
+// 请求与应答使用不同类型，收发器回显的请求帧会被识别并忽略。
+//
+// 类型化消息帧（C 板 -> 主机）：[0xAA][0x5A][msg][addr][len hi][len lo][payload...][cksum]
+//   msg 为消息类型（cboard_msg_type_t），addr 为板地址 1..boards（点对点单板可为 0），len 为 16 位 payload 长度，
+//   cksum 为 msg 至 payload 末尾所有字节之和的低 8 位（覆盖长度字段，损坏的长度不会吞掉后续帧）。
+//   解析器按长度定界，处理函数经 256 项的表按类型常数时间分派，直接读取接收缓冲中的 payload；
+//   表中没有的类型只计数，按长度整帧跳过。
+static const uint8_t FRAME_HDR0 = 0xAA;
+static const uint8_t FRAME_HDR1 = 0x55;
+#define FRAME_BUS_REQ   0x56
+#define FRAME_BUS_REPLY 0x57
+#define FRAME_TYPED     0x5A
+#define FRAME_TYPED_HDR 6
+#define FRAME_MAX_PAYLOAD 255 // 长度字段为 1 字节
+_Static_assert(FRAME_TYPED_HDR + CBOARD_MSG_MAX_PAYLOAD + 1 <= SERIAL_RX_BUF_SIZE,
+			   "CBOARD_MSG_MAX_PAYLOAD must fit in the channel rx buffer");
+#define CBOARD_MAX_CMDS_PER_FRAME (FRAME_MAX_PAYLOAD / 6)
+
+// 总线上每块板的轮询与命令状态
+typedef struct {
+	motor_command_t cmd[CBOARD_MOTORS_PER_BOARD]; // 各电机最新的待发命令（本地 id）
+	uint32_t pending;      // 待发命令位图
+	uint8_t misses;        // 连续超时次数
+	uint16_t skip;         // 离线后跳过的轮询周期数
+	uint16_t reply_len;    // 最近一次应答帧长度（用于估算应答时间）
+	telem_delta_state_t telem; // 批量差分遥测的解码状态
+	bool estop;            // 总线：急停命令待发（由急停轮次优先轮询）
+	cboard_board_stats_t st;
+} cboard_board_t;
+
+// 通道：独立的解析器、发送调度与板集合
+typedef struct {
+	const cboard_link_cfg_t *cfg;
+	uint8_t first_board;   // 该通道第一块板的全局板号
+	uint8_t rx_buf[SERIAL_RX_BUF_SIZE]; // 流式接收缓冲：跨多次读取保留不完整的帧
+	size_t rx_len;
+	uint8_t rx_chunk[SERIAL_RX_CHUNK_SIZE];
+	serial_rx_stats_t stats; // 仅由该通道的接收路径写入
+	int64_t err_since_us;  // 最近一次错误后尚未收到正确帧的起始时间，0 表示链路正常
+	int64_t err_log_us;    // 上次接收错误告警的时刻
+	uint32_t err_log_held; // 此后被限速压下的错误数
+	volatile uint8_t reply_addr; // 总线：最近一次收到应答的板地址
+	volatile bool estop;   // 总线：有急停命令待发，中断当前轮询轮次
+	bool bench;            // 自测基准的私有通道：解析结果只写入基准自己的状态
+	SemaphoreHandle_t tx_lock;
+	StaticSemaphore_t tx_lock_buf;
+} cboard_chan_t;
+
+static cboard_chan_t s_chans[CBOARD_CHANNELS];
+static cboard_board_t s_boards[CBOARD_MAX_BOARDS];
+static uint8_t s_board_count;
+static uint8_t s_board_chan[CBOARD_MAX_BOARDS]; // 板号 -> 通道
+
+// 所有电机状态按全局 id 索引
+#define CBOARD_MAX_MOTORS (CBOARD_MAX_BOARDS * CBOARD_MOTORS_PER_BOARD)
+static motor_status_t s_motors[CBOARD_MAX_MOTORS];
+
+// 派生量：只为出现过的电机分配滤波器槽位（id -> 槽位 + 1，0 = 未分配），查找为 O(1)
+static uint8_t s_dsp_slot[CBOARD_MAX_MOTORS];
+static tdsp_state_t s_dsp[TDSP_MAX_TRACKED];
+static motor_derived_t s_derived[TDSP_MAX_TRACKED];
+static uint8_t s_dsp_used;
+// 遥测代数：每解析完一帧状态加 1，供下游缓存判断数据是否变化
+static volatile uint32_t s_telemetry_gen;
+// 自测基准的解析目标：与实时状态分开，基准帧不进入 s_motors、滤波器槽位、遥测代数与总线。
+// 只有基准任务使用（bench_acquire 保证同时只有一个）；只接受 0 号板的状态帧，按本地 id 索引
+static cboard_chan_t s_bench_chan = { .bench = true };
+static struct {
+	motor_status_t motors[CBOARD_MOTORS_PER_BOARD];
+	tdsp_state_t dsp[CBOARD_MOTORS_PER_BOARD];
+	motor_derived_t derived[CBOARD_MOTORS_PER_BOARD];
+} s_bench;
+
+// 急停通道状态（见 serial_cboard.h）
+typedef struct {
+	volatile bool latched;
+	int64_t trig_us;       // 急停任务尚未处理的最早触发时刻（0 = 无）
+	int64_t out_us;        // 进行中的急停轮次的触发时刻（总线通道尚未发完）
+	uint32_t bus_pending;  // 尚未发出停止命令的总线通道（位图）
+	serial_estop_stats_t st;
+} estop_state_t;
+// ISR 触发路径在 IRAM 中访问（flash 操作期间也可执行），数据显式放在 DRAM
+static DRAM_ATTR portMUX_TYPE s_estop_mux = portMUX_INITIALIZER_UNLOCKED;
+static DRAM_ATTR estop_state_t s_estop;
+static DRAM_ATTR TaskHandle_t s_estop_task;
+static serial_estop_cb_t s_estop_cb;
+
+// 用于保护对电机状态的并发访问
 static SemaphoreHandle_t motor_lock = NULL;
+static StaticSemaphore_t s_motor_lock_buf;
 
-// 返回指定 id 的电机状态（线程安全：复制到静态缓冲区并返回指针）
+uint8_t serial_cboard_global_id(uint8_t board, uint8_t local_id)
+{
+	if (board >= CBOARD_MAX_BOARDS || local_id == 0 || local_id >= CBOARD_MOTORS_PER_BOARD) return 0;
+	return (uint8_t)(board * CBOARD_MOTORS_PER_BOARD + local_id);
+}
+
+bool serial_cboard_map_id(uint8_t global_id, uint8_t *board, uint8_t *local_id)
+{
+	uint8_t b = global_id / CBOARD_MOTORS_PER_BOARD;
+	uint8_t l = global_id % CBOARD_MOTORS_PER_BOARD;
+	if (l == 0 || b >= s_board_count) return false;
+	if (board) *board = b;
+	if (local_id) *local_id = l;
+	return true;
+}
+
+// 返回指定全局 id 的电机状态：指向内部对象的只读指针（每个电机独立存储，
+// 连续查询不同电机不会互相覆盖）。读取时短时加锁，返回后调用者需接受可能的并发更新
 const motor_status_t* get_motor_status(uint8_t id)
 {
-	// 注意：之前实现使用了一个单一的静态缓冲区并返回其地址，
-	// 导致连续两次调用 get_motor_status(1) 和 get_motor_status(2)
-	// 返回的指针指向同一缓冲区，被后一次调用覆盖，进而使
-	// 上层代码误以为两台电机状态相同。这里改为直接返回
-	// 指向内部静态对象 motor1/motor2 的只读指针。
-	// 读取时仍短时加锁以保证一致性（但返回后调用者需
-	// 视为只读并接受可能的并发更新）。
+	if (id == 0 || id >= CBOARD_MAX_MOTORS) return NULL;
 	const motor_status_t *ret = NULL;
 	if (motor_lock) xSemaphoreTake(motor_lock, portMAX_DELAY);
-	if (id == motor1.motor_id) {
-		ret = &motor1;
-	} else if (id == motor2.motor_id) {
-		ret = &motor2;
-	} else {
-		ret = NULL;
-	}
+	if (s_motors[id].motor_id == id) ret = &s_motors[id];
 	if (motor_lock) xSemaphoreGive(motor_lock);
 	return ret;
 }
 
-// UART 配置
-#define SERIAL_PORT_NUM      UART_NUM_1
-#define SERIAL_TX_GPIO       17
-#define SERIAL_RX_GPIO       18
-#define SERIAL_BAUD_RATE     115200
-#define SERIAL_RX_BUF_SIZE   2048
+bool get_motor_derived(uint8_t id, motor_derived_t *out)
+{
+	if (id == 0 || id >= CBOARD_MAX_MOTORS || !out) return false;
+	bool ok = false;
+	if (motor_lock) xSemaphoreTake(motor_lock, portMAX_DELAY);
+	uint8_t slot = s_dsp_slot[id];
+	if (slot && s_derived[slot - 1].samples) {
+		*out = s_derived[slot - 1];
+		ok = true;
+	}
+	if (motor_lock) xSemaphoreGive(motor_lock);
+	return ok;
+}
 
-// 帧定义： [0xAA,0x55][len][payload...][cksum]
-// payload 可为 16 字节（两个电机状态）或其它，由 len 指定
-static const uint8_t FRAME_HDR0 = 0xAA;
-static const uint8_t FRAME_HDR1 = 0x55;
+// 更新一个电机的派生量（调用者持有 motor_lock）；槽位用尽时返回 NULL
+static const motor_derived_t *dsp_update_locked(const motor_status_t *st, int64_t t_us)
+{
+	uint8_t slot = s_dsp_slot[st->motor_id];
+	if (!slot) {
+		if (s_dsp_used >= TDSP_MAX_TRACKED) return NULL;
+		slot = ++s_dsp_used;
+		s_dsp_slot[st->motor_id] = slot;
+		tdsp_reset(&s_dsp[slot - 1]);
+	}
+	tdsp_update(&s_dsp[slot - 1], st, t_us, &s_derived[slot - 1]);
+	return &s_derived[slot - 1];
+}
 
 // helpers
 static uint8_t calc_cksum(const uint8_t *payload, size_t len)
@@ -70,11 +219,119 @@ static uint8_t calc_cksum(const uint8_t *payload, size_t len)
 // 用于记录哪些电机已完成复位（防止重复触发）
 static bool motor_homed_map[256] = { false };
 
-static void parse_and_print_status(const uint8_t *payload, size_t payload_len)
+// 一帧遥测的下游处理状态：各电机的最新值，帧结束时一次发布到遥测总线
+typedef struct {
+	motor_status_t batch[CBOARD_MOTORS_PER_BOARD];
+	motor_derived_t dbatch[CBOARD_MOTORS_PER_BOARD]; // 与 batch 逐项对应的派生量（同一样本）
+	size_t nbatch;
+	bool any;
+	bool bench;            // 基准帧：只写入 s_bench，不记录、不计代数、不发布
+} status_sink_t;
+
+// 样本时间戳：TEST_MODE 下用模拟器虚拟时钟（倍速运行时差分仍然正确）
+static int64_t telemetry_now_us(void)
+{
+#if TEST_MODE
+	return (int64_t)simulator_now_us();
+#else
+	return esp_timer_get_time();
+#endif
+}
+
+// 处理一个电机样本（motor_id 已为全局 id）：记录、更新状态与派生量，并记入本帧的发布批
+static void status_ingest(status_sink_t *sink, const motor_status_t *stp, int64_t t_us)
+{
+	const motor_status_t st = *stp;
+	motor_derived_t dv = { 0 };
+	if (sink->bench) {
+		// 与实时路径相同的加锁与滤波开销，但写入基准的私有状态
+		uint8_t k = st.motor_id % CBOARD_MOTORS_PER_BOARD;
+		if (motor_lock) xSemaphoreTake(motor_lock, portMAX_DELAY);
+		s_bench.motors[k] = st;
+		tdsp_update(&s_bench.dsp[k], &st, t_us, &s_bench.derived[k]);
+		dv = s_bench.derived[k];
+		if (motor_lock) xSemaphoreGive(motor_lock);
+	} else {
+		// 记录仪需要每个样本，不经总线（总线只保留最新值）
+		recorder_log_telemetry(&st);
+
+		// 更新到对应的全局状态，并在同一临界区内更新派生量（加锁保护）；
+		// 派生量随样本一起进入发布批，订阅者读到的原始值与派生量来自同一样本
+		if (motor_lock) xSemaphoreTake(motor_lock, portMAX_DELAY);
+		s_motors[st.motor_id] = st;
+		const motor_derived_t *d = dsp_update_locked(&st, t_us);
+		if (d) dv = *d;
+		if (motor_lock) xSemaphoreGive(motor_lock);
+	}
+
+	sink->any = true;
+	// 批量帧中同一电机有多个样本：批中只保留最新的一个
+	for (size_t i = 0; i < sink->nbatch; ++i) {
+		if (sink->batch[i].motor_id == st.motor_id) {
+			sink->batch[i] = st;
+			sink->dbatch[i] = dv;
+			return;
+		}
+	}
+	if (sink->nbatch == sizeof(sink->batch) / sizeof(sink->batch[0])) {
+		// 异常长的帧：先发布已有的部分
+		if (!sink->bench) telem_bus_publish(sink->batch, sink->dbatch, sink->nbatch);
+		sink->nbatch = 0;
+	}
+	sink->dbatch[sink->nbatch] = dv;
+	sink->batch[sink->nbatch++] = st;
+}
+
+static void status_flush(status_sink_t *sink)
+{
+	if (sink->bench) {
+		sink->nbatch = 0;
+		return;
+	}
+	if (sink->any) {
+		s_telemetry_gen++;
+		boot_event(BOOT_EV_FIRST_TELEMETRY);
+	}
+	// 一帧遥测发布一次，订阅者（上位机 UDP、串口屏、滑块同步、复位检测）由总线唤醒
+	if (sink->nbatch) telem_bus_publish(sink->batch, sink->dbatch, sink->nbatch);
+	sink->nbatch = 0;
+}
+
+// 电流复位检测（总线订阅者，调度器控制执行任务）：只在复位电机的遥测到达时运行。
+// 按 5 点中值电流判断，单个毛刺样本不会误触发，持续的堵转电流在第 3 个样本确认
+#if RESET_BY_CURRENT_ENABLED
+static int s_homing_sub = -1;
+
+static int64_t homing_job(void *arg, int64_t deadline_us)
+{
+	(void)arg;
+	(void)deadline_us;
+	motor_status_t st;
+	motor_derived_t dv;
+	// 原始值与中值电流取自总线上的同一样本
+	if (!telem_bus_get_sample(s_homing_sub, RESET_MOTOR_ID, &st, &dv) || motor_homed_map[RESET_MOTOR_ID]) {
+		return SCHED_NEXT_PERIOD;
+	}
+	int16_t cur_med = dv.samples ? dv.current_med : st.current;
+	int16_t abs_curr = (cur_med < 0) ? -cur_med : cur_med;
+	if (abs_curr >= RESET_CURRENT_RAW_THRESHOLD) {
+		// 标记已复位
+		motor_homed_map[RESET_MOTOR_ID] = true;
+		ESP_LOGI(TAG, "Motor %u reset by overcurrent (median=%d raw=%d)", RESET_MOTOR_ID, cur_med, st.current);
+		// 进入手动模式作为正常控制阶段入口
+		ui_state_set_mode(MODE_MANUAL);
+	}
+	return SCHED_NEXT_PERIOD;
+}
+#endif
+
+static void parse_and_print_status(const cboard_chan_t *ch, uint8_t board, const uint8_t *payload, size_t payload_len)
 {
 	// 每个电机8字节：angle(2), speed(2), current(2), temp(1), id(1)
 	const size_t per = 8;
 	size_t count = payload_len / per;
+	status_sink_t sink = { .nbatch = 0, .bench = ch->bench };
+	int64_t t_us = telemetry_now_us();
 	for (size_t i = 0; i < count; ++i) {
 		const uint8_t *p = payload + i * per;
 		motor_status_t st;
@@ -82,67 +339,398 @@ static void parse_and_print_status(const uint8_t *payload, size_t payload_len)
 		st.speed = (int16_t)((uint16_t)p[2] << 8 | p[3]);
 		st.current = (int16_t)((uint16_t)p[4] << 8 | p[5]);
 		st.temperature = p[6];
-		st.motor_id = p[7];
+		// 帧内为板内本地 id，映射为全局 id（0 号板的全局 id 与本地 id 相同）
+		st.motor_id = serial_cboard_global_id(board, p[7]);
+		if (st.motor_id == 0) continue;
+		status_ingest(&sink, &st, t_us);
+	}
+	status_flush(&sink);
+}
 
-		// 检测是否需要触发电流复位（仅在配置启用时）
-#if RESET_BY_CURRENT_ENABLED
-		if (st.motor_id == RESET_MOTOR_ID) {
-			int16_t abs_curr = (st.current < 0) ? -st.current : st.current;
-			if (!motor_homed_map[st.motor_id] && abs_curr >= RESET_CURRENT_RAW_THRESHOLD) {
-				// 标记已复位
-				motor_homed_map[st.motor_id] = true;
-				ESP_LOGI(TAG, "Motor %u reset by overcurrent (raw=%d)", st.motor_id, st.current);
-				// 进入手动模式作为正常控制阶段入口
-				ui_state_set_mode(MODE_MANUAL);
-			}
-		}
-#endif
+uint32_t serial_cboard_telemetry_gen(void)
+{
+	return s_telemetry_gen;
+}
 
-		// 更新到对应的全局状态（加锁保护）
-		if (motor_lock) xSemaphoreTake(motor_lock, portMAX_DELAY);
-		if (st.motor_id == 1) {
-			motor1 = st;
-		} else if (st.motor_id == 2) {
-			motor2 = st;
-		}
-		if (motor_lock) xSemaphoreGive(motor_lock);
+// 清除复位标记，使下一次电流突变重新触发复位（用于模拟器复位后重复测试）
+void serial_cboard_reset_homing(void)
+{
+	memset(motor_homed_map, 0, sizeof(motor_homed_map));
+}
+
+static void rx_note_error(cboard_chan_t *ch)
+{
+	if (ch->err_since_us == 0) ch->err_since_us = esp_timer_get_time();
+}
 
-		// 打印 -> 在串口监视器中可见
-		// ESP_LOGI(TAG, "Motor %u: angle=%u (0-8191), speed=%d RPM, current=%d (raw), temp=%uC",
-		// 		 st.motor_id, st.angle, st.speed, st.current, st.temperature);
+// 帧错误日志：逐帧只打调试级别；告警按通道限速，附带期间压下的错误数。
+// 噪声链路上每个假帧头都可能校验失败，逐条告警会刷屏，也会计入 parse_cycles
+static void rx_log_error(cboard_chan_t *ch, const char *what)
+{
+	const char *name = ch->cfg ? ch->cfg->name : "bench";
+	ESP_LOGD(TAG, "%s: %s", name, what);
+	int64_t now = esp_timer_get_time();
+	if (ch->err_log_us && now - ch->err_log_us < SERIAL_RX_ERR_LOG_US) {
+		ch->err_log_held++;
+		return;
 	}
+	ESP_LOGW(TAG, "%s: %s (+%lu more since last warning)", name, what, (unsigned long)ch->err_log_held);
+	ch->err_log_us = now;
+	ch->err_log_held = 0;
 }
 
-// 将 raw frame 交给解析器（外部也可调用，用于 TEST_MODE）
-void serial_cboard_process_raw(const uint8_t *data, size_t len)
+static void rx_note_good_frame(cboard_chan_t *ch)
+{
+	serial_rx_stats_t *s = &ch->stats;
+	s->frames_ok++;
+	if (ch->err_since_us != 0) {
+		uint32_t rec = (uint32_t)(esp_timer_get_time() - ch->err_since_us);
+		ch->err_since_us = 0;
+		s->recoveries++;
+		s->recovery_us_total += rec;
+		if (rec > s->recovery_us_max) s->recovery_us_max = rec;
+	}
+}
+
+static bool frame_type_known(uint8_t t)
+{
+	return t == FRAME_HDR1 || t == FRAME_BUS_REQ || t == FRAME_BUS_REPLY || t == FRAME_TYPED;
+}
+
+static inline uint16_t get_be16(const uint8_t *p)
+{
+	return (uint16_t)((uint16_t)p[0] << 8 | p[1]);
+}
+
+// ---- 类型化消息处理函数：payload 指向接收缓冲，长度已按消息表校验 ----
+
+static void msg_status(cboard_chan_t *ch, uint8_t board, const uint8_t *payload, size_t len)
+{
+	parse_and_print_status(ch, board, payload, len);
+}
+
+static void msg_board_power(cboard_chan_t *ch, uint8_t board, const uint8_t *payload, size_t len)
+{
+	(void)ch;
+	(void)len;
+	cboard_board_stats_t *st = &s_boards[board].st;
+	st->voltage_mv = get_be16(payload);
+	st->current_ma = (int16_t)get_be16(payload + 2);
+}
+
+static void msg_error(cboard_chan_t *ch, uint8_t board, const uint8_t *payload, size_t len)
+{
+	(void)len;
+	cboard_board_stats_t *st = &s_boards[board].st;
+	st->errors++;
+	st->last_error = payload[0];
+	st->last_error_motor = payload[1] ? serial_cboard_global_id(board, payload[1]) : 0;
+	st->last_error_detail = get_be16(payload + 2);
+	ESP_LOGW(TAG, "%s: board %u error 0x%02x motor %u detail 0x%04x", ch->cfg->name, board, payload[0],
+			 st->last_error_motor, st->last_error_detail);
+}
+
+static void msg_ack(cboard_chan_t *ch, uint8_t board, const uint8_t *payload, size_t len)
+{
+	(void)ch;
+	(void)len;
+	cboard_board_stats_t *st = &s_boards[board].st;
+	st->acks++;
+	st->last_ack_seq = get_be16(payload);
+	st->last_ack_status = payload[2];
+}
+
+// 参数读取应答：n × [id u16][value i32]，只保留最后一个
+static void msg_param(cboard_chan_t *ch, uint8_t board, const uint8_t *payload, size_t len)
+{
+	(void)ch;
+	cboard_board_stats_t *st = &s_boards[board].st;
+	for (size_t off = 0; off + 6 <= len; off += 6) {
+		const uint8_t *p = payload + off;
+		st->param_reads++;
+		st->last_param_id = get_be16(p);
+		st->last_param_value = (int32_t)((uint32_t)p[2] << 24 | (uint32_t)p[3] << 16 | (uint32_t)p[4] << 8 | p[5]);
+	}
+}
+
+// 批量差分遥测：按板解码，逐样本按各自时刻进入与 0x55/STATUS 相同的处理路径
+typedef struct {
+	uint8_t board;
+	int64_t t_last_us;
+	status_sink_t sink;
+} telem_batch_ctx_t;
+
+static void telem_batch_row(void *arg, const motor_status_t *row, uint8_t motors, uint8_t sample,
+							uint8_t samples, uint16_t interval_us)
+{
+	telem_batch_ctx_t *ctx = arg;
+	int64_t t_us = ctx->t_last_us - (int64_t)(samples - 1 - sample) * interval_us;
+	for (uint8_t m = 0; m < motors; ++m) {
+		motor_status_t st = row[m];
+		st.motor_id = serial_cboard_global_id(ctx->board, row[m].motor_id);
+		if (st.motor_id) status_ingest(&ctx->sink, &st, t_us);
+	}
+}
+
+static void msg_telem_batch(cboard_chan_t *ch, uint8_t board, const uint8_t *payload, size_t len)
+{
+	telem_batch_ctx_t ctx = { .board = board, .t_last_us = telemetry_now_us(), .sink.bench = ch->bench };
+	int n = telem_delta_decode(&s_boards[board].telem, payload, len, telem_batch_row, &ctx);
+	status_flush(&ctx.sink);
+	if (n >= 0) {
+		ch->stats.telem_batches++;
+		ch->stats.telem_samples += (uint32_t)n * payload[2];
+		ch->stats.telem_bytes += (uint32_t)(len + FRAME_TYPED_HDR + 1);
+	} else if (n == TELEM_DELTA_ERR_SYNC) {
+		ch->stats.telem_sync_drops++;
+	} else {
+		ch->stats.msgs_bad_len++;
+	}
+}
+
+// 消息表：min_len 为最短 payload，rec_len 非 0 时超出部分须为整数条记录
+typedef struct {
+	void (*fn)(cboard_chan_t *ch, uint8_t board, const uint8_t *payload, size_t len);
+	uint8_t min_len;
+	uint8_t rec_len;
+} cboard_msg_def_t;
+
+static const cboard_msg_def_t s_msg_table[256] = {
+	[CBOARD_MSG_STATUS]      = { msg_status,      0, 8 },
+	[CBOARD_MSG_BOARD_POWER] = { msg_board_power, 4, 0 },
+	[CBOARD_MSG_ERROR]       = { msg_error,       4, 0 },
+	[CBOARD_MSG_ACK]         = { msg_ack,         3, 0 },
+	[CBOARD_MSG_PARAM]       = { msg_param,       6, 6 },
+	[CBOARD_MSG_TELEM_BATCH] = { msg_telem_batch, TELEM_DELTA_HDR, 0 },
+};
+
+// 校验并分派一帧类型化消息（len 为整帧长度，已由调用者与长度字段核对）
+static bool process_typed(cboard_chan_t *ch, const uint8_t *data, size_t len)
 {
-	if (len < 4) return;
-	if (data[0] != FRAME_HDR0 || data[1] != FRAME_HDR1) return;
+	size_t paylen = len - FRAME_TYPED_HDR - 1;
+	if (calc_cksum(data + 2, len - 3) != data[len - 1]) {
+		ch->stats.cksum_errors++;
+		rx_log_error(ch, "checksum mismatch (typed frame)");
+		rx_note_error(ch);
+		return false;
+	}
+	rx_note_good_frame(ch);
+
+	uint8_t msg = data[2];
+	uint8_t addr = data[3];
+	bool bus = ch->cfg->type == CBOARD_LINK_RS485;
+	if (addr > ch->cfg->boards || (bus && addr == 0)) return true; // 不属于本通道的板
+	uint8_t board = addr ? (uint8_t)(ch->first_board + addr - 1) : ch->first_board;
+
+	const cboard_msg_def_t *d = &s_msg_table[msg];
+	if (!d->fn) {
+		ch->stats.msgs_unknown++;
+		return true;
+	}
+	if (paylen < d->min_len || (d->rec_len ? (paylen - d->min_len) % d->rec_len : 0)) {
+		ch->stats.msgs_bad_len++;
+		return true;
+	}
+	d->fn(ch, board, data + FRAME_TYPED_HDR, paylen);
+	// 总线应答以状态（或批量遥测）消息结束：其余消息须在同一应答中排在状态之前
+	if (bus && (msg == CBOARD_MSG_STATUS || msg == CBOARD_MSG_TELEM_BATCH)) {
+		s_boards[board].reply_len = (uint16_t)len;
+		ch->reply_addr = addr;
+	}
+	return true;
+}
+
+// 帧长：data 至少有 avail 字节；头部尚不完整返回 0，长度非法返回 SIZE_MAX
+static size_t frame_len(const uint8_t *data, size_t avail)
+{
+	if (data[1] != FRAME_TYPED) return avail >= 3 ? (size_t)data[2] + 4 : 0;
+	if (avail < FRAME_TYPED_HDR) return 0;
+	size_t paylen = get_be16(data + 4);
+	if (paylen > CBOARD_MSG_MAX_PAYLOAD) return SIZE_MAX;
+	return FRAME_TYPED_HDR + paylen + 1;
+}
+
+// 校验并解析一帧，返回是否为有效帧
+static bool process_frame(cboard_chan_t *ch, const uint8_t *data, size_t len)
+{
+	if (len < 4) return false;
+	if (data[0] != FRAME_HDR0 || !frame_type_known(data[1])) return false;
+	if (data[1] == FRAME_TYPED) {
+		if (frame_len(data, len) != len) {
+			ch->stats.frames_bad_len++;
+			rx_log_error(ch, "length mismatch (typed frame)");
+			return false;
+		}
+		return process_typed(ch, data, len);
+	}
 	uint8_t paylen = data[2];
 	if ((size_t)paylen + 4 != len) {
-		ESP_LOGW(TAG, "raw len mismatch: expected %u payload, got %u total", paylen, (uint32_t)len);
-		return;
+		ch->stats.frames_bad_len++;
+		rx_log_error(ch, "length mismatch");
+		return false;
 	}
 	const uint8_t *payload = data + 3;
 	uint8_t cksum = data[3 + paylen];
 	if (calc_cksum(payload, paylen) != cksum) {
-		ESP_LOGW(TAG, "checksum mismatch");
-		return;
+		ch->stats.cksum_errors++;
+		rx_log_error(ch, "checksum mismatch");
+		rx_note_error(ch);
+		return false;
+	}
+	if (data[1] == FRAME_HDR1) {
+		parse_and_print_status(ch, ch->first_board, payload, paylen);
+	} else if (data[1] == FRAME_BUS_REPLY && paylen >= 1 && payload[0] >= 1 && payload[0] <= ch->cfg->boards) {
+		uint8_t addr = payload[0];
+		s_boards[ch->first_board + addr - 1].reply_len = (uint16_t)len;
+		parse_and_print_status(ch, ch->first_board + addr - 1, payload + 1, paylen - 1);
+		ch->reply_addr = addr;
 	}
-	parse_and_print_status(payload, paylen);
+	// 其余（回显的总线请求、未知地址）为合法帧但无需处理
+	rx_note_good_frame(ch);
+	return true;
 }
 
-// 打包并发送到 C 板（将一组 motor_command_t 序列化为 payload）
-int serial_cboard_send(const motor_command_t *cmds, size_t cmd_count)
+// 回放期间屏蔽 UART/模拟器输入与真实发送，只接受回放数据
+static volatile bool s_replay_active = false;
+
+// 将 raw frame 交给 0 号通道的解析器（外部也可调用，用于 TEST_MODE）
+void serial_cboard_process_raw(const uint8_t *data, size_t len)
+{
+	if (s_replay_active) return;
+	uart_capture_record(UART_CAPTURE_RX, data, len);
+	process_frame(&s_chans[0], data, len);
+}
+
+bool serial_cboard_bench_parse(const uint8_t *data, size_t len)
+{
+	// 其它帧类型会写板级状态（应答长度、错误/参数统计），不在基准范围内
+	if (len < 2 || data[1] != FRAME_HDR1) return false;
+	return process_frame(&s_bench_chan, data, len);
+}
+
+// 在通道接收缓冲中查找并处理完整帧，返回已消费的字节数
+static size_t rx_scan(cboard_chan_t *ch)
+{
+	size_t idx = 0;
+	while (idx + 4 <= ch->rx_len) {
+		if (ch->rx_buf[idx] != FRAME_HDR0 || !frame_type_known(ch->rx_buf[idx + 1])) {
+			idx++;
+			ch->stats.bytes_discarded++;
+			rx_note_error(ch);
+			continue;
+		}
+		size_t framelen = frame_len(ch->rx_buf + idx, ch->rx_len - idx);
+		if (framelen == 0) break; // 类型化帧头不完整
+		if (framelen == SIZE_MAX) {
+			// 长度超出上限：假帧头或损坏的头部，跳过 1 字节重新同步
+			idx++;
+			ch->stats.bytes_discarded++;
+			rx_note_error(ch);
+			continue;
+		}
+		if (idx + framelen > ch->rx_len) break; // 不完整，保留到下次
+		if (process_frame(ch, ch->rx_buf + idx, framelen)) {
+			idx += framelen;
+		} else {
+			// 校验失败：可能是假帧头，仅跳过 1 字节重新同步
+			idx++;
+			ch->stats.bytes_discarded++;
+		}
+	}
+	return idx;
+}
+
+// 将接收到的字节流交给通道解析器（任意分片均可）
+static void rx_feed(cboard_chan_t *ch, const uint8_t *data, size_t len)
+{
+	uint32_t c0 = esp_cpu_get_cycle_count();
+	ch->stats.bytes_in += (uint32_t)len;
+	while (len > 0) {
+		size_t room = sizeof(ch->rx_buf) - ch->rx_len;
+		size_t n = len < room ? len : room;
+		memcpy(ch->rx_buf + ch->rx_len, data, n);
+		ch->rx_len += n;
+		data += n;
+		len -= n;
+
+		size_t used = rx_scan(ch);
+		if (used > 0) {
+			memmove(ch->rx_buf, ch->rx_buf + used, ch->rx_len - used);
+			ch->rx_len -= used;
+		}
+	}
+	ch->stats.parse_cycles += (uint32_t)(esp_cpu_get_cycle_count() - c0);
+}
+
+// 抓包与回放只针对 0 号通道（多通道字节流交错后无法按单一链路回放）
+void serial_cboard_feed(const uint8_t *data, size_t len)
+{
+	if (!data || s_replay_active) return;
+	uart_capture_record(UART_CAPTURE_RX, data, len);
+	rx_feed(&s_chans[0], data, len);
+}
+
+void serial_cboard_feed_replay(const uint8_t *data, size_t len)
+{
+	if (!data || !s_replay_active) return;
+	rx_feed(&s_chans[0], data, len);
+}
+
+void serial_cboard_set_replay(bool active)
+{
+	if (active) {
+		// 从干净的解析状态开始，使复位逻辑可以重新触发；差分遥测等待回放数据中的关键帧
+		s_replay_active = true;
+		s_chans[0].rx_len = 0;
+		for (int b = 0; b < CBOARD_MAX_BOARDS; ++b) telem_delta_reset(&s_boards[b].telem);
+		serial_cboard_reset_homing();
+	} else {
+		s_chans[0].rx_len = 0;
+		s_replay_active = false;
+	}
+	ESP_LOGI(TAG, "replay %s", active ? "active: live RX and TX suppressed" : "finished");
+}
+
+// 汇总所有通道的接收统计
+void serial_cboard_get_rx_stats(serial_rx_stats_t *out)
+{
+	if (!out) return;
+	memset(out, 0, sizeof(*out));
+	for (size_t i = 0; i < CBOARD_CHANNELS; ++i) {
+		const serial_rx_stats_t *s = &s_chans[i].stats;
+		out->bytes_in += s->bytes_in;
+		out->frames_ok += s->frames_ok;
+		out->cksum_errors += s->cksum_errors;
+		out->bytes_discarded += s->bytes_discarded;
+		out->parse_cycles += s->parse_cycles;
+		out->recoveries += s->recoveries;
+		out->recovery_us_total += s->recovery_us_total;
+		out->msgs_unknown += s->msgs_unknown;
+		out->msgs_bad_len += s->msgs_bad_len;
+		out->frames_bad_len += s->frames_bad_len;
+		out->telem_batches += s->telem_batches;
+		out->telem_samples += s->telem_samples;
+		out->telem_bytes += s->telem_bytes;
+		out->telem_sync_drops += s->telem_sync_drops;
+		if (s->recovery_us_max > out->recovery_us_max) out->recovery_us_max = s->recovery_us_max;
+	}
+}
+
+void serial_cboard_reset_rx_stats(void)
+{
+	for (size_t i = 0; i < CBOARD_CHANNELS; ++i) {
+		memset(&s_chans[i].stats, 0, sizeof(s_chans[i].stats));
+		s_chans[i].err_since_us = 0;
+	}
+}
+
+// 组帧：[0xAA][type][len][addr?][cmds...][cksum]，addr 为 0 时不带地址字节；返回帧长
+static size_t build_cmd_frame(uint8_t *buf, uint8_t type, uint8_t addr, const motor_command_t *cmds, size_t n)
 {
-	if (!cmds || cmd_count == 0) return -1;
-	// 每条命令占 6 字节：target_speed(2), target_pos(2), mode(1), id(1)
-	size_t payload_len = cmd_count * 6;
-	uint8_t *buf = malloc(payload_len + 4);
-	if (!buf) return -1;
-	buf[0] = FRAME_HDR0; buf[1] = FRAME_HDR1; buf[2] = (uint8_t)payload_len;
 	uint8_t *p = buf + 3;
-	for (size_t i = 0; i < cmd_count; ++i) {
+	if (addr) *p++ = addr;
+	// 每条命令占 6 字节：target_speed(2), target_pos(2), mode(1), id(1)
+	for (size_t i = 0; i < n; ++i) {
 		const motor_command_t *c = &cmds[i];
 		p[0] = (uint8_t)((uint16_t)c->target_speed >> 8);
 		p[1] = (uint8_t)((uint16_t)c->target_speed & 0xFF);
@@ -152,31 +740,125 @@ int serial_cboard_send(const motor_command_t *cmds, size_t cmd_count)
 		p[5] = c->motor_id;
 		p += 6;
 	}
-	uint8_t cks = calc_cksum(buf + 3, payload_len);
-	buf[3 + payload_len] = cks;
+	size_t payload_len = (size_t)(p - (buf + 3));
+	buf[0] = FRAME_HDR0; buf[1] = type; buf[2] = (uint8_t)payload_len;
+	*p = calc_cksum(buf + 3, payload_len);
+	return payload_len + 4;
+}
+
+size_t serial_cboard_encode_frame(uint8_t *buf, size_t size, const motor_command_t *cmds, size_t n)
+{
+	if (!buf || n * 6 > FRAME_MAX_PAYLOAD || size < n * 6 + 4) return 0;
+	return build_cmd_frame(buf, FRAME_HDR1, 0, cmds, n);
+}
+
+// 锁存期间丢弃普通命令
+static bool estop_drop(size_t n)
+{
+	if (!s_estop.latched) return false;
+	portENTER_CRITICAL(&s_estop_mux);
+	s_estop.st.dropped_cmds += (uint32_t)n;
+	portEXIT_CRITICAL(&s_estop_mux);
+	return true;
+}
+
+// 点对点通道：直接在调用者任务中组帧发送。急停帧（estop）由急停任务发出：
+// 只等待正在写的那一帧，并等到最后一个字节离开 UART 才返回
+static int p2p_send(cboard_chan_t *ch, uint8_t board, const motor_command_t *cmds, size_t n, bool estop)
+{
+	if (n * 6 > FRAME_MAX_PAYLOAD) return -1;
+	if (!estop && estop_drop(n)) return -1;
+	// 帧缓冲放在调用者栈上（最多 259 字节），发送路径不分配堆内存
+	uint8_t buf[3 + FRAME_MAX_PAYLOAD + 1];
+	size_t len = build_cmd_frame(buf, FRAME_HDR1, 0, cmds, n);
 
 #if TEST_MODE
+	if (ch == &s_chans[0]) uart_capture_record(UART_CAPTURE_TX, buf, len);
 	// 在测试模式下，打印即将发送的帧内容，不真正发送
 	ESP_LOGI(TAG, "TEST_MODE: Frame to send: ");
-	for (size_t i = 0; i < payload_len + 4; ++i) {
-		printf("%02X ", buf[i]);
-	}
-	printf("\n");
-    // 在测试模式下，通知模拟器更新目标（若模拟器存在）
-    if (cmds && cmd_count > 0) {
-        // 回调模拟器，将命令数组传过去（注意类型不严格依赖，以避免循环包含复杂性）
-        simulator_on_command((const void *)cmds, cmd_count);
-    }
-	free(buf);
+	ESP_LOG_BUFFER_HEX_LEVEL(TAG, buf, len, ESP_LOG_INFO);
+	// 在测试模式下，通知模拟器更新目标
+	simulator_on_command(board, (const void *)cmds, n);
 	return 0;
 #else
-	int w = uart_write_bytes(SERIAL_PORT_NUM, (const char *)buf, (int)(payload_len + 4));
-	free(buf);
-	if (w <= 0) return -1;
-	return 0;
+	(void)board;
+	xSemaphoreTake(ch->tx_lock, portMAX_DELAY);
+	// 排队等锁期间触发了急停：本帧不再发出，停止帧不会排在它之后
+	if (!estop && estop_drop(n)) {
+		xSemaphoreGive(ch->tx_lock);
+		return -1;
+	}
+	if (ch == &s_chans[0]) uart_capture_record(UART_CAPTURE_TX, buf, len);
+	int w = uart_write_bytes(ch->cfg->uart, (const char *)buf, len);
+	if (estop) uart_wait_tx_done(ch->cfg->uart, pdMS_TO_TICKS(20));
+	xSemaphoreGive(ch->tx_lock);
+	return w <= 0 ? -1 : 0;
 #endif
 }
 
+// 总线通道：合并为每个电机的最新命令，由总线任务在该板的下一个轮询时隙发出
+static int bus_queue(cboard_chan_t *ch, uint8_t board, const motor_command_t *cmds, size_t n)
+{
+	cboard_board_t *b = &s_boards[board];
+	xSemaphoreTake(ch->tx_lock, portMAX_DELAY);
+	// 在锁内检查：不会覆盖急停已经放入的停止命令
+	if (estop_drop(n)) {
+		xSemaphoreGive(ch->tx_lock);
+		return -1;
+	}
+	for (size_t i = 0; i < n; ++i) {
+		b->cmd[cmds[i].motor_id] = cmds[i];
+		b->pending |= 1u << cmds[i].motor_id;
+	}
+	xSemaphoreGive(ch->tx_lock);
+	return 0;
+}
+
+// 打包并发送到 C 板：命令中的 motor_id 为全局 id，按板分组后转为本地 id 交给各自通道
+int serial_cboard_send(const motor_command_t *cmds, size_t cmd_count)
+{
+	if (!cmds || cmd_count == 0) return -1;
+	if (s_replay_active) {
+		// 回放期间命令不发往 C 板（也不驱动模拟器），避免离线分析时电机动作
+		ESP_LOGD(TAG, "replay: suppressed %u commands", (unsigned)cmd_count);
+		return 0;
+	}
+	if (estop_drop(cmd_count)) return -1;
+	recorder_log_commands(cmds, cmd_count);
+
+	uint32_t done = 0; // 已处理的板（位图）
+	int rc = 0;
+	for (size_t i = 0; i < cmd_count; ++i) {
+		uint8_t board, local;
+		if (!serial_cboard_map_id(cmds[i].motor_id, &board, &local)) {
+			ESP_LOGW(TAG, "no board for motor id %u", cmds[i].motor_id);
+			rc = -1;
+			continue;
+		}
+		if (done & (1u << board)) continue;
+		done |= 1u << board;
+		// 收集该板的全部命令（保持原有顺序）；超过一帧的容量时分多帧发送，不丢弃
+		cboard_chan_t *ch = &s_chans[s_board_chan[board]];
+		motor_command_t local_cmds[CBOARD_MAX_CMDS_PER_FRAME];
+		size_t j = i;
+		while (j < cmd_count) {
+			size_t n = 0;
+			for (; j < cmd_count && n < CBOARD_MAX_CMDS_PER_FRAME; ++j) {
+				uint8_t bj, lj;
+				if (!serial_cboard_map_id(cmds[j].motor_id, &bj, &lj) || bj != board) continue;
+				local_cmds[n] = cmds[j];
+				local_cmds[n].motor_id = lj;
+				n++;
+			}
+			if (n == 0) break;
+			int r = (ch->cfg->type == CBOARD_LINK_RS485) ? bus_queue(ch, board, local_cmds, n)
+														   : p2p_send(ch, board, local_cmds, n, false);
+			if (r != 0) rc = r;
+		}
+	}
+	return rc;
+}
+
 // 发送单个电机命令的便捷函数
 int send_motor_command(uint8_t id, int16_t speed, int16_t pos, uint8_t mode)
 {
@@ -189,65 +871,446 @@ int send_motor_command(uint8_t id, int16_t speed, int16_t pos, uint8_t mode)
 	return serial_cboard_send(&cmd, 1);
 }
 
-// UART 接收并解析任务
+// 一块板上所有电机的停止命令（本地 id），返回条数
+static size_t estop_board_cmds(motor_command_t *cmds)
+{
+	size_t n = 0;
+	for (uint8_t id = 1; id < CBOARD_MOTORS_PER_BOARD; ++id) {
+		cmds[n++] = (motor_command_t){ .control_mode = ESTOP_CONTROL_MODE, .motor_id = id };
+	}
+	return n;
+}
+
+// 一轮急停的所有通道发送完毕：记录延迟。调用者持有 s_estop_mux
+static uint32_t estop_done_locked(int64_t now)
+{
+	uint32_t lat = (uint32_t)(now - s_estop.out_us);
+	serial_estop_stats_t *st = &s_estop.st;
+	s_estop.out_us = 0;
+	st->sent++;
+	st->last_us = lat;
+	st->total_us += lat;
+	if (lat > st->max_us) st->max_us = lat;
+	return lat;
+}
+
+// 向所有通道发停止命令：点对点通道在本任务中直接写，总线通道交给总线任务优先轮询
+static void estop_send_all(void)
+{
+	motor_command_t cmds[CBOARD_MOTORS_PER_BOARD];
+	size_t n = estop_board_cmds(cmds);
+	uint32_t bus = 0;
+	for (size_t i = 0; i < CBOARD_CHANNELS; ++i) {
+		cboard_chan_t *ch = &s_chans[i];
+		uint8_t nb = ch->cfg->boards;
+		if (ch->cfg->type == CBOARD_LINK_RS485) {
+			xSemaphoreTake(ch->tx_lock, portMAX_DELAY);
+			for (uint8_t k = 0; k < nb && ch->first_board + k < CBOARD_MAX_BOARDS; ++k) {
+				cboard_board_t *b = &s_boards[ch->first_board + k];
+				for (size_t j = 0; j < n; ++j) b->cmd[cmds[j].motor_id] = cmds[j];
+				b->pending = ((1u << CBOARD_MOTORS_PER_BOARD) - 1) & ~1u;
+				b->estop = true;
+			}
+			ch->estop = true;
+			xSemaphoreGive(ch->tx_lock);
+			bus |= 1u << i;
+		} else {
+			for (uint8_t k = 0; k < nb && ch->first_board + k < CBOARD_MAX_BOARDS; ++k) {
+				p2p_send(ch, ch->first_board + k, cmds, n, true);
+			}
+		}
+	}
+
+	int64_t now = esp_timer_get_time();
+	int64_t lat = -1;
+	portENTER_CRITICAL(&s_estop_mux);
+	s_estop.bus_pending |= bus;
+	if (!s_estop.bus_pending) lat = estop_done_locked(now);
+	portEXIT_CRITICAL(&s_estop_mux);
+	if (lat >= 0) ESP_LOGW(TAG, "E-STOP sent to all boards in %lld us", (long long)lat);
+
+	// 记录到飞行记录仪（全局 id），放在发送之后，不占用急停延迟
+	for (uint8_t b = 0; b < s_board_count; ++b) {
+		motor_command_t g[CBOARD_MOTORS_PER_BOARD];
+		for (size_t j = 0; j < n; ++j) {
+			g[j] = cmds[j];
+			g[j].motor_id = serial_cboard_global_id(b, cmds[j].motor_id);
+		}
+		recorder_log_commands(g, n);
+	}
+}
+
+// 急停任务：最高优先级，平时阻塞在任务通知上
+static void estop_task(void *arg)
+{
+	(void)arg;
+	while (1) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		int64_t t0;
+		uint8_t src;
+		portENTER_CRITICAL(&s_estop_mux);
+		t0 = s_estop.trig_us;
+		s_estop.trig_us = 0;
+		// 上一轮的总线通道尚未发完时沿用更早的触发时刻，延迟按最早的触发计
+		if (t0 && !s_estop.out_us) s_estop.out_us = t0;
+		src = s_estop.st.last_source;
+		portEXIT_CRITICAL(&s_estop_mux);
+		if (!t0) continue;
+		estop_send_all();
+		ESP_LOGW(TAG, "E-STOP (%s): commands latched off", serial_cboard_estop_source_name(src));
+		if (s_estop_cb) s_estop_cb((estop_source_t)src);
+	}
+}
+
+// 记录一次触发。调用者持有 s_estop_mux（任务或 ISR 临界区）
+static void IRAM_ATTR estop_note_trigger_locked(estop_source_t src, int64_t now)
+{
+	s_estop.latched = true;
+	s_estop.st.triggers++;
+	s_estop.st.last_source = (uint8_t)src;
+	if (!s_estop.trig_us) s_estop.trig_us = now;
+}
+
+void serial_cboard_estop(estop_source_t src)
+{
+	int64_t now = esp_timer_get_time();
+	portENTER_CRITICAL(&s_estop_mux);
+	estop_note_trigger_locked(src, now);
+	portEXIT_CRITICAL(&s_estop_mux);
+	if (s_estop_task) xTaskNotifyGive(s_estop_task);
+}
+
+void IRAM_ATTR serial_cboard_estop_from_isr(estop_source_t src)
+{
+	BaseType_t woken = pdFALSE;
+	int64_t now = esp_timer_get_time();
+	portENTER_CRITICAL_ISR(&s_estop_mux);
+	estop_note_trigger_locked(src, now);
+	portEXIT_CRITICAL_ISR(&s_estop_mux);
+	if (s_estop_task) vTaskNotifyGiveFromISR(s_estop_task, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+void serial_cboard_estop_release(void)
+{
+	portENTER_CRITICAL(&s_estop_mux);
+	bool was = s_estop.latched;
+	s_estop.latched = false;
+	portEXIT_CRITICAL(&s_estop_mux);
+	if (was) ESP_LOGW(TAG, "E-STOP released");
+}
+
+bool serial_cboard_estop_latched(void)
+{
+	return s_estop.latched;
+}
+
+void serial_cboard_set_estop_cb(serial_estop_cb_t cb)
+{
+	s_estop_cb = cb;
+}
+
+void serial_cboard_get_estop_stats(serial_estop_stats_t *out)
+{
+	if (!out) return;
+	portENTER_CRITICAL(&s_estop_mux);
+	*out = s_estop.st;
+	out->latched = s_estop.latched;
+	portEXIT_CRITICAL(&s_estop_mux);
+}
+
+void serial_cboard_reset_estop_stats(void)
+{
+	portENTER_CRITICAL(&s_estop_mux);
+	uint8_t src = s_estop.st.last_source;
+	memset(&s_estop.st, 0, sizeof(s_estop.st));
+	s_estop.st.last_source = src;
+	portEXIT_CRITICAL(&s_estop_mux);
+}
+
+const char *serial_cboard_estop_source_name(uint8_t src)
+{
+	static const char *const names[ESTOP_SRC_COUNT] = { "button", "http", "cli" };
+	return src < ESTOP_SRC_COUNT ? names[src] : "?";
+}
+
+// 点对点通道的 UART 接收并解析任务
 static void serial_task(void *arg)
 {
-	uint8_t *data = malloc(SERIAL_RX_BUF_SIZE);
-	if (!data) vTaskDelete(NULL);
+	cboard_chan_t *ch = (cboard_chan_t *)arg;
+	uint8_t *data = ch->rx_chunk;
 
 	while (1) {
 #if !TEST_MODE
-		int len = uart_read_bytes(SERIAL_PORT_NUM, data, SERIAL_RX_BUF_SIZE, pdMS_TO_TICKS(200));
+		int len = uart_read_bytes(ch->cfg->uart, data, SERIAL_RX_CHUNK_SIZE, pdMS_TO_TICKS(20));
 		if (len <= 0) continue;
-
-		// 简单的流式解析：查找 header
-		int idx = 0;
-		while (idx + 4 <= len) {
-			if (data[idx] == FRAME_HDR0 && data[idx+1] == FRAME_HDR1) {
-				uint8_t paylen = data[idx+2];
-				size_t framelen = (size_t)paylen + 4;
-				if (idx + framelen <= (size_t)len) {
-					// 有完整帧
-					serial_cboard_process_raw(data + idx, framelen);
-					idx += (int)framelen;
-					continue;
-				} else {
-					// 不完整，保留到下次
-					break;
-				}
-			}
-			idx++;
+		// 流式解析：查找 header，不完整的帧保留到下次
+		if (ch == &s_chans[0]) {
+			serial_cboard_feed(data, (size_t)len);
+		} else {
+			rx_feed(ch, data, (size_t)len);
 		}
 #else
-		// 在测试模式下，不从物理 UART 读取，而由 simulator 注入 raw
-		vTaskDelay(pdMS_TO_TICKS(1000));
+		// 在测试模式下，不从物理 UART 读取：
+		// 启用链路仿真时从仿真链路读取字节流，否则由 simulator 直接注入 raw
+		if (link_emu_enabled()) {
+			int len = link_emu_read(data, SERIAL_RX_CHUNK_SIZE, pdMS_TO_TICKS(200));
+			if (len > 0) serial_cboard_feed(data, (size_t)len);
+		} else {
+			vTaskDelay(pdMS_TO_TICKS(100));
+		}
 #endif
 	}
+}
 
-	free(data);
-	vTaskDelete(NULL);
+#if !TEST_MODE
+// 应答预计用时：帧长 * 10 bit / 波特率 + 从机转向时间
+static int64_t bus_reply_timeout_us(const cboard_chan_t *ch, const cboard_board_t *b)
+{
+	uint32_t bytes = b->reply_len ? b->reply_len : 4 + 1 + 8 * 2;
+	return (int64_t)bytes * 10 * 1000000 / ch->cfg->baud + CBOARD_RS485_TURNAROUND_US;
 }
 
-void serial_cboard_init(void)
+// 轮询一块板：发送请求（携带待发命令），等待其应答或超时
+static void bus_poll(cboard_chan_t *ch, uint8_t addr)
 {
-	// 配置 UART
+	uint8_t board = ch->first_board + addr - 1;
+	cboard_board_t *b = &s_boards[board];
+	motor_command_t cmds[CBOARD_MOTORS_PER_BOARD];
+	size_t n = 0;
+	uint32_t sent_mask;
+
+	xSemaphoreTake(ch->tx_lock, portMAX_DELAY);
+	sent_mask = b->pending;
+	for (int i = 0; i < CBOARD_MOTORS_PER_BOARD; ++i) {
+		if (sent_mask & (1u << i)) cmds[n++] = b->cmd[i];
+	}
+	b->pending = 0;
+	xSemaphoreGive(ch->tx_lock);
+
+	uint8_t buf[3 + 1 + CBOARD_MOTORS_PER_BOARD * 6 + 1];
+	size_t len = build_cmd_frame(buf, FRAME_BUS_REQ, addr, cmds, n);
+	if (ch == &s_chans[0]) uart_capture_record(UART_CAPTURE_TX, buf, len);
+
+	ch->reply_addr = 0;
+	int64_t t0 = esp_timer_get_time();
+	uart_write_bytes(ch->cfg->uart, (const char *)buf, len);
+	uart_wait_tx_done(ch->cfg->uart, pdMS_TO_TICKS(10));
+	int64_t deadline = esp_timer_get_time() + bus_reply_timeout_us(ch, b);
+	b->st.polls++;
+
+	// 先取走已缓冲的字节，否则阻塞读 1 字节，应答一到即返回
+	while (ch->reply_addr != addr) {
+		int64_t remain = deadline - esp_timer_get_time();
+		if (remain <= 0) break;
+		size_t avail = 0;
+		uart_get_buffered_data_len(ch->cfg->uart, &avail);
+		if (avail > SERIAL_RX_CHUNK_SIZE) avail = SERIAL_RX_CHUNK_SIZE;
+		TickType_t to = 0;
+		if (!avail) {
+			to = pdMS_TO_TICKS((remain + 999) / 1000);
+			if (to == 0) to = 1;
+		}
+		int r = uart_read_bytes(ch->cfg->uart, ch->rx_chunk, avail ? avail : 1, to);
+		if (r <= 0) continue;
+		if (ch == &s_chans[0]) {
+			serial_cboard_feed(ch->rx_chunk, (size_t)r);
+		} else {
+			rx_feed(ch, ch->rx_chunk, (size_t)r);
+		}
+	}
+
+	if (ch->reply_addr == addr) {
+		uint32_t rtt = (uint32_t)(esp_timer_get_time() - t0);
+		b->st.replies++;
+		b->st.rtt_us_last = rtt;
+		if (rtt > b->st.rtt_us_max) b->st.rtt_us_max = rtt;
+		if (!b->st.online) ESP_LOGI(TAG, "%s: board %u (addr %u) online", ch->cfg->name, board, addr);
+		b->st.online = true;
+		b->misses = 0;
+		return;
+	}
+	b->st.timeouts++;
+	// 未确认的命令放回待发（若期间没有更新的命令），保证最新设定点最终送达
+	xSemaphoreTake(ch->tx_lock, portMAX_DELAY);
+	for (size_t i = 0; i < n; ++i) {
+		uint32_t bit = 1u << cmds[i].motor_id;
+		if (!(b->pending & bit)) {
+			b->cmd[cmds[i].motor_id] = cmds[i];
+			b->pending |= bit;
+		}
+	}
+	xSemaphoreGive(ch->tx_lock);
+	// 连续超时的板视为离线，之后每隔若干周期才试探一次，避免占用总线时间
+	if (++b->misses >= CBOARD_RS485_OFFLINE_MISSES) {
+		if (b->st.online) ESP_LOGW(TAG, "%s: board %u (addr %u) offline", ch->cfg->name, board, addr);
+		b->st.online = false;
+		b->skip = CBOARD_RS485_OFFLINE_RETRY;
+	}
+}
+
+// 总线任务发完本通道所有板的停止命令后调用
+static void estop_bus_done(cboard_chan_t *ch)
+{
+	uint32_t bit = 1u << (uint32_t)(ch - s_chans);
+	int64_t now = esp_timer_get_time();
+	int64_t lat = -1;
+	portENTER_CRITICAL(&s_estop_mux);
+	if (s_estop.bus_pending & bit) {
+		s_estop.bus_pending &= ~bit;
+		if (!s_estop.bus_pending && s_estop.out_us) lat = estop_done_locked(now);
+	}
+	portEXIT_CRITICAL(&s_estop_mux);
+	if (lat >= 0) ESP_LOGW(TAG, "E-STOP sent to all boards in %lld us", (long long)lat);
+}
+
+// 急停轮次：从 1 号地址起轮询每块有停止命令待发的板（包括离线退避中的板），
+// 请求帧全部写出即算本通道完成（未应答的板在之后的轮询中重发）
+static void bus_estop_round(cboard_chan_t *ch)
+{
+	uint64_t addrs = 0; // 地址 1..32
+	xSemaphoreTake(ch->tx_lock, portMAX_DELAY);
+	ch->estop = false;
+	for (uint8_t addr = 1; addr <= ch->cfg->boards; ++addr) {
+		cboard_board_t *b = &s_boards[ch->first_board + addr - 1];
+		if (!b->estop) continue;
+		b->estop = false;
+		b->skip = 0;
+		addrs |= 1ull << addr;
+	}
+	xSemaphoreGive(ch->tx_lock);
+	for (uint8_t addr = 1; addr <= ch->cfg->boards; ++addr) {
+		if (addrs & (1ull << addr)) bus_poll(ch, addr);
+	}
+	estop_bus_done(ch);
+}
+
+// 总线任务：按地址背靠背轮询在线的板，总线不留空闲，聚合遥测吞吐最大
+static void bus_task(void *arg)
+{
+	cboard_chan_t *ch = (cboard_chan_t *)arg;
+	while (1) {
+		bool polled = false;
+		for (uint8_t addr = 1; addr <= ch->cfg->boards; ++addr) {
+			// 急停：当前时隙结束后中断本轮，先发停止命令
+			if (ch->estop) break;
+			cboard_board_t *b = &s_boards[ch->first_board + addr - 1];
+			if (b->skip) {
+				b->skip--;
+				continue;
+			}
+			bus_poll(ch, addr);
+			polled = true;
+		}
+		if (ch->estop) {
+			bus_estop_round(ch);
+			continue;
+		}
+		// 全部离线时让出 CPU，避免空转
+		if (!polled) vTaskDelay(pdMS_TO_TICKS(10));
+	}
+}
+#endif
+
+int serial_cboard_board_count(void)
+{
+	return s_board_count;
+}
+
+bool serial_cboard_get_board_stats(uint8_t board, cboard_board_stats_t *out)
+{
+	if (board >= s_board_count || !out) return false;
+	const cboard_chan_t *ch = &s_chans[s_board_chan[board]];
+	*out = s_boards[board].st;
+	out->channel = s_board_chan[board];
+	out->address = (ch->cfg->type == CBOARD_LINK_RS485) ? (uint8_t)(board - ch->first_board + 1) : 0;
+	if (ch->cfg->type != CBOARD_LINK_RS485) out->online = ch->stats.frames_ok > 0;
+	return true;
+}
+
+const cboard_link_cfg_t *serial_cboard_link_cfg(uint8_t channel)
+{
+	return channel < CBOARD_CHANNELS ? &s_links[channel] : NULL;
+}
+
+static void chan_init(cboard_chan_t *ch)
+{
+	const cboard_link_cfg_t *cfg = ch->cfg;
+	ch->tx_lock = xSemaphoreCreateMutexStatic(&ch->tx_lock_buf);
+#if !TEST_MODE
 	const uart_config_t uart_config = {
-		.baud_rate = SERIAL_BAUD_RATE,
+		.baud_rate = (int)cfg->baud,
 		.data_bits = UART_DATA_8_BITS,
 		.parity = UART_PARITY_DISABLE,
 		.stop_bits = UART_STOP_BITS_1,
 		.flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
 		.source_clk = UART_SCLK_APB,
 	};
-	uart_driver_install(SERIAL_PORT_NUM, SERIAL_RX_BUF_SIZE * 2, 0, 0, NULL, 0);
-	uart_param_config(SERIAL_PORT_NUM, &uart_config);
-	uart_set_pin(SERIAL_PORT_NUM, SERIAL_TX_GPIO, SERIAL_RX_GPIO, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+	uart_driver_install(cfg->uart, SERIAL_RX_BUF_SIZE * 2, 0, 0, NULL, 0);
+	uart_param_config(cfg->uart, &uart_config);
+	if (cfg->type == CBOARD_LINK_RS485) {
+		// 半双工：RTS 引脚驱动收发器 DE，发送期间自动拉高
+		uart_set_pin(cfg->uart, cfg->tx_gpio, cfg->rx_gpio, cfg->de_gpio, UART_PIN_NO_CHANGE);
+		uart_set_mode(cfg->uart, UART_MODE_RS485_HALF_DUPLEX);
+		uart_set_rx_timeout(cfg->uart, 2); // 2 个字符时间无数据即上报，缩短应答等待
+	} else {
+		uart_set_pin(cfg->uart, cfg->tx_gpio, cfg->rx_gpio, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+	}
+#endif
+	ESP_LOGI(TAG, "%s: %s UART%d TX=%d RX=%d baud=%lu boards %u..%u", cfg->name,
+			 cfg->type == CBOARD_LINK_RS485 ? "RS-485 bus" : "point-to-point", cfg->uart,
+			 cfg->tx_gpio, cfg->rx_gpio, (unsigned long)cfg->baud, ch->first_board,
+			 ch->first_board + cfg->boards - 1);
+}
 
-	// 启动解析任务
-	xTaskCreate(serial_task, "serial_task", 4096, NULL, 10, NULL);
+void serial_cboard_init(void)
+{
+	// 初始化状态锁（须先于解析任务创建）
+	if (!motor_lock) motor_lock = xSemaphoreCreateMutexStatic(&s_motor_lock_buf);
 
-	// 初始化状态锁
-	if (!motor_lock) motor_lock = xSemaphoreCreateMutex();
+	// 分配板号并初始化各通道
+	s_board_count = 0;
+	for (size_t i = 0; i < CBOARD_CHANNELS; ++i) {
+		cboard_chan_t *ch = &s_chans[i];
+		ch->cfg = &s_links[i];
+		ch->first_board = s_board_count;
+		for (uint8_t b = 0; b < ch->cfg->boards && s_board_count < CBOARD_MAX_BOARDS; ++b) {
+			s_board_chan[s_board_count++] = (uint8_t)i;
+		}
+		chan_init(ch);
+	}
+	mem_budget_add("serial_cboard", "channel rx buffers", sizeof(s_chans));
+	mem_budget_add("serial_cboard", "motor status table", sizeof(s_motors));
+	mem_budget_add("serial_cboard", "board table", sizeof(s_boards));
+	mem_budget_add("serial_cboard", "telemetry dsp", sizeof(s_dsp) + sizeof(s_derived) + sizeof(s_dsp_slot));
+	mem_budget_add("serial_cboard", "bench parse target", sizeof(s_bench_chan) + sizeof(s_bench));
+
+#if RESET_BY_CURRENT_ENABLED
+	// 复位检测只关心复位电机，其它电机的遥测不唤醒它
+	int job = sched_add("homing", SCHED_EXEC_CTRL, 0, 0, homing_job, NULL);
+	const telem_bus_sub_cfg_t homing = {
+		.name = "homing",
+		.sched_job = job,
+		.ids = { RESET_MOTOR_ID },
+		.nids = 1,
+		.enabled = true,
+	};
+	if (job >= 0) s_homing_sub = telem_bus_subscribe(&homing);
+#endif
+
+	// 急停通道的专用任务（优先级最高，平时不运行）
+	task_topology_create(TASK_ID_ESTOP, estop_task, NULL, &s_estop_task, NULL);
+
+	// 每个通道一个接收/轮询任务
+	for (size_t i = 0; i < CBOARD_CHANNELS; ++i) {
+		char name[16] = "serial_task";
+		if (i) snprintf(name, sizeof(name), "serial_task%u", (unsigned)i);
+		TaskFunction_t fn = serial_task;
+#if !TEST_MODE
+		if (s_chans[i].cfg->type == CBOARD_LINK_RS485) fn = bus_task;
+#endif
+		task_topology_create(TASK_ID_SERIAL, fn, &s_chans[i], NULL, name);
+	}
 
-	ESP_LOGI(TAG, "serial_cboard initialized (UART%d TX=%d RX=%d)", SERIAL_PORT_NUM, SERIAL_TX_GPIO, SERIAL_RX_GPIO);
+	ESP_LOGI(TAG, "serial_cboard initialized (%u channels, %u boards)", (unsigned)CBOARD_CHANNELS, s_board_count);
 }
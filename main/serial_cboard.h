@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 
 typedef struct {
 	uint16_t angle;      // 0-8191 对应 0°-360°
@@ -12,6 +13,18 @@ typedef struct {
 	uint8_t motor_id;
 } motor_status_t;
 
+// 遥测派生量（由 telemetry_dsp 每样本更新，与原始状态一起保存）
+typedef struct {
+	int32_t position;     // 多圈位置（编码器计数，8192 = 一圈）
+	int32_t velocity;     // 角度差分速度（计数/s，滤波后）
+	int32_t accel;        // 加速度（计数/s²，滤波后）
+	int16_t speed_filt;   // 速度反馈滤波值（RPM）
+	int16_t current_med;  // 电流中值（raw）
+	int16_t current_filt; // 电流中值 + EMA（raw）
+	uint16_t current_rms; // 滑动 RMS 电流（raw）
+	uint32_t samples;
+} motor_derived_t;
+
 typedef struct {
 	int16_t target_speed;    // RPM 或相对单位
 	int16_t target_position; // 编码器位置或目标位置
@@ -19,18 +32,167 @@ typedef struct {
 	uint8_t motor_id;
 } motor_command_t;
 
-// 初始化串口通信（创建任务并启动 UART 驱动）
+// 链路（通道）配置：点对点 UART 连接一块 C 板，或 RS-485 半双工总线按地址 1..boards 轮询多块 C 板
+typedef enum {
+	CBOARD_LINK_UART = 0,
+	CBOARD_LINK_RS485,
+} cboard_link_type_t;
+
+typedef struct {
+	const char *name;
+	cboard_link_type_t type;
+	int uart;
+	int tx_gpio;
+	int rx_gpio;
+	int de_gpio;        // RS-485 收发器 DE（由 UART RTS 驱动），点对点为 -1
+	uint32_t baud;
+	uint8_t boards;     // 该链路上的板数
+} cboard_link_cfg_t;
+
+// 每块板的链路统计
+typedef struct {
+	uint8_t channel;
+	uint8_t address;    // 总线地址，点对点为 0
+	bool online;
+	uint32_t polls;     // 总线：轮询次数
+	uint32_t replies;
+	uint32_t timeouts;
+	uint32_t rtt_us_last; // 请求发出到应答解析完成
+	uint32_t rtt_us_max;
+	// 以下来自类型化消息（见 cboard_msg_type_t），未收到时为 0
+	uint16_t voltage_mv;  // 板供电电压
+	int16_t current_ma;   // 板总电流
+	uint32_t errors;
+	uint8_t last_error;
+	uint8_t last_error_motor; // 全局 id，0 = 板级错误
+	uint16_t last_error_detail;
+	uint32_t acks;
+	uint16_t last_ack_seq;
+	uint8_t last_ack_status;
+	uint32_t param_reads;
+	uint16_t last_param_id;
+	int32_t last_param_value;
+} cboard_board_stats_t;
+
+// 类型化消息（C 板 -> 主机，帧格式见 serial_cboard.c），多字节字段均为大端
+typedef enum {
+	CBOARD_MSG_STATUS      = 0x01, // n × 8 字节电机状态（与 0x55 帧相同），不受 31 条限制
+	CBOARD_MSG_BOARD_POWER = 0x02, // [电压 mV u16][电流 mA i16]
+	CBOARD_MSG_ERROR       = 0x03, // [错误码 u8][本地电机 id u8，0 = 板级][详情 u16]
+	CBOARD_MSG_ACK         = 0x04, // [序号 u16][结果 u8]
+	CBOARD_MSG_PARAM       = 0x05, // n × [参数 id u16][值 i32]
+	CBOARD_MSG_TELEM_BATCH = 0x06, // 多个连续样本的差分/变长编码遥测（格式见 telem_delta.h）
+} cboard_msg_type_t;
+
+// 初始化串口通信（按链路表启动各通道的 UART 驱动与接收/轮询任务）
 void serial_cboard_init(void);
 
-// 发送命令到C板（会将命令封装为二进制帧并写入 UART）
+// 电机全局 id 与 (板号, 板内本地 id) 互相映射：global = board * CBOARD_MOTORS_PER_BOARD + local。
+// 0 号板的全局 id 与本地 id 相同；无效时分别返回 0 / false
+uint8_t serial_cboard_global_id(uint8_t board, uint8_t local_id);
+bool serial_cboard_map_id(uint8_t global_id, uint8_t *board, uint8_t *local_id);
+
+int serial_cboard_board_count(void);
+bool serial_cboard_get_board_stats(uint8_t board, cboard_board_stats_t *out);
+const cboard_link_cfg_t *serial_cboard_link_cfg(uint8_t channel);
+
+// 发送命令到C板：motor_id 为全局 id，按板分组后由各自通道发送
+// （点对点通道立即写入 UART；总线通道合并为最新命令，在该板的下一个轮询时隙发出）。
+// 一块板的命令超过单帧容量时按原顺序分多帧发送。急停锁存期间丢弃并返回 -1
 int serial_cboard_send(const motor_command_t *cmds, size_t cmd_count);
 
+// 急停通道：独立于普通命令通道的最高优先级通道。触发后（任意任务或 ISR）由专用的急停任务
+// （优先级高于解析与调度器任务）立即向所有板的所有电机发停止命令，并锁存：
+//   - 点对点通道：只等待正在写入 UART 的那一帧（无法撤回已进入 FIFO 的字节），
+//     排在发送锁上的普通命令拿到锁后看到锁存即丢弃，不会排在停止帧之前；
+//   - 总线通道：停止命令覆盖各板待发的设定点，总线任务在当前时隙结束后从 1 号地址起
+//     先轮询各板（忽略离线退避）发出停止命令，再恢复正常轮询。
+// 锁存期间普通命令（预设、滑块、CLI、UDP、运动规划）一律丢弃并计数，直到显式解除。
+// 延迟 = 触发 -> 所有通道的停止帧发送完毕（点对点等待 UART 发送完成，总线为请求帧写出）。
+typedef enum {
+	ESTOP_SRC_BUTTON = 0,
+	ESTOP_SRC_HTTP,
+	ESTOP_SRC_CLI,
+	ESTOP_SRC_COUNT
+} estop_source_t;
+
+typedef struct {
+	bool latched;
+	uint8_t last_source;    // estop_source_t
+	uint32_t triggers;      // 触发次数（急停任务处理前的重复触发合并为一次发送）
+	uint32_t sent;          // 完成的急停发送轮次
+	uint32_t dropped_cmds;  // 锁存期间丢弃的普通命令数
+	uint32_t last_us;       // 最近一次：触发 -> 停止帧全部发出
+	uint32_t max_us;        // 最坏情况
+	uint64_t total_us;      // 累计（求平均）
+} serial_estop_stats_t;
+
+// 急停命令发出后在急停任务中调用：停止上游的设定点来源（退出预设、终止运动规划等）
+typedef void (*serial_estop_cb_t)(estop_source_t src);
+void serial_cboard_set_estop_cb(serial_estop_cb_t cb);
+
+// 触发急停（任意任务；ISR 中用 _from_isr，它在 IRAM 中，可由 ESP_INTR_FLAG_IRAM 的中断调用）
+void serial_cboard_estop(estop_source_t src);
+void serial_cboard_estop_from_isr(estop_source_t src);
+// 解除锁存，普通命令恢复发送（不恢复之前的设定点）
+void serial_cboard_estop_release(void);
+bool serial_cboard_estop_latched(void);
+void serial_cboard_get_estop_stats(serial_estop_stats_t *out);
+void serial_cboard_reset_estop_stats(void);
+const char *serial_cboard_estop_source_name(uint8_t src);
+
 // 在非硬件环境（TEST_MODE）下，将原始帧数据直接交由解析器处理（用于模拟）
 void serial_cboard_process_raw(const uint8_t *data, size_t len);
 
-// 获取指定 id 的电机状态（返回内部静态副本，调用者不可修改）
+// 将接收到的原始字节流交给解析器（可为任意分片，不完整的帧会保留到下次）
+void serial_cboard_feed(const uint8_t *data, size_t len);
+
+// 回放模式：开启后 UART/模拟器输入被丢弃、发送被抑制，仅接受 serial_cboard_feed_replay 的数据
+void serial_cboard_set_replay(bool active);
+void serial_cboard_feed_replay(const uint8_t *data, size_t len);
+
+// 接收路径统计（所有通道汇总）
+typedef struct {
+	uint32_t bytes_in;          // 输入解析器的字节数
+	uint32_t frames_ok;         // 校验通过的帧数
+	uint32_t cksum_errors;      // 校验失败次数
+	uint32_t frames_bad_len;    // 帧长与长度字段不符的次数（逐帧不告警）
+	uint32_t bytes_discarded;   // 重新同步时丢弃的字节数
+	uint64_t parse_cycles;      // 流式解析耗费的 CPU 周期
+	uint32_t recoveries;        // 出错后恢复到下一个正确帧的次数
+	uint32_t recovery_us_max;   // 最长恢复时间
+	uint64_t recovery_us_total; // 恢复时间累计（用于求平均）
+	uint32_t msgs_unknown;      // 未知类型的类型化消息（按长度整帧跳过）
+	uint32_t msgs_bad_len;      // 长度与消息定义不符而丢弃的消息
+	uint32_t telem_batches;     // 解出的批量差分遥测帧
+	uint32_t telem_samples;     // 其中的电机样本数（电机 × 样本）
+	uint32_t telem_bytes;       // 这些帧的总字节数（含帧头与校验）
+	uint32_t telem_sync_drops;  // 丢帧后等待关键帧而丢弃的差分帧
+} serial_rx_stats_t;
+
+void serial_cboard_get_rx_stats(serial_rx_stats_t *out);
+void serial_cboard_reset_rx_stats(void);
+
+// 清除电流复位标记（模拟器复位后可重新触发复位流程）
+void serial_cboard_reset_homing(void);
+
+// 获取指定全局 id 的电机状态（返回内部静态副本，调用者不可修改；尚未收到遥测时返回 NULL）
 const motor_status_t* get_motor_status(uint8_t id);
 
+// 获取指定全局 id 的派生量（复制到 out）；该电机尚无样本或未分配滤波器槽位时返回 false
+bool get_motor_derived(uint8_t id, motor_derived_t *out);
+
+// 自测基准：按点对点格式组一帧命令（不发送），返回帧长；缓冲不足或命令过多返回 0
+size_t serial_cboard_encode_frame(uint8_t *buf, size_t size, const motor_command_t *cmds, size_t n);
+
+// 自测基准：用私有通道解析一帧点对点状态帧（0xAA 0x55），走与实时帧相同的校验、解码与滤波路径，
+// 结果只写入基准自己的状态，不影响实时遥测（电机状态、派生量、遥测代数、总线、记录仪与抓包）。
+// 只能由基准任务调用；其它帧类型返回 false
+bool serial_cboard_bench_parse(const uint8_t *data, size_t len);
+
+// 遥测代数：每解析完一帧状态报文加 1（回绕无妨，只用于判断是否变化）
+uint32_t serial_cboard_telemetry_gen(void);
+
 // 发送单个电机命令的便捷函数
 int send_motor_command(uint8_t id, int16_t speed, int16_t pos, uint8_t mode);
 
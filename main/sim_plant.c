@@ -0,0 +1,171 @@
+#include "sim_plant.h"
+#include <string.h>
+#include "config.h"
+#include "mem_budget.h"
+
+// 单位与定点格式：位置为编码器计数 Q8（uint32 回绕，低 21 位即 13 位角度 Q8），转速 rpm Q8，
+// 电流 mA，力矩 µNm，温度 °C Q16。乘积可能超出 32 位的地方用 32x32->64 乘法后移位，循环内没有除法。
+
+#define DT_US (1000000 / SIM_PLANT_HZ)
+#define POS_RANGE_Q8 (8191 << 8)
+
+// 由参数推导的常量（编译期）
+#define KE_Q24      ((int64_t)SIM_KT_MNM_PER_A * 6863)              // rpm Q8 -> 反电动势 mV（Ke = Kt，SI 单位）
+#define G_Q16       ((int64_t)65536000 / SIM_R_MOHM)                // mV -> mA（1/R）
+#define A_E_Q15     ((int32_t)(32768LL * DT_US / (SIM_TAU_I_US + DT_US)))
+#define KPOS_Q24    ((int64_t)137438953472LL / (60 * SIM_PLANT_HZ)) // rpm Q8 -> 每步位置增量 Q8
+#define KI_STEP_Q16 ((int64_t)SIM_CB_SPEED_KI * 65536 / SIM_PLANT_HZ)
+#define RAMP_Q8     ((int32_t)SIM_MAX_ACCEL_RPM_PER_SEC * 256 / SIM_PLANT_HZ)
+#define B_Q24       ((int64_t)SIM_B_UNM_PER_KRPM * 16777216 / 256000)
+#define A_TH_Q30    ((int64_t)1073741824 / ((int64_t)SIM_TAU_TH_S * SIM_PLANT_HZ + 1))
+#define I_MAX       SIM_CB_I_MAX_MA
+#define W_MAX_Q8    ((int32_t)SIM_CB_MAX_RPM << 8)
+
+_Static_assert(RAMP_Q8 > 0, "SIM_MAX_ACCEL_RPM_PER_SEC too small for SIM_PLANT_HZ");
+
+// 结构数组：每个阶段顺序扫过几条数组
+typedef struct {
+	// 状态
+	uint32_t pos[SIM_MOTORS];
+	int32_t w[SIM_MOTORS];
+	int32_t i[SIM_MOTORS];
+	int32_t temp[SIM_MOTORS];
+	// 仿真 C 板控制器
+	int32_t w_ref[SIM_MOTORS];
+	int32_t integ[SIM_MOTORS];   // 速度环积分，mA Q8
+	int32_t i_cmd[SIM_MOTORS];
+	// 目标（其它任务写入，单字段写入无需加锁）
+	int16_t tgt_speed[SIM_MOTORS];
+	int16_t tgt_pos[SIM_MOTORS];
+	uint8_t mode[SIM_MOTORS];
+	// 参数
+	int32_t k_acc[SIM_MOTORS];   // 净力矩 µNm -> 每步转速增量 rpm Q8，Q24（含各电机负载惯量）
+	uint8_t hard_stop[SIM_MOTORS];
+} sim_plant_soa_t;
+
+static sim_plant_soa_t s_p;
+
+static inline int32_t clamp32(int32_t v, int32_t lo, int32_t hi)
+{
+	return v < lo ? lo : (v > hi ? hi : v);
+}
+
+void sim_plant_reset(void)
+{
+	memset(&s_p, 0, sizeof(s_p));
+	// J = SIM_J_GCM2 * (1, 1.25, 1.5, 1.75) 循环分配，使各电机负载不同
+	const int64_t base = (int64_t)16777216 * 153600 * 1000 / ((int64_t)6283 * SIM_J_GCM2 * SIM_PLANT_HZ);
+	for (int k = 0; k < SIM_MOTORS; ++k) {
+		s_p.temp[k] = SIM_AMBIENT_C << 16;
+		s_p.k_acc[k] = (int32_t)(base * 4 / (4 + k % 4));
+	}
+}
+
+void sim_plant_init(void)
+{
+	mem_budget_add("simulator", "plant model", sizeof(s_p));
+	sim_plant_reset();
+}
+
+void sim_plant_config(int idx, uint16_t angle, bool hard_stop)
+{
+	if (idx < 0 || idx >= SIM_MOTORS) return;
+	s_p.pos[idx] = (uint32_t)(angle & 8191) << 8;
+	s_p.hard_stop[idx] = hard_stop;
+}
+
+void sim_plant_set_target(int idx, uint8_t mode, int16_t speed, int16_t pos)
+{
+	if (idx < 0 || idx >= SIM_MOTORS) return;
+	s_p.tgt_speed[idx] = speed;
+	s_p.tgt_pos[idx] = pos;
+	s_p.mode[idx] = mode;
+}
+
+void sim_plant_reset_controller(int idx)
+{
+	if (idx < 0 || idx >= SIM_MOTORS) return;
+	s_p.integ[idx] = 0;
+	s_p.w_ref[idx] = s_p.w[idx];
+}
+
+void sim_plant_step(void)
+{
+	// 仿真 C 板：位置环给出速度参考，斜坡限幅后进入速度 PI，输出电流指令
+	for (int k = 0; k < SIM_MOTORS; ++k) {
+		int32_t ref = (int32_t)s_p.tgt_speed[k] << 8;
+		if (s_p.mode[k] == 1) {
+			int32_t err = (int32_t)s_p.tgt_pos[k] - (int32_t)((s_p.pos[k] >> 8) & 8191);
+			if (!s_p.hard_stop[k]) err = ((err + 4096) & 8191) - 4096; // 最短路径
+			ref = err * SIM_CB_POS_KP_Q8;
+		}
+		ref = clamp32(ref, -W_MAX_Q8, W_MAX_Q8);
+		s_p.w_ref[k] += clamp32(ref - s_p.w_ref[k], -RAMP_Q8, RAMP_Q8);
+		int32_t e = s_p.w_ref[k] - s_p.w[k];
+		int32_t integ = s_p.integ[k] + (int32_t)(((int64_t)e * KI_STEP_Q16) >> 16);
+		integ = clamp32(integ, -(I_MAX << 8), I_MAX << 8);
+		s_p.integ[k] = integ;
+		s_p.i_cmd[k] = clamp32((int32_t)(((int64_t)e * SIM_CB_SPEED_KP) >> 8) + (integ >> 8), -I_MAX, I_MAX);
+	}
+
+	// 电气：电流向指令一阶逼近，可达范围为 (±Vbus - 反电动势) / R
+	for (int k = 0; k < SIM_MOTORS; ++k) {
+		int32_t emf = (int32_t)(((int64_t)s_p.w[k] * KE_Q24) >> 24);
+		int32_t hi = (int32_t)(((int64_t)(SIM_VBUS_MV - emf) * G_Q16) >> 16);
+		int32_t lo = (int32_t)(((int64_t)(-SIM_VBUS_MV - emf) * G_Q16) >> 16);
+		int32_t tgt = clamp32(s_p.i_cmd[k], lo, hi);
+		s_p.i[k] += (int32_t)(((int64_t)(tgt - s_p.i[k]) * A_E_Q15) >> 15);
+	}
+
+	// 机械：合力矩积分得转速；库仑摩擦不使转速越过 0（停住后需克服静摩擦才能再动）
+	for (int k = 0; k < SIM_MOTORS; ++k) {
+		int32_t w = s_p.w[k];
+		int32_t drive = s_p.i[k] * SIM_KT_MNM_PER_A - (int32_t)(((int64_t)w * B_Q24) >> 24);
+		int32_t t;
+		if (w > 0) t = drive - SIM_TC_UNM;
+		else if (w < 0) t = drive + SIM_TC_UNM;
+		else t = drive > SIM_TC_UNM ? drive - SIM_TC_UNM : (drive < -SIM_TC_UNM ? drive + SIM_TC_UNM : 0);
+		int32_t wn = w + (int32_t)(((int64_t)t * s_p.k_acc[k]) >> 24);
+		if ((w > 0 && wn < 0) || (w < 0 && wn > 0)) {
+			if (drive <= SIM_TC_UNM && drive >= -SIM_TC_UNM) wn = 0;
+		}
+		int32_t dpos = (int32_t)(((int64_t)wn * KPOS_Q24) >> 24);
+		if (s_p.hard_stop[k]) {
+			int32_t p = (int32_t)s_p.pos[k] + dpos;
+			if (p < 0) {
+				p = 0;
+				if (wn < 0) wn = 0;
+			} else if (p > POS_RANGE_Q8) {
+				p = POS_RANGE_Q8;
+				if (wn > 0) wn = 0;
+			}
+			s_p.pos[k] = (uint32_t)p;
+		} else {
+			s_p.pos[k] += (uint32_t)dpos;
+		}
+		s_p.w[k] = wn;
+	}
+
+	// 热：稳态温升 = i²R * Rth，按时间常数 SIM_TAU_TH_S 逼近
+	for (int k = 0; k < SIM_MOTORS; ++k) {
+		int64_t i = s_p.i[k];
+		int64_t p_mw = (i * i * SIM_R_MOHM * 4295) >> 32;
+		int32_t ss = (SIM_AMBIENT_C << 16) + (int32_t)((p_mw * SIM_RTH_MK_PER_W * 4295) >> 16);
+		s_p.temp[k] += (int32_t)(((int64_t)(ss - s_p.temp[k]) * A_TH_Q30) >> 30);
+	}
+}
+
+void sim_plant_read(int idx, sim_motor_fb_t *out)
+{
+	if (!out || idx < 0 || idx >= SIM_MOTORS) return;
+	int32_t temp = s_p.temp[idx] >> 16;
+	out->angle = (uint16_t)((s_p.pos[idx] >> 8) & 8191);
+	out->speed = (int16_t)clamp32((s_p.w[idx] + 128) >> 8, -32768, 32767);
+	out->current = (int16_t)clamp32(s_p.i[idx] / 10, -32768, 32767);
+	out->temp = (uint8_t)clamp32(temp, 0, 255);
+	out->current_ma = s_p.i[idx];
+	out->current_cmd_ma = s_p.i_cmd[idx];
+	out->speed_ref = (int16_t)clamp32(s_p.w_ref[idx] >> 8, -32768, 32767);
+	out->at_stop = s_p.hard_stop[idx] && s_p.w[idx] == 0 &&
+				   (s_p.pos[idx] == 0 || s_p.pos[idx] == (uint32_t)POS_RANGE_Q8);
+}
@@ -0,0 +1,46 @@
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 模拟器的电机对象模型（TEST_MODE）：SIM_MOTORS 个电机按结构数组（SoA）存放，定点整数运算，
+// 每次 sim_plant_step 以 1/SIM_PLANT_HZ 推进全部电机。每个电机包括：
+//   仿真 C 板控制器  位置 P 环 -> 速度参考斜坡 -> 速度 PI 环（抗积分饱和）-> 电流指令
+//   电气            电流环闭环一阶滞后，输出受母线电压减反电动势限制（高速时电流上不去）
+//   机械            J dω/dt = Kt·i - B·ω - 库仑摩擦（含静摩擦），可选机械限位（相对编码器）
+//   热              绕组一阶 RC：铜损 i²R 加热，向环境温度散热
+// 各阶段在独立的循环中对全部电机计算，便于编译器展开与流水。参数见 config.h 的 SIM_* 配置。
+
+typedef struct {
+	uint16_t angle;     // 0-8191
+	int16_t speed;      // rpm
+	int16_t current;    // C 板上报单位（10 mA）
+	uint8_t temp;       // °C
+	int32_t current_ma;
+	int32_t current_cmd_ma;
+	int16_t speed_ref;  // 斜坡后的速度参考 rpm
+	bool at_stop;       // 顶在机械限位上
+} sim_motor_fb_t;
+
+// 启动时调用一次（登记静态内存并复位）
+void sim_plant_init(void);
+
+// 全部电机恢复初始状态（静止、环境温度、速度模式目标 0）
+void sim_plant_reset(void);
+
+// 设置初始角度与是否有机械限位（限位电机位置限制在 [0, 8191]，不回绕）
+void sim_plant_config(int idx, uint16_t angle, bool hard_stop);
+
+// 更新仿真 C 板的目标（mode 0 = 速度，1 = 位置）
+void sim_plant_set_target(int idx, uint8_t mode, int16_t speed, int16_t pos);
+
+// 清除控制器积分与速度参考（仿真 C 板重新初始化该电机的控制环）
+void sim_plant_reset_controller(int idx);
+
+// 推进全部电机一个步长 1/SIM_PLANT_HZ
+void sim_plant_step(void);
+
+void sim_plant_read(int idx, sim_motor_fb_t *out);
+
+#endif // SIM_PLANT_H
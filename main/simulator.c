@@ -1,101 +1,137 @@
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
 #include "config.h"
 #include "serial_cboard.h"
 #include "simulator.h"
-#include <math.h>
+#include "sim_plant.h"
+#include "link_emu.h"
+#include "telem_delta.h"
+#include "task_topology.h"
+#include "mem_budget.h"
 #include <stdbool.h>
 
 static const char *TAG = "simulator";
 
-// 模拟器实现：维护两个电机的当前状态与目标值，并以 SIM_UPDATE_HZ 的频率
-// 逐步逼近目标值，然后打包帧注入到 serial_cboard_process_raw
+// 模拟器实现：以固定步长 dt = 1/SIM_UPDATE_HZ 推进虚拟时钟，每步内电机模型（sim_plant）
+// 以 SIM_PLANT_HZ 推进若干子步，然后把各板的状态打包成帧注入到 serial_cboard_process_raw
+// （SIM_TELEM_BATCH 时每若干步打包一帧批量差分遥测）。
+// 物理计算全部使用整数（定点）运算，相同输入序列下每次运行的输出完全一致。
 
-typedef struct {
-	uint16_t angle; // 0-8191
-	int16_t speed;  // RPM
-	int16_t current; // raw
-	uint8_t temp;
-	uint8_t id;
-} sim_state_t;
+// 固定步长（微秒）
+#define SIM_STEP_US (1000000ULL / SIM_UPDATE_HZ)
+#define SIM_SUBSTEPS (SIM_PLANT_HZ / SIM_UPDATE_HZ)
 
-static sim_state_t cur_state[2];
+_Static_assert(SIM_PLANT_HZ % SIM_UPDATE_HZ == 0, "SIM_PLANT_HZ must be a multiple of SIM_UPDATE_HZ");
+_Static_assert(SIM_BOARDS <= CBOARD_MAX_BOARDS, "SIM_MOTORS needs more boards than CBOARD_MAX_BOARDS");
+#if SIM_BOARDS > 1 && !SIM_TYPED_FRAMES
+#error "SIM_MOTORS beyond one board needs SIM_TYPED_FRAMES (legacy frames carry no board address)"
+#endif
+#if SIM_TELEM_BATCH
+#if !SIM_TYPED_FRAMES
+#error "SIM_TELEM_BATCH needs SIM_TYPED_FRAMES"
+#endif
+_Static_assert(SIM_TELEM_BATCH <= 255 && SIM_TELEM_KEYFRAME > 0, "SIM_TELEM_BATCH must be 1..255");
+// 最满的一块板（0 号板）按最坏情况（每个残差取最长编码）须能放进一帧
+#define SIM_TELEM_MAX_MOTORS (SIM_MOTORS < SIM_MOTORS_PER_BOARD ? SIM_MOTORS : SIM_MOTORS_PER_BOARD)
+_Static_assert(TELEM_DELTA_MAX_PAYLOAD(SIM_TELEM_MAX_MOTORS, SIM_TELEM_BATCH) <= CBOARD_MSG_MAX_PAYLOAD,
+			   "SIM_TELEM_BATCH samples do not fit in CBOARD_MSG_MAX_PAYLOAD");
+_Static_assert(SIM_STEP_US <= 65535, "SIM_UPDATE_HZ too low for the 16-bit batch sample interval");
 
-// 模拟器内部的 homing 标志（仅在模拟器层面用于产生电流突变）
-static bool sim_homed[2] = { false, false };
+// 批量差分遥测：每板缓存 SIM_TELEM_BATCH 步的样本，满后编码成一帧
+static motor_status_t s_telem_buf[SIM_BOARDS][SIM_TELEM_BATCH * SIM_MOTORS_PER_BOARD];
+static telem_delta_state_t s_telem_enc[SIM_BOARDS];
+static uint32_t s_telem_frames[SIM_BOARDS];
+static uint8_t s_telem_n; // 已缓存的样本数（各板同步）
+#endif
 
-// 目标由 simulator_on_command 更新（接收来自 serial_cboard_send 的命令）
-typedef struct {
-	int16_t target_speed;
-	int16_t target_position;
-	uint8_t control_mode; // 0 speed, 1 position
-	uint8_t motor_id;
-} sim_target_t;
+// 复位时的堵转持续时间：真实电机顶住机械限位时电流持续数百毫秒，
+// 而不是单个样本的毛刺（固件侧按中值滤波后的电流判断）；之后仿真 C 板松开控制环
+#define SIM_STALL_US 200000
 
-static sim_target_t targets[2];
+// 模拟器内部的 homing 标志（仅在模拟器层面用于结束堵转）
+static bool s_homed;
+static uint64_t s_release_us; // 非 0：到该虚拟时刻结束堵转
+static int s_reset_idx = -1;  // RESET_MOTOR_ID 对应的模型下标
 
-// helper: 找到 motor index (0/1) 对应 id
-static int find_index_by_id(uint8_t id)
+// 电机下标 <-> (板号, 板内本地 id)：每板依次放 SIM_MOTORS_PER_BOARD 个电机，本地 id 从 1 开始
+static int sim_index(uint8_t board, uint8_t local_id)
 {
-	for (int i = 0; i < 2; ++i) if (cur_state[i].id == id) return i;
-	return -1;
+	if (local_id == 0 || local_id > SIM_MOTORS_PER_BOARD) return -1;
+	int idx = board * SIM_MOTORS_PER_BOARD + local_id - 1;
+	return idx < SIM_MOTORS ? idx : -1;
 }
 
-// 外部回调：当 ESP 在 TEST_MODE 下发送命令时 serial_cboard 会调用此函数
-void simulator_on_command(const void *cmds_void, size_t cmd_count)
+// 外部回调：当 ESP 在 TEST_MODE 下向 board 发送命令时 serial_cboard 会调用此函数（命令为本地 id）
+void simulator_on_command(uint8_t board, const void *cmds_void, size_t cmd_count)
 {
 	if (!cmds_void || cmd_count == 0) return;
 	const motor_command_t *cmds = (const motor_command_t *)cmds_void;
 	for (size_t i = 0; i < cmd_count; ++i) {
 		const motor_command_t *c = &cmds[i];
-		int idx = find_index_by_id(c->motor_id);
-		if (idx < 0) {
-			// 如果未初始化过该 id，则使用第一个空位
-			for (int j = 0; j < 2; ++j) {
-				if (cur_state[j].id == 0) { idx = j; break; }
-			}
-			if (idx < 0) idx = 0; // 强制使用 0
-			cur_state[idx].id = c->motor_id;
-		}
-		targets[idx].target_speed = c->target_speed;
-		targets[idx].target_position = c->target_position;
-		targets[idx].control_mode = c->control_mode;
-		targets[idx].motor_id = c->motor_id;
-		ESP_LOGI(TAG, "simulator: received cmd for id=%u mode=%u tgt_speed=%d tgt_pos=%d (idx=%d)",
-				 c->motor_id, c->control_mode, c->target_speed, c->target_position, idx);
+		int idx = sim_index(board, c->motor_id);
+		if (idx < 0) continue;
+		sim_plant_set_target(idx, c->control_mode, c->target_speed, c->target_position);
+		ESP_LOGD(TAG, "simulator: received cmd for board=%u id=%u mode=%u tgt_speed=%d tgt_pos=%d (idx=%d)",
+				 board, c->motor_id, c->control_mode, c->target_speed, c->target_position, idx);
 	}
 }
 
-// 初始化默认值（第一次运行时）
-static void sim_init_once(void)
+// 虚拟时钟与运行控制
+static uint64_t s_sim_time_us = 0;       // 虚拟时间（每步固定推进 SIM_STEP_US）
+static uint64_t s_sim_steps = 0;         // 已执行步数
+static uint32_t s_trace_hash = 2166136261u; // 注入帧序列的 FNV-1a 摘要，用于比对两次运行
+static volatile uint32_t s_speed = SIM_DEFAULT_SPEED; // 1=实时, N=N 倍速, 0=尽可能快
+static volatile bool s_reset_pending = false;
+static volatile uint64_t s_run_until_us = 0; // 非 0 时以最快速度运行至该虚拟时间
+static uint32_t s_saved_speed = SIM_DEFAULT_SPEED;
+static portMUX_TYPE s_run_mux = portMUX_INITIALIZER_UNLOCKED; // 定时运行的结束与调用者超时互斥
+static uint32_t s_overruns = 0;          // 实时模式下落后超过 1s 而重新对齐的次数
+static SemaphoreHandle_t s_run_done = NULL;
+static StaticSemaphore_t s_run_done_buf;
+static sim_step_hook_t s_step_hook = NULL;
+static uint64_t s_plant_cycles;          // 电机模型累计 CPU 周期（每个子步）
+static uint32_t s_plant_cycles_max;
+
+// 恢复确定性初始状态（仅在 sim_task 上下文中调用）
+static void sim_reset_state(void)
 {
-	static bool inited = false;
-	if (inited) return;
-	inited = true;
-	// 默认 id 1/2
-	cur_state[0].id = 1; cur_state[0].angle = 0; cur_state[0].speed = 0; cur_state[0].current = 0; cur_state[0].temp = 30;
-	cur_state[1].id = 2; cur_state[1].angle = 4096; cur_state[1].speed = 0; cur_state[1].current = 0; cur_state[1].temp = 30;
-	// 默认目标为当前值
-	for (int i = 0; i < 2; ++i) {
-		targets[i].motor_id = cur_state[i].id;
-		targets[i].target_speed = cur_state[i].speed;
-		targets[i].target_position = cur_state[i].angle;
-		targets[i].control_mode = 0;
+	sim_plant_reset();
+	s_reset_idx = -1;
+	for (int k = 0; k < SIM_MOTORS; ++k) {
+		uint8_t board = (uint8_t)(k / SIM_MOTORS_PER_BOARD);
+		uint8_t id = serial_cboard_global_id(board, (uint8_t)(1 + k % SIM_MOTORS_PER_BOARD));
+		// 复位电机（如 M3508）为相对编码，行程两端是机械限位；初始位于行程中点
+		bool reset_motor = id == RESET_MOTOR_ID;
+		if (reset_motor) s_reset_idx = k;
+		sim_plant_config(k, (k & 1) ? 4096 : 0, reset_motor);
 	}
+	s_homed = false;
+	s_release_us = 0;
+	s_sim_time_us = 0;
+	s_sim_steps = 0;
+	s_trace_hash = 2166136261u;
+	s_plant_cycles = 0;
+	s_plant_cycles_max = 0;
+#if SIM_TELEM_BATCH
+	// 复位后的第一帧为关键帧
+	memset(s_telem_enc, 0, sizeof(s_telem_enc));
+	memset(s_telem_frames, 0, sizeof(s_telem_frames));
+	s_telem_n = 0;
+#endif
 
 	// 在测试模式下，如果启用了电流复位，则对指定的复位电机施加一个缓慢的反向速度，
-	// 以便在到达编码 0 时触发电流突变（仅模拟）。
+	// 使其顶到编码 0 处的机械限位，由仿真 C 板的速度环积分出堵转电流（仅模拟）。
 #if RESET_BY_CURRENT_ENABLED
-	for (int i = 0; i < 2; ++i) {
-		if (cur_state[i].id == RESET_MOTOR_ID) {
-			// 小反向速度（RPM），使编码逐渐减小到 0
-			targets[i].target_speed = -5; // 可根据需要调整
-			sim_homed[i] = false;
-			ESP_LOGI(TAG, "simulator: motor id %u will perform startup homing (sim)", cur_state[i].id);
-		}
+	if (s_reset_idx >= 0) {
+		sim_plant_set_target(s_reset_idx, 0, -5, 0);
+		ESP_LOGI(TAG, "simulator: motor id %u will perform startup homing (sim)", RESET_MOTOR_ID);
 	}
 #endif
 }
@@ -107,157 +143,305 @@ static inline void put_be16(uint8_t *buf, uint16_t v)
 	buf[1] = v & 0xFF;
 }
 
+// 复位电机的回零过程：堵转电流达到固件阈值后保持 SIM_STALL_US，再松开控制环并停止
+static void sim_homing(void)
+{
+	if (s_reset_idx < 0) return;
+	sim_motor_fb_t fb;
+	sim_plant_read(s_reset_idx, &fb);
+#if RESET_BY_CURRENT_ENABLED
+	if (!s_homed && fb.at_stop && abs(fb.current) >= RESET_CURRENT_RAW_THRESHOLD) {
+		s_homed = true;
+		s_release_us = s_sim_time_us + SIM_STALL_US;
+		ESP_LOGI(TAG, "simulator: motor id %u simulated homing reached -> stall current %ld mA",
+				 RESET_MOTOR_ID, (long)fb.current_ma);
+	}
+	if (s_release_us && s_sim_time_us >= s_release_us) {
+		s_release_us = 0;
+		sim_plant_set_target(s_reset_idx, 0, 0, 0);
+		sim_plant_reset_controller(s_reset_idx);
+	}
+#elif RESET_BY_SWITCH_ENABLED
+	if (!s_homed && fb.angle <= RESET_SWITCH_ANGLE_THRESHOLD) {
+		// 模拟微动开关触发：仿真 C 板立即停止该电机
+		s_homed = true;
+		sim_plant_set_target(s_reset_idx, 0, 0, 0);
+		sim_plant_reset_controller(s_reset_idx);
+		ESP_LOGI(TAG, "simulator: motor id %u simulated homing reached -> switch triggered", RESET_MOTOR_ID);
+	}
+#endif
+}
+
+// 记录输出轨迹摘要（FNV-1a）并注入解析器：启用链路仿真时经字节通道进入真实接收路径，否则直接交给帧解析
+static void sim_emit(const uint8_t *frame, size_t len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		s_trace_hash = (s_trace_hash ^ frame[i]) * 16777619u;
+	}
+	if (link_emu_enabled()) {
+		link_emu_write_frame(frame, len);
+	} else {
+		serial_cboard_process_raw(frame, len);
+	}
+}
+
+#if SIM_TYPED_FRAMES
+// 类型化消息帧 [0xAA][0x5A][msg][addr][len hi][len lo][payload][cksum]（格式见 serial_cboard.c）
+static void sim_emit_typed(uint8_t msg, uint8_t addr, const uint8_t *payload, size_t len)
+{
+	static uint8_t frame[6 + CBOARD_MSG_MAX_PAYLOAD + 1]; // 仅 sim_task 使用
+	if (len > CBOARD_MSG_MAX_PAYLOAD) return;
+	frame[0] = 0xAA; frame[1] = 0x5A; frame[2] = msg; frame[3] = addr;
+	put_be16(frame + 4, (uint16_t)len);
+	memcpy(frame + 6, payload, len);
+	uint8_t ssum = 0;
+	for (size_t i = 2; i < 6 + len; ++i) ssum += frame[i];
+	frame[6 + len] = ssum;
+	sim_emit(frame, 6 + len + 1);
+}
+#endif
+
+#if SIM_TELEM_BATCH
+// 缓存一块板本步的样本；批满时编码发出
+static void sim_telem_batch(int board, uint8_t addr, const motor_status_t *row, uint8_t motors, bool last)
+{
+	memcpy(&s_telem_buf[board][s_telem_n * motors], row, motors * sizeof(row[0]));
+	if (!last) return;
+	static uint8_t payload[TELEM_DELTA_MAX_PAYLOAD(SIM_TELEM_MAX_MOTORS, SIM_TELEM_BATCH)];
+	bool key = s_telem_frames[board] % SIM_TELEM_KEYFRAME == 0;
+	size_t len = telem_delta_encode(&s_telem_enc[board], payload, sizeof(payload), s_telem_buf[board], motors,
+									SIM_TELEM_BATCH, (uint16_t)SIM_STEP_US, key);
+	s_telem_frames[board]++;
+	if (len) sim_emit_typed(CBOARD_MSG_TELEM_BATCH, addr, payload, len);
+}
+#endif
+
+// 执行一个固定步长：调用步进钩子 -> 推进电机模型 -> 注入帧 -> 推进虚拟时钟
+static void sim_step(void)
+{
+	// 钩子在当前虚拟时刻运行（例如预设轨迹），其发出的命令在本步生效
+	if (s_step_hook) s_step_hook(s_sim_time_us);
+
+	for (int n = 0; n < SIM_SUBSTEPS; ++n) {
+		uint32_t c0 = esp_cpu_get_cycle_count();
+		sim_plant_step();
+		uint32_t dc = esp_cpu_get_cycle_count() - c0;
+		s_plant_cycles += dc;
+		if (dc > s_plant_cycles_max) s_plant_cycles_max = dc;
+	}
+	sim_homing();
+
+	// 每块板一帧：板内电机各 8 字节（角度、速度、电流、温度、本地 id）；
+	// 批量模式下改为缓存样本，每 SIM_TELEM_BATCH 步发一帧差分编码的遥测
+#if SIM_TELEM_BATCH
+	bool batch_full = s_telem_n + 1 == SIM_TELEM_BATCH;
+#endif
+	for (int board = 0; board < SIM_BOARDS; ++board) {
+		uint8_t payload[SIM_MOTORS_PER_BOARD * 8];
+		size_t len = 0;
+		uint32_t ma = 0;
+#if SIM_TELEM_BATCH
+		motor_status_t row[SIM_MOTORS_PER_BOARD];
+		uint8_t nrow = 0;
+#endif
+		for (int k = board * SIM_MOTORS_PER_BOARD; k < SIM_MOTORS && k < (board + 1) * SIM_MOTORS_PER_BOARD; ++k) {
+			sim_motor_fb_t fb;
+			sim_plant_read(k, &fb);
+			put_be16(payload + len + 0, fb.angle);
+			put_be16(payload + len + 2, (uint16_t)fb.speed);
+			put_be16(payload + len + 4, (uint16_t)fb.current);
+			payload[len + 6] = fb.temp;
+			payload[len + 7] = (uint8_t)(1 + k % SIM_MOTORS_PER_BOARD);
+			len += 8;
+			ma += (uint32_t)abs(fb.current_ma);
+#if SIM_TELEM_BATCH
+			row[nrow++] = (motor_status_t){
+				.angle = fb.angle,
+				.speed = fb.speed,
+				.current = fb.current,
+				.temperature = fb.temp,
+				.motor_id = (uint8_t)(1 + k % SIM_MOTORS_PER_BOARD),
+			};
+#endif
+		}
+#if SIM_TYPED_FRAMES
+		uint8_t addr = SIM_BOARDS > 1 ? (uint8_t)(board + 1) : 0;
+#if SIM_TELEM_BATCH
+		sim_telem_batch(board, addr, row, nrow, batch_full);
+#else
+		sim_emit_typed(CBOARD_MSG_STATUS, addr, payload, len);
+#endif
+		// 每秒一条板供电消息：母线 SIM_VBUS_MV，内阻 50 mΩ
+		if (s_sim_steps % SIM_UPDATE_HZ == 0) {
+			if (ma > 32767) ma = 32767;
+			uint8_t power[4];
+			put_be16(power, (uint16_t)(SIM_VBUS_MV - ma / 20));
+			put_be16(power + 2, (uint16_t)ma);
+			sim_emit_typed(CBOARD_MSG_BOARD_POWER, addr, power, sizeof(power));
+		}
+#else
+		(void)ma;
+		uint8_t frame[3 + sizeof(payload) + 1];
+		frame[0] = 0xAA; frame[1] = 0x55; frame[2] = (uint8_t)len;
+		memcpy(frame + 3, payload, len);
+		uint8_t ssum = 0;
+		for (size_t i = 0; i < len; ++i) ssum += payload[i];
+		frame[3 + len] = ssum;
+		sim_emit(frame, len + 4);
+#endif
+	}
+#if SIM_TELEM_BATCH
+	s_telem_n = batch_full ? 0 : s_telem_n + 1;
+#endif
+
+	s_sim_time_us += SIM_STEP_US;
+	s_sim_steps++;
+}
+
 // 每个周期更新状态并注入帧
 static void sim_task(void *arg)
 {
-	sim_init_once();
-	ESP_LOGI(TAG, "simulator started (TEST_MODE=%d) update_hz=%d", TEST_MODE, SIM_UPDATE_HZ);
-	const float hz = (float)SIM_UPDATE_HZ;
-	const float dt = 1.0f / hz;
+	sim_reset_state();
+	ESP_LOGI(TAG, "simulator started (TEST_MODE=%d) update_hz=%d plant_hz=%d motors=%d boards=%d speed=%u",
+			 TEST_MODE, SIM_UPDATE_HZ, SIM_PLANT_HZ, SIM_MOTORS, SIM_BOARDS, (unsigned)s_speed);
 
-	// 动力学参数（可调）
-	const float max_accel_rpm_per_sec = 2000.0f; // 最大加速度
-	const float pos_k = 0.5f; // 位置误差到速度的比例 (RPM per encoder unit)
-	const int16_t max_rpm = 4000; // 限幅
+	// 实时/倍速模式下的绝对截止时间（真实时间 us），按截止时间睡眠，避免误差累积
+	int64_t next_deadline = esp_timer_get_time();
+	uint32_t fast_steps = 0;
 
 	while (1) {
-		// 更新每个电机
-		for (int i = 0; i < 2; ++i) {
-			sim_state_t *s = &cur_state[i];
-			sim_target_t *t = &targets[i];
-
-			// 根据 control_mode 决定期望速度
-			int16_t desired_speed = t->target_speed;
-			if (t->control_mode == 1) {
-				// 位置控制：计算最短角度差（编码器单位 0..8191）
-				int32_t diff = (int32_t)t->target_position - (int32_t)s->angle;
-				// wrap to [-4096,4095]
-				while (diff > 4096) diff -= 8192;
-				while (diff < -4096) diff += 8192;
-				// 把位置误差映射为速度
-				float v = diff * pos_k;
-				if (v > max_rpm) v = max_rpm;
-				if (v < -max_rpm) v = -max_rpm;
-				desired_speed = (int16_t)v;
-			}
+		if (s_reset_pending) {
+			s_reset_pending = false;
+			sim_reset_state();
+			next_deadline = esp_timer_get_time();
+		}
 
-			// 限制加速度：每秒 max_accel_rpm_per_sec
-			float max_delta_per_tick = max_accel_rpm_per_sec * dt;
-			float delta = (float)desired_speed - (float)s->speed;
-			if (delta > max_delta_per_tick) delta = max_delta_per_tick;
-			if (delta < -max_delta_per_tick) delta = -max_delta_per_tick;
-			s->speed = (int16_t)roundf((float)s->speed + delta);
-
-			// 更新角度： RPM -> 编码器单位增量
-			// RPM -> rev/s = RPM/60, rev/s * 8192 = units/s
-			float units_per_sec = ((float)s->speed) / 60.0f * 8192.0f;
-			float units_step = units_per_sec * dt;
-			int32_t prev_angle = s->angle;
-			int32_t candidate_angle = prev_angle + (int32_t)roundf(units_step);
-
-
-			// 先计算基础模拟电流：与速度变化相关（简单模型）
-			int16_t simulated_current = (int16_t)roundf(delta * 0.5f); // scale
-
-			// 对于相对编码（如 M3508，配置为 RESET_MOTOR_ID），不允许环绕，严格 clamp 到 [0,8191]
-			if (s->id == RESET_MOTOR_ID) {
-				if (candidate_angle < 0) {
-					// 到达下限，保持为 0（不环绕）
-					s->angle = 0;
-					// 如果仍在向负方向移动，模拟堵转/碰撞导致电流显著增大（恒定 bump，而非累加）
-					if (s->speed < 0) {
-						int bump = 1000 + (int)(abs(s->speed) / 2);
-						if (bump > 2000) bump = 2000;
-						// 直接设置为 bump（保留方向由速度决定）
-						simulated_current = (s->speed < 0) ? -bump : bump;
-					}
-				} else if (candidate_angle > 8191) {
-					// 到达上限，保持为 8191（不环绕）
-					s->angle = 8191;
-					if (s->speed > 0) {
-						int bump = 1000 + (int)(abs(s->speed) / 2);
-						if (bump > 2000) bump = 2000;
-						simulated_current = (s->speed < 0) ? -bump : bump;
-					}
-				} else {
-					s->angle = (uint16_t)candidate_angle;
-				}
-			} else {
-				// 绝对编码或其他电机，保持原来的环绕行为
-				int32_t new_angle = candidate_angle % 8192;
-				if (new_angle < 0) new_angle += 8192;
-				s->angle = (uint16_t)new_angle;
-			}
+		sim_step();
 
-			// 支持两种复位模拟方式：电流突增（RESET_BY_CURRENT_ENABLED）或微动开关触发（RESET_BY_SWITCH_ENABLED）
-#if RESET_BY_CURRENT_ENABLED
-			if (s->id == RESET_MOTOR_ID) {
-				// 当未标记为 homed 且到达接近开关位置/处于边界并产生较高电流时触发
-				if (!sim_homed[i]) {
-					// 如果电流已经被模拟成很高（例如刚才因为边界导致的 bump），触发 homing
-					if (abs(simulated_current) >= RESET_CURRENT_RAW_THRESHOLD || s->angle == 0 || s->angle <= RESET_SWITCH_ANGLE_THRESHOLD) {
-						simulated_current = 2000;
-						sim_homed[i] = true;
-						// 停止移动
-						s->speed = 0;
-						targets[i].target_speed = 0;
-						ESP_LOGI(TAG, "simulator: motor id %u simulated homing reached -> current spike", s->id);
-					}
-				}
-			}
-#endif
+		// 定时运行结束：恢复原速度并通知等待者
+		bool run_end = false;
+		portENTER_CRITICAL(&s_run_mux);
+		if (s_run_until_us && s_sim_time_us >= s_run_until_us) {
+			s_run_until_us = 0;
+			s_speed = s_saved_speed;
+			run_end = true;
+		}
+		portEXIT_CRITICAL(&s_run_mux);
+		if (run_end) {
+			next_deadline = esp_timer_get_time();
+			if (s_run_done) xSemaphoreGive(s_run_done);
+		}
 
-#if RESET_BY_SWITCH_ENABLED
-			if (s->id == RESET_MOTOR_ID) {
-				if (!sim_homed[i] && s->angle <= RESET_SWITCH_ANGLE_THRESHOLD) {
-					// 模拟微动开关触发
-					sim_homed[i] = true;
-					s->speed = 0;
-					targets[i].target_speed = 0;
-					ESP_LOGI(TAG, "simulator: motor id %u simulated homing reached -> switch triggered", s->id);
-				}
+		uint32_t speed = s_run_until_us ? 0 : s_speed;
+		if (speed == 0) {
+			// 尽可能快：周期性让出 1 tick，避免饿死 IDLE 任务触发看门狗
+			if (++fast_steps >= SIM_FAST_YIELD_STEPS) {
+				fast_steps = 0;
+				vTaskDelay(1);
 			}
-#endif
-			// clamp 到 -2000..2000（代表 -20A..20A, 需与上位解析对应）
-			if (simulated_current > 2000) simulated_current = 2000;
-			if (simulated_current < -2000) simulated_current = -2000;
-			s->current = simulated_current;
-
-			// 温度慢慢随电流升高
-			int tmp = s->temp + (abs(s->current) / 500); // small change per tick
-			if (tmp > 100) tmp = 100;
-			if (tmp < 20) tmp = 20;
-			s->temp = (uint8_t)tmp;
+			next_deadline = esp_timer_get_time();
+			continue;
 		}
 
-		// 构建 payload（两个电机，每个 8 字节）
-		uint8_t payload[16];
-		for (int i = 0; i < 2; ++i) {
-			sim_state_t *s = &cur_state[i];
-			int base = i * 8;
-			put_be16(payload + base + 0, s->angle);
-			put_be16(payload + base + 2, (uint16_t)s->speed);
-			put_be16(payload + base + 4, (uint16_t)s->current);
-			payload[base + 6] = s->temp;
-			payload[base + 7] = s->id;
+		next_deadline += (int64_t)(SIM_STEP_US / speed);
+		int64_t now = esp_timer_get_time();
+		int64_t remain = next_deadline - now;
+		if (remain < -1000000) {
+			// 落后超过 1 秒（例如被长时间阻塞），放弃追赶，重新对齐
+			s_overruns++;
+			next_deadline = now;
+		} else if (remain > 0) {
+			const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+			vTaskDelay((TickType_t)((remain + tick_us - 1) / tick_us));
+			task_jitter_note_wake(TASK_ID_SIM, next_deadline);
 		}
+	}
+}
 
-		uint8_t frame[2 + 1 + 16 + 1];
-		frame[0] = 0xAA; frame[1] = 0x55; frame[2] = 16;
-		memcpy(frame + 3, payload, 16);
-		uint8_t ssum = 0;
-		for (int i = 0; i < 16; ++i) ssum += payload[i];
-		frame[3 + 16] = ssum;
+void simulator_start(void)
+{
+	if (!s_run_done) s_run_done = xSemaphoreCreateBinaryStatic(&s_run_done_buf);
+	link_emu_init();
+	sim_plant_init();
+#if SIM_TELEM_BATCH
+	mem_budget_add("simulator", "telemetry batch", sizeof(s_telem_buf) + sizeof(s_telem_enc));
+#endif
+	task_topology_create(TASK_ID_SIM, sim_task, NULL, NULL, NULL);
+}
+
+uint64_t simulator_now_us(void)
+{
+	return s_sim_time_us;
+}
+
+void simulator_set_speed(uint32_t speed)
+{
+	s_speed = speed;
+	ESP_LOGI(TAG, "simulator speed set to %u%s", (unsigned)speed, speed == 0 ? " (as fast as possible)" : "x");
+}
+
+uint32_t simulator_get_speed(void)
+{
+	return s_speed;
+}
 
-		// 注入解析器
-		serial_cboard_process_raw(frame, sizeof(frame));
+void simulator_register_step_hook(sim_step_hook_t hook)
+{
+	s_step_hook = hook;
+}
+
+void simulator_reset(void)
+{
+	s_reset_pending = true;
+}
 
-		// 等待下一周期
-		vTaskDelay(pdMS_TO_TICKS((uint32_t)(1000.0f / hz)));
+bool simulator_run_for(uint32_t virtual_ms, uint32_t timeout_ms)
+{
+	if (!s_run_done || virtual_ms == 0) return false;
+	xSemaphoreTake(s_run_done, 0); // 清除残留信号
+	s_saved_speed = s_speed;
+	// 快速运行期间逐帧日志会成为瓶颈，临时只保留警告
+	esp_log_level_set("simulator", ESP_LOG_WARN);
+	esp_log_level_set("serial_cboard", ESP_LOG_WARN);
+	portENTER_CRITICAL(&s_run_mux);
+	s_run_until_us = s_sim_time_us + (uint64_t)virtual_ms * 1000ULL;
+	portEXIT_CRITICAL(&s_run_mux);
+	bool done = xSemaphoreTake(s_run_done, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+	if (!done) {
+		// 调用者放弃：停止快进并恢复原速度，否则模拟器会一直全速运行，且迟到的完成信号会被下次调用误收。
+		// 若模拟任务恰好在此刻完成，则按完成处理（信号在此取走）
+		portENTER_CRITICAL(&s_run_mux);
+		bool pending = s_run_until_us != 0;
+		s_run_until_us = 0;
+		s_speed = s_saved_speed;
+		portEXIT_CRITICAL(&s_run_mux);
+		if (!pending) done = xSemaphoreTake(s_run_done, 0) == pdTRUE;
 	}
+	esp_log_level_set("simulator", ESP_LOG_INFO);
+	esp_log_level_set("serial_cboard", ESP_LOG_INFO);
+	return done;
 }
 
-void simulator_start(void)
+void simulator_get_stats(sim_stats_t *out)
+{
+	if (!out) return;
+	out->time_us = s_sim_time_us;
+	out->steps = s_sim_steps;
+	out->trace_hash = s_trace_hash;
+	out->speed = s_speed;
+	out->overruns = s_overruns;
+	out->motors = SIM_MOTORS;
+	out->plant_hz = SIM_PLANT_HZ;
+	uint64_t plant_steps = s_sim_steps * SIM_SUBSTEPS;
+	out->plant_cycles_avg = plant_steps ? (uint32_t)(s_plant_cycles / plant_steps) : 0;
+	out->plant_cycles_max = s_plant_cycles_max;
+}
+
+bool simulator_get_motor(uint8_t id, sim_motor_fb_t *out)
 {
-	xTaskCreate(sim_task, "sim_task", 4096, NULL, 5, NULL);
+	uint8_t board = id / CBOARD_MOTORS_PER_BOARD;
+	int idx = sim_index(board, id % CBOARD_MOTORS_PER_BOARD);
+	if (idx < 0 || !out) return false;
+	sim_plant_read(idx, out);
+	return true;
 }
@@ -1,15 +1,63 @@
 #ifndef SIMULATOR_H
 #define SIMULATOR_H
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "config.h"
+#include "sim_plant.h"
+
 // 测试环境模拟模块头文件
+// 模拟器以固定步长 1/SIM_UPDATE_HZ 推进虚拟时钟，电机模型（sim_plant.h）以 SIM_PLANT_HZ 推进，
+// 物理计算为整数运算，相同的命令序列会得到完全相同的输出帧序列（可用 trace_hash 比对）。
+
+// 模拟的 C 板：每板 SIM_MOTORS_PER_BOARD 个电机，板数由 SIM_MOTORS 决定（TEST_MODE 链路的板数）
+#define SIM_MOTORS_PER_BOARD (CBOARD_MOTORS_PER_BOARD - 1)
+#define SIM_BOARDS ((SIM_MOTORS + SIM_MOTORS_PER_BOARD - 1) / SIM_MOTORS_PER_BOARD)
 
 // 在 TEST_MODE 下启动模拟器（周期性注入模拟帧到解析器）
 void simulator_start(void);
 
 // 当 ESP 在 TEST_MODE 下发送命令时，serial_cboard 会回调此函数
 // 以便模拟器更新目标值。
-// cmds: 命令数组（与 serial_cboard.h 中的 motor_command_t 同名）
+// board: 目标板号
+// cmds: 命令数组（与 serial_cboard.h 中的 motor_command_t 同名，motor_id 为板内本地 id）
 // cmd_count: 命令数量
-void simulator_on_command(const void *cmds, size_t cmd_count);
+void simulator_on_command(uint8_t board, const void *cmds, size_t cmd_count);
+
+// 当前虚拟时间（微秒，自上次复位起）
+uint64_t simulator_now_us(void);
+
+// 时间倍率：1 = 实时，N = N 倍速，0 = 尽可能快（不休眠）
+void simulator_set_speed(uint32_t speed);
+uint32_t simulator_get_speed(void);
+
+// 步进钩子：每个固定步长开始时在模拟器任务中以当前虚拟时间调用，
+// 用于让预设轨迹等逻辑与虚拟时钟锁步运行
+typedef void (*sim_step_hook_t)(uint64_t now_us);
+void simulator_register_step_hook(sim_step_hook_t hook);
+
+// 请求恢复确定性初始状态（虚拟时钟、电机状态、轨迹摘要清零），在下一步生效
+void simulator_reset(void);
+
+// 以最快速度运行 virtual_ms 虚拟毫秒后恢复原倍率；阻塞至完成或 timeout_ms 超时
+bool simulator_run_for(uint32_t virtual_ms, uint32_t timeout_ms);
+
+typedef struct {
+	uint64_t time_us;    // 虚拟时间
+	uint64_t steps;      // 已执行步数
+	uint32_t trace_hash; // 输出帧序列摘要（FNV-1a）
+	uint32_t speed;      // 当前倍率
+	uint32_t overruns;   // 实时模式下重新对齐次数
+	uint32_t motors;
+	uint32_t plant_hz;
+	uint32_t plant_cycles_avg; // 电机模型每个子步（全部电机）的 CPU 周期
+	uint32_t plant_cycles_max;
+} sim_stats_t;
+
+void simulator_get_stats(sim_stats_t *out);
+
+// 读取全局 id 对应的模型状态（含指令电流、速度参考等 C 板不上报的量）；未模拟的 id 返回 false
+bool simulator_get_motor(uint8_t id, sim_motor_fb_t *out);
 
-#endif // SIMULATOR_H
\ No newline at end of file
+#endif // SIMULATOR_H
@@ -0,0 +1,208 @@
+#include "task_topology.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "config.h"
+#include "time_sync.h"
+
+static const char *TAG = "task_topology";
+
+// 任务拓扑表：修改任务的核心/优先级/栈只需改这里。
+// static 列为静态实例数：常驻任务的栈与 TCB 在编译期分配（不占堆，也不会随运行碎片化）；
+// 0 表示按需创建/删除的临时任务（回放、基准）、由组件自行创建的任务（httpd），
+// 或只在运行时按需启动的任务（CLI `sync` 开启的时间同步），仍使用堆。
+// 栈大小为初始估计，尚未按实测调整；`mem` 命令报告各任务的栈峰值，调整时取峰值 + 余量。
+#define TASK_TABLE(X) \
+	/*  id               name              stack prio core static */ \
+	X(ESTOP,           "estop",          4096, 12,  1,   1) \
+	X(SERIAL,          "serial_task",    4096, 10,  1,   1) \
+	X(SCHED_CTRL,      "sched_ctrl",     4096,  8,  1,   1) \
+	X(MOTION,          "motion",         3072,  9,  1,   !TEST_MODE) \
+	X(SIM,             "sim_task",       4096,  6,  1,   TEST_MODE) \
+	X(CAPTURE_REPLAY,  "capture_replay", 4096,  6,  1,   0) \
+	X(TIME_SYNC,       "time_sync",      3072,  6,  0,   TIME_SYNC_ROLE != TIME_SYNC_OFF) \
+	X(UDP_RX,          "udp_rx",         3072,  6,  0,   UDP_CTRL_ENABLE) \
+	X(UDP_TX,          "udp_tx",         3072,  6,  0,   UDP_CTRL_ENABLE) \
+	X(CLI,             "cli_task",       4096,  5,  0,   1) \
+	X(SCHED_UI,        "sched_ui",       4096,  4,  0,   1) \
+	X(HTTPD,           "httpd",          4096,  4,  0,   0) \
+	X(HTTPD_ASYNC,     "httpd_async",    4096,  3,  0,   HTTPD_ASYNC_WORKERS) \
+	X(CAPTURE_WR,      "capture_wr",     3072,  3,  0,   1) \
+	X(RECORDER,        "recorder",       4096,  2,  0,   1) \
+	X(BOOT_NET,        "boot_net",       6144,  3,  0,   0) \
+	X(BENCH,           "bench",          6144,  2,  1,   0)
+
+#define X_PROFILE(id, name, stack, prio, core, n) [TASK_ID_##id] = { name, stack, prio, core },
+static const task_profile_t s_profiles[TASK_ID_COUNT] = { TASK_TABLE(X_PROFILE) };
+
+#define X_STATIC_N(id, name, stack, prio, core, n) [TASK_ID_##id] = n,
+static const uint8_t s_static_n[TASK_ID_COUNT] = { TASK_TABLE(X_STATIC_N) };
+
+// 静态栈池与 TCB：按表中静态实例数在编译期求和，创建任务时顺序切分，永不释放
+#define X_STACK_BYTES(id, name, stack, prio, core, n) + (stack) * (n)
+#define X_TCB_COUNT(id, name, stack, prio, core, n) + (n)
+enum {
+	STATIC_STACK_BYTES = 0 TASK_TABLE(X_STACK_BYTES),
+	STATIC_TCB_COUNT = 0 TASK_TABLE(X_TCB_COUNT),
+};
+static StackType_t s_stack_pool[STATIC_STACK_BYTES / sizeof(StackType_t)] __attribute__((aligned(16)));
+static StaticTask_t s_tcb_pool[STATIC_TCB_COUNT];
+static size_t s_stack_used;   // 已切分的栈池字节数
+static size_t s_tcb_used;
+
+// 运行时信息
+typedef struct {
+	uint32_t instances;    // 累计创建次数
+	uint32_t wakes;
+	int64_t late_sum_us;
+	int32_t late_min_us;
+	int32_t late_max_us;
+	uint8_t cores_seen;    // 唤醒时实际所在核心的位掩码
+	uint8_t static_used;   // 已使用的静态实例数
+	char last_name[configMAX_TASK_NAME_LEN]; // 最近一次创建的实例名（报告时按名称查找，避免使用已删除任务的句柄）
+} task_rt_t;
+
+static task_rt_t s_rt[TASK_ID_COUNT];
+
+const task_profile_t *task_topology_get(task_id_t id)
+{
+	return (id < TASK_ID_COUNT) ? &s_profiles[id] : NULL;
+}
+
+BaseType_t task_topology_create(task_id_t id, TaskFunction_t fn, void *arg, TaskHandle_t *out, const char *name)
+{
+	if (id >= TASK_ID_COUNT) return pdFAIL;
+	const task_profile_t *p = &s_profiles[id];
+	task_rt_t *rt = &s_rt[id];
+	if (!name) name = p->name;
+	TaskHandle_t h = NULL;
+	if (rt->static_used < s_static_n[id]) {
+		// 常驻任务：从静态池切分（只在启动阶段创建，不需要加锁）
+		size_t words = p->stack / sizeof(StackType_t);
+		h = xTaskCreateStaticPinnedToCore(fn, name, p->stack, arg, p->priority,
+										  &s_stack_pool[s_stack_used / sizeof(StackType_t)],
+										  &s_tcb_pool[s_tcb_used], p->core);
+		if (h) {
+			s_stack_used += words * sizeof(StackType_t);
+			s_tcb_used++;
+			rt->static_used++;
+		}
+	} else {
+		if (xTaskCreatePinnedToCore(fn, name, p->stack, arg, p->priority, &h, p->core) != pdPASS) h = NULL;
+	}
+	if (h) {
+		rt->instances++;
+		strlcpy(rt->last_name, name, sizeof(rt->last_name));
+	} else {
+		ESP_LOGE(TAG, "failed to create %s", name);
+	}
+	if (out) *out = h;
+	return h ? pdPASS : pdFAIL;
+}
+
+size_t task_topology_static_bytes(void)
+{
+	return sizeof(s_stack_pool) + sizeof(s_tcb_pool);
+}
+
+// 报告用：按名称查找任务（已删除的任务返回 NULL）
+static TaskHandle_t find_task(task_id_t id)
+{
+	const task_rt_t *rt = &s_rt[id];
+	return xTaskGetHandle(rt->last_name[0] ? rt->last_name : s_profiles[id].name);
+}
+
+void task_jitter_note_wake(task_id_t id, int64_t expected_us)
+{
+	if (id >= TASK_ID_COUNT) return;
+	task_rt_t *rt = &s_rt[id];
+	int32_t late = (int32_t)(esp_timer_get_time() - expected_us);
+	rt->cores_seen |= (uint8_t)(1u << esp_cpu_get_core_id());
+	if (rt->wakes == 0 || late < rt->late_min_us) rt->late_min_us = late;
+	if (rt->wakes == 0 || late > rt->late_max_us) rt->late_max_us = late;
+	rt->late_sum_us += late;
+	rt->wakes++;
+}
+
+static void core_str(BaseType_t core, char *buf, size_t len)
+{
+	if (core == tskNO_AFFINITY) snprintf(buf, len, "any");
+	else snprintf(buf, len, "%d", (int)core);
+}
+
+static void cores_seen_str(uint8_t mask, char *buf, size_t len)
+{
+	if (mask == 0) snprintf(buf, len, "-");
+	else if (mask == 3) snprintf(buf, len, "0+1");
+	else snprintf(buf, len, "%d", mask == 1 ? 0 : 1);
+}
+
+void task_topology_report(void)
+{
+	printf("%-16s %-9s %-9s %-7s %-6s %-8s %s\n",
+		   "task", "core cfg", "core act", "prio", "stack", "stk free", "wake late us (n/min/avg/max) on");
+	for (int i = 0; i < TASK_ID_COUNT; ++i) {
+		const task_profile_t *p = &s_profiles[i];
+		const task_rt_t *rt = &s_rt[i];
+		TaskHandle_t h = find_task((task_id_t)i); // 由组件创建的任务（如 httpd）同样按名称查找
+		char cfg[8], act[8], seen[8];
+		core_str(p->core, cfg, sizeof(cfg));
+		if (h) core_str(xTaskGetCoreID(h), act, sizeof(act));
+		else snprintf(act, sizeof(act), "-");
+		cores_seen_str(rt->cores_seen, seen, sizeof(seen));
+		if (!h) {
+			printf("%-16s %-9s %-9s %-7u %-6lu %-8s (not running)\n", p->name, cfg, act,
+				   (unsigned)p->priority, (unsigned long)p->stack, "-");
+			continue;
+		}
+		char prio[12];
+		snprintf(prio, sizeof(prio), "%u/%u", (unsigned)uxTaskPriorityGet(h), (unsigned)p->priority);
+		printf("%-16s %-9s %-9s %-7s %-6lu %-8lu",
+			   p->name, cfg, act, prio, (unsigned long)p->stack,
+			   (unsigned long)uxTaskGetStackHighWaterMark(h));
+		if (rt->wakes) {
+			printf(" %lu/%ld/%ld/%ld on %s\n", (unsigned long)rt->wakes, (long)rt->late_min_us,
+				   (long)(rt->late_sum_us / (int64_t)rt->wakes), (long)rt->late_max_us, seen);
+		} else {
+			printf(" -\n");
+		}
+	}
+	// 系统任务：确认 Wi-Fi / lwIP 运行在 core 0
+	static const char *sys_tasks[] = { "wifi", "tiT", "esp_timer", "sys_evt" };
+	for (size_t i = 0; i < sizeof(sys_tasks) / sizeof(sys_tasks[0]); ++i) {
+		TaskHandle_t h = xTaskGetHandle(sys_tasks[i]);
+		if (!h) continue;
+		char act[8];
+		core_str(xTaskGetCoreID(h), act, sizeof(act));
+		printf("%-16s %-9s %-9s %-7u %-6s %-8lu (system)\n", sys_tasks[i], "sdkconfig", act,
+			   (unsigned)uxTaskPriorityGet(h), "-", (unsigned long)uxTaskGetStackHighWaterMark(h));
+	}
+}
+
+void task_topology_stack_report(void)
+{
+	printf("%-16s %-6s %-7s %-6s %-6s %s\n", "task", "alloc", "stack", "peak", "free", "suggest");
+	for (int i = 0; i < TASK_ID_COUNT; ++i) {
+		const task_profile_t *p = &s_profiles[i];
+		unsigned n = s_static_n[i] ? s_static_n[i] : 1;
+		const char *alloc = s_static_n[i] ? "static" : "heap";
+		TaskHandle_t h = find_task((task_id_t)i);
+		if (!h) {
+			printf("%-16s %-6s %-7lu %-6s %-6s -\n", p->name, alloc, (unsigned long)p->stack * n, "-", "-");
+			continue;
+		}
+		// ESP-IDF 中栈深度与高水位均以字节计
+		uint32_t free_b = (uint32_t)uxTaskGetStackHighWaterMark(h);
+		uint32_t peak = p->stack > free_b ? p->stack - free_b : 0;
+		// 建议值：峰值 + 25% 且至少 512 字节余量，向上取整到 256
+		uint32_t margin = peak / 4 > 512 ? peak / 4 : 512;
+		uint32_t suggest = (peak + margin + 255) & ~255u;
+		printf("%-16s %-6s %-7lu %-6lu %-6lu %lu%s\n", p->name, alloc, (unsigned long)p->stack * n,
+			   (unsigned long)peak, (unsigned long)free_b, (unsigned long)suggest,
+			   suggest < p->stack ? "" : " (!)");
+	}
+	printf("static stacks: %lu/%lu bytes, TCBs: %u x %u bytes\n", (unsigned long)s_stack_used,
+		   (unsigned long)sizeof(s_stack_pool), (unsigned)s_tcb_used, (unsigned)sizeof(StaticTask_t));
+}
@@ -0,0 +1,60 @@
+#ifndef TASK_TOPOLOGY_H
+#define TASK_TOPOLOGY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// 任务拓扑：集中定义固件中每个任务的核心、优先级与栈大小。
+// core 0：Wi-Fi / lwIP（由 sdkconfig 固定）、httpd 及其它非实时任务；
+// core 1：串口解析、预设与模拟器等控制路径，不与网络协议栈争抢 CPU。
+
+typedef enum {
+	TASK_ID_ESTOP = 0,     // 急停通道：最高优先级，只在触发时运行
+	TASK_ID_SERIAL,
+	TASK_ID_SCHED_CTRL,    // 调度器执行任务：按键、预设
+	TASK_ID_MOTION,
+	TASK_ID_SIM,
+	TASK_ID_CAPTURE_REPLAY,
+	TASK_ID_TIME_SYNC,
+	TASK_ID_UDP_RX,
+	TASK_ID_UDP_TX,
+	TASK_ID_CLI,
+	TASK_ID_SCHED_UI,      // 调度器执行任务：串口屏、滑块同步、速率调节
+	TASK_ID_HTTPD,         // 由 esp_http_server 创建，这里只提供配置
+	TASK_ID_HTTPD_ASYNC,   // 多实例（worker 池）
+	TASK_ID_CAPTURE_WR,
+	TASK_ID_RECORDER,
+	TASK_ID_BOOT_NET,      // 启动第二阶段（网络/存储初始化后自删除）
+	TASK_ID_BENCH,         // 自测基准（每次运行新建）
+	TASK_ID_COUNT
+} task_id_t;
+
+typedef struct {
+	const char *name;
+	uint32_t stack;       // 字节
+	UBaseType_t priority;
+	BaseType_t core;      // 0 / 1 / tskNO_AFFINITY
+} task_profile_t;
+
+// 获取任务配置
+const task_profile_t *task_topology_get(task_id_t id);
+
+// 按拓扑表创建（并固定核心）任务；name 为 NULL 时使用表中名称（多实例任务可传入自定义名称）
+BaseType_t task_topology_create(task_id_t id, TaskFunction_t fn, void *arg, TaskHandle_t *out, const char *name);
+
+// 静态栈池与 TCB 池占用的字节数（内存预算报告用）
+size_t task_topology_static_bytes(void);
+
+// 打印每个任务的栈分配方式、配置大小、峰值用量与建议大小
+void task_topology_stack_report(void);
+
+// 周期任务在每次唤醒后调用：expected_us 为期望唤醒时刻（esp_timer 时间），
+// 记录唤醒延迟（抖动）与实际运行的核心
+void task_jitter_note_wake(task_id_t id, int64_t expected_us);
+
+// 打印任务放置与调度抖动报告（配置 vs 实际核心/优先级、栈余量、唤醒延迟）
+void task_topology_report(void);
+
+#endif // TASK_TOPOLOGY_H
@@ -0,0 +1,254 @@
+#include "telem_bus.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "sched.h"
+#include "mem_budget.h"
+
+static const char *TAG = "telem_bus";
+
+#define BUS_MAX_MOTORS (CBOARD_MAX_BOARDS * CBOARD_MOTORS_PER_BOARD)
+#define BUS_WORDS      ((BUS_MAX_MOTORS + 31) / 32)
+
+typedef struct {
+	bool used;
+	bool enabled;
+	const char *name;
+	TaskHandle_t task;
+	int sched_job;
+	uint16_t decim;
+	uint16_t decim_cnt;
+	uint32_t min_period_us;
+	int64_t last_wake_us;
+	int64_t pending_us;        // 首个未读发布的时刻（0 = 没有未读）
+	uint32_t want[BUS_WORDS];  // 关心的电机
+	uint32_t dirty[BUS_WORDS]; // 自上次读取以来更新过的电机
+	uint32_t published;
+	uint32_t wakes;
+	uint32_t held;
+	uint32_t reads;
+	uint32_t lat_us_max;
+	uint64_t lat_us_sum;
+} bus_sub_t;
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static motor_status_t s_snap[BUS_MAX_MOTORS];
+static motor_derived_t s_dsnap[BUS_MAX_MOTORS]; // 与 s_snap 同一样本的派生量
+static uint32_t s_have[BUS_WORDS];
+static bus_sub_t s_subs[TELEM_BUS_MAX_SUBS];
+static volatile uint32_t s_gen;
+
+void telem_bus_init(void)
+{
+	mem_budget_add("telem_bus", "snapshot + subscribers", sizeof(s_snap) + sizeof(s_dsnap) + sizeof(s_subs));
+}
+
+int telem_bus_subscribe(const telem_bus_sub_cfg_t *cfg)
+{
+	if (!cfg || (!cfg->task && cfg->sched_job < 0)) return -1;
+	int sub = -1;
+	portENTER_CRITICAL(&s_mux);
+	for (int i = 0; i < TELEM_BUS_MAX_SUBS; ++i) {
+		if (s_subs[i].used) continue;
+		bus_sub_t *s = &s_subs[i];
+		*s = (bus_sub_t){
+			.used = true,
+			.enabled = cfg->enabled,
+			.name = cfg->name,
+			.task = cfg->sched_job >= 0 ? NULL : cfg->task,
+			.sched_job = cfg->sched_job,
+			.decim = cfg->decim ? cfg->decim : 1,
+			.min_period_us = cfg->min_period_us,
+		};
+		if (cfg->nids == 0) {
+			memset(s->want, 0xFF, sizeof(s->want));
+		}
+		for (uint8_t k = 0; k < cfg->nids && k < TELEM_BUS_MAX_IDS; ++k) {
+			uint8_t id = cfg->ids[k];
+			if (id < BUS_MAX_MOTORS) s->want[id / 32] |= 1u << (id % 32);
+		}
+		sub = i;
+		break;
+	}
+	portEXIT_CRITICAL(&s_mux);
+	if (sub < 0) ESP_LOGE(TAG, "subscriber table full, cannot add %s", cfg->name);
+	return sub;
+}
+
+void telem_bus_set_rate(int sub, uint16_t decim, uint32_t min_period_us)
+{
+	if (sub < 0 || sub >= TELEM_BUS_MAX_SUBS) return;
+	portENTER_CRITICAL(&s_mux);
+	s_subs[sub].decim = decim ? decim : 1;
+	s_subs[sub].min_period_us = min_period_us;
+	portEXIT_CRITICAL(&s_mux);
+}
+
+void telem_bus_enable(int sub, bool on)
+{
+	if (sub < 0 || sub >= TELEM_BUS_MAX_SUBS) return;
+	portENTER_CRITICAL(&s_mux);
+	bus_sub_t *s = &s_subs[sub];
+	s->enabled = on;
+	if (!on) {
+		// 停用期间的数据不再送达：清掉脏位，重新启用后从下一帧开始
+		memset(s->dirty, 0, sizeof(s->dirty));
+		s->pending_us = 0;
+		s->decim_cnt = 0;
+	}
+	portEXIT_CRITICAL(&s_mux);
+}
+
+void telem_bus_publish(const motor_status_t *st, const motor_derived_t *dv, size_t n)
+{
+	if (!st || n == 0) return;
+	uint32_t upd[BUS_WORDS] = { 0 };
+	TaskHandle_t tasks[TELEM_BUS_MAX_SUBS];
+	int jobs[TELEM_BUS_MAX_SUBS];
+	int ntasks = 0, njobs = 0;
+	int64_t now = esp_timer_get_time();
+
+	portENTER_CRITICAL(&s_mux);
+	for (size_t i = 0; i < n; ++i) {
+		uint8_t id = st[i].motor_id;
+		if (id >= BUS_MAX_MOTORS) continue;
+		s_snap[id] = st[i];
+		if (dv) s_dsnap[id] = dv[i];
+		else memset(&s_dsnap[id], 0, sizeof(s_dsnap[id]));
+		upd[id / 32] |= 1u << (id % 32);
+	}
+	for (int w = 0; w < BUS_WORDS; ++w) s_have[w] |= upd[w];
+	s_gen++;
+	for (int i = 0; i < TELEM_BUS_MAX_SUBS; ++i) {
+		bus_sub_t *s = &s_subs[i];
+		if (!s->used || !s->enabled) continue;
+		uint32_t hit = 0;
+		for (int w = 0; w < BUS_WORDS; ++w) {
+			uint32_t bits = upd[w] & s->want[w];
+			s->dirty[w] |= bits;
+			hit |= bits;
+		}
+		if (!hit) continue;
+		s->published++;
+		if (!s->pending_us) s->pending_us = now;
+		if (++s->decim_cnt < s->decim || now - s->last_wake_us < (int64_t)s->min_period_us) {
+			s->held++;
+			continue;
+		}
+		s->decim_cnt = 0;
+		s->last_wake_us = now;
+		s->wakes++;
+		if (s->task) tasks[ntasks++] = s->task;
+		else jobs[njobs++] = s->sched_job;
+	}
+	portEXIT_CRITICAL(&s_mux);
+
+	for (int i = 0; i < ntasks; ++i) xTaskNotifyGive(tasks[i]);
+	for (int i = 0; i < njobs; ++i) sched_trigger(jobs[i]);
+}
+
+// 读到新数据时记一次延迟。调用者持有 s_mux
+static void note_read_locked(bus_sub_t *s, int64_t now)
+{
+	if (!s->pending_us) return;
+	uint32_t lat = (uint32_t)(now - s->pending_us);
+	s->pending_us = 0;
+	s->reads++;
+	s->lat_us_sum += lat;
+	if (lat > s->lat_us_max) s->lat_us_max = lat;
+}
+
+size_t telem_bus_read(int sub, motor_status_t *out, size_t max)
+{
+	if (sub < 0 || sub >= TELEM_BUS_MAX_SUBS || !out) return 0;
+	size_t n = 0;
+	int64_t now = esp_timer_get_time();
+	portENTER_CRITICAL(&s_mux);
+	bus_sub_t *s = &s_subs[sub];
+	for (int w = 0; w < BUS_WORDS && n < max; ++w) {
+		uint32_t bits = s->dirty[w];
+		while (bits && n < max) {
+			uint32_t bit = bits & -bits;
+			bits &= bits - 1;
+			s->dirty[w] &= ~bit;
+			out[n++] = s_snap[w * 32 + __builtin_ctz(bit)];
+		}
+	}
+	if (n) note_read_locked(s, now);
+	portEXIT_CRITICAL(&s_mux);
+	return n;
+}
+
+bool telem_bus_get(int sub, uint8_t id, motor_status_t *out)
+{
+	return telem_bus_get_sample(sub, id, out, NULL);
+}
+
+bool telem_bus_get_sample(int sub, uint8_t id, motor_status_t *out, motor_derived_t *dv)
+{
+	if (id >= BUS_MAX_MOTORS || !out) return false;
+	uint32_t bit = 1u << (id % 32);
+	bool have;
+	int64_t now = esp_timer_get_time();
+	portENTER_CRITICAL(&s_mux);
+	have = s_have[id / 32] & bit;
+	if (have) {
+		*out = s_snap[id];
+		if (dv) *dv = s_dsnap[id];
+	}
+	if (sub >= 0 && sub < TELEM_BUS_MAX_SUBS) {
+		bus_sub_t *s = &s_subs[sub];
+		if (s->dirty[id / 32] & bit) {
+			s->dirty[id / 32] &= ~bit;
+			note_read_locked(s, now);
+		}
+	}
+	portEXIT_CRITICAL(&s_mux);
+	return have;
+}
+
+uint32_t telem_bus_gen(void)
+{
+	return s_gen;
+}
+
+bool telem_bus_get_stats(int sub, telem_bus_sub_stats_t *out)
+{
+	if (sub < 0 || sub >= TELEM_BUS_MAX_SUBS || !out) return false;
+	portENTER_CRITICAL(&s_mux);
+	const bus_sub_t *s = &s_subs[sub];
+	bool used = s->used;
+	if (used) {
+		*out = (telem_bus_sub_stats_t){
+			.name = s->name,
+			.enabled = s->enabled,
+			.decim = s->decim,
+			.min_period_us = s->min_period_us,
+			.published = s->published,
+			.wakes = s->wakes,
+			.held = s->held,
+			.reads = s->reads,
+			.lat_us_avg = s->reads ? (uint32_t)(s->lat_us_sum / s->reads) : 0,
+			.lat_us_max = s->lat_us_max,
+		};
+	}
+	portEXIT_CRITICAL(&s_mux);
+	return used;
+}
+
+void telem_bus_report(void)
+{
+	printf("gen=%lu\n", (unsigned long)telem_bus_gen());
+	printf("%-12s %-3s %5s %9s %9s %8s %8s %8s %13s\n", "subscriber", "on", "decim", "period_us", "published",
+		   "wakes", "held", "reads", "lat avg/max");
+	for (int i = 0; i < TELEM_BUS_MAX_SUBS; ++i) {
+		telem_bus_sub_stats_t st;
+		if (!telem_bus_get_stats(i, &st)) continue;
+		printf("%-12s %-3s %5u %9lu %9lu %8lu %8lu %8lu %6lu/%-6lu\n", st.name ? st.name : "?",
+			   st.enabled ? "on" : "off", st.decim, (unsigned long)st.min_period_us, (unsigned long)st.published,
+			   (unsigned long)st.wakes, (unsigned long)st.held, (unsigned long)st.reads,
+			   (unsigned long)st.lat_us_avg, (unsigned long)st.lat_us_max);
+	}
+}
@@ -0,0 +1,79 @@
+#ifndef TELEM_BUS_H
+#define TELEM_BUS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "serial_cboard.h"
+
+// 遥测发布/订阅总线：解析器每解完一帧发布一次（该帧各电机的最新状态），订阅者不再各自轮询。
+// 总线保存每个电机的最新值，并为每个订阅者记录自上次读取以来更新过的电机（脏位）；
+// 发布时只唤醒关心这些电机、且满足抽取比与最小间隔的订阅者：
+//   - 任务订阅者：xTaskNotifyGive，任务用 ulTaskNotifyTake 等待；
+//   - 调度器作业订阅者：sched_trigger，作业在执行任务中立即运行。
+// 被抽取/限速压下的发布只置脏位，由之后的发布唤醒（遥测持续到达时至多晚一个最小间隔）；
+// 订阅者应另有兜底周期，以便遥测中断时也能刷新。读取在同一临界区内复制，
+// 同一帧的各电机值以及每个电机的原始值与派生量总是一致的；统计每个订阅者从首个未读发布到读取的延迟。
+
+// 单个订阅者关心的电机数上限（0 个表示全部电机）
+#define TELEM_BUS_MAX_IDS 4
+
+typedef struct {
+	const char *name;
+	TaskHandle_t task;     // 任务订阅者（与 sched_job 二选一）
+	int sched_job;         // 调度器作业订阅者（>= 0 时使用）
+	uint8_t ids[TELEM_BUS_MAX_IDS]; // 关心的电机（全局 id），nids 为 0 表示全部
+	uint8_t nids;
+	uint16_t decim;        // 每 N 次相关发布至多唤醒一次（0/1 = 每次）
+	uint32_t min_period_us; // 两次唤醒之间的最小间隔（0 = 不限）
+	bool enabled;          // false 时发布既不置脏位也不唤醒（如没有上位机订阅时）
+} telem_bus_sub_cfg_t;
+
+typedef struct {
+	const char *name;
+	bool enabled;
+	uint16_t decim;
+	uint32_t min_period_us;
+	uint32_t published;   // 相关的发布次数
+	uint32_t wakes;       // 实际唤醒次数
+	uint32_t held;        // 被抽取或限速压下的发布
+	uint32_t reads;       // 读到新数据的读取次数
+	uint32_t lat_us_avg;  // 首个未读发布 -> 读取
+	uint32_t lat_us_max;
+} telem_bus_sub_stats_t;
+
+// 登记内存预算（须先于解析任务启动）
+void telem_bus_init(void);
+
+// 订阅，返回句柄（表满返回 -1）
+int telem_bus_subscribe(const telem_bus_sub_cfg_t *cfg);
+
+// 运行中调整订阅（速率调节器给出的新周期、上位机订阅者的有无）
+void telem_bus_set_rate(int sub, uint16_t decim, uint32_t min_period_us);
+void telem_bus_enable(int sub, bool on);
+
+// 解析器调用：发布一帧（motor_id 为全局 id），dv 为与 st 逐项对应的派生量（NULL 表示没有）。
+// 只在一个临界区内更新快照与脏位，唤醒在临界区外进行
+void telem_bus_publish(const motor_status_t *st, const motor_derived_t *dv, size_t n);
+
+// 读取自上次读取以来更新过的电机（按 id 升序），最多 max 个，返回个数；放不下的留待下次
+size_t telem_bus_read(int sub, motor_status_t *out, size_t max);
+
+// 读取一个电机的最新值并清除该订阅者的对应脏位（sub < 0 时只读不计）；尚无遥测返回 false
+bool telem_bus_get(int sub, uint8_t id, motor_status_t *out);
+
+// 同上，并复制与该样本一起发布的派生量（没有滤波器槽位时 samples 为 0）
+bool telem_bus_get_sample(int sub, uint8_t id, motor_status_t *out, motor_derived_t *dv);
+
+// 发布计数（每帧加一）
+uint32_t telem_bus_gen(void);
+
+// 订阅者统计（越界或空槽返回 false）
+bool telem_bus_get_stats(int sub, telem_bus_sub_stats_t *out);
+
+// 打印所有订阅者的唤醒与延迟统计
+void telem_bus_report(void);
+
+#endif // TELEM_BUS_H
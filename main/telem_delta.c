@@ -0,0 +1,204 @@
+#include "telem_delta.h"
+#include <string.h>
+
+// 13 位角度差回绕到 [-4096, 4095]
+static inline int32_t wrap13(int32_t d)
+{
+	return ((d + 4096) & 8191) - 4096;
+}
+
+static inline uint32_t zigzag(int32_t v)
+{
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v)
+{
+	return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static uint8_t *put_varint(uint8_t *p, uint32_t v)
+{
+	while (v >= 0x80) {
+		*p++ = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (uint8_t)v;
+	return p;
+}
+
+// 读一个变长整数（最多 3 字节，足够 17 位的 zigzag 残差）；越界或过长返回 false
+static bool get_varint(const uint8_t **pp, const uint8_t *end, uint32_t *out)
+{
+	const uint8_t *p = *pp;
+	uint32_t v = 0;
+	for (int shift = 0; shift < 21; shift += 7) {
+		if (p >= end) return false;
+		uint8_t b = *p++;
+		v |= (uint32_t)(b & 0x7F) << shift;
+		if (!(b & 0x80)) {
+			*pp = p;
+			*out = v;
+			return true;
+		}
+	}
+	return false;
+}
+
+void telem_delta_reset(telem_delta_state_t *st)
+{
+	memset(st, 0, sizeof(*st));
+}
+
+static void clear_predictors(telem_delta_state_t *st)
+{
+	memset(st->angle, 0, sizeof(st->angle));
+	memset(st->dangle, 0, sizeof(st->dangle));
+	memset(st->speed, 0, sizeof(st->speed));
+	memset(st->current, 0, sizeof(st->current));
+	memset(st->temp, 0, sizeof(st->temp));
+}
+
+size_t telem_delta_encode(telem_delta_state_t *st, uint8_t *out, size_t size, const motor_status_t *samples,
+						  uint8_t motors, uint8_t nsamples, uint16_t interval_us, bool keyframe)
+{
+	if (!st || !out || !samples || motors == 0 || nsamples == 0 || motors >= CBOARD_MOTORS_PER_BOARD) return 0;
+	if (size < TELEM_DELTA_MAX_PAYLOAD((size_t)motors, (size_t)nsamples)) return 0;
+	for (uint8_t m = 0; m < motors; ++m) {
+		uint8_t id = samples[m].motor_id;
+		if (id == 0 || id >= CBOARD_MOTORS_PER_BOARD) return 0;
+	}
+	if (keyframe) clear_predictors(st);
+
+	uint8_t *p = out;
+	*p++ = st->seq;
+	*p++ = keyframe ? TELEM_DELTA_F_KEY : 0;
+	*p++ = motors;
+	*p++ = nsamples;
+	*p++ = (uint8_t)(interval_us >> 8);
+	*p++ = (uint8_t)interval_us;
+	for (uint8_t m = 0; m < motors; ++m) *p++ = samples[m].motor_id;
+
+	for (uint8_t s = 0; s < nsamples; ++s) {
+		const motor_status_t *row = samples + (size_t)s * motors;
+		uint8_t *mask = p;
+		p += (motors + 1) / 2;
+		memset(mask, 0, (motors + 1) / 2);
+		for (uint8_t m = 0; m < motors; ++m) {
+			uint8_t id = samples[m].motor_id;
+			const motor_status_t *ms = &row[m];
+			int32_t r[4];
+			int32_t da = wrap13((int32_t)ms->angle - st->angle[id]);
+			r[0] = wrap13(da - st->dangle[id]);
+			r[1] = (int32_t)ms->speed - st->speed[id];
+			r[2] = (int32_t)ms->current - st->current[id];
+			r[3] = (int32_t)ms->temperature - st->temp[id];
+			uint8_t bits = 0;
+			for (int f = 0; f < 4; ++f) {
+				if (r[f]) {
+					bits |= 1u << f;
+					p = put_varint(p, zigzag(r[f]));
+				}
+			}
+			mask[m / 2] |= (uint8_t)(bits << ((m & 1) * 4));
+			st->dangle[id] = (int16_t)da;
+			st->angle[id] = ms->angle & 8191;
+			st->speed[id] = ms->speed;
+			st->current[id] = ms->current;
+			st->temp[id] = ms->temperature;
+		}
+	}
+	st->seq++;
+	return (size_t)(p - out);
+}
+
+// 只检查一个样本的结构（掩码与残差长度），不改预测值；payload 越界或残差过长返回 false
+static bool check_sample(uint8_t motors, const uint8_t **pp, const uint8_t *end)
+{
+	const uint8_t *mask = *pp;
+	const uint8_t *p = mask + (motors + 1) / 2;
+	if (p > end) return false;
+	for (uint8_t m = 0; m < motors; ++m) {
+		uint8_t bits = (mask[m / 2] >> ((m & 1) * 4)) & 0x0F;
+		for (int f = 0; f < 4; ++f) {
+			uint32_t v;
+			if ((bits & (1u << f)) && !get_varint(&p, end, &v)) return false;
+		}
+	}
+	*pp = p;
+	return true;
+}
+
+// 解一个样本的掩码与残差并更新预测值；payload 越界返回 false
+static bool decode_sample(telem_delta_state_t *st, const uint8_t *ids, uint8_t motors, const uint8_t **pp,
+						  const uint8_t *end, motor_status_t *row)
+{
+	const uint8_t *mask = *pp;
+	const uint8_t *p = mask + (motors + 1) / 2;
+	if (p > end) return false;
+	for (uint8_t m = 0; m < motors; ++m) {
+		uint8_t id = ids[m];
+		uint8_t bits = (mask[m / 2] >> ((m & 1) * 4)) & 0x0F;
+		int32_t r[4] = { 0, 0, 0, 0 };
+		for (int f = 0; f < 4; ++f) {
+			uint32_t v;
+			if (!(bits & (1u << f))) continue;
+			if (!get_varint(&p, end, &v)) return false;
+			r[f] = unzigzag(v);
+		}
+		int32_t da = wrap13(st->dangle[id] + r[0]);
+		st->dangle[id] = (int16_t)da;
+		st->angle[id] = (uint16_t)((st->angle[id] + da) & 8191);
+		st->speed[id] = (int16_t)(st->speed[id] + r[1]);
+		st->current[id] = (int16_t)(st->current[id] + r[2]);
+		st->temp[id] = (uint8_t)(st->temp[id] + r[3]);
+		row[m] = (motor_status_t){
+			.angle = st->angle[id],
+			.speed = st->speed[id],
+			.current = st->current[id],
+			.temperature = st->temp[id],
+			.motor_id = id,
+		};
+	}
+	*pp = p;
+	return true;
+}
+
+int telem_delta_decode(telem_delta_state_t *st, const uint8_t *p, size_t len, telem_delta_sink_t sink, void *ctx)
+{
+	if (len < TELEM_DELTA_HDR) return TELEM_DELTA_ERR_FORMAT;
+	const uint8_t *end = p + len;
+	uint8_t seq = p[0];
+	bool key = p[1] & TELEM_DELTA_F_KEY;
+	uint8_t motors = p[2];
+	uint8_t nsamples = p[3];
+	uint16_t interval = (uint16_t)((uint16_t)p[4] << 8 | p[5]);
+	const uint8_t *ids = p + TELEM_DELTA_HDR;
+	if (!key && (!st->valid || seq != st->seq)) {
+		st->valid = false;
+		return TELEM_DELTA_ERR_SYNC;
+	}
+	st->valid = false; // 整帧解完才恢复同步
+	if (motors == 0 || motors >= CBOARD_MOTORS_PER_BOARD || (size_t)(end - ids) < motors) return TELEM_DELTA_ERR_FORMAT;
+	p = ids + motors;
+	for (uint8_t m = 0; m < motors; ++m) {
+		if (ids[m] == 0 || ids[m] >= CBOARD_MOTORS_PER_BOARD) return TELEM_DELTA_ERR_FORMAT;
+	}
+	// 先完整检查整帧结构，通过后才更新预测值并交出样本：
+	// 中途损坏的帧不会已经发布了前面的样本，预测值也保持不变（等待关键帧）
+	const uint8_t *q = p;
+	for (uint8_t s = 0; s < nsamples; ++s) {
+		if (!check_sample(motors, &q, end)) return TELEM_DELTA_ERR_FORMAT;
+	}
+	if (q != end) return TELEM_DELTA_ERR_FORMAT;
+	if (key) clear_predictors(st);
+
+	motor_status_t row[CBOARD_MOTORS_PER_BOARD];
+	for (uint8_t s = 0; s < nsamples; ++s) {
+		if (!decode_sample(st, ids, motors, &p, end, row)) return TELEM_DELTA_ERR_FORMAT;
+		if (sink) sink(ctx, row, motors, s, nsamples, interval);
+	}
+	st->valid = true;
+	st->seq = (uint8_t)(seq + 1);
+	return nsamples;
+}
@@ -0,0 +1,60 @@
+#ifndef TELEM_DELTA_H
+#define TELEM_DELTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "config.h"
+#include "serial_cboard.h"
+
+// 批量差分遥测（类型化消息 CBOARD_MSG_TELEM_BATCH 的 payload）：一帧携带一块板若干个连续样本，
+// 字段按预测残差编码，静止的电机每样本只占半字节。
+//
+//   [seq u8][flags u8][motors M u8][samples S u8][interval_us u16]  flags bit0 = 关键帧
+//   [M × 本地 id]
+//   S × { [⌈M/2⌉ 字节掩码：每电机 4 位，低半字节在前；bit0 角度 bit1 速度 bit2 电流 bit3 温度]
+//         [按电机顺序，掩码置位字段的残差：zigzag 变长整数（LEB128，每字节 7 位）] }
+//
+// 预测：角度按上一次的角度增量线性外推（13 位回绕，残差取最短方向），速度/电流/温度为上一次的值；
+// 掩码位为 0 表示残差为 0。关键帧在第一个样本前把全部预测值清零，第一个样本即为绝对值，
+// 解码器据此重新同步。差分帧的 seq 须为上一帧加 1，否则（丢帧、尚未收到关键帧）整帧丢弃直到下一个关键帧。
+// 各样本的时刻为：帧的最后一个样本对应接收时刻，向前每个样本相差 interval_us。
+
+#define TELEM_DELTA_HDR    6
+#define TELEM_DELTA_F_KEY  0x01
+// 残差最长字节数：角度 2，速度/电流 3，温度 2
+#define TELEM_DELTA_MAX_PER_MOTOR 10
+// M 个电机、S 个样本的最长 payload
+#define TELEM_DELTA_MAX_PAYLOAD(m, s) (TELEM_DELTA_HDR + (m) + (s) * (((m) + 1) / 2 + (m) * TELEM_DELTA_MAX_PER_MOTOR))
+
+// 解码返回值（>= 0 为样本数）
+#define TELEM_DELTA_ERR_SYNC   (-1) // 差分帧无法应用（序号不连续或尚未收到关键帧）
+#define TELEM_DELTA_ERR_FORMAT (-2) // payload 结构错误（此后需要关键帧）
+
+// 每块板一份编解码状态，按板内本地 id 索引
+typedef struct {
+	bool valid;    // 解码：已同步
+	uint8_t seq;   // 编码：下一帧的序号；解码：期望的序号
+	uint16_t angle[CBOARD_MOTORS_PER_BOARD];
+	int16_t dangle[CBOARD_MOTORS_PER_BOARD];
+	int16_t speed[CBOARD_MOTORS_PER_BOARD];
+	int16_t current[CBOARD_MOTORS_PER_BOARD];
+	uint8_t temp[CBOARD_MOTORS_PER_BOARD];
+} telem_delta_state_t;
+
+// 每解出一个样本调用一次：row 为该样本的 M 个电机状态（motor_id 为本地 id）
+typedef void (*telem_delta_sink_t)(void *ctx, const motor_status_t *row, uint8_t motors, uint8_t sample,
+								   uint8_t samples, uint16_t interval_us);
+
+void telem_delta_reset(telem_delta_state_t *st);
+
+// 编码 S 个样本（samples[s * motors + m]，motor_id 为本地 id，各样本的电机顺序须相同），
+// 返回 payload 长度；参数无效或 size 小于 TELEM_DELTA_MAX_PAYLOAD(motors, nsamples) 返回 0
+size_t telem_delta_encode(telem_delta_state_t *st, uint8_t *out, size_t size, const motor_status_t *samples,
+						  uint8_t motors, uint8_t nsamples, uint16_t interval_us, bool keyframe);
+
+// 解码一帧 payload，逐样本交给 sink；返回样本数或 TELEM_DELTA_ERR_*。
+// 整帧结构先检查通过才开始交出样本，结构错误的帧不会交出任何样本
+int telem_delta_decode(telem_delta_state_t *st, const uint8_t *p, size_t len, telem_delta_sink_t sink, void *ctx);
+
+#endif // TELEM_DELTA_H
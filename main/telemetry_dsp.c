@@ -0,0 +1,134 @@
+#include "telemetry_dsp.h"
+#include <string.h>
+
+#if TDSP_RMS_WINDOW < 1 || TDSP_RMS_WINDOW > 255
+#error "TDSP_RMS_WINDOW must be within 1..255"
+#endif
+
+// 差分速度/加速度的限幅（计数/s、计数/s²）：远高于实际转速（8192 × 10000 rpm / 60 ≈ 1.4M），
+// 且 Q8 后仍在 32 位内
+#define TDSP_DIFF_LIMIT (1 << 22)
+
+#define CSWAP(a, b) do { if ((a) > (b)) { int16_t t_ = (a); (a) = (b); (b) = t_; } } while (0)
+
+// 5 点中值：固定 7 次比较交换的选择网络
+static int16_t median5(const int16_t *h)
+{
+	int16_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+	CSWAP(a, b); CSWAP(d, e); CSWAP(a, d); CSWAP(b, e);
+	CSWAP(b, c); CSWAP(c, d); CSWAP(b, c);
+	return c;
+}
+
+static uint16_t isqrt32(uint32_t x)
+{
+	uint32_t r = 0, bit = 1u << 30;
+	while (bit > x) bit >>= 2;
+	while (bit) {
+		if (x >= r + bit) {
+			x -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t)r;
+}
+
+static inline int32_t ema_q8(int32_t ema, int32_t x)
+{
+	return (int32_t)(ema + (((int64_t)x * 256 - ema) >> TDSP_EMA_SHIFT));
+}
+
+static inline int32_t clamp_diff(int64_t v)
+{
+	if (v > TDSP_DIFF_LIMIT) return TDSP_DIFF_LIMIT;
+	if (v < -TDSP_DIFF_LIMIT) return -TDSP_DIFF_LIMIT;
+	return (int32_t)v;
+}
+
+static inline int32_t q8_round(int32_t v)
+{
+	return (v + (v >= 0 ? 128 : -128)) / 256;
+}
+
+void tdsp_reset(tdsp_state_t *s)
+{
+	memset(s, 0, sizeof(*s));
+}
+
+void tdsp_update(tdsp_state_t *s, const motor_status_t *raw, int64_t t_us, motor_derived_t *out)
+{
+	int64_t dt = t_us - s->t_prev_us;
+	// 首个样本或时间基准跳变（模拟器复位、长时间中断）：以当前样本重新初始化滤波器，保留多圈位置。
+	// 时间戳不前进或略有倒退（同一读取块中的多帧、回放）不算跳变：滤波照常，只推迟差分
+	if (!s->primed || dt > 1000000 || dt < -1000000) {
+		int32_t pos = s->primed ? out->position : raw->angle;
+		uint32_t samples = out->samples;
+		tdsp_reset(s);
+		for (int i = 0; i < TDSP_MEDIAN_N; ++i) {
+			s->cur_hist[i] = raw->current;
+			s->spd_hist[i] = raw->speed;
+		}
+		s->cur_ema_q8 = (int32_t)raw->current * 256;
+		s->spd_ema_q8 = (int32_t)raw->speed * 256;
+		s->angle_prev = raw->angle;
+		s->t_prev_us = t_us;
+		s->primed = true;
+		memset(out, 0, sizeof(*out));
+		out->position = pos;
+		out->speed_filt = raw->speed;
+		out->current_med = raw->current;
+		out->current_filt = raw->current;
+		out->samples = samples;
+		dt = 0; // 本样本只作基准，不差分
+	}
+
+	// 中值 + EMA
+	s->cur_hist[s->med_idx] = raw->current;
+	s->spd_hist[s->med_idx] = raw->speed;
+	s->med_idx = (uint8_t)((s->med_idx + 1) % TDSP_MEDIAN_N);
+	int16_t cur_med = median5(s->cur_hist);
+	s->cur_ema_q8 = ema_q8(s->cur_ema_q8, cur_med);
+	s->spd_ema_q8 = ema_q8(s->spd_ema_q8, median5(s->spd_hist));
+
+	// 滑动 RMS：减去被挤出的样本，加上新样本
+	int32_t c = raw->current;
+	if (s->rms_n == TDSP_RMS_WINDOW) {
+		int32_t old = s->rms_hist[s->rms_idx];
+		s->rms_sum -= (uint64_t)(old * old);
+	} else {
+		s->rms_n++;
+	}
+	s->rms_hist[s->rms_idx] = raw->current;
+	s->rms_sum += (uint64_t)(c * c);
+	s->rms_idx = (uint8_t)((s->rms_idx + 1) % TDSP_RMS_WINDOW);
+
+	// 角度展开每个样本都做；差分只在距上次差分至少 TDSP_MIN_DT_US 时进行，
+	// 其间的角度差累积到下一次（时间戳几乎相同的样本不会把微小的 dt 放大成离谱的速度）
+	int32_t d = (int32_t)raw->angle - (int32_t)s->angle_prev;
+	if (d > 4095) d -= 8192;
+	if (d < -4096) d += 8192;
+	out->position += d;
+	s->angle_prev = raw->angle;
+	s->d_pending += d;
+	if (dt >= TDSP_MIN_DT_US) {
+		int32_t vel = clamp_diff((int64_t)s->d_pending * 1000000 / dt);
+		s->vel_ema_q8 = ema_q8(s->vel_ema_q8, vel);
+		int32_t vel_f = q8_round(s->vel_ema_q8);
+		int32_t acc = clamp_diff((int64_t)(vel_f - s->vel_prev) * 1000000 / dt);
+		s->acc_ema_q8 = ema_q8(s->acc_ema_q8, acc);
+		s->vel_prev = vel_f;
+		out->velocity = vel_f;
+		out->accel = q8_round(s->acc_ema_q8);
+		s->d_pending = 0;
+		s->t_prev_us = t_us;
+	}
+
+	out->speed_filt = (int16_t)q8_round(s->spd_ema_q8);
+	out->current_med = cur_med;
+	out->current_filt = (int16_t)q8_round(s->cur_ema_q8);
+	out->current_rms = isqrt32((uint32_t)(s->rms_sum / s->rms_n)); // 均值 <= 32768^2，放得下 32 位
+	out->samples++;
+}
@@ -0,0 +1,46 @@
+#ifndef TELEMETRY_DSP_H
+#define TELEMETRY_DSP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "serial_cboard.h"
+#include "config.h"
+
+// 遥测信号处理：解析器每收到一个电机样本调用一次 tdsp_update，
+// 以 O(1) 的整数运算更新该电机的派生量，结果与原始值一起保存（见 get_motor_derived），
+// 复位检测、串口屏与网页直接读取，不再各自对原始噪声数据做处理。
+//
+//   电流/速度：5 点中值（去除单点毛刺）后接一阶 EMA（alpha = 1/2^TDSP_EMA_SHIFT）
+//   角度展开：相邻样本角度差按最短路径折算到 [-4096, 4095]，累加得到多圈位置
+//   速度/加速度：由展开后的角度差分与样本时间戳求得（计数/s、计数/s²），限幅后经 EMA；
+//   间隔不足 TDSP_MIN_DT_US 的样本只累积角度差，留到下一次差分
+//   RMS 电流：最近 TDSP_RMS_WINDOW 个样本平方和的滑动窗口
+
+#define TDSP_MEDIAN_N 5
+
+// 每个电机的滤波器状态
+typedef struct {
+	bool primed;
+	uint8_t med_idx;
+	uint8_t rms_idx;
+	uint8_t rms_n;
+	int16_t cur_hist[TDSP_MEDIAN_N];
+	int16_t spd_hist[TDSP_MEDIAN_N];
+	int16_t rms_hist[TDSP_RMS_WINDOW];
+	uint64_t rms_sum;      // 窗口内平方和（单个平方可达 2^30，满量程时 4 个样本即超出 32 位）
+	int32_t cur_ema_q8;    // Q8
+	int32_t spd_ema_q8;
+	int32_t vel_ema_q8;
+	int32_t acc_ema_q8;
+	int32_t vel_prev;
+	int32_t d_pending;     // 上次差分以来累积的角度差
+	uint16_t angle_prev;
+	int64_t t_prev_us;
+} tdsp_state_t;
+
+void tdsp_reset(tdsp_state_t *s);
+
+// 处理一个样本并写出派生量（out 同时作为多圈位置的累加基准，需随 s 一起保存）
+void tdsp_update(tdsp_state_t *s, const motor_status_t *raw, int64_t t_us, motor_derived_t *out);
+
+#endif // TELEMETRY_DSP_H
@@ -0,0 +1,405 @@
+#include "time_sync.h"
+#include <string.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "config.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "task_topology.h"
+
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+#define TS_LOCK()   portENTER_CRITICAL(&s_mux)
+#define TS_UNLOCK() portEXIT_CRITICAL(&s_mux)
+
+int64_t time_sync_local_us(void)
+{
+	return esp_timer_get_time();
+}
+#else
+// 主机构建：时钟由测试程序提供（可注入偏移与频偏），日志输出到 stderr
+#include <pthread.h>
+
+static pthread_mutex_t s_mtx = PTHREAD_MUTEX_INITIALIZER;
+#define TS_LOCK()   pthread_mutex_lock(&s_mtx)
+#define TS_UNLOCK() pthread_mutex_unlock(&s_mtx)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+
+int64_t time_sync_host_clock_us(void);
+
+int64_t time_sync_local_us(void)
+{
+	return time_sync_host_clock_us();
+}
+#endif
+
+static const char *TAG = "time_sync";
+
+// 报文（小端）：[u16 magic][u8 ver][u8 type][u32 seq][body]
+//   REQ   body: i64 t1（从机发送时刻）
+//   RESP  body: i64 t1（回显）, i64 t2（主机接收时刻）, i64 t3（主机发送时刻）
+//   START body: i64 epoch（主机时间）, u8 mode
+#define TS_MAGIC      0x5354
+#define TS_VERSION    1
+#define TS_TYPE_REQ   1
+#define TS_TYPE_RESP  2
+#define TS_TYPE_START 3
+#define TS_HDR_LEN    8
+
+#define TS_WINDOW       32 // 拟合窗口（被接受的样本）
+#define TS_DELAY_WINDOW 32 // 最小延迟统计窗口（全部样本）
+#define TS_BURST        8  // 启动时以短间隔快速采样的次数
+#define TS_BURST_MS     50
+#define TS_MAX_DRIFT    500e-6 // 频偏上限（晶振 ±500 ppm）
+
+typedef struct {
+	int64_t t;    // 样本的本地时间（请求与应答的中点）
+	int64_t off;  // 主机时间 - 本地时间
+} ts_sample_t;
+
+typedef struct {
+	struct sockaddr_in addr;
+	int64_t last_seen_us;
+} ts_peer_t;
+
+static int s_sock = -1;
+static bool s_bound_master; // socket 绑定在 TIME_SYNC_PORT 上
+static volatile time_sync_role_t s_role = TIME_SYNC_OFF;
+static struct sockaddr_in s_master;
+static time_sync_start_cb_t s_start_cb = NULL;
+
+// 从机请求/样本状态（仅服务任务访问）
+static uint32_t s_seq;
+static volatile uint32_t s_reqs; // 本次以从机身份发出的请求数（前 TS_BURST 个快速采样）
+static ts_sample_t s_win[TS_WINDOW];
+static int s_win_n, s_win_head;
+static uint32_t s_delays[TS_DELAY_WINDOW];
+static int s_delay_n, s_delay_head;
+static int64_t s_last_epoch = -1; // 已处理的启动命令（重复报文去重）
+
+// 主机：近期从机
+static ts_peer_t s_peers[TIME_SYNC_MAX_PEERS];
+
+// 时钟模型（加锁读写）：sync = local + a + b * (local - tref)
+static int64_t s_tref;
+static double s_a;
+static double s_b;
+static bool s_have_model;
+static time_sync_status_t s_status;
+static int64_t s_last_accept_us;
+
+static void put_le(uint8_t *p, uint64_t v, int n)
+{
+	for (int i = 0; i < n; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t *p, int n)
+{
+	uint64_t v = 0;
+	for (int i = 0; i < n; ++i) v |= (uint64_t)p[i] << (8 * i);
+	return v;
+}
+
+static size_t put_hdr(uint8_t *p, uint8_t type, uint32_t seq)
+{
+	put_le(p, TS_MAGIC, 2);
+	p[2] = TS_VERSION;
+	p[3] = type;
+	put_le(p + 4, seq, 4);
+	return TS_HDR_LEN;
+}
+
+static int64_t model_offset(int64_t local)
+{
+	return (int64_t)(s_a + s_b * (double)(local - s_tref));
+}
+
+int64_t time_sync_now_us(void)
+{
+	int64_t local = time_sync_local_us();
+	TS_LOCK();
+	int64_t off = s_have_model ? model_offset(local) : 0;
+	TS_UNLOCK();
+	return local + off;
+}
+
+int64_t time_sync_to_local_us(int64_t sync_us)
+{
+	TS_LOCK();
+	int64_t off = 0;
+	if (s_have_model) {
+		// 一阶反解：频偏很小，先用 sync 近似 local 求偏移即可
+		off = model_offset(sync_us - (int64_t)s_a);
+	}
+	TS_UNLOCK();
+	return sync_us - off;
+}
+
+static uint32_t delay_min(void)
+{
+	uint32_t m = UINT32_MAX;
+	for (int i = 0; i < s_delay_n; ++i) {
+		if (s_delays[i] < m) m = s_delays[i];
+	}
+	return m;
+}
+
+static void reset_model(void)
+{
+	s_win_n = s_win_head = 0;
+	TS_LOCK();
+	s_have_model = false;
+	s_status.locked = false;
+	TS_UNLOCK();
+}
+
+// 最小二乘拟合 off = a + b * (t - tref)，tref 取最新样本时间
+static void fit_model(void)
+{
+	int newest = (s_win_head + TS_WINDOW - 1) % TS_WINDOW;
+	int64_t tref = s_win[newest].t;
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	for (int i = 0; i < s_win_n; ++i) {
+		double x = (double)(s_win[i].t - tref);
+		double y = (double)s_win[i].off;
+		sx += x; sy += y; sxx += x * x; sxy += x * y;
+	}
+	double n = (double)s_win_n;
+	double b = 0.0;
+	double var = sxx - sx * sx / n;
+	if (s_win_n >= 4 && var > 0.0) b = (sxy - sx * sy / n) / var;
+	if (b > TS_MAX_DRIFT) b = TS_MAX_DRIFT;
+	if (b < -TS_MAX_DRIFT) b = -TS_MAX_DRIFT;
+	double a = sy / n - b * (sx / n);
+
+	TS_LOCK();
+	s_tref = tref;
+	s_a = a;
+	s_b = b;
+	s_have_model = true;
+	s_status.locked = s_win_n >= 4;
+	s_status.offset_us = (int64_t)a;
+	s_status.drift_ppb = (int32_t)(b * 1e9);
+	TS_UNLOCK();
+}
+
+// 处理一次完整的时间戳交换
+static void add_sample(int64_t t1, int64_t t2, int64_t t3, int64_t t4)
+{
+	int64_t rtt = (t4 - t1) - (t3 - t2);
+	if (rtt < 0) rtt = 0;
+	int64_t off = ((t2 - t1) + (t3 - t4)) / 2;
+	int64_t mid = t1 + (t4 - t1) / 2;
+
+	s_delays[s_delay_head] = (uint32_t)rtt;
+	s_delay_head = (s_delay_head + 1) % TS_DELAY_WINDOW;
+	if (s_delay_n < TS_DELAY_WINDOW) s_delay_n++;
+	uint32_t dmin = delay_min();
+	s_status.samples++;
+	s_status.delay_min_us = dmin;
+
+	// 只用接近最小延迟的样本：排队造成的不对称延迟是偏移误差的主要来源
+	if ((uint32_t)rtt > dmin + TIME_SYNC_DELAY_SLACK_US) {
+		s_status.rejected++;
+		return;
+	}
+	// 偏移突变（主机重启或本机时钟跳变）：丢弃旧模型重新收敛
+	if (s_have_model && s_win_n >= 4) {
+		int64_t err = off - model_offset(mid);
+		if (err > TIME_SYNC_STEP_US || err < -TIME_SYNC_STEP_US) {
+			ESP_LOGW(TAG, "offset step %lld us, resetting clock model", (long long)err);
+			s_status.resets++;
+			reset_model();
+		}
+	}
+	s_win[s_win_head] = (ts_sample_t){ .t = mid, .off = off };
+	s_win_head = (s_win_head + 1) % TS_WINDOW;
+	if (s_win_n < TS_WINDOW) s_win_n++;
+	s_status.delay_us = (uint32_t)rtt;
+	s_last_accept_us = t4;
+	bool was_locked = s_status.locked;
+	fit_model();
+	if (!was_locked && s_status.locked) {
+		ESP_LOGI(TAG, "locked: offset=%lld us drift=%ld ppb delay=%lu us", (long long)s_status.offset_us,
+				 (long)s_status.drift_ppb, (unsigned long)rtt);
+	}
+}
+
+static void send_req(void)
+{
+	uint8_t buf[TS_HDR_LEN + 8];
+	size_t n = put_hdr(buf, TS_TYPE_REQ, ++s_seq);
+	put_le(buf + n, (uint64_t)time_sync_local_us(), 8);
+	sendto(s_sock, buf, sizeof(buf), 0, (struct sockaddr *)&s_master, sizeof(s_master));
+}
+
+static void note_peer(const struct sockaddr_in *from, int64_t now)
+{
+	ts_peer_t *slot = NULL;
+	for (int i = 0; i < TIME_SYNC_MAX_PEERS; ++i) {
+		ts_peer_t *p = &s_peers[i];
+		if (p->last_seen_us && p->addr.sin_addr.s_addr == from->sin_addr.s_addr &&
+			p->addr.sin_port == from->sin_port) {
+			slot = p;
+			break;
+		}
+		// 空槽或最久未见的槽
+		if (!slot || p->last_seen_us < slot->last_seen_us) slot = p;
+	}
+	slot->addr = *from;
+	slot->last_seen_us = now;
+}
+
+static void handle_packet(const uint8_t *buf, int len, const struct sockaddr_in *from, int64_t t_rx)
+{
+	if (len < TS_HDR_LEN || get_le(buf, 2) != TS_MAGIC || buf[2] != TS_VERSION) return;
+	uint8_t type = buf[3];
+	uint32_t seq = (uint32_t)get_le(buf + 4, 4);
+	const uint8_t *body = buf + TS_HDR_LEN;
+
+	if (type == TS_TYPE_REQ && s_role == TIME_SYNC_MASTER && len >= TS_HDR_LEN + 8) {
+		uint8_t out[TS_HDR_LEN + 24];
+		size_t n = put_hdr(out, TS_TYPE_RESP, seq);
+		memcpy(out + n, body, 8); // t1
+		put_le(out + n + 8, (uint64_t)t_rx, 8);
+		put_le(out + n + 16, (uint64_t)time_sync_local_us(), 8); // t3 尽量靠近实际发送
+		sendto(s_sock, out, sizeof(out), 0, (const struct sockaddr *)from, sizeof(*from));
+		note_peer(from, t_rx);
+	} else if (type == TS_TYPE_RESP && s_role == TIME_SYNC_SLAVE && len >= TS_HDR_LEN + 24) {
+		if (seq != s_seq) return; // 过期应答（超时后才到达），其 t4 不可信
+		add_sample((int64_t)get_le(body, 8), (int64_t)get_le(body + 8, 8), (int64_t)get_le(body + 16, 8), t_rx);
+	} else if (type == TS_TYPE_START && s_role == TIME_SYNC_SLAVE && len >= TS_HDR_LEN + 9) {
+		int64_t epoch = (int64_t)get_le(body, 8);
+		if (epoch == s_last_epoch) return; // 重复发送的同一命令
+		s_last_epoch = epoch;
+		ESP_LOGI(TAG, "start command: mode=%u epoch=%lld (in %lld ms)", body[8], (long long)epoch,
+				 (long long)((epoch - time_sync_now_us()) / 1000));
+		if (s_start_cb) s_start_cb(body[8], epoch);
+	}
+}
+
+void time_sync_run(void)
+{
+	uint8_t buf[64];
+	int64_t next_req = 0;
+	while (1) {
+		if (s_role == TIME_SYNC_SLAVE) {
+			int64_t now = time_sync_local_us();
+			if (now >= next_req) {
+				send_req();
+				s_reqs++;
+				next_req = now + (int64_t)(s_reqs < TS_BURST ? TS_BURST_MS : TIME_SYNC_INTERVAL_MS) * 1000;
+			}
+		}
+		struct sockaddr_in from;
+		socklen_t fl = sizeof(from);
+		int n = recvfrom(s_sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &fl);
+		int64_t t_rx = time_sync_local_us(); // 软件时间戳：尽量紧挨 recvfrom
+		if (n > 0) handle_packet(buf, n, &from, t_rx);
+	}
+}
+
+#ifdef ESP_PLATFORM
+static void time_sync_task(void *arg)
+{
+	(void)arg;
+	time_sync_run();
+}
+#endif
+
+int time_sync_start(time_sync_role_t role, const char *master_ip)
+{
+	if (role == TIME_SYNC_SLAVE) {
+		memset(&s_master, 0, sizeof(s_master));
+		s_master.sin_family = AF_INET;
+		s_master.sin_port = htons(TIME_SYNC_PORT);
+		if (!master_ip || inet_pton(AF_INET, master_ip, &s_master.sin_addr) != 1) {
+			ESP_LOGE(TAG, "invalid master address");
+			return -1;
+		}
+		s_delay_n = s_delay_head = 0;
+		s_reqs = 0;
+	} else if (role == TIME_SYNC_MASTER && s_sock >= 0 && !s_bound_master) {
+		// 从机使用的是临时端口，从机收不到发往 TIME_SYNC_PORT 的请求
+		ESP_LOGE(TAG, "socket bound as slave; reboot with TIME_SYNC_ROLE=1 to act as master");
+		return -1;
+	}
+	// 角色变化后旧的模型不再适用：主机/关闭时同步时间即本地时间，从机重新收敛
+	reset_model();
+	if (s_sock < 0) {
+		int sock = socket(AF_INET, SOCK_DGRAM, 0);
+		if (sock < 0) return -1;
+		// 主机固定端口；从机使用任意端口（主机按来源地址应答）
+		struct sockaddr_in local = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_ANY) };
+		local.sin_port = htons(role == TIME_SYNC_SLAVE ? 0 : TIME_SYNC_PORT);
+		struct timeval tv = { .tv_sec = 0, .tv_usec = TS_BURST_MS * 1000 };
+		setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+		if (bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+			ESP_LOGE(TAG, "bind failed");
+			close(sock);
+			return -1;
+		}
+		s_sock = sock;
+		s_bound_master = role != TIME_SYNC_SLAVE;
+#ifdef ESP_PLATFORM
+		task_topology_create(TASK_ID_TIME_SYNC, time_sync_task, NULL, NULL, NULL);
+#endif
+	}
+	s_role = role;
+	TS_LOCK();
+	s_status.role = role;
+	TS_UNLOCK();
+	ESP_LOGI(TAG, "role=%s%s%s", role == TIME_SYNC_MASTER ? "master" : role == TIME_SYNC_SLAVE ? "slave" : "off",
+			 role == TIME_SYNC_SLAVE ? " master=" : "", role == TIME_SYNC_SLAVE ? master_ip : "");
+	return 0;
+}
+
+void time_sync_get_status(time_sync_status_t *out)
+{
+	if (!out) return;
+	int64_t now = time_sync_local_us();
+	TS_LOCK();
+	*out = s_status;
+	if (s_have_model) out->offset_us = model_offset(now);
+	TS_UNLOCK();
+	out->last_sample_age_ms = s_last_accept_us ? (now - s_last_accept_us) / 1000 : -1;
+	out->peers = 0;
+	for (int i = 0; i < TIME_SYNC_MAX_PEERS; ++i) {
+		if (s_peers[i].last_seen_us && now - s_peers[i].last_seen_us < (int64_t)TIME_SYNC_PEER_TIMEOUT_MS * 1000) {
+			out->peers++;
+		}
+	}
+}
+
+void time_sync_set_start_cb(time_sync_start_cb_t cb)
+{
+	s_start_cb = cb;
+}
+
+int time_sync_broadcast_start(uint8_t mode, int64_t epoch_us)
+{
+	if (s_sock < 0 || s_role != TIME_SYNC_MASTER) return 0;
+	uint8_t buf[TS_HDR_LEN + 9];
+	size_t n = put_hdr(buf, TS_TYPE_START, 0);
+	put_le(buf + n, (uint64_t)epoch_us, 8);
+	buf[n + 8] = mode;
+	int64_t now = time_sync_local_us();
+	int sent = 0;
+	for (int i = 0; i < TIME_SYNC_MAX_PEERS; ++i) {
+		const ts_peer_t *p = &s_peers[i];
+		if (!p->last_seen_us || now - p->last_seen_us >= (int64_t)TIME_SYNC_PEER_TIMEOUT_MS * 1000) continue;
+		for (int r = 0; r < 3; ++r) {
+			sendto(s_sock, buf, sizeof(buf), 0, (const struct sockaddr *)&p->addr, sizeof(p->addr));
+		}
+		sent++;
+	}
+	return sent;
+}
@@ -0,0 +1,60 @@
+#ifndef TIME_SYNC_H
+#define TIME_SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 多机架时间同步：轻量 UDP 协议（类 PTP 的双向时间戳交换）。
+// 从机周期性发送请求，主机回复接收/发送时间戳，从机由四个时间戳求出偏移与路径延迟，
+// 只接受接近最小延迟的样本（过滤 Wi-Fi 排队抖动），对窗口内样本做线性拟合得到偏移与频偏。
+// time_sync_now_us() 给出主机时间基准下的当前时间，预设层据此在共同的时间轴上运行。
+//
+// 本模块不依赖 FreeRTOS 之外的 ESP 组件，也可在主机上编译（见 tools/timesync_loopback.c），
+// 用两个进程在回环地址上验证同步精度。
+
+typedef enum {
+	TIME_SYNC_OFF = 0,   // 不同步：同步时间即本地时间
+	TIME_SYNC_MASTER,    // 主机：以本地时钟为基准应答请求，并可下发“在 T 时刻启动”
+	TIME_SYNC_SLAVE,     // 从机：向主机请求时间并估计偏移/频偏
+} time_sync_role_t;
+
+typedef struct {
+	time_sync_role_t role;
+	bool locked;            // 从机：样本足够，时钟模型可用
+	int64_t offset_us;      // 当前时刻 主机时间 - 本地时间
+	int32_t drift_ppb;      // 本地时钟相对主机的频率偏差（十亿分之一）
+	uint32_t delay_us;      // 最近一个被接受样本的往返路径延迟
+	uint32_t delay_min_us;  // 近期最小往返延迟
+	uint32_t samples;       // 收到的有效应答数
+	uint32_t rejected;      // 因延迟过大被丢弃的样本数
+	uint32_t resets;        // 偏移突变（如主机重启）导致的模型重置次数
+	uint32_t peers;         // 主机：近期活跃的从机数
+	int64_t last_sample_age_ms; // 距最近一次被接受样本的时间，-1 表示尚无样本
+} time_sync_status_t;
+
+// 收到主机的启动命令：mode 为预设模式，epoch_us 为主机时间基准下的起始时刻
+typedef void (*time_sync_start_cb_t)(uint8_t mode, int64_t epoch_us);
+
+// 启动/切换角色；首次调用时创建 UDP socket 与服务任务。master_ip 仅从机需要
+int time_sync_start(time_sync_role_t role, const char *master_ip);
+
+// 本地单调时钟（微秒）
+int64_t time_sync_local_us(void);
+
+// 主机时间基准下的当前时间（未同步时等于本地时间）
+int64_t time_sync_now_us(void);
+
+// 主机时间 -> 本地时间（用于把同步时间轴上的截止时刻换算为本地睡眠时长）
+int64_t time_sync_to_local_us(int64_t sync_us);
+
+void time_sync_get_status(time_sync_status_t *out);
+
+void time_sync_set_start_cb(time_sync_start_cb_t cb);
+
+// 主机：向所有近期活跃的从机下发启动命令（UDP 重复发送以应对丢包），返回发送的从机数
+int time_sync_broadcast_start(uint8_t mode, int64_t epoch_us);
+
+// 服务循环（阻塞）：ESP 上由 time_sync 任务运行，主机构建中由测试程序调用
+void time_sync_run(void);
+
+#endif // TIME_SYNC_H
@@ -0,0 +1,410 @@
+#include "uart_capture.h"
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_partition.h"
+#include "config.h"
+#include "serial_cboard.h"
+#include "ui_state.h"
+#include "task_topology.h"
+#include "mem_budget.h"
+
+static const char *TAG = "uart_capture";
+
+// 分区布局：第 0 扇区存放文件头（magic + 长度），记录区从第 1 扇区开始
+#define CAPTURE_SECTOR_SIZE  4096
+#define CAPTURE_DATA_OFFSET  CAPTURE_SECTOR_SIZE
+#define CAPTURE_REC_MAX      (1 + 10 + UART_CAPTURE_MAX_CHUNK) // 时间差为 64 位变长整数
+
+static const esp_partition_t *s_part = NULL;
+static uint32_t s_capacity = 0;   // 记录区容量
+static uint32_t s_saved_len = 0;  // 已提交（文件头中记录）的记录区长度
+
+// 抓包状态：两个扇区大小的暂存块轮流填充，满后交给写入任务落盘
+typedef struct {
+	uint8_t idx;
+	bool final;
+	uint16_t len;
+	uint32_t off; // 记录区内偏移（扇区对齐）
+} flush_item_t;
+
+static uint8_t s_block[2][CAPTURE_SECTOR_SIZE];
+static volatile bool s_block_busy[2];
+static int s_cur = 0;
+static size_t s_fill = 0;
+static uint32_t s_block_off = 0;  // 当前块对应的记录区偏移
+static volatile bool s_recording = false;
+static int64_t s_last_us = 0;
+static uint32_t s_records = 0;
+static uint32_t s_dropped = 0;
+// 抓包暂存状态的锁：记录在发送路径（含急停发送）上进行，用临界区而不是互斥量，
+// 低优先级的写入任务不会通过优先级反转拖住高优先级的发送任务；临界区内只做内存拷贝
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static QueueHandle_t s_flush_q = NULL;
+static SemaphoreHandle_t s_flush_done = NULL;
+static StaticSemaphore_t s_flush_done_buf;
+static StaticQueue_t s_flush_q_buf;
+static uint8_t s_flush_q_storage[2 * sizeof(flush_item_t)];
+
+// 回放状态
+static TaskHandle_t s_replay_task = NULL;
+static volatile bool s_replay_stop = false;
+static uint32_t s_replay_speed = 1;
+static uint32_t s_replay_records = 0;
+
+// 上传状态：记录区按扇区在写入前擦除（s_upload_erased 为已擦除的记录区字节数）
+static uint32_t s_upload_off = 0;
+static uint32_t s_upload_erased = 0;
+static uint8_t s_upload_hdr[UART_CAPTURE_HDR_SIZE];
+
+static inline void put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = v & 0xFF; p[1] = (v >> 8) & 0xFF; p[2] = (v >> 16) & 0xFF; p[3] = (v >> 24) & 0xFF;
+}
+
+static inline uint32_t get_le32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static esp_err_t write_header(uint32_t len)
+{
+	uint8_t hdr[UART_CAPTURE_HDR_SIZE];
+	put_le32(hdr, UART_CAPTURE_MAGIC);
+	put_le32(hdr + 4, len);
+	esp_err_t err = esp_partition_erase_range(s_part, 0, CAPTURE_SECTOR_SIZE);
+	if (err == ESP_OK) err = esp_partition_write(s_part, 0, hdr, sizeof(hdr));
+	if (err == ESP_OK) s_saved_len = len;
+	return err;
+}
+
+static uint32_t read_saved_len(void)
+{
+	uint8_t hdr[UART_CAPTURE_HDR_SIZE];
+	if (!s_part || esp_partition_read(s_part, 0, hdr, sizeof(hdr)) != ESP_OK) return 0;
+	if (get_le32(hdr) != UART_CAPTURE_MAGIC) return 0;
+	uint32_t len = get_le32(hdr + 4);
+	return len <= s_capacity ? len : 0;
+}
+
+// 后台写入任务：擦除目标扇区并写入暂存块
+static void capture_writer_task(void *arg)
+{
+	(void)arg;
+	flush_item_t it;
+	while (1) {
+		if (xQueueReceive(s_flush_q, &it, portMAX_DELAY) != pdTRUE) continue;
+		if (it.len > 0) {
+			esp_err_t err = esp_partition_erase_range(s_part, CAPTURE_DATA_OFFSET + it.off, CAPTURE_SECTOR_SIZE);
+			if (err == ESP_OK) err = esp_partition_write(s_part, CAPTURE_DATA_OFFSET + it.off, s_block[it.idx], it.len);
+			if (err != ESP_OK) ESP_LOGE(TAG, "flash write failed at %lu: %s", (unsigned long)it.off, esp_err_to_name(err));
+		}
+		s_block_busy[it.idx] = false;
+		if (it.final) {
+			write_header(it.off + it.len);
+			xSemaphoreGive(s_flush_done);
+		}
+	}
+}
+
+void uart_capture_init(void)
+{
+	s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, CAPTURE_PARTITION_LABEL);
+	if (!s_part) {
+		ESP_LOGW(TAG, "partition '%s' not found, capture disabled", CAPTURE_PARTITION_LABEL);
+		return;
+	}
+	s_capacity = (s_part->size - CAPTURE_DATA_OFFSET) & ~(CAPTURE_SECTOR_SIZE - 1);
+	s_saved_len = read_saved_len();
+	s_flush_q = xQueueCreateStatic(2, sizeof(flush_item_t), s_flush_q_storage, &s_flush_q_buf);
+	s_flush_done = xSemaphoreCreateBinaryStatic(&s_flush_done_buf);
+	mem_budget_add("uart_capture", "staging blocks", sizeof(s_block));
+	task_topology_create(TASK_ID_CAPTURE_WR, capture_writer_task, NULL, NULL, NULL);
+	ESP_LOGI(TAG, "capture partition: %lu bytes, saved capture %lu bytes",
+			 (unsigned long)s_capacity, (unsigned long)s_saved_len);
+}
+
+esp_err_t uart_capture_start(void)
+{
+	if (!s_part) return ESP_ERR_NOT_FOUND;
+	if (s_recording || s_replay_task) return ESP_ERR_INVALID_STATE;
+	// 先使旧文件头失效，避免中途掉电后读到新旧混杂的数据（尚未开始记录，不需要加锁）
+	esp_partition_erase_range(s_part, 0, CAPTURE_SECTOR_SIZE);
+	portENTER_CRITICAL(&s_mux);
+	s_saved_len = 0;
+	s_cur = 0;
+	s_fill = 0;
+	s_block_off = 0;
+	s_block_busy[0] = s_block_busy[1] = false;
+	s_records = 0;
+	s_dropped = 0;
+	s_last_us = esp_timer_get_time();
+	s_recording = true;
+	portEXIT_CRITICAL(&s_mux);
+	ESP_LOGI(TAG, "capture started");
+	return ESP_OK;
+}
+
+esp_err_t uart_capture_stop(void)
+{
+	if (!s_recording) return ESP_ERR_INVALID_STATE;
+	portENTER_CRITICAL(&s_mux);
+	s_recording = false;
+	// 提交最后一个（可能不满的）块，并由写入任务写入文件头
+	flush_item_t it = { .idx = (uint8_t)s_cur, .final = true, .len = (uint16_t)s_fill, .off = s_block_off };
+	s_block_busy[s_cur] = true;
+	portEXIT_CRITICAL(&s_mux);
+	xSemaphoreTake(s_flush_done, 0);
+	xQueueSend(s_flush_q, &it, portMAX_DELAY);
+	if (xSemaphoreTake(s_flush_done, pdMS_TO_TICKS(2000)) != pdTRUE) {
+		ESP_LOGE(TAG, "capture flush timeout");
+		return ESP_ERR_TIMEOUT;
+	}
+	// 与停止并发的记录可能在最后一块之后才提交前一块：等它也落盘
+	for (int i = 0; i < 200 && (s_block_busy[0] || s_block_busy[1]); ++i) vTaskDelay(pdMS_TO_TICKS(10));
+	ESP_LOGI(TAG, "capture stopped: %lu records, %lu bytes, %lu dropped",
+			 (unsigned long)s_records, (unsigned long)s_saved_len, (unsigned long)s_dropped);
+	return ESP_OK;
+}
+
+// 当前块写满后能否切换到另一块（需持有 s_mux）
+static bool can_switch_block(void)
+{
+	if (s_block_busy[s_cur ^ 1]) return false;                       // 写入任务尚未完成
+	return s_block_off + 2 * CAPTURE_SECTOR_SIZE <= s_capacity;      // 分区未满
+}
+
+// 切换到另一块（需持有 s_mux，调用前需 can_switch_block() 为真）；写满的块由调用者在临界区外
+// 交给写入任务（队列深度 2，另一块空闲时必有空位，不会阻塞）
+static flush_item_t switch_block(void)
+{
+	flush_item_t it = { .idx = (uint8_t)s_cur, .final = false, .len = (uint16_t)s_fill, .off = s_block_off };
+	s_block_busy[s_cur] = true;
+	s_cur ^= 1;
+	s_fill = 0;
+	s_block_off += CAPTURE_SECTOR_SIZE;
+	return it;
+}
+
+void uart_capture_record(uart_capture_dir_t dir, const uint8_t *data, size_t len)
+{
+	if (!s_recording || !data || len == 0) return;
+	// 写满的块在临界区外提交；刚提交的块在本次调用内不会被释放，因此一次调用至多切换一次
+	flush_item_t full;
+	bool have_full = false;
+	portENTER_CRITICAL(&s_mux);
+	int64_t now = esp_timer_get_time();
+	while (s_recording && len > 0) {
+		size_t n = len > UART_CAPTURE_MAX_CHUNK ? UART_CAPTURE_MAX_CHUNK : len;
+		uint8_t rec[CAPTURE_REC_MAX];
+		size_t r = 0;
+		rec[r++] = (uint8_t)((dir == UART_CAPTURE_TX ? 0x80 : 0x00) | (n - 1));
+		// 64 位时间差：长时间没有流量也不会回绕
+		uint64_t delta = (uint64_t)(now - s_last_us);
+		while (delta >= 0x80) {
+			rec[r++] = (uint8_t)(delta | 0x80);
+			delta >>= 7;
+		}
+		rec[r++] = (uint8_t)delta;
+		memcpy(rec + r, data, n);
+		r += n;
+
+		// 记录可跨块存放，使记录区在 flash 上连续；放不下时整条丢弃，避免半条记录
+		size_t space = CAPTURE_SECTOR_SIZE - s_fill;
+		if (r >= space && !can_switch_block()) {
+			s_dropped++;
+			break;
+		}
+		memcpy(&s_block[s_cur][s_fill], rec, r < space ? r : space);
+		s_fill += r < space ? r : space;
+		if (r >= space) {
+			full = switch_block();
+			have_full = true;
+			memcpy(&s_block[s_cur][0], rec + space, r - space);
+			s_fill = r - space;
+		}
+		s_records++;
+		s_last_us = now;
+		data += n;
+		len -= n;
+	}
+	portEXIT_CRITICAL(&s_mux);
+	if (have_full) xQueueSend(s_flush_q, &full, 0);
+}
+
+size_t uart_capture_read(size_t offset, uint8_t *buf, size_t len)
+{
+	if (!s_part || !buf || s_recording) return 0;
+	size_t total = UART_CAPTURE_HDR_SIZE + s_saved_len;
+	if (s_saved_len == 0 || offset >= total) return 0;
+	if (len > total - offset) len = total - offset;
+	size_t done = 0;
+	if (offset < UART_CAPTURE_HDR_SIZE) {
+		uint8_t hdr[UART_CAPTURE_HDR_SIZE];
+		put_le32(hdr, UART_CAPTURE_MAGIC);
+		put_le32(hdr + 4, s_saved_len);
+		size_t n = UART_CAPTURE_HDR_SIZE - offset;
+		if (n > len) n = len;
+		memcpy(buf, hdr + offset, n);
+		done = n;
+		offset += n;
+	}
+	if (done < len) {
+		if (esp_partition_read(s_part, CAPTURE_DATA_OFFSET + offset - UART_CAPTURE_HDR_SIZE, buf + done, len - done) != ESP_OK) {
+			return done;
+		}
+		done = len;
+	}
+	return done;
+}
+
+esp_err_t uart_capture_upload_begin(void)
+{
+	if (!s_part) return ESP_ERR_NOT_FOUND;
+	if (s_recording || s_replay_task) return ESP_ERR_INVALID_STATE;
+	s_upload_off = 0;
+	s_upload_erased = 0;
+	s_saved_len = 0;
+	// 只擦除文件头扇区；记录区随写入逐扇区擦除，不在开始时一次擦除整个分区
+	return esp_partition_erase_range(s_part, 0, CAPTURE_SECTOR_SIZE);
+}
+
+esp_err_t uart_capture_upload_write(const uint8_t *data, size_t len)
+{
+	if (!s_part) return ESP_ERR_NOT_FOUND;
+	while (len > 0 && s_upload_off < UART_CAPTURE_HDR_SIZE) {
+		s_upload_hdr[s_upload_off++] = *data++;
+		len--;
+	}
+	if (len == 0) return ESP_OK;
+	uint32_t off = s_upload_off - UART_CAPTURE_HDR_SIZE;
+	if (off + len > s_capacity) return ESP_ERR_INVALID_SIZE;
+	esp_err_t err = ESP_OK;
+	while (err == ESP_OK && s_upload_erased < off + len) {
+		err = esp_partition_erase_range(s_part, CAPTURE_DATA_OFFSET + s_upload_erased, CAPTURE_SECTOR_SIZE);
+		if (err == ESP_OK) s_upload_erased += CAPTURE_SECTOR_SIZE;
+	}
+	if (err == ESP_OK) err = esp_partition_write(s_part, CAPTURE_DATA_OFFSET + off, data, len);
+	if (err == ESP_OK) s_upload_off += len;
+	return err;
+}
+
+esp_err_t uart_capture_upload_end(void)
+{
+	if (!s_part) return ESP_ERR_NOT_FOUND;
+	if (s_upload_off < UART_CAPTURE_HDR_SIZE || get_le32(s_upload_hdr) != UART_CAPTURE_MAGIC) return ESP_ERR_INVALID_ARG;
+	uint32_t len = get_le32(s_upload_hdr + 4);
+	if (len > s_upload_off - UART_CAPTURE_HDR_SIZE) return ESP_ERR_INVALID_SIZE;
+	esp_err_t err = esp_partition_write(s_part, 0, s_upload_hdr, sizeof(s_upload_hdr));
+	if (err == ESP_OK) s_saved_len = len;
+	ESP_LOGI(TAG, "capture uploaded: %lu bytes", (unsigned long)len);
+	return err;
+}
+
+// 回放任务：顺序解码记录，RX 数据按时间戳送入解析器
+static void replay_task(void *arg)
+{
+	(void)arg;
+	const uint32_t len = s_saved_len;
+	static uint8_t win[512]; // 记录区读取窗口（单个回放任务独占）
+	uint32_t win_off = 0, win_len = 0;
+	uint32_t pos = 0;
+	uint64_t rec_t = 0;
+	uint32_t tx_records = 0;
+
+	serial_cboard_set_replay(true);
+	ui_state_set_mode(MODE_MANUAL);
+	const int64_t t0 = esp_timer_get_time();
+	ESP_LOGI(TAG, "replay started: %lu bytes speed=%lu", (unsigned long)len, (unsigned long)s_replay_speed);
+
+	while (!s_replay_stop && pos < len) {
+		// 保证窗口内至少有一条完整记录
+		if (pos + CAPTURE_REC_MAX > win_off + win_len && win_off + win_len < len) {
+			win_off = pos;
+			win_len = len - pos < sizeof(win) ? len - pos : sizeof(win);
+			if (esp_partition_read(s_part, CAPTURE_DATA_OFFSET + win_off, win, win_len) != ESP_OK) break;
+		}
+		const uint8_t *p = win + (pos - win_off);
+		const uint8_t *end = win + win_len;
+		uint8_t tag = *p++;
+		uint64_t delta = 0;
+		int shift = 0;
+		while (p < end && shift < 70) {
+			uint8_t b = *p++;
+			delta |= (uint64_t)(b & 0x7F) << shift;
+			shift += 7;
+			if (!(b & 0x80)) break;
+		}
+		size_t n = (size_t)(tag & 0x7F) + 1;
+		if (p + n > end) {
+			ESP_LOGW(TAG, "truncated record at %lu", (unsigned long)pos);
+			break;
+		}
+		rec_t += delta;
+
+		uint32_t speed = s_replay_speed;
+		if (speed > 0) {
+			int64_t target = t0 + (int64_t)(rec_t / speed);
+			int64_t remain = target - esp_timer_get_time();
+			if (remain > 0) {
+				const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+				vTaskDelay((TickType_t)((remain + tick_us - 1) / tick_us));
+			}
+		} else if ((s_replay_records & 0x3FF) == 0) {
+			vTaskDelay(1); // 尽可能快模式下周期性让出 CPU
+		}
+
+		if (tag & 0x80) {
+			tx_records++; // TX 记录仅用于离线分析，回放时不重发
+		} else {
+			serial_cboard_feed_replay(p, n);
+		}
+		s_replay_records++;
+		pos = (uint32_t)((p + n) - win) + win_off;
+	}
+
+	serial_cboard_set_replay(false);
+	ESP_LOGI(TAG, "replay finished: %lu records (%lu tx skipped), %lld ms capture time in %lld ms",
+			 (unsigned long)s_replay_records, (unsigned long)tx_records,
+			 (long long)(rec_t / 1000), (long long)((esp_timer_get_time() - t0) / 1000));
+	s_replay_task = NULL;
+	vTaskDelete(NULL);
+}
+
+esp_err_t uart_capture_replay_start(uint32_t speed)
+{
+	if (!s_part) return ESP_ERR_NOT_FOUND;
+	if (s_recording || s_replay_task) return ESP_ERR_INVALID_STATE;
+	if (s_saved_len == 0) return ESP_ERR_INVALID_SIZE;
+	s_replay_speed = speed;
+	s_replay_records = 0;
+	s_replay_stop = false;
+	if (task_topology_create(TASK_ID_CAPTURE_REPLAY, replay_task, NULL, &s_replay_task, NULL) != pdPASS) {
+		s_replay_task = NULL;
+		return ESP_ERR_NO_MEM;
+	}
+	return ESP_OK;
+}
+
+void uart_capture_replay_stop(void)
+{
+	s_replay_stop = true;
+}
+
+void uart_capture_get_status(uart_capture_status_t *out)
+{
+	if (!out) return;
+	out->available = s_part != NULL;
+	out->recording = s_recording;
+	out->replaying = s_replay_task != NULL;
+	out->capacity = s_capacity;
+	out->length = s_recording ? s_block_off + (uint32_t)s_fill : s_saved_len;
+	out->records = s_records;
+	out->dropped = s_dropped;
+	out->replay_records = s_replay_records;
+	out->replay_speed = s_replay_speed;
+}
@@ -0,0 +1,66 @@
+#ifndef UART_CAPTURE_H
+#define UART_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+// C 板串口抓包与回放模块
+// 抓包：将 C 板链路的原始 RX/TX 字节连同时间戳写入 flash 上的 "capture" 分区，
+// 可通过 HTTP 下载/上传。回放：将抓包中的 RX 字节按原始时间（或加速）重新送入
+// 解析器，从而离线复现复位逻辑与模式状态机的行为。
+//
+// 文件格式（下载/上传时的字节流）：
+//   [magic "RKC1"][u32 LE 记录区长度][记录...]
+// 每条记录：
+//   [tag: bit7=方向(0 RX, 1 TX), bit0..6 = 长度-1][varint 距上一条记录的微秒数][数据]
+
+#define UART_CAPTURE_MAGIC      0x31434B52u // "RKC1"（小端）
+#define UART_CAPTURE_HDR_SIZE   8
+#define UART_CAPTURE_MAX_CHUNK  128         // 单条记录最大数据字节数，超出自动拆分
+
+typedef enum {
+	UART_CAPTURE_RX = 0,
+	UART_CAPTURE_TX = 1,
+} uart_capture_dir_t;
+
+typedef struct {
+	bool available;          // 是否找到 capture 分区
+	bool recording;
+	bool replaying;
+	uint32_t capacity;       // 记录区容量（字节）
+	uint32_t length;         // 已保存的记录区长度
+	uint32_t records;        // 本次抓包记录条数
+	uint32_t dropped;        // 写入跟不上或空间不足而丢弃的记录条数
+	uint32_t replay_records; // 回放已处理的记录数
+	uint32_t replay_speed;   // 回放倍率（0 = 尽可能快）
+} uart_capture_status_t;
+
+// 查找分区并启动后台写入任务
+void uart_capture_init(void);
+
+// 开始/停止抓包（开始时清空旧数据；停止时写入文件头）
+esp_err_t uart_capture_start(void);
+esp_err_t uart_capture_stop(void);
+
+// 由串口收发路径（含急停发送）调用，记录一段原始字节（抓包未开启时立即返回）。
+// 只在短临界区内拷贝，不等待写入任务
+void uart_capture_record(uart_capture_dir_t dir, const uint8_t *data, size_t len);
+
+// 读取抓包文件字节流（含 8 字节文件头），用于 HTTP 流式下载；返回实际读取字节数
+size_t uart_capture_read(size_t offset, uint8_t *buf, size_t len);
+
+// 上传抓包文件：begin 擦除文件头扇区，write 依次写入文件字节流（记录区逐扇区在写入前擦除），
+// end 校验并提交。由 HTTP 异步 worker 调用，flash 擦除不在服务器任务中进行
+esp_err_t uart_capture_upload_begin(void);
+esp_err_t uart_capture_upload_write(const uint8_t *data, size_t len);
+esp_err_t uart_capture_upload_end(void);
+
+// 回放：speed = 1 按原始节奏，N = N 倍速，0 = 尽可能快
+esp_err_t uart_capture_replay_start(uint32_t speed);
+void uart_capture_replay_stop(void);
+
+void uart_capture_get_status(uart_capture_status_t *out);
+
+#endif // UART_CAPTURE_H
@@ -0,0 +1,360 @@
+#include "udp_ctrl.h"
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "config.h"
+#include "ui_state.h"
+#include "time_sync.h"
+#include "task_topology.h"
+#include "mem_budget.h"
+#include "telem_bus.h"
+
+static const char *TAG = "udp_ctrl";
+
+#define UDP_MAX_MOTORS  (CBOARD_MAX_BOARDS * CBOARD_MOTORS_PER_BOARD)
+#define UDP_CMD_LEN     6
+#define UDP_TELEM_LEN   8
+#define UDP_TELEM_HDR   (UDP_CTRL_HDR_LEN + 17)
+#define UDP_MAX_CMDS    32
+
+typedef struct {
+	struct sockaddr_in addr;
+	int64_t last_seen_us;   // 0 = 空槽
+	bool subscribed;
+	uint8_t decim;
+	uint8_t decim_cnt;
+	bool have_rx_seq;
+	uint32_t rx_seq;        // 最近接受的报文序号
+	uint32_t cmds;
+	uint32_t cmd_lost;
+	uint32_t tx_seq;
+	uint32_t speed_ids[(UDP_MAX_MOTORS + 31) / 32]; // 该客户端置为速度模式的电机（超时归零）
+} udp_client_t;
+
+static int s_sock = -1;
+static TaskHandle_t s_tx_task = NULL;
+static SemaphoreHandle_t s_lock = NULL; // 客户端表与统计
+static StaticSemaphore_t s_lock_buf;
+static udp_client_t s_clients[UDP_CTRL_MAX_CLIENTS];
+static udp_ctrl_stats_t s_stats;
+static volatile uint32_t s_subscribers;
+
+// 遥测总线订阅：发送任务被每帧遥测唤醒，取走自上次发送以来更新过的电机；没有订阅者时停用
+static int s_bus_sub = -1;
+static bool s_bus_on;
+static motor_status_t s_rows[UDP_MAX_MOTORS];
+
+static uint8_t s_tx_buf[UDP_TELEM_HDR + UDP_MAX_MOTORS * UDP_TELEM_LEN];
+
+static void put_le(uint8_t *p, uint64_t v, int n)
+{
+	for (int i = 0; i < n; ++i) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_le(const uint8_t *p, int n)
+{
+	uint64_t v = 0;
+	for (int i = 0; i < n; ++i) v |= (uint64_t)p[i] << (8 * i);
+	return v;
+}
+
+static size_t put_hdr(uint8_t *p, uint8_t type, uint32_t seq)
+{
+	put_le(p, UDP_CTRL_MAGIC, 2);
+	p[2] = UDP_CTRL_VERSION;
+	p[3] = type;
+	put_le(p + 4, seq, 4);
+	return UDP_CTRL_HDR_LEN;
+}
+
+// 订阅者有无变化时启停总线订阅。调用者持有 s_lock
+static void bus_sync_locked(void)
+{
+	bool on = s_subscribers > 0;
+	if (on == s_bus_on) return;
+	s_bus_on = on;
+	telem_bus_enable(s_bus_sub, on);
+}
+
+// 查找（create 时分配）客户端；表满时复用最久未见的槽。调用者持有 s_lock
+static udp_client_t *find_client(const struct sockaddr_in *from, bool create)
+{
+	udp_client_t *slot = NULL;
+	for (int i = 0; i < UDP_CTRL_MAX_CLIENTS; ++i) {
+		udp_client_t *c = &s_clients[i];
+		if (c->last_seen_us && c->addr.sin_addr.s_addr == from->sin_addr.s_addr &&
+			c->addr.sin_port == from->sin_port) {
+			return c;
+		}
+		if (!slot || c->last_seen_us < slot->last_seen_us) slot = c;
+	}
+	if (!create) return NULL;
+	if (slot->last_seen_us) {
+		ESP_LOGW(TAG, "client table full, evicting port %u", ntohs(slot->addr.sin_port));
+		if (slot->subscribed) s_subscribers--;
+	}
+	memset(slot, 0, sizeof(*slot));
+	slot->addr = *from;
+	slot->decim = 1;
+	return slot;
+}
+
+// 命令报文 -> motor_command_t 批量，返回命令数；过期（序号不新于已接受的）命令直接丢弃，
+// 避免 Wi-Fi 重排后旧的设定点覆盖新的
+static size_t handle_cmd(udp_client_t *c, uint32_t seq, const uint8_t *body, int len, motor_command_t *cmds)
+{
+	if (len < 1 || body[0] > UDP_MAX_CMDS || len < 1 + body[0] * UDP_CMD_LEN) {
+		s_stats.rx_bad++;
+		return 0;
+	}
+	if (c->have_rx_seq) {
+		int32_t gap = (int32_t)(seq - c->rx_seq);
+		if (gap <= 0) {
+			s_stats.cmd_stale++;
+			return 0;
+		}
+		c->cmd_lost += gap - 1;
+		s_stats.cmd_lost += gap - 1;
+	}
+	c->have_rx_seq = true;
+	c->rx_seq = seq;
+
+	size_t n = body[0];
+	for (size_t i = 0; i < n; ++i) {
+		const uint8_t *p = body + 1 + i * UDP_CMD_LEN;
+		cmds[i].motor_id = p[0];
+		cmds[i].control_mode = p[1];
+		cmds[i].target_speed = (int16_t)get_le(p + 2, 2);
+		cmds[i].target_position = (int16_t)get_le(p + 4, 2);
+		uint8_t id = p[0];
+		if (id < UDP_MAX_MOTORS) {
+			if (p[1] == 0) c->speed_ids[id / 32] |= 1u << (id % 32);
+			else c->speed_ids[id / 32] &= ~(1u << (id % 32));
+		}
+	}
+	c->cmds++;
+	s_stats.cmds++;
+	return n;
+}
+
+static void handle_packet(const uint8_t *buf, int len, const struct sockaddr_in *from)
+{
+	if (len < UDP_CTRL_HDR_LEN || get_le(buf, 2) != UDP_CTRL_MAGIC || buf[2] != UDP_CTRL_VERSION) {
+		s_stats.rx_bad++;
+		return;
+	}
+	uint8_t type = buf[3];
+	uint32_t seq = (uint32_t)get_le(buf + 4, 4);
+	const uint8_t *body = buf + UDP_CTRL_HDR_LEN;
+	int body_len = len - UDP_CTRL_HDR_LEN;
+
+	motor_command_t cmds[UDP_MAX_CMDS];
+	size_t ncmds = 0;
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	s_stats.rx_packets++;
+	udp_client_t *c = find_client(from, type == UDP_CTRL_TYPE_CMD || type == UDP_CTRL_TYPE_SUB);
+	if (!c) {
+		xSemaphoreGive(s_lock);
+		return;
+	}
+	if (!c->last_seen_us) s_stats.clients++;
+	c->last_seen_us = esp_timer_get_time();
+	if (type == UDP_CTRL_TYPE_CMD) {
+		ncmds = handle_cmd(c, seq, body, body_len, cmds);
+	} else if (type == UDP_CTRL_TYPE_SUB) {
+		if (!c->subscribed) s_subscribers++;
+		c->subscribed = true;
+		c->decim = (body_len >= 1 && body[0] > 0) ? body[0] : 1;
+		uint8_t ack[UDP_CTRL_HDR_LEN + 4];
+		size_t n = put_hdr(ack, UDP_CTRL_TYPE_ACK, seq);
+		put_le(ack + n, UDP_CTRL_CLIENT_TIMEOUT_MS, 2);
+		put_le(ack + n + 2, UDP_MAX_MOTORS, 2);
+		sendto(s_sock, ack, sizeof(ack), 0, (const struct sockaddr *)from, sizeof(*from));
+	} else if (type == UDP_CTRL_TYPE_UNSUB) {
+		if (c->subscribed) s_subscribers--;
+		c->subscribed = false;
+	} else {
+		s_stats.rx_bad++;
+	}
+	bus_sync_locked();
+	xSemaphoreGive(s_lock);
+	if (ncmds) {
+		// 与网页手动控制一致：外部命令接管控制，退出预设
+		if (ui_state_get_mode() != MODE_MANUAL) ui_state_set_mode(MODE_MANUAL);
+		serial_cboard_send(cmds, ncmds);
+	}
+}
+
+static void udp_rx_task(void *arg)
+{
+	(void)arg;
+	uint8_t buf[UDP_CTRL_HDR_LEN + 1 + UDP_MAX_CMDS * UDP_CMD_LEN];
+	while (1) {
+		struct sockaddr_in from;
+		socklen_t fl = sizeof(from);
+		int n = recvfrom(s_sock, buf, sizeof(buf), 0, (struct sockaddr *)&from, &fl);
+		if (n > 0) handle_packet(buf, n, &from);
+	}
+}
+
+// 移除超时客户端；曾下发速度命令的客户端消失时把这些电机的速度置 0
+static void expire_clients(int64_t now)
+{
+	motor_command_t stop[UDP_MAX_CMDS];
+	size_t n = 0;
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	for (int i = 0; i < UDP_CTRL_MAX_CLIENTS; ++i) {
+		udp_client_t *c = &s_clients[i];
+		if (!c->last_seen_us || now - c->last_seen_us < (int64_t)UDP_CTRL_CLIENT_TIMEOUT_MS * 1000) continue;
+		ESP_LOGW(TAG, "client port %u timed out", ntohs(c->addr.sin_port));
+		s_stats.timeouts++;
+#if UDP_CTRL_FAILSAFE
+		for (int id = 1; id < UDP_MAX_MOTORS && n < UDP_MAX_CMDS; ++id) {
+			if (!(c->speed_ids[id / 32] & (1u << (id % 32)))) continue;
+			stop[n++] = (motor_command_t){ .motor_id = (uint8_t)id, .control_mode = 0 };
+		}
+#endif
+		if (c->subscribed) s_subscribers--;
+		memset(c, 0, sizeof(*c));
+	}
+	bus_sync_locked();
+	s_stats.clients = 0;
+	for (int i = 0; i < UDP_CTRL_MAX_CLIENTS; ++i) {
+		if (s_clients[i].last_seen_us) s_stats.clients++;
+	}
+	if (n) s_stats.failsafes++;
+	xSemaphoreGive(s_lock);
+	if (n) {
+		ESP_LOGW(TAG, "failsafe: zero speed on %u motor(s)", (unsigned)n);
+		serial_cboard_send(stop, n);
+	}
+}
+
+// 取走更新过的电机并编码遥测负载，返回电机数
+static size_t build_telemetry(uint8_t *p)
+{
+	size_t n = telem_bus_read(s_bus_sub, s_rows, UDP_MAX_MOTORS);
+	for (size_t i = 0; i < n; ++i) {
+		const motor_status_t *st = &s_rows[i];
+		p[0] = st->motor_id;
+		p[1] = st->temperature;
+		put_le(p + 2, st->angle, 2);
+		put_le(p + 4, (uint16_t)st->speed, 2);
+		put_le(p + 6, (uint16_t)st->current, 2);
+		p += UDP_TELEM_LEN;
+	}
+	return n;
+}
+
+static void udp_tx_task(void *arg)
+{
+	(void)arg;
+	int64_t last_expire = 0;
+	while (1) {
+		// 新遥测到达即发送；无遥测时也定期醒来检查客户端超时
+		ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+		int64_t now = esp_timer_get_time();
+		if (now - last_expire >= 100 * 1000) {
+			last_expire = now;
+			expire_clients(now);
+		}
+		size_t n = build_telemetry(s_tx_buf + UDP_TELEM_HDR);
+		if (n == 0) continue;
+		size_t len = UDP_TELEM_HDR + n * UDP_TELEM_LEN;
+		uint8_t *b = s_tx_buf + UDP_CTRL_HDR_LEN;
+		put_le(b, (uint64_t)time_sync_now_us(), 8);
+		b[16] = (uint8_t)n;
+
+		xSemaphoreTake(s_lock, portMAX_DELAY);
+		for (int i = 0; i < UDP_CTRL_MAX_CLIENTS; ++i) {
+			udp_client_t *c = &s_clients[i];
+			if (!c->last_seen_us || !c->subscribed) continue;
+			if (++c->decim_cnt < c->decim) continue;
+			c->decim_cnt = 0;
+			// 头部与每客户端字段就地改写，负载共享
+			put_hdr(s_tx_buf, UDP_CTRL_TYPE_TELEM, ++c->tx_seq);
+			put_le(b + 8, c->rx_seq, 4);
+			put_le(b + 12, c->cmd_lost, 4);
+			if (sendto(s_sock, s_tx_buf, len, 0, (const struct sockaddr *)&c->addr, sizeof(c->addr)) < 0) {
+				s_stats.tx_errors++;
+			} else {
+				s_stats.tx_frames++;
+			}
+		}
+		xSemaphoreGive(s_lock);
+	}
+}
+
+void udp_ctrl_init(void)
+{
+	if (s_sock >= 0) return;
+	s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0) {
+		ESP_LOGE(TAG, "socket failed");
+		return;
+	}
+	struct sockaddr_in local = {
+		.sin_family = AF_INET,
+		.sin_port = htons(UDP_CTRL_PORT),
+		.sin_addr.s_addr = htonl(INADDR_ANY),
+	};
+	if (bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+		ESP_LOGE(TAG, "bind %d failed", UDP_CTRL_PORT);
+		close(sock);
+		return;
+	}
+	s_sock = sock;
+	mem_budget_add("udp_ctrl", "telemetry buffers", sizeof(s_rows) + sizeof(s_tx_buf) + sizeof(s_clients));
+	task_topology_create(TASK_ID_UDP_TX, udp_tx_task, NULL, &s_tx_task, NULL);
+	const telem_bus_sub_cfg_t sub = {
+		.name = "udp",
+		.task = s_tx_task,
+		.sched_job = -1,
+		.enabled = false,
+	};
+	s_bus_sub = telem_bus_subscribe(&sub);
+	task_topology_create(TASK_ID_UDP_RX, udp_rx_task, NULL, NULL, NULL);
+	ESP_LOGI(TAG, "listening on udp/%d", UDP_CTRL_PORT);
+}
+
+void udp_ctrl_get_stats(udp_ctrl_stats_t *out)
+{
+	if (!out) return;
+	if (!s_lock) {
+		memset(out, 0, sizeof(*out));
+		return;
+	}
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	*out = s_stats;
+	out->subscribers = s_subscribers;
+	xSemaphoreGive(s_lock);
+}
+
+bool udp_ctrl_get_client(int idx, udp_ctrl_client_info_t *out)
+{
+	if (!s_lock || idx < 0 || idx >= UDP_CTRL_MAX_CLIENTS || !out) return false;
+	xSemaphoreTake(s_lock, portMAX_DELAY);
+	const udp_client_t *c = &s_clients[idx];
+	bool used = c->last_seen_us != 0;
+	if (used) {
+		*out = (udp_ctrl_client_info_t){
+			.ip = c->addr.sin_addr.s_addr,
+			.port = ntohs(c->addr.sin_port),
+			.subscribed = c->subscribed,
+			.decim = c->decim,
+			.idle_ms = (uint32_t)((esp_timer_get_time() - c->last_seen_us) / 1000),
+			.cmds = c->cmds,
+			.cmd_lost = c->cmd_lost,
+			.tx_seq = c->tx_seq,
+		};
+	}
+	xSemaphoreGive(s_lock);
+	return used;
+}
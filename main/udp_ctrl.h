@@ -0,0 +1,65 @@
+#ifndef UDP_CTRL_H
+#define UDP_CTRL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "serial_cboard.h"
+
+// 上位机 UDP 二进制通道：与 HTTP 接口并存，免去每个设定点的 TCP 握手与 HTTP 解析。
+// 命令报文直接映射为一批 motor_command_t；订阅的客户端在每个遥测帧到达后收到遥测报文。
+//
+// 报文（小端）：[u16 magic 0x5544][u8 ver=1][u8 type][u32 seq][body]
+//   CMD   (PC->设备)  body: u8 n, n * { u8 id, u8 mode, i16 speed, i16 pos }
+//   SUB   (PC->设备)  body: [u8 decim]（每 decim 个遥测帧发送一次，缺省 1）
+//   UNSUB (PC->设备)  无 body
+//   ACK   (设备->PC)  应答 SUB，body: u16 client_timeout_ms, u16 max_motors
+//   TELEM (设备->PC)  body: i64 t_us（同步时间）, u32 ack_seq（最近接受的命令序号）,
+//                         u32 cmd_lost（该客户端丢失的命令数）, u8 n,
+//                         n * { u8 id, u8 temp, u16 angle, i16 speed, i16 current }
+// seq：CMD 的 seq 由 PC 逐条递增（设备据此统计丢包、丢弃乱序/过期命令，TELEM 回显最近接受的值，
+// PC 可据此测量往返时间）；SUB 的 seq 原样回显在 ACK 中；TELEM 的 seq 按客户端递增，PC 据此统计遥测丢包。
+// 客户端在 UDP_CTRL_CLIENT_TIMEOUT_MS 内没有任何报文即被移除（SUB 可用作心跳），
+// 曾下发速度命令的客户端超时后，对应电机速度被置 0（UDP_CTRL_FAILSAFE）。
+
+#define UDP_CTRL_MAGIC      0x5544
+#define UDP_CTRL_VERSION    1
+#define UDP_CTRL_HDR_LEN    8
+#define UDP_CTRL_TYPE_CMD   1
+#define UDP_CTRL_TYPE_SUB   2
+#define UDP_CTRL_TYPE_UNSUB 3
+#define UDP_CTRL_TYPE_ACK   0x81
+#define UDP_CTRL_TYPE_TELEM 0x82
+
+typedef struct {
+	uint32_t clients;      // 当前客户端数
+	uint32_t subscribers;  // 其中订阅遥测的
+	uint32_t rx_packets;
+	uint32_t rx_bad;       // 格式错误/版本不符
+	uint32_t cmds;         // 已执行的命令报文
+	uint32_t cmd_lost;     // 按序号推算的丢失命令报文
+	uint32_t cmd_stale;    // 乱序/重复而被丢弃的命令报文
+	uint32_t tx_frames;    // 发出的遥测报文
+	uint32_t tx_errors;
+	uint32_t timeouts;     // 超时移除的客户端
+	uint32_t failsafes;    // 超时触发的速度归零
+} udp_ctrl_stats_t;
+
+typedef struct {
+	uint32_t ip;           // 网络字节序
+	uint16_t port;
+	bool subscribed;
+	uint8_t decim;
+	uint32_t idle_ms;
+	uint32_t cmds;
+	uint32_t cmd_lost;
+	uint32_t tx_seq;
+} udp_ctrl_client_info_t;
+
+// 创建 socket 与收发任务（需在 Wi-Fi/网络栈初始化之后调用）
+void udp_ctrl_init(void);
+
+void udp_ctrl_get_stats(udp_ctrl_stats_t *out);
+bool udp_ctrl_get_client(int idx, udp_ctrl_client_info_t *out);
+
+#endif // UDP_CTRL_H
@@ -1,10 +1,13 @@
 #include "ui_state.h"
 #include "config.h"
 #include "esp_log.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
 #include "driver/gpio.h"
+#include "hal/gpio_ll.h"
+#include "esp_attr.h"
+#include "esp_intr_alloc.h"
 #include "esp_timer.h"
+#include "sched.h"
+#include "serial_cboard.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -13,6 +16,7 @@ static const char *TAG = "ui_state";
 static control_mode_t s_current_mode = MODE_MANUAL;
 static control_mode_t s_last_non_manual = MODE_PRESET1;
 static ui_mode_change_cb_t s_mode_cb = NULL;
+static volatile ui_page_t s_page = UI_PAGE_NUMBERS;
 
 // 内部：调用回调并打印
 static void notify_mode_change(control_mode_t m)
@@ -50,6 +54,17 @@ void ui_state_button_event_ok(void)
 	}
 }
 
+void ui_state_button_event_page(void)
+{
+	s_page = (ui_page_t)((s_page + 1) % UI_PAGE_COUNT);
+	ESP_LOGI(TAG, "Display page -> %d", (int)s_page);
+}
+
+ui_page_t ui_state_get_page(void)
+{
+	return s_page;
+}
+
 control_mode_t ui_state_get_mode(void)
 {
 	return s_current_mode;
@@ -67,40 +82,83 @@ void ui_state_register_mode_change_cb(ui_mode_change_cb_t cb)
 	s_mode_cb = cb;
 }
 
-// 按键轮询任务实现（在非测试模式下读取GPIO，测试模式由CLI模拟）
-static void ui_state_task(void *arg)
+// 按键轮询作业（调度器 CTRL 执行任务，周期 BUTTON_POLL_INTERVAL_MS；测试模式由 CLI 模拟）：简单轮询去抖
+typedef struct {int gpio; int active_level; int last_level; int stable_level; int64_t last_change_ms;} btn_t;
+static btn_t s_buttons[3] = {
+	{ BUTTON_UP_GPIO, BUTTON_ACTIVE_LEVEL, 1, 1, 0},
+	{ BUTTON_DOWN_GPIO, BUTTON_ACTIVE_LEVEL, 1, 1, 0},
+	{ BUTTON_OK_GPIO, BUTTON_ACTIVE_LEVEL, 1, 1, 0}
+};
+
+// OK 键：短按在松开时生效，按住超过 UI_LONG_PRESS_MS 即切换页面（松开后不再触发短按）
+static bool s_ok_pending = false;
+static int64_t s_ok_down_ms = 0;
+
+static int64_t ui_state_poll_job(void *arg, int64_t deadline_us)
 {
-	// 在此处做简单轮询去抖
-	typedef struct {int gpio; int active_level; int last_level; int stable_level; int64_t last_change_ms;} btn_t;
-	btn_t buttons[3] = {
-		{ BUTTON_UP_GPIO, BUTTON_ACTIVE_LEVEL, 1, 1, 0},
-		{ BUTTON_DOWN_GPIO, BUTTON_ACTIVE_LEVEL, 1, 1, 0},
-		{ BUTTON_OK_GPIO, BUTTON_ACTIVE_LEVEL, 1, 1, 0}
-	};
-
-	while (1) {
-		for (int i = 0; i < 3; ++i) {
-			int level = gpio_get_level(buttons[i].gpio);
-			int64_t now = esp_timer_get_time() / 1000; // ms
-			if (level != buttons[i].last_level) {
-				buttons[i].last_change_ms = now;
-				buttons[i].last_level = level;
-			} else {
-				if (now - buttons[i].last_change_ms >= BUTTON_DEBOUNCE_MS) {
-					if (buttons[i].stable_level != level) {
-						buttons[i].stable_level = level;
-						// active edge
-						if (level == buttons[i].active_level) {
-							if (i == 0) ui_state_button_event_up();
-							else if (i == 1) ui_state_button_event_down();
-							else if (i == 2) ui_state_button_event_ok();
+	(void)arg;
+	(void)deadline_us;
+	btn_t *buttons = s_buttons;
+	for (int i = 0; i < 3; ++i) {
+		int level = gpio_get_level(buttons[i].gpio);
+		int64_t now = esp_timer_get_time() / 1000; // ms
+		if (level != buttons[i].last_level) {
+			buttons[i].last_change_ms = now;
+			buttons[i].last_level = level;
+		} else {
+			if (now - buttons[i].last_change_ms >= BUTTON_DEBOUNCE_MS) {
+				if (buttons[i].stable_level != level) {
+					buttons[i].stable_level = level;
+					// active edge
+					if (level == buttons[i].active_level) {
+						if (i == 0) ui_state_button_event_up();
+						else if (i == 1) ui_state_button_event_down();
+						else if (i == 2) {
+							s_ok_pending = true;
+							s_ok_down_ms = now;
 						}
+					} else if (i == 2 && s_ok_pending) {
+						s_ok_pending = false;
+						ui_state_button_event_ok();
 					}
 				}
 			}
 		}
-		vTaskDelay(pdMS_TO_TICKS(BUTTON_POLL_INTERVAL_MS));
+		if (i == 2 && s_ok_pending && now - s_ok_down_ms >= UI_LONG_PRESS_MS) {
+			s_ok_pending = false;
+			ui_state_button_event_page();
+		}
 	}
+	return SCHED_NEXT_PERIOD;
+}
+
+#if ESTOP_GPIO >= 0
+// 急停按键中断：任一边沿进入，有效电平且此前已稳定 BUTTON_DEBOUNCE_MS 才触发。
+// 按下的第一个边沿即触发（不等去抖），按下与松开时的抖动都落在窗口内而被忽略。
+// 以 ESP_INTR_FLAG_IRAM 注册，flash 擦写（记录仪、抓包、OTA）期间也立即响应：
+// 整条路径（本函数、serial_cboard_estop_from_isr 及其加锁更新）都在 IRAM，数据在 DRAM，
+// 电平直接读寄存器（gpio_get_level 在 flash 中），不调用 esp_log
+static DRAM_ATTR int64_t s_estop_edge_us;
+
+static void IRAM_ATTR estop_isr(void *arg)
+{
+	(void)arg;
+	int64_t now = esp_timer_get_time();
+	bool quiet = now - s_estop_edge_us >= (int64_t)BUTTON_DEBOUNCE_MS * 1000;
+	s_estop_edge_us = now;
+	if (quiet && gpio_ll_get_level(&GPIO, ESTOP_GPIO) == ESTOP_ACTIVE_LEVEL) {
+		serial_cboard_estop_from_isr(ESTOP_SRC_BUTTON);
+	}
+}
+#endif
+
+bool ui_state_estop_held(void)
+{
+#if ESTOP_GPIO >= 0
+	return gpio_get_level(ESTOP_GPIO) == ESTOP_ACTIVE_LEVEL;
+#else
+	return false;
+#endif
 }
 
 void ui_state_init(void)
@@ -112,5 +170,19 @@ void ui_state_init(void)
 	io_conf.pull_up_en = 1;
 	io_conf.pull_down_en = 0;
 	gpio_config(&io_conf);
-	xTaskCreate(ui_state_task, "ui_state_task", 2048, NULL, 7, NULL);
+	sched_add("buttons", SCHED_EXEC_CTRL, BUTTON_POLL_INTERVAL_MS * 1000, 0, ui_state_poll_job, NULL);
+
+#if ESTOP_GPIO >= 0
+	gpio_config_t es_conf = {};
+	es_conf.intr_type = GPIO_INTR_ANYEDGE;
+	es_conf.mode = GPIO_MODE_INPUT;
+	es_conf.pin_bit_mask = 1ULL << ESTOP_GPIO;
+	es_conf.pull_up_en = ESTOP_ACTIVE_LEVEL == 0;
+	es_conf.pull_down_en = ESTOP_ACTIVE_LEVEL != 0;
+	gpio_config(&es_conf);
+	gpio_install_isr_service(ESP_INTR_FLAG_IRAM); // 该服务上的所有处理函数都须在 IRAM
+	gpio_isr_handler_add(ESTOP_GPIO, estop_isr, NULL);
+	// 上电时按键已按下：直接进入急停
+	if (ui_state_estop_held()) serial_cboard_estop(ESTOP_SRC_BUTTON);
+#endif
 }
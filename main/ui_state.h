@@ -2,6 +2,7 @@
 #define UI_STATE_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 // 模式状态机模块头文件
 
@@ -12,6 +13,14 @@ typedef enum {
 	MODE_COUNT // keep last
 } control_mode_t;
 
+// 串口屏页面：长按 OK 键切换到下一页（短按 OK 仍为手动/预设切换）
+typedef enum {
+	UI_PAGE_NUMBERS = 0, // 两路电机数值
+	UI_PAGE_TREND_M1,    // 电机 1 速度/电流趋势
+	UI_PAGE_TREND_M2,    // 电机 2 速度/电流趋势
+	UI_PAGE_COUNT
+} ui_page_t;
+
 // 回调类型：当模式切换（最终生效）时会被调用
 typedef void (*ui_mode_change_cb_t)(control_mode_t new_mode);
 
@@ -27,6 +36,13 @@ void ui_state_button_event_up(void);
 void ui_state_button_event_down(void);
 void ui_state_button_event_ok(void);
 
+// 长按 OK：切换到下一个显示页面
+void ui_state_button_event_page(void);
+ui_page_t ui_state_get_page(void);
+
+// 急停按键是否仍处于按下状态（解除急停前检查；未接急停按键时恒为 false）
+bool ui_state_estop_held(void);
+
 // 注册模式变更回调
 void ui_state_register_mode_change_cb(ui_mode_change_cb_t cb);
 
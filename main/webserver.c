@@ -3,11 +3,24 @@
 #include "serial_cboard.h"
 #include "ui_state.h"
 #include "display_uart.h"
+#include "uart_capture.h"
+#include "flight_recorder.h"
+#include "task_topology.h"
+#include "mem_budget.h"
+#include "rate_gov.h"
+#include "bench.h"
+#include "boot_prof.h"
+#include "sched.h"
+#include "telem_bus.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "esp_log.h"
@@ -30,6 +43,9 @@ static httpd_handle_t server = NULL;
 static int16_t s_rotation_value = 0;
 static int16_t s_position_value = 0;
 static SemaphoreHandle_t s_slider_lock = NULL;
+static StaticSemaphore_t s_slider_lock_buf;
+// 同一对值打包（rotation << 16 | position），/api/status 缓存无锁比较用
+static volatile uint32_t s_slider_packed = 0;
 
 // 更新滑块值（线程安全）
 void webserver_update_slider_values(int16_t rotation_speed, int16_t position)
@@ -37,6 +53,7 @@ void webserver_update_slider_values(int16_t rotation_speed, int16_t position)
 	if (s_slider_lock) xSemaphoreTake(s_slider_lock, portMAX_DELAY);
 	s_rotation_value = rotation_speed;
 	s_position_value = position;
+	s_slider_packed = (uint32_t)(uint16_t)rotation_speed << 16 | (uint16_t)position;
 	if (s_slider_lock) xSemaphoreGive(s_slider_lock);
 }
 
@@ -65,6 +82,8 @@ static const char html_page[] =
 "        .btn{flex:1;min-width:0;padding:12px 10px;font-size:16px;border:none;border-radius:5px;cursor:pointer;background:#4CAF50;color:white;transition:background 0.3s;text-align:center;}\n"
 "        .btn:hover{background:#45a049;}\n"
 "        .btn:active{background:#357a38;}\n"
+"        .estop{background:#d32f2f;font-size:20px;font-weight:bold;}\n"
+"        .estop:hover{background:#b71c1c;}\n"
 "        .mode-indicator{text-align:center;padding:10px;background:#555;border-radius:5px;font-size:18px;margin-bottom:20px;}\n"
 "        .display-preview{background:#000;color:#0f0;padding:15px;border-radius:5px;font-family:monospace;font-size:14px;line-height:1.4;white-space:pre;height:120px;overflow:auto;box-sizing:border-box;}\n"
 "    </style>\n"
@@ -109,6 +128,14 @@ static const char html_page[] =
 "        </div>\n"
 "\n"
 "        <div class='section'>\n"
+"            <div class='buttons'>\n"
+"                <button class='btn estop' onclick='estop()'>⛔ E-STOP</button>\n"
+"                <button class='btn' onclick='estopRelease()'>Release</button>\n"
+"            </div>\n"
+"            <div id='estop_state'></div>\n"
+"        </div>\n"
+"\n"
+"        <div class='section'>\n"
 "            <h2>🎮 Manual Control</h2>\n"
 "            <div class='control'>\n"
 "                <label>Rotation Speed: <span id='rot_val'>0</span> rpm</label>\n"
@@ -148,6 +175,7 @@ static const char html_page[] =
 "        let rotVal = document.getElementById('rot_val');\n"
 "        let posVal = document.getElementById('pos_val');\n"
 "        let userInteracting = false;\n"
+"        let pollMs = 200; // 由设备在 status 中下发（速率调节器）\n"
 "\n"
 "        rotSlider.oninput = function(){\n"
 "            rotVal.textContent = this.value;\n"
@@ -167,6 +195,19 @@ static const char html_page[] =
 "            .then(d => console.log('Button press:', d));\n"
 "        }\n"
 "\n"
+"        function showEstop(d){\n"
+"            document.getElementById('estop_state').textContent = d.error ? d.error :\n"
+"                (d.latched ? 'E-STOP latched (' + d.last_us + ' us to boards)' : 'E-STOP released');\n"
+"        }\n"
+"\n"
+"        function estop(){\n"
+"            fetch('/api/estop').then(r => r.json()).then(showEstop);\n"
+"        }\n"
+"\n"
+"        function estopRelease(){\n"
+"            fetch('/api/estop?release=1').then(r => r.json()).then(showEstop);\n"
+"        }\n"
+"\n"
 "        function updateStatus(){\n"
 "            fetch('/api/status')\n"
 "            .then(r => r.json())\n"
@@ -194,74 +235,508 @@ static const char html_page[] =
 "                    posSlider.value = d.slider_position;\n"
 "                    posVal.textContent = d.slider_position;\n"
 "                }\n"
+"                if (d.poll_ms) pollMs = d.poll_ms;\n"
 "            })\n"
 "            .catch(err => {\n"
 "                document.getElementById('mode').textContent = 'Error';\n"
-"            });\n"
+"            })\n"
+"            .finally(() => setTimeout(updateStatus, pollMs));\n"
 "            // 重置交互标志\n"
 "            setTimeout(() => { userInteracting = false; }, 500);\n"
 "        }\n"
 "\n"
-"        setInterval(updateStatus, 200);\n"
 "        updateStatus();\n"
 "    </script>\n"
 "</body>\n"
 "</html>\n";
 
+// ---- 异步请求处理 ----
+// 可能长时间占用连接的处理函数（大页面、文件上传/下载）通过 httpd_req_async_handler_begin
+// 交给小型 worker 池执行，服务器任务立即返回继续处理其它连接，慢客户端不再阻塞所有请求。
+// worker 全忙时请求排队（最多 HTTPD_ASYNC_QUEUE 个），队列也满则回 503 + Retry-After；
+// 异步类处理函数从不在服务器任务中运行，状态、滑块与急停接口不会排在慢请求之后。
+// 注册时 .handler = async_dispatch_handler，.user_ctx 为实际处理函数。
+
+typedef esp_err_t (*http_handler_fn_t)(httpd_req_t *req);
+
+typedef struct {
+	httpd_req_t *req;
+	http_handler_fn_t handler;
+} http_async_job_t;
+
+static QueueHandle_t s_async_q = NULL;
+#define HTTP_ASYNC_SLOTS (HTTPD_ASYNC_WORKERS + HTTPD_ASYNC_QUEUE)
+static SemaphoreHandle_t s_async_slots = NULL; // 计数信号量：空闲的槽位（运行中 + 排队中 <= 槽位数）
+static StaticQueue_t s_async_q_buf;
+static uint8_t s_async_q_storage[HTTP_ASYNC_SLOTS * sizeof(http_async_job_t)];
+static StaticSemaphore_t s_async_slots_buf;
+static TaskHandle_t s_async_workers[HTTPD_ASYNC_WORKERS];
+
+// HTTP 统计（/api/http/stats）
+static http_stats_t s_http_stats;
+
+// 服务时间直方图：第 i 桶统计 [2^i, 2^(i+1)) 微秒
+static void lat_hist_add(uint32_t *hist, uint32_t us)
+{
+	int b = 0;
+	while (us > 1 && b < HTTP_LAT_BUCKETS - 1) {
+		us >>= 1;
+		b++;
+	}
+	hist[b]++;
+}
+
+// 由直方图估算百分位（返回所在桶上界，单位微秒）
+static uint32_t lat_hist_percentile(const uint32_t *hist, uint32_t permille)
+{
+	uint32_t total = 0;
+	for (int i = 0; i < HTTP_LAT_BUCKETS; ++i) total += hist[i];
+	if (total == 0) return 0;
+	uint32_t target = (uint32_t)(((uint64_t)total * permille + 999) / 1000);
+	uint32_t acc = 0;
+	for (int i = 0; i < HTTP_LAT_BUCKETS; ++i) {
+		acc += hist[i];
+		if (acc >= target) return 1u << (i + 1);
+	}
+	return 1u << HTTP_LAT_BUCKETS;
+}
+
+// 直方图输出为 JSON 数组，返回写入长度（缓冲区须能容纳 HTTP_LAT_BUCKETS 个 10 位数）
+static int hist_json(char *buf, size_t size, const uint32_t *hist)
+{
+	int n = snprintf(buf, size, "[");
+	for (int i = 0; i < HTTP_LAT_BUCKETS; ++i) {
+		n += snprintf(buf + n, size - n, "%s%lu", i ? "," : "", (unsigned long)hist[i]);
+	}
+	n += snprintf(buf + n, size - n, "]");
+	return n;
+}
+
+static void http_async_worker(void *arg)
+{
+	(void)arg;
+	http_async_job_t job;
+	while (1) {
+		if (xQueueReceive(s_async_q, &job, portMAX_DELAY) != pdTRUE) continue;
+		job.handler(job.req);
+		httpd_req_async_handler_complete(job.req);
+		xSemaphoreGive(s_async_slots);
+	}
+}
+
+static void http_async_init(void)
+{
+	if (s_async_q) return;
+	s_async_q = xQueueCreateStatic(HTTP_ASYNC_SLOTS, sizeof(http_async_job_t), s_async_q_storage, &s_async_q_buf);
+	s_async_slots = xSemaphoreCreateCountingStatic(HTTP_ASYNC_SLOTS, HTTP_ASYNC_SLOTS, &s_async_slots_buf);
+	for (int i = 0; i < HTTPD_ASYNC_WORKERS; ++i) {
+		char name[16];
+		snprintf(name, sizeof(name), "httpd_async%d", i);
+		task_topology_create(TASK_ID_HTTPD_ASYNC, http_async_worker, NULL, &s_async_workers[i], name);
+	}
+}
+
+// 分发到 worker（全忙时排队）；槽位用尽或异步化失败时回 503，客户端稍后重试
+static esp_err_t async_dispatch_handler(httpd_req_t *req)
+{
+	http_handler_fn_t handler = (http_handler_fn_t)req->user_ctx;
+	if (xSemaphoreTake(s_async_slots, 0) == pdTRUE) {
+		httpd_req_t *copy = NULL;
+		if (httpd_req_async_handler_begin(req, &copy) == ESP_OK) {
+			http_async_job_t job = { .req = copy, .handler = handler };
+			xQueueSend(s_async_q, &job, portMAX_DELAY); // 队列深度 = 槽位数，必有空位
+			s_http_stats.async_dispatched++;
+			return ESP_OK;
+		}
+		xSemaphoreGive(s_async_slots);
+	}
+	s_http_stats.async_rejected++;
+	httpd_resp_set_status(req, "503 Service Unavailable");
+	httpd_resp_set_hdr(req, "Retry-After", "1");
+	httpd_resp_send(req, "busy", HTTPD_RESP_USE_STRLEN);
+	return ESP_OK;
+}
+
+void webserver_get_http_stats(http_stats_t *out)
+{
+	if (!out) return;
+	*out = s_http_stats;
+	out->status_p50_us = lat_hist_percentile(s_http_stats.status_hist, 500);
+	out->status_p99_us = lat_hist_percentile(s_http_stats.status_hist, 990);
+	out->status_p999_us = lat_hist_percentile(s_http_stats.status_hist, 999);
+}
+
+void webserver_reset_http_stats(void)
+{
+	memset(&s_http_stats, 0, sizeof(s_http_stats));
+}
+
+// 控制类接口：记录服务时间与命令时延（cmd_us 为 0 表示请求未产生命令，如参数无效）
+static void ctl_stats_add(http_ctl_t ep, int64_t t_start, int64_t t_cmd)
+{
+	http_ctl_stats_t *st = &s_http_stats.ctl[ep];
+	uint32_t us = (uint32_t)(esp_timer_get_time() - t_start);
+	lat_hist_add(st->hist, us);
+	if (us > st->max_us) st->max_us = us;
+	if (t_cmd) {
+		uint32_t cmd_us = (uint32_t)(t_cmd - t_start);
+		lat_hist_add(st->cmd_hist, cmd_us);
+		if (cmd_us > st->cmd_max_us) st->cmd_max_us = cmd_us;
+	}
+	st->requests++;
+}
+
+// HTTP 处理函数：/api/http/stats[?reset=1] - 异步分发、/api/status 与控制类接口的服务时间统计。
+// 百分位为直方图桶上界；同时给出原始直方图，负载测试工具据此自行计算。reset=1 在返回后清零
+static esp_err_t http_stats_handler(httpd_req_t *req)
+{
+	static const char *const ctl_names[HTTP_CTL_COUNT] = {
+		[HTTP_CTL_ROTATION] = "rotation",
+		[HTTP_CTL_POSITION] = "position",
+		[HTTP_CTL_BUTTON]   = "button",
+		[HTTP_CTL_ESTOP]    = "estop",
+	};
+	char query[32] = "", val[4] = "";
+	size_t qlen = httpd_req_get_url_query_len(req) + 1;
+	bool reset = qlen > 1 && qlen <= sizeof(query) && httpd_req_get_url_query_str(req, query, qlen) == ESP_OK &&
+				 httpd_query_key_value(query, "reset", val, sizeof(val)) == ESP_OK && atoi(val) != 0;
+
+	http_stats_t st;
+	webserver_get_http_stats(&st);
+	if (reset) webserver_reset_http_stats();
+	char buf[768]; // 每段最长约 720 字节（两个直方图均为 10 位数时）
+	int n = snprintf(buf, sizeof(buf),
+		"{\"async_dispatched\":%lu,\"async_rejected\":%lu,\"status_requests\":%lu,"
+		"\"status_p50_us\":%lu,\"status_p99_us\":%lu,\"status_p999_us\":%lu,\"status_max_us\":%lu,"
+		"\"status_cache_hits\":%lu,\"status_rebuilds\":%lu,\"status_not_modified\":%lu,\"status_hist\":",
+		(unsigned long)st.async_dispatched, (unsigned long)st.async_rejected,
+		(unsigned long)st.status_requests, (unsigned long)st.status_p50_us,
+		(unsigned long)st.status_p99_us, (unsigned long)st.status_p999_us, (unsigned long)st.status_max_us,
+		(unsigned long)st.status_cache_hits, (unsigned long)st.status_rebuilds,
+		(unsigned long)st.status_not_modified);
+	n += hist_json(buf + n, sizeof(buf) - n, st.status_hist);
+	httpd_resp_set_type(req, "application/json");
+	httpd_resp_send_chunk(req, buf, n);
+	for (int i = 0; i < HTTP_CTL_COUNT; ++i) {
+		const http_ctl_stats_t *c = &st.ctl[i];
+		n = snprintf(buf, sizeof(buf),
+			"%s\"%s\":{\"requests\":%lu,\"p50_us\":%lu,\"p99_us\":%lu,\"p999_us\":%lu,\"max_us\":%lu,"
+			"\"cmd_p50_us\":%lu,\"cmd_p99_us\":%lu,\"cmd_p999_us\":%lu,\"cmd_max_us\":%lu,\"hist\":",
+			i ? "," : ",\"control\":{", ctl_names[i], (unsigned long)c->requests,
+			(unsigned long)lat_hist_percentile(c->hist, 500), (unsigned long)lat_hist_percentile(c->hist, 990),
+			(unsigned long)lat_hist_percentile(c->hist, 999), (unsigned long)c->max_us,
+			(unsigned long)lat_hist_percentile(c->cmd_hist, 500), (unsigned long)lat_hist_percentile(c->cmd_hist, 990),
+			(unsigned long)lat_hist_percentile(c->cmd_hist, 999), (unsigned long)c->cmd_max_us);
+		n += hist_json(buf + n, sizeof(buf) - n, c->hist);
+		n += snprintf(buf + n, sizeof(buf) - n, ",\"cmd_hist\":");
+		n += hist_json(buf + n, sizeof(buf) - n, c->cmd_hist);
+		n += snprintf(buf + n, sizeof(buf) - n, "}");
+		httpd_resp_send_chunk(req, buf, n);
+	}
+	httpd_resp_send_chunk(req, "}}", 2);
+	httpd_resp_send_chunk(req, NULL, 0);
+	return ESP_OK;
+}
+
+// HTTP 处理函数：/api/rates[?name=<consumer>&period_ms=<ms|0>] - 速率调节器状态，可选手动覆盖（0 恢复自动）
+static esp_err_t rates_handler(httpd_req_t *req)
+{
+	char query[64] = "";
+	char name[16] = "", val[12] = "";
+	bool ok = true;
+	size_t qlen = httpd_req_get_url_query_len(req) + 1;
+	if (qlen > 1 && qlen <= sizeof(query) && httpd_req_get_url_query_str(req, query, qlen) == ESP_OK &&
+		httpd_query_key_value(query, "name", name, sizeof(name)) == ESP_OK &&
+		httpd_query_key_value(query, "period_ms", val, sizeof(val)) == ESP_OK) {
+		ok = rate_gov_override(name, strtoul(val, NULL, 10));
+	}
+	rate_gov_signals_t sig;
+	rate_gov_get_signals(&sig);
+	char buf[512];
+	int n = snprintf(buf, sizeof(buf),
+		"{\"ok\":%s,\"web_viewers\":%lu,\"udp_subscribers\":%lu,\"active\":%s,"
+		"\"idle_pct\":[%u,%u],\"throttle_pct\":%lu,\"consumers\":[",
+		ok ? "true" : "false", (unsigned long)sig.web_viewers, (unsigned long)sig.udp_subscribers,
+		sig.active ? "true" : "false", sig.idle_pct[0], sig.idle_pct[1], (unsigned long)sig.throttle_pct);
+	for (int i = 0; i < RATE_GOV_COUNT && n < (int)sizeof(buf); ++i) {
+		rate_gov_entry_t e;
+		rate_gov_get((rate_gov_id_t)i, &e);
+		n += snprintf(buf + n, sizeof(buf) - n,
+			"%s{\"name\":\"%s\",\"current_ms\":%lu,\"target_ms\":%lu,\"override_ms\":%lu,"
+			"\"min_ms\":%lu,\"max_ms\":%lu}",
+			i ? "," : "", e.name, (unsigned long)e.current_ms, (unsigned long)e.target_ms,
+			(unsigned long)e.override_ms, (unsigned long)e.min_ms, (unsigned long)e.max_ms);
+	}
+	if (n < (int)sizeof(buf)) n += snprintf(buf + n, sizeof(buf) - n, "]}");
+	if (n >= (int)sizeof(buf)) n = sizeof(buf) - 1;
+	httpd_resp_set_type(req, "application/json");
+	httpd_resp_send(req, buf, n);
+	return ESP_OK;
+}
+
+// HTTP 处理函数：/api/bench?name=<parser|tx|json|display>&n=<iters> - 设备自测基准（异步 worker 中运行）
+static esp_err_t bench_handler(httpd_req_t *req)
+{
+	char q[64] = "", name[16] = "", val[12];
+	uint32_t iters = 0;
+	size_t qlen = httpd_req_get_url_query_len(req) + 1;
+	if (qlen > 1 && qlen <= sizeof(q) && httpd_req_get_url_query_str(req, q, qlen) == ESP_OK) {
+		httpd_query_key_value(q, "name", name, sizeof(name));
+		if (httpd_query_key_value(q, "n", val, sizeof(val)) == ESP_OK) iters = (uint32_t)atoi(val);
+	}
+	bench_result_t r;
+	esp_err_t err = bench_run(name, iters, &r);
+	char buf[320];
+	int n;
+	if (err != ESP_OK) {
+		n = snprintf(buf, sizeof(buf), "{\"ok\":false,\"error\":\"%s\"}", esp_err_to_name(err));
+	} else {
+		n = snprintf(buf, sizeof(buf),
+			"{\"ok\":true,\"name\":\"%s\",\"iters\":%lu,\"cycles_avg\":%lu,\"cycles_min\":%lu,"
+			"\"cycles_max\":%lu,\"us_total\":%lu,\"bytes_per_op\":%lu,\"heap_delta\":%ld,"
+			"\"stack_used\":%lu,\"stack_size\":%lu}",
+			r.name, (unsigned long)r.iters, (unsigned long)r.cycles_avg, (unsigned long)r.cycles_min,
+			(unsigned long)r.cycles_max, (unsigned long)r.us_total, (unsigned long)r.bytes_per_op,
+			(long)r.heap_delta, (unsigned long)r.stack_used, (unsigned long)r.stack_size);
+	}
+	httpd_resp_set_type(req, "application/json");
+	httpd_resp_send(req, buf, n);
+	return ESP_OK;
+}
+
+// HTTP 处理函数：/api/linktest?ms=<window> - C 板链路有效字节率与错误率（异步 worker 中运行）
+static esp_err_t linktest_handler(httpd_req_t *req)
+{
+	char q[32] = "", val[12];
+	uint32_t ms = 1000;
+	size_t qlen = httpd_req_get_url_query_len(req) + 1;
+	if (qlen > 1 && qlen <= sizeof(q) && httpd_req_get_url_query_str(req, q, qlen) == ESP_OK
+			&& httpd_query_key_value(q, "ms", val, sizeof(val)) == ESP_OK) {
+		ms = (uint32_t)atoi(val);
+	}
+	if (ms > 10000) ms = 10000;
+	linktest_result_t r;
+	esp_err_t err = linktest_run(ms, &r);
+	char buf[320];
+	int n;
+	if (err != ESP_OK) {
+		n = snprintf(buf, sizeof(buf), "{\"ok\":false,\"error\":\"%s\"}", esp_err_to_name(err));
+	} else {
+		n = snprintf(buf, sizeof(buf),
+			"{\"ok\":true,\"ms\":%lu,\"bytes_in\":%lu,\"frames_ok\":%lu,\"cksum_errors\":%lu,"
+			"\"bytes_discarded\":%lu,\"goodput_Bps\":%lu,\"line_Bps\":%lu,\"util_permille\":%lu,"
+			"\"frame_err_ppm\":%lu,\"byte_err_ppm\":%lu,\"polls\":%lu,\"replies\":%lu,\"timeouts\":%lu}",
+			(unsigned long)r.ms, (unsigned long)r.bytes_in, (unsigned long)r.frames_ok,
+			(unsigned long)r.cksum_errors, (unsigned long)r.bytes_discarded, (unsigned long)r.goodput_Bps,
+			(unsigned long)r.line_Bps, (unsigned long)r.util_permille, (unsigned long)r.frame_err_ppm,
+			(unsigned long)r.byte_err_ppm, (unsigned long)r.polls, (unsigned long)r.replies,
+			(unsigned long)r.timeouts);
+	}
+	httpd_resp_set_type(req, "application/json");
+	httpd_resp_send(req, buf, n);
+	return ESP_OK;
+}
+
 // HTTP 处理函数：根页面
 static esp_err_t root_handler(httpd_req_t *req)
 {
 	httpd_resp_set_type(req, "text/html");
 	httpd_resp_send(req, html_page, HTTPD_RESP_USE_STRLEN);
+	boot_event(BOOT_EV_FIRST_HTTP);
 	return ESP_OK;
 }
 
-// HTTP 处理函数：/api/status - 返回电机状态与模式信息（JSON）
-static esp_err_t status_handler(httpd_req_t *req)
+// /api/status 响应缓存：所有客户端共享同一份已格式化的 JSON。
+// 响应内容只取决于 (遥测代数, 模式, 滑块值, 轮询周期)，这些都不变时直接发送缓存，
+// 否则重建一次并递增代数；代数同时作为 ETag，客户端带 If-None-Match（或 ?gen=）命中时回 304。
+// 该处理函数注册为同步处理，只在 httpd 服务器任务中运行，缓存无需加锁
+// （httpd_resp_send 返回前已把数据交给协议栈，之后重建不会影响已发送的响应）
+typedef struct {
+	uint32_t tel_gen;
+	uint32_t slider;
+	uint32_t poll_ms;
+	control_mode_t mode;
+} status_key_t;
+
+static char s_status_buf[640];
+static int s_status_len;
+static uint32_t s_status_gen;
+static bool s_status_valid;
+static status_key_t s_status_key;
+static char s_status_etag[16];
+
+// 整数格式化（避免 snprintf 的浮点路径）
+typedef struct {
+	char *p;
+	char *end;
+} jbuf_t;
+
+static void jb_str(jbuf_t *b, const char *str)
+{
+	while (*str && b->p < b->end) *b->p++ = *str++;
+}
+
+static void jb_uint(jbuf_t *b, uint32_t v)
+{
+	char tmp[10];
+	int n = 0;
+	do {
+		tmp[n++] = (char)('0' + v % 10);
+		v /= 10;
+	} while (v);
+	while (n && b->p < b->end) *b->p++ = tmp[--n];
+}
+
+static void jb_int(jbuf_t *b, int32_t v)
+{
+	if (v < 0) {
+		jb_str(b, "-");
+		jb_uint(b, (uint32_t)0 - (uint32_t)v);
+	} else {
+		jb_uint(b, (uint32_t)v);
+	}
+}
+
+// 定点一位小数：tenths = 值 * 10
+static void jb_fix1(jbuf_t *b, int32_t tenths)
+{
+	if (tenths < 0) {
+		jb_str(b, "-");
+		tenths = -tenths;
+	}
+	jb_uint(b, (uint32_t)tenths / 10);
+	char frac[3] = { '.', (char)('0' + (uint32_t)tenths % 10), 0 };
+	jb_str(b, frac);
+}
+
+static void status_motor_common(jbuf_t *b, const motor_status_t *m, bool has_d, const motor_derived_t *d)
+{
+	jb_str(b, ",\"speed\":");
+	jb_fix1(b, (has_d ? d->speed_filt : m ? m->speed : 0) * 10);
+	jb_str(b, ",\"current\":");
+	jb_int(b, has_d ? d->current_filt : m ? m->current : 0);
+	jb_str(b, ",\"temp\":");
+	jb_uint(b, m ? m->temperature : 0u);
+	jb_str(b, ",\"multi_turn\":");
+	jb_int(b, d->position);
+	jb_str(b, ",\"accel\":");
+	jb_int(b, d->accel);
+	jb_str(b, ",\"current_rms\":");
+	jb_uint(b, d->current_rms);
+	jb_str(b, "}");
+}
+
+static int status_build(char *buf, size_t size, const status_key_t *key)
 {
 	const motor_status_t *m1 = get_motor_status(1);
 	const motor_status_t *m2 = get_motor_status(2);
-	control_mode_t mode = ui_state_get_mode();
 	const char *mode_names[] = {"MANUAL", "PRESET1", "PRESET2"};
-	const char *mode_str = (mode < MODE_COUNT) ? mode_names[mode] : "UNKNOWN";
+	const char *mode_str = (key->mode < MODE_COUNT) ? mode_names[key->mode] : "UNKNOWN";
 
-	// 获取滑块值
-	int16_t rot_val = 0, pos_val = 0;
-	if (s_slider_lock) xSemaphoreTake(s_slider_lock, portMAX_DELAY);
-	rot_val = s_rotation_value;
-	pos_val = s_position_value;
-	if (s_slider_lock) xSemaphoreGive(s_slider_lock);
+	// 速度/电流显示滤波值（遥测处理阶段已算好），另附多圈位置、加速度与 RMS 电流
+	motor_derived_t d1 = { 0 }, d2 = { 0 };
+	bool h1 = get_motor_derived(1, &d1);
+	bool h2 = get_motor_derived(2, &d2);
 
-	char buf[512];
-	int n = snprintf(buf, sizeof(buf),
-		"{"
-		"\"mode\":\"%s\","
-		"\"gm6020\":{\"angle\":%.1f,\"speed\":%.1f,\"current\":%d,\"temp\":%u},"
-		"\"m3508\":{\"position\":%u,\"speed\":%.1f,\"current\":%d,\"temp\":%u},"
-		"\"slider_rotation\":%d,"
-		"\"slider_position\":%d"
-		"}",
-		mode_str,
-		m1 ? (m1->angle * 360.0f / 8191.0f) : 0.0f,
-		m1 ? (float)m1->speed : 0.0f,
-		m1 ? (int)m1->current : 0,
-		m1 ? (unsigned)m1->temperature : 0u,
-		m2 ? (unsigned)m2->angle : 0u,
-		m2 ? (float)m2->speed : 0.0f,
-		m2 ? (int)m2->current : 0,
-		m2 ? (unsigned)m2->temperature : 0u,
-		(int)rot_val,
-		(int)pos_val
-	);
+	jbuf_t b = { buf, buf + size - 1 };
+	jb_str(&b, "{\"mode\":\"");
+	jb_str(&b, mode_str);
+	jb_str(&b, "\",\"gm6020\":{\"angle\":");
+	// 角度（度）保留一位小数：angle * 3600 / 8191 四舍五入
+	jb_fix1(&b, m1 ? (int32_t)(((uint32_t)m1->angle * 3600u + 4095u) / 8191u) : 0);
+	status_motor_common(&b, m1, h1, &d1);
+	jb_str(&b, ",\"m3508\":{\"position\":");
+	jb_uint(&b, m2 ? m2->angle : 0u);
+	status_motor_common(&b, m2, h2, &d2);
+	jb_str(&b, ",\"slider_rotation\":");
+	jb_int(&b, (int16_t)(key->slider >> 16));
+	jb_str(&b, ",\"slider_position\":");
+	jb_int(&b, (int16_t)(key->slider & 0xFFFF));
+	jb_str(&b, ",\"poll_ms\":");
+	jb_uint(&b, key->poll_ms);
+	jb_str(&b, "}");
+	*b.p = 0;
+	return (int)(b.p - buf);
+}
+
+static void status_key_now(status_key_t *key)
+{
+	*key = (status_key_t){
+		.tel_gen = serial_cboard_telemetry_gen(),
+		.slider = s_slider_packed,
+		.poll_ms = rate_gov_period_ms(RATE_GOV_WEB_POLL),
+		.mode = ui_state_get_mode(),
+	};
+}
+
+int webserver_status_json(char *buf, size_t size)
+{
+	if (!buf || size < 2) return 0;
+	status_key_t key;
+	status_key_now(&key);
+	return status_build(buf, size, &key);
+}
+
+// 客户端已持有当前代数：If-None-Match: "<gen>" 或查询参数 gen=<gen>
+static bool status_client_fresh(httpd_req_t *req)
+{
+	char buf[24];
+	if (httpd_req_get_hdr_value_str(req, "If-None-Match", buf, sizeof(buf)) == ESP_OK
+			&& strcmp(buf, s_status_etag) == 0) {
+		return true;
+	}
+	size_t qlen = httpd_req_get_url_query_len(req) + 1;
+	char q[32], val[12];
+	if (qlen > 1 && qlen <= sizeof(q) && httpd_req_get_url_query_str(req, q, qlen) == ESP_OK
+			&& httpd_query_key_value(q, "gen", val, sizeof(val)) == ESP_OK) {
+		return strtoul(val, NULL, 10) == s_status_gen;
+	}
+	return false;
+}
+
+// HTTP 处理函数：/api/status - 返回电机状态与模式信息（JSON）
+static esp_err_t status_handler(httpd_req_t *req)
+{
+	int64_t t_start = esp_timer_get_time();
+	rate_gov_note_viewer(httpd_req_to_sockfd(req));
+
+	status_key_t key;
+	status_key_now(&key);
+	if (!s_status_valid || memcmp(&key, &s_status_key, sizeof(key)) != 0) {
+		s_status_len = status_build(s_status_buf, sizeof(s_status_buf), &key);
+		s_status_key = key;
+		s_status_valid = true;
+		s_status_gen++;
+		snprintf(s_status_etag, sizeof(s_status_etag), "\"%lu\"", (unsigned long)s_status_gen);
+		s_http_stats.status_rebuilds++;
+	} else {
+		s_http_stats.status_cache_hits++;
+	}
 
 	httpd_resp_set_type(req, "application/json");
-	httpd_resp_send(req, buf, n);
+	httpd_resp_set_hdr(req, "ETag", s_status_etag);
+	httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+	if (status_client_fresh(req)) {
+		httpd_resp_set_status(req, "304 Not Modified");
+		httpd_resp_send(req, NULL, 0);
+		s_http_stats.status_not_modified++;
+	} else {
+		httpd_resp_send(req, s_status_buf, s_status_len);
+	}
+	boot_event(BOOT_EV_FIRST_HTTP);
+
+	uint32_t us = (uint32_t)(esp_timer_get_time() - t_start);
+	lat_hist_add(s_http_stats.status_hist, us);
+	s_http_stats.status_requests++;
+	if (us > s_http_stats.status_max_us) s_http_stats.status_max_us = us;
 	return ESP_OK;
 }
 
 // HTTP 处理函数：/api/rotation - 设置旋转速度
 static esp_err_t rotation_handler(httpd_req_t *req)
 {
+	int64_t t_start = esp_timer_get_time();
+	int64_t t_cmd = 0;
 	char buf[64];
 	size_t buf_len = httpd_req_get_url_query_len(req) + 1;
 	if (buf_len > 1 && buf_len <= sizeof(buf)) {
@@ -275,6 +750,7 @@ static esp_err_t rotation_handler(httpd_req_t *req)
 				}
 				// 发送速度控制命令到电机1 (GM6020)
 				send_motor_command(1, (int16_t)value, 0, 0);
+				t_cmd = esp_timer_get_time();
 				// 更新滑块值
 				webserver_update_slider_values((int16_t)value, s_position_value);
 				ESP_LOGI(TAG, "Set rotation speed: %d", value);
@@ -283,12 +759,15 @@ static esp_err_t rotation_handler(httpd_req_t *req)
 	}
 	httpd_resp_set_type(req, "application/json");
 	httpd_resp_send(req, "{\"ok\":true}", HTTPD_RESP_USE_STRLEN);
+	ctl_stats_add(HTTP_CTL_ROTATION, t_start, t_cmd);
 	return ESP_OK;
 }
 
 // HTTP 处理函数：/api/position - 设置位置
 static esp_err_t position_handler(httpd_req_t *req)
 {
+	int64_t t_start = esp_timer_get_time();
+	int64_t t_cmd = 0;
 	char buf[64];
 	size_t buf_len = httpd_req_get_url_query_len(req) + 1;
 	if (buf_len > 1 && buf_len <= sizeof(buf)) {
@@ -302,6 +781,7 @@ static esp_err_t position_handler(httpd_req_t *req)
 				}
 				// 发送位置控制命令到电机2 (M3508)
 				send_motor_command(2, 0, (int16_t)value, 1);
+				t_cmd = esp_timer_get_time();
 				// 更新滑块值
 				webserver_update_slider_values(s_rotation_value, (int16_t)value);
 				ESP_LOGI(TAG, "Set position: %d", value);
@@ -310,12 +790,15 @@ static esp_err_t position_handler(httpd_req_t *req)
 	}
 	httpd_resp_set_type(req, "application/json");
 	httpd_resp_send(req, "{\"ok\":true}", HTTPD_RESP_USE_STRLEN);
+	ctl_stats_add(HTTP_CTL_POSITION, t_start, t_cmd);
 	return ESP_OK;
 }
 
 // HTTP 处理函数：/api/button - 虚拟按键
 static esp_err_t button_handler(httpd_req_t *req)
 {
+	int64_t t_start = esp_timer_get_time();
+	int64_t t_cmd = 0;
 	char buf[64];
 	size_t buf_len = httpd_req_get_url_query_len(req) + 1;
 	if (buf_len > 1 && buf_len <= sizeof(buf)) {
@@ -324,12 +807,15 @@ static esp_err_t button_handler(httpd_req_t *req)
 			if (httpd_query_key_value(buf, "btn", btn_str, sizeof(btn_str)) == ESP_OK) {
 				if (strcmp(btn_str, "up") == 0) {
 					ui_state_button_event_up();
+					t_cmd = esp_timer_get_time();
 					ESP_LOGI(TAG, "Virtual button: UP");
 				} else if (strcmp(btn_str, "down") == 0) {
 					ui_state_button_event_down();
+					t_cmd = esp_timer_get_time();
 					ESP_LOGI(TAG, "Virtual button: DOWN");
 				} else if (strcmp(btn_str, "ok") == 0) {
 					ui_state_button_event_ok();
+					t_cmd = esp_timer_get_time();
 					ESP_LOGI(TAG, "Virtual button: OK");
 				}
 			}
@@ -337,6 +823,175 @@ static esp_err_t button_handler(httpd_req_t *req)
 	}
 	httpd_resp_set_type(req, "application/json");
 	httpd_resp_send(req, "{\"ok\":true}", HTTPD_RESP_USE_STRLEN);
+	ctl_stats_add(HTTP_CTL_BUTTON, t_start, t_cmd);
+	return ESP_OK;
+}
+
+// HTTP 处理函数：/api/estop[?release=1|?reset=1|?status=1] - 触发急停（默认）、解除锁存、清零统计或只查询，
+// 返回急停通道统计。触发在处理函数内直接交给急停通道（不经异步 worker）
+static esp_err_t estop_handler(httpd_req_t *req)
+{
+	int64_t t_start = esp_timer_get_time();
+	int64_t t_cmd = 0;
+	const char *err = NULL;
+	char query[32] = "", val[4] = "";
+	size_t qlen = httpd_req_get_url_query_len(req) + 1;
+	bool have_q = qlen > 1 && qlen <= sizeof(query) && httpd_req_get_url_query_str(req, query, qlen) == ESP_OK;
+	if (have_q && httpd_query_key_value(query, "release", val, sizeof(val)) == ESP_OK && atoi(val) != 0) {
+		if (ui_state_estop_held()) err = "button still pressed";
+		else serial_cboard_estop_release();
+	} else if (have_q && httpd_query_key_value(query, "reset", val, sizeof(val)) == ESP_OK && atoi(val) != 0) {
+		serial_cboard_reset_estop_stats();
+	} else if (!(have_q && httpd_query_key_value(query, "status", val, sizeof(val)) == ESP_OK)) {
+		serial_cboard_estop(ESTOP_SRC_HTTP);
+		t_cmd = esp_timer_get_time();
+	}
+
+	serial_estop_stats_t st;
+	serial_cboard_get_estop_stats(&st);
+	char buf[256];
+	int n = snprintf(buf, sizeof(buf),
+		"{\"latched\":%s,\"triggers\":%lu,\"sent\":%lu,\"dropped_cmds\":%lu,\"last_source\":\"%s\","
+		"\"last_us\":%lu,\"avg_us\":%lu,\"max_us\":%lu%s%s%s}",
+		st.latched ? "true" : "false", (unsigned long)st.triggers, (unsigned long)st.sent,
+		(unsigned long)st.dropped_cmds, serial_cboard_estop_source_name(st.last_source), (unsigned long)st.last_us,
+		(unsigned long)(st.sent ? st.total_us / st.sent : 0), (unsigned long)st.max_us,
+		err ? ",\"error\":\"" : "", err ? err : "", err ? "\"" : "");
+	httpd_resp_set_type(req, "application/json");
+	httpd_resp_send(req, buf, n);
+	if (t_cmd) ctl_stats_add(HTTP_CTL_ESTOP, t_start, t_cmd);
+	return ESP_OK;
+}
+
+// HTTP 处理函数：GET /api/capture - 流式下载串口抓包文件（分块发送，不在内存中缓存整个文件）
+static esp_err_t capture_download_handler(httpd_req_t *req)
+{
+	uint8_t chunk[512];
+	size_t off = 0;
+	httpd_resp_set_type(req, "application/octet-stream");
+	httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"cboard.rkc\"");
+	while (1) {
+		size_t n = uart_capture_read(off, chunk, sizeof(chunk));
+		if (n == 0) break;
+		if (httpd_resp_send_chunk(req, (const char *)chunk, n) != ESP_OK) {
+			ESP_LOGW(TAG, "capture download aborted at %u", (unsigned)off);
+			return ESP_FAIL;
+		}
+		off += n;
+	}
+	return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// HTTP 处理函数：POST /api/capture - 上传抓包文件（用于在另一台设备上回放）
+static esp_err_t capture_upload_handler(httpd_req_t *req)
+{
+	uint8_t chunk[512];
+	size_t remaining = req->content_len;
+	esp_err_t err = uart_capture_upload_begin();
+	while (err == ESP_OK && remaining > 0) {
+		int r = httpd_req_recv(req, (char *)chunk, remaining < sizeof(chunk) ? remaining : sizeof(chunk));
+		if (r <= 0) {
+			err = ESP_FAIL;
+			break;
+		}
+		err = uart_capture_upload_write(chunk, (size_t)r);
+		remaining -= (size_t)r;
+	}
+	if (err == ESP_OK) err = uart_capture_upload_end();
+	httpd_resp_set_type(req, "application/json");
+	if (err != ESP_OK) {
+		char buf[64];
+		snprintf(buf, sizeof(buf), "{\"ok\":false,\"error\":\"%s\"}", esp_err_to_name(err));
+		httpd_resp_sendstr(req, buf);
+		return ESP_OK;
+	}
+	httpd_resp_sendstr(req, "{\"ok\":true}");
+	return ESP_OK;
+}
+
+// HTTP 处理函数：/api/capture/ctl?action=start|stop|replay|replay_stop|status[&speed=N]
+static esp_err_t capture_ctl_handler(httpd_req_t *req)
+{
+	char query[64] = "";
+	char action[16] = "status";
+	char speed_str[12] = "1";
+	size_t qlen = httpd_req_get_url_query_len(req) + 1;
+	if (qlen > 1 && qlen <= sizeof(query) && httpd_req_get_url_query_str(req, query, qlen) == ESP_OK) {
+		httpd_query_key_value(query, "action", action, sizeof(action));
+		httpd_query_key_value(query, "speed", speed_str, sizeof(speed_str));
+	}
+	esp_err_t err = ESP_OK;
+	if (strcmp(action, "start") == 0) err = uart_capture_start();
+	else if (strcmp(action, "stop") == 0) err = uart_capture_stop();
+	else if (strcmp(action, "replay") == 0) err = uart_capture_replay_start((uint32_t)atoi(speed_str));
+	else if (strcmp(action, "replay_stop") == 0) uart_capture_replay_stop();
+
+	uart_capture_status_t st;
+	uart_capture_get_status(&st);
+	char buf[256];
+	int n = snprintf(buf, sizeof(buf),
+		"{\"ok\":%s,\"error\":\"%s\",\"available\":%s,\"recording\":%s,\"replaying\":%s,"
+		"\"length\":%lu,\"capacity\":%lu,\"records\":%lu,\"dropped\":%lu,\"replayed\":%lu}",
+		err == ESP_OK ? "true" : "false", err == ESP_OK ? "" : esp_err_to_name(err),
+		st.available ? "true" : "false", st.recording ? "true" : "false", st.replaying ? "true" : "false",
+		(unsigned long)st.length, (unsigned long)st.capacity, (unsigned long)st.records,
+		(unsigned long)st.dropped, (unsigned long)st.replay_records);
+	httpd_resp_set_type(req, "application/json");
+	httpd_resp_send(req, buf, n);
+	return ESP_OK;
+}
+
+// 飞行记录仪下载：把记录块直接写成 HTTP 分块
+static esp_err_t recorder_http_sink(void *ctx, const char *data, size_t len)
+{
+	return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+// HTTP 处理函数：/api/recorder?from=<ms>&to=<ms>&session=<hex>&format=csv|raw - 流式下载时间范围内的记录
+static esp_err_t recorder_download_handler(httpd_req_t *req)
+{
+	char query[128] = "";
+	char val[16];
+	uint32_t from_ms = 0, to_ms = UINT32_MAX, session = 0;
+	recorder_fmt_t fmt = RECORDER_FMT_CSV;
+	size_t qlen = httpd_req_get_url_query_len(req) + 1;
+	if (qlen > 1 && qlen <= sizeof(query) && httpd_req_get_url_query_str(req, query, qlen) == ESP_OK) {
+		if (httpd_query_key_value(query, "from", val, sizeof(val)) == ESP_OK) from_ms = strtoul(val, NULL, 10);
+		if (httpd_query_key_value(query, "to", val, sizeof(val)) == ESP_OK) to_ms = strtoul(val, NULL, 10);
+		if (httpd_query_key_value(query, "session", val, sizeof(val)) == ESP_OK) session = strtoul(val, NULL, 16);
+		if (httpd_query_key_value(query, "format", val, sizeof(val)) == ESP_OK && strcmp(val, "raw") == 0) {
+			fmt = RECORDER_FMT_RAW;
+		}
+	}
+	if (fmt == RECORDER_FMT_RAW) {
+		httpd_resp_set_type(req, "application/octet-stream");
+		httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"flight.frb\"");
+	} else {
+		httpd_resp_set_type(req, "text/csv");
+	}
+	esp_err_t err = recorder_stream(session, from_ms, to_ms, fmt, recorder_http_sink, req);
+	if (err != ESP_OK) {
+		ESP_LOGW(TAG, "recorder download ended: %s", esp_err_to_name(err));
+	}
+	return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+// HTTP 处理函数：/api/recorder/status - 飞行记录仪统计
+static esp_err_t recorder_status_handler(httpd_req_t *req)
+{
+	recorder_stats_t st;
+	recorder_get_stats(&st);
+	char buf[320];
+	int n = snprintf(buf, sizeof(buf),
+		"{\"mounted\":%s,\"session\":\"%08lx\",\"samples\":%lu,\"commands\":%lu,\"dropped\":%lu,"
+		"\"blocks\":%lu,\"bytes_written\":%lu,\"raw_bytes\":%lu,\"segments_deleted\":%lu,"
+		"\"fs_total\":%u,\"fs_used\":%u}",
+		st.mounted ? "true" : "false", (unsigned long)st.session, (unsigned long)st.samples,
+		(unsigned long)st.commands, (unsigned long)st.dropped, (unsigned long)st.blocks,
+		(unsigned long)st.bytes_written, (unsigned long)st.raw_bytes, (unsigned long)st.segments_deleted,
+		(unsigned)st.fs_total, (unsigned)st.fs_used);
+	httpd_resp_set_type(req, "application/json");
+	httpd_resp_send(req, buf, n);
 	return ESP_OK;
 }
 
@@ -354,6 +1009,18 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
 		ESP_LOGI(TAG, "Station %02x:%02x:%02x:%02x:%02x:%02x left, AID=%d",
 				 event->mac[0], event->mac[1], event->mac[2],
 				 event->mac[3], event->mac[4], event->mac[5], event->aid);
+	} else if (event_id == WIFI_EVENT_STA_START || event_id == WIFI_EVENT_STA_DISCONNECTED) {
+		// 上行（仅 WIFI_UPLINK_SSID 非空时启用 STA）：启动或断开后重连
+		esp_wifi_connect();
+	}
+}
+
+static void ip_event_handler(void* arg, esp_event_base_t event_base,
+							 int32_t event_id, void* event_data)
+{
+	if (event_id == IP_EVENT_STA_GOT_IP) {
+		ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
+		ESP_LOGI(TAG, "Uplink %s connected, ip=" IPSTR, WIFI_UPLINK_SSID, IP2STR(&event->ip_info.ip));
 	}
 }
 
@@ -362,6 +1029,15 @@ static httpd_handle_t start_webserver(void)
 {
 	httpd_config_t config = HTTPD_DEFAULT_CONFIG();
 	config.lru_purge_enable = true;
+	config.max_uri_handlers = 16;
+	// 服务器任务的核心/优先级/栈来自任务拓扑表（与 Wi-Fi 同核、优先级低于串口解析任务）
+	const task_profile_t *tp = task_topology_get(TASK_ID_HTTPD);
+	config.max_open_sockets = HTTPD_MAX_SOCKETS;
+	config.stack_size = tp->stack;
+	config.task_priority = tp->priority;
+	config.core_id = tp->core;
+
+	http_async_init();
 
 	httpd_handle_t srv = NULL;
 	if (httpd_start(&srv, &config) == ESP_OK) {
@@ -369,8 +1045,8 @@ static httpd_handle_t start_webserver(void)
 		httpd_uri_t root_uri = {
 			.uri       = "/",
 			.method    = HTTP_GET,
-			.handler   = root_handler,
-			.user_ctx  = NULL
+			.handler   = async_dispatch_handler,
+			.user_ctx  = root_handler
 		};
 		httpd_register_uri_handler(srv, &root_uri);
 
@@ -406,7 +1082,89 @@ static httpd_handle_t start_webserver(void)
 		};
 		httpd_register_uri_handler(srv, &button_uri);
 
-		ESP_LOGI(TAG, "HTTP server started");
+		httpd_uri_t estop_uri = {
+			.uri       = "/api/estop",
+			.method    = HTTP_GET,
+			.handler   = estop_handler,
+			.user_ctx  = NULL
+		};
+		httpd_register_uri_handler(srv, &estop_uri);
+
+		httpd_uri_t capture_get_uri = {
+			.uri       = "/api/capture",
+			.method    = HTTP_GET,
+			.handler   = async_dispatch_handler,
+			.user_ctx  = capture_download_handler
+		};
+		httpd_register_uri_handler(srv, &capture_get_uri);
+
+		httpd_uri_t capture_post_uri = {
+			.uri       = "/api/capture",
+			.method    = HTTP_POST,
+			.handler   = async_dispatch_handler,
+			.user_ctx  = capture_upload_handler
+		};
+		httpd_register_uri_handler(srv, &capture_post_uri);
+
+		// start 擦除文件头扇区、stop 等待最后一块落盘：都在 worker 中执行
+		httpd_uri_t capture_ctl_uri = {
+			.uri       = "/api/capture/ctl",
+			.method    = HTTP_GET,
+			.handler   = async_dispatch_handler,
+			.user_ctx  = capture_ctl_handler
+		};
+		httpd_register_uri_handler(srv, &capture_ctl_uri);
+
+		httpd_uri_t recorder_uri = {
+			.uri       = "/api/recorder",
+			.method    = HTTP_GET,
+			.handler   = async_dispatch_handler,
+			.user_ctx  = recorder_download_handler
+		};
+		httpd_register_uri_handler(srv, &recorder_uri);
+
+		httpd_uri_t recorder_status_uri = {
+			.uri       = "/api/recorder/status",
+			.method    = HTTP_GET,
+			.handler   = recorder_status_handler,
+			.user_ctx  = NULL
+		};
+		httpd_register_uri_handler(srv, &recorder_status_uri);
+
+		httpd_uri_t http_stats_uri = {
+			.uri       = "/api/http/stats",
+			.method    = HTTP_GET,
+			.handler   = http_stats_handler,
+			.user_ctx  = NULL
+		};
+		httpd_register_uri_handler(srv, &http_stats_uri);
+
+		httpd_uri_t rates_uri = {
+			.uri       = "/api/rates",
+			.method    = HTTP_GET,
+			.handler   = rates_handler,
+			.user_ctx  = NULL
+		};
+		httpd_register_uri_handler(srv, &rates_uri);
+
+		httpd_uri_t bench_uri = {
+			.uri       = "/api/bench",
+			.method    = HTTP_GET,
+			.handler   = async_dispatch_handler,
+			.user_ctx  = bench_handler
+		};
+		httpd_register_uri_handler(srv, &bench_uri);
+
+		httpd_uri_t linktest_uri = {
+			.uri       = "/api/linktest",
+			.method    = HTTP_GET,
+			.handler   = async_dispatch_handler,
+			.user_ctx  = linktest_handler
+		};
+		httpd_register_uri_handler(srv, &linktest_uri);
+
+		ESP_LOGI(TAG, "HTTP server started (sockets=%d prio=%u core=%d async_workers=%d)",
+				 HTTPD_MAX_SOCKETS, (unsigned)tp->priority, (int)tp->core, HTTPD_ASYNC_WORKERS);
 		return srv;
 	}
 
@@ -419,7 +1177,18 @@ static void wifi_init_softap(void)
 {
 	ESP_ERROR_CHECK(esp_netif_init());
 	ESP_ERROR_CHECK(esp_event_loop_create_default());
-	esp_netif_create_default_wifi_ap();
+	esp_netif_t *ap_netif = esp_netif_create_default_wifi_ap();
+	const bool uplink = strlen(WIFI_UPLINK_SSID) > 0;
+	if (uplink) esp_netif_create_default_wifi_sta();
+
+	// 热点地址 192.168.<WIFI_AP_SUBNET>.1：多个机架同时上线时各自的热点网段互不冲突
+	esp_netif_ip_info_t ip_info;
+	IP4_ADDR(&ip_info.ip, 192, 168, WIFI_AP_SUBNET, 1);
+	IP4_ADDR(&ip_info.gw, 192, 168, WIFI_AP_SUBNET, 1);
+	IP4_ADDR(&ip_info.netmask, 255, 255, 255, 0);
+	esp_netif_dhcps_stop(ap_netif);
+	ESP_ERROR_CHECK(esp_netif_set_ip_info(ap_netif, &ip_info));
+	esp_netif_dhcps_start(ap_netif);
 
 	wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
 	ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -429,6 +1198,13 @@ static void wifi_init_softap(void)
 														&wifi_event_handler,
 														NULL,
 														NULL));
+	if (uplink) {
+		ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
+															IP_EVENT_STA_GOT_IP,
+															&ip_event_handler,
+															NULL,
+															NULL));
+	}
 
 	wifi_config_t wifi_config = {
 		.ap = {
@@ -445,29 +1221,43 @@ static void wifi_init_softap(void)
 		wifi_config.ap.authmode = WIFI_AUTH_OPEN;
 	}
 
-	ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_AP));
+	ESP_ERROR_CHECK(esp_wifi_set_mode(uplink ? WIFI_MODE_APSTA : WIFI_MODE_AP));
 	ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_AP, &wifi_config));
+	if (uplink) {
+		// 多机架：STA 接入公共网络（如主机架热点），时间同步经此链路进行
+		wifi_config_t sta_config = { 0 };
+		strlcpy((char *)sta_config.sta.ssid, WIFI_UPLINK_SSID, sizeof(sta_config.sta.ssid));
+		strlcpy((char *)sta_config.sta.password, WIFI_UPLINK_PASS, sizeof(sta_config.sta.password));
+		ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &sta_config));
+	}
 	ESP_ERROR_CHECK(esp_wifi_start());
 
-	ESP_LOGI(TAG, "Wi-Fi AP started. SSID:%s password:%s channel:%d",
-			 WIFI_SSID, WIFI_PASS, WIFI_CHANNEL);
+	ESP_LOGI(TAG, "Wi-Fi AP started. SSID:%s password:%s channel:%d ip:192.168.%d.1%s%s",
+			 WIFI_SSID, WIFI_PASS, WIFI_CHANNEL, WIFI_AP_SUBNET, uplink ? " uplink:" : "", WIFI_UPLINK_SSID);
 }
 
-// 后台任务：在非手动模式下更新滑块值
-static void slider_sync_task(void *arg)
+// 滑块同步作业（调度器 UI 执行任务）：订阅电机 1、2 的遥测，在非手动模式下把实际值同步到滑块。
+// 手动模式下滑块由用户拖动，停用订阅，只按兜底间隔检查模式
+static int s_slider_sub = -1;
+
+static int64_t slider_sync_job(void *arg, int64_t deadline_us)
 {
-	while (1) {
-		control_mode_t mode = ui_state_get_mode();
-		if (mode != MODE_MANUAL) {
-			// 同步实际电机值到滑块
-			const motor_status_t *m1 = get_motor_status(1);
-			const motor_status_t *m2 = get_motor_status(2);
-			if (m1 && m2) {
-				webserver_update_slider_values(m1->speed, m2->angle);
-			}
+	(void)arg;
+	control_mode_t mode = ui_state_get_mode();
+	uint32_t period_ms = rate_gov_period_ms(RATE_GOV_SLIDER_SYNC);
+	telem_bus_enable(s_slider_sub, mode != MODE_MANUAL);
+	if (mode != MODE_MANUAL) {
+		motor_status_t m1, m2;
+		bool have1 = telem_bus_get(s_slider_sub, 1, &m1);
+		bool have2 = telem_bus_get(s_slider_sub, 2, &m2);
+		if (have1 && have2) {
+			webserver_update_slider_values(m1.speed, m2.angle);
 		}
-		vTaskDelay(pdMS_TO_TICKS(100));
+		// 无人观看时由速率调节器拉长间隔
+		telem_bus_set_rate(s_slider_sub, 1, period_ms * 1000);
 	}
+	uint32_t fallback_ms = period_ms > TELEM_BUS_FALLBACK_MS ? period_ms : TELEM_BUS_FALLBACK_MS;
+	return deadline_us + (int64_t)fallback_ms * 1000;
 }
 
 void webserver_init(void)
@@ -479,20 +1269,32 @@ void webserver_init(void)
 		ret = nvs_flash_init();
 	}
 	ESP_ERROR_CHECK(ret);
+	boot_mark(BOOT_STAGE_NET, "nvs");
 
 	// 创建滑块锁
-	s_slider_lock = xSemaphoreCreateMutex();
+	s_slider_lock = xSemaphoreCreateMutexStatic(&s_slider_lock_buf);
 
 	// 初始化 Wi-Fi AP
 	wifi_init_softap();
+	boot_mark(BOOT_STAGE_NET, "wifi");
 
 	// 启动 HTTP Server
 	server = start_webserver();
+	boot_mark(BOOT_STAGE_NET, "httpd");
 
-	// 启动滑块同步任务
-	xTaskCreate(slider_sync_task, "slider_sync", 2048, NULL, 5, NULL);
+	// 登记滑块同步作业并订阅遥测（首次运行按当前模式启停订阅）
+	const telem_bus_sub_cfg_t sub = {
+		.name = "slider_sync",
+		.sched_job = sched_add("slider_sync", SCHED_EXEC_UI, 0, esp_timer_get_time(), slider_sync_job, NULL),
+		.ids = { 1, 2 },
+		.nids = 2,
+		.min_period_us = (uint32_t)rate_gov_period_ms(RATE_GOV_SLIDER_SYNC) * 1000,
+		.enabled = false,
+	};
+	if (sub.sched_job >= 0) s_slider_sub = telem_bus_subscribe(&sub);
+	sched_trigger(sub.sched_job);
 
-	ESP_LOGI(TAG, "Web server initialized. Connect to Wi-Fi AP and visit http://192.168.4.1");
+	ESP_LOGI(TAG, "Web server initialized. Connect to Wi-Fi AP and visit http://192.168.%d.1", WIFI_AP_SUBNET);
 }
 
 void webserver_stop(void)
@@ -2,6 +2,7 @@
 #define WEBSERVER_H
 
 #include <stdint.h>
+#include <stddef.h>
 
 // Web Server 模块头文件
 
@@ -11,6 +12,52 @@ void webserver_init(void);
 // 停止 Web Server（若需要）
 void webserver_stop(void);
 
+#define HTTP_LAT_BUCKETS 20
+
+// 控制类接口（网页滑块、虚拟按键与急停）
+typedef enum {
+	HTTP_CTL_ROTATION = 0,
+	HTTP_CTL_POSITION,
+	HTTP_CTL_BUTTON,
+	HTTP_CTL_ESTOP,
+	HTTP_CTL_COUNT
+} http_ctl_t;
+
+// 控制类接口统计：服务时间（请求进入处理函数 -> 响应发出）与命令时延
+// （请求进入 -> 命令交给 C 板链路：点对点写入 UART，总线放入下一次轮询；按键为模式切换完成；
+//   急停为交给急停通道，之后到停止帧发出的时间见急停通道统计）
+typedef struct {
+	uint32_t requests;
+	uint32_t max_us;
+	uint32_t cmd_max_us;
+	uint32_t hist[HTTP_LAT_BUCKETS];
+	uint32_t cmd_hist[HTTP_LAT_BUCKETS];
+} http_ctl_stats_t;
+
+// HTTP 服务统计
+typedef struct {
+	uint32_t async_dispatched;        // 交给异步 worker 的请求数
+	uint32_t async_rejected;          // worker 与队列全满时回 503 的请求数
+	uint32_t status_requests;         // /api/status 请求数
+	uint32_t status_max_us;           // /api/status 最长服务时间
+	uint32_t status_p50_us;           // 由直方图估算（桶上界）
+	uint32_t status_p99_us;
+	uint32_t status_p999_us;
+	uint32_t status_cache_hits;       // 直接发送缓存的 /api/status 响应
+	uint32_t status_rebuilds;         // 输入变化后重建（代数递增）
+	uint32_t status_not_modified;     // 客户端已持有当前代数，回 304
+	uint32_t status_hist[HTTP_LAT_BUCKETS]; // 服务时间直方图（log2 微秒桶）
+	http_ctl_stats_t ctl[HTTP_CTL_COUNT];
+} http_stats_t;
+
+void webserver_get_http_stats(http_stats_t *out);
+
+// 清零统计（负载测试开始前调用，使百分位只反映本次测试）
+void webserver_reset_http_stats(void);
+
+// 按当前状态生成 /api/status 的 JSON（不经缓存，自测基准用），返回长度
+int webserver_status_json(char *buf, size_t size);
+
 // 更新网页端滑块位置（在非手动模式下调用，同步实际值到前端）
 void webserver_update_slider_values(int16_t rotation_speed, int16_t position);
 
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""通过 CLI 串口的二进制帧模式高速下发设定点（需要 pyserial）。
+
+用法：
+    python3 tools/cli_bin_stream.py --port /dev/ttyUSB0 --rate 2000 --duration 5 --motor 2
+    python3 tools/cli_bin_stream.py --port /dev/ttyUSB0 --baud 921600 --rate 5000 --batch 4
+
+先发送文本命令 `bin` 进入二进制模式，按 --rate 频率发送 SETPOINTS 帧（每帧 --batch 个设定点，
+同一电机的正弦位置序列），结束时发送 PING 读取设备统计，再发送 EXIT 回到文本模式。
+帧格式见 main/cli.h。
+"""
+import argparse
+import math
+import struct
+import time
+
+import serial
+
+SOF = 0xA5
+T_SETPOINTS, T_PING, T_EXIT, T_REPLY = 0x01, 0x02, 0x03, 0x80
+
+
+def frame(typ, payload=b""):
+    return bytes([SOF, typ, len(payload)]) + payload + bytes([sum(payload) & 0xFF])
+
+
+def read_reply(ser, typ, timeout=1.0):
+    """跳过日志等文本输出，按帧头与校验和找到指定类型的应答帧。"""
+    buf = b""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        buf += ser.read(ser.in_waiting or 1)
+        i = buf.find(bytes([SOF, typ]))
+        while i >= 0:
+            if len(buf) >= i + 4 and len(buf) >= i + 4 + buf[i + 2]:
+                n = buf[i + 2]
+                payload = buf[i + 3:i + 3 + n]
+                if sum(payload) & 0xFF == buf[i + 3 + n]:
+                    return payload
+            i = buf.find(bytes([SOF, typ]), i + 1)
+    return None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--port", required=True)
+    ap.add_argument("--baud", type=int, default=115200)
+    ap.add_argument("--rate", type=float, default=1000.0, help="帧频率 Hz")
+    ap.add_argument("--batch", type=int, default=1, help="每帧设定点数")
+    ap.add_argument("--duration", type=float, default=5.0)
+    ap.add_argument("--motor", type=int, default=2)
+    ap.add_argument("--amplitude", type=int, default=2000)
+    args = ap.parse_args()
+
+    ser = serial.Serial(args.port, args.baud, timeout=0)
+    ser.write(b"\nbin\n")
+    time.sleep(0.05)
+    ser.reset_input_buffer()
+
+    period = 1.0 / args.rate
+    t0 = time.monotonic()
+    next_t = t0
+    frames = 0
+    while time.monotonic() - t0 < args.duration:
+        now = time.monotonic()
+        if now < next_t:
+            continue
+        recs = b""
+        for k in range(args.batch):
+            t = now - t0 + k * period / args.batch
+            pos = int((args.amplitude * math.sin(2 * math.pi * 0.5 * t)) % 8192)
+            recs += struct.pack("<BBhh", args.motor, 1, 0, pos)
+        ser.write(frame(T_SETPOINTS, recs))
+        frames += 1
+        next_t += period
+    elapsed = time.monotonic() - t0
+
+    ser.write(frame(T_PING))
+    st = read_reply(ser, T_PING | T_REPLY)
+    ser.write(frame(T_EXIT))
+    read_reply(ser, T_EXIT | T_REPLY)
+    print("sent %d frames (%.0f/s, %.0f setpoints/s)" % (frames, frames / elapsed, frames * args.batch / elapsed))
+    if st and len(st) >= 16:
+        dev_frames, setpoints, sends, errors = struct.unpack("<IIII", st[:16])
+        print("device: frames=%d setpoints=%d sends=%d errors=%d" % (dev_frames, setpoints, sends, errors))
+    else:
+        print("device: no PING reply")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,105 @@
+#!/usr/bin/env python3
+"""/api/status 延迟基准：N 个客户端并发轮询，输出 p50/p99 延迟与吞吐。
+
+用法（连接到设备热点后）：
+    python3 tools/http_bench.py --host 192.168.4.1 --clients 4 --duration 30
+
+每个客户端使用独立的 keep-alive 连接（与浏览器行为一致），按 --interval 间隔
+轮询（默认 0.2s，与网页一致；设为 0 表示尽可能快）。结束时同时读取设备端
+/api/http/stats，对比服务器内部服务时间与客户端感知延迟。
+"""
+import argparse
+import http.client
+import json
+import threading
+import time
+
+
+def percentile(sorted_vals, p):
+    if not sorted_vals:
+        return 0.0
+    k = min(len(sorted_vals) - 1, max(0, int(round(p / 100.0 * len(sorted_vals) + 0.5)) - 1))
+    return sorted_vals[k]
+
+
+def client_loop(host, port, path, interval, deadline, out, errors):
+    conn = None
+    next_t = time.monotonic()
+    while time.monotonic() < deadline:
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(host, port, timeout=5)
+            t0 = time.perf_counter()
+            conn.request("GET", path)
+            resp = conn.getresponse()
+            resp.read()
+            dt = time.perf_counter() - t0
+            if resp.status == 200:
+                out.append(dt)
+            else:
+                errors.append(resp.status)
+        except (OSError, http.client.HTTPException) as e:
+            errors.append(type(e).__name__)
+            if conn is not None:
+                conn.close()
+            conn = None
+        if interval > 0:
+            next_t += interval
+            delay = next_t - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            else:
+                next_t = time.monotonic()
+    if conn is not None:
+        conn.close()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", default="192.168.4.1")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--path", default="/api/status")
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--duration", type=float, default=30.0)
+    ap.add_argument("--interval", type=float, default=0.2)
+    args = ap.parse_args()
+
+    deadline = time.monotonic() + args.duration
+    results = [[] for _ in range(args.clients)]
+    errors = [[] for _ in range(args.clients)]
+    threads = [
+        threading.Thread(target=client_loop,
+                         args=(args.host, args.port, args.path, args.interval, deadline, results[i], errors[i]))
+        for i in range(args.clients)
+    ]
+    t_start = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    elapsed = time.monotonic() - t_start
+
+    lat = sorted(v for r in results for v in r)
+    errs = [e for r in errors for e in r]
+    print(f"{args.path}: clients={args.clients} duration={elapsed:.1f}s ok={len(lat)} errors={len(errs)} "
+          f"throughput={len(lat) / elapsed:.1f} req/s")
+    if lat:
+        ms = lambda v: v * 1000.0
+        print(f"latency ms: p50={ms(percentile(lat, 50)):.1f} p90={ms(percentile(lat, 90)):.1f} "
+              f"p99={ms(percentile(lat, 99)):.1f} max={ms(lat[-1]):.1f}")
+    for i, r in enumerate(results):
+        if r:
+            s = sorted(r)
+            print(f"  client {i}: n={len(s)} p99={percentile(s, 99) * 1000.0:.1f} ms")
+
+    try:
+        conn = http.client.HTTPConnection(args.host, args.port, timeout=5)
+        conn.request("GET", "/api/http/stats")
+        stats = json.loads(conn.getresponse().read())
+        print("device:", json.dumps(stats))
+    except (OSError, ValueError, http.client.HTTPException) as e:
+        print("device stats unavailable:", e)
+
+
+if __name__ == "__main__":
+    main()
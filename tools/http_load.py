@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""控制 API 负载测试：按网页的真实流量模型模拟多台手机，输出各接口吞吐、延迟百分位与错误数。
+
+用法（连接到设备热点后）：
+    python3 tools/http_load.py --host 192.168.4.1 --clients 4 --duration 60
+
+每个客户端模拟一个打开网页的浏览器：
+  - /api/status 轮询：独立 keep-alive 连接，上一次完成后按设备下发的 poll_ms 再发下一次，
+    携带 If-None-Match（与浏览器缓存行为一致，数据未变时设备回 304）；
+  - 拖动滑块：平均每 --drag-every 秒一次，持续 --drag-ms，期间按 --drag-hz 触发 oninput，
+    每次一个 /api/rotation 或 /api/position 请求，不等待上一次完成（与网页一致）；
+  - 虚拟按键：平均每 --button-every 秒按一次 /api/button（up/down 随机）。
+滑块与按键请求共用每客户端 --conns 条连接（浏览器对同一主机的并发连接上限，默认 6），
+连接全忙时请求排队；延迟从事件触发算起，包含排队时间，即用户感知的延迟。
+--no-drag 只测轮询，--buttons 0 关闭按键（按键会切换模式，对正在运行的设备有影响）。
+--estop-every N 在负载期间平均每 N 秒触发一次急停（独立连接，模拟另一台设备上的操作员），
+保持 --estop-hold 毫秒后解除；急停会让电机停下并切到手动模式，只在台架上使用。
+设备端给出急停通道延迟（触发 -> 所有板的停止帧发出）的最坏值，即满负载下的急停时延。
+
+测试开始前清零设备端统计（/api/http/stats?reset=1），结束后读取设备端的服务时间与
+命令时延（请求进入 -> 命令交给 C 板链路）百分位，与客户端感知延迟对照。
+"""
+import argparse
+import http.client
+import json
+import queue
+import random
+import threading
+import time
+
+from http_bench import percentile
+
+ENDPOINTS = ("status", "rotation", "position", "button", "estop")
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.lat = {e: [] for e in ENDPOINTS}
+        self.errors = {e: {} for e in ENDPOINTS}
+        self.not_modified = 0
+
+    def ok(self, ep, dt):
+        with self.lock:
+            self.lat[ep].append(dt)
+
+    def err(self, ep, what):
+        with self.lock:
+            self.errors[ep][what] = self.errors[ep].get(what, 0) + 1
+
+
+def request(conn, path, headers=None):
+    conn.request("GET", path, headers=headers or {})
+    resp = conn.getresponse()
+    body = resp.read()
+    return resp, body
+
+
+def status_loop(args, deadline, stats):
+    conn = None
+    etag = None
+    poll_s = 0.2
+    while time.monotonic() < deadline:
+        t0 = time.perf_counter()
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+            resp, body = request(conn, "/api/status", {"If-None-Match": etag} if etag else None)
+            dt = time.perf_counter() - t0
+            if resp.status == 200:
+                stats.ok("status", dt)
+                etag = resp.getheader("ETag")
+                poll_ms = json.loads(body).get("poll_ms")
+                if poll_ms:
+                    poll_s = poll_ms / 1000.0
+            elif resp.status == 304:
+                stats.ok("status", dt)
+                with stats.lock:
+                    stats.not_modified += 1
+            else:
+                stats.err("status", resp.status)
+        except (OSError, ValueError, http.client.HTTPException) as e:
+            stats.err("status", type(e).__name__)
+            if conn is not None:
+                conn.close()
+            conn = None
+        # 网页在上一次完成（或失败）后才安排下一次轮询
+        time.sleep(poll_s if args.interval is None else args.interval)
+    if conn is not None:
+        conn.close()
+
+
+def conn_worker(args, q, stats):
+    conn = None
+    while True:
+        item = q.get()
+        if item is None:
+            break
+        ep, path, t_event = item
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+            resp, _ = request(conn, path)
+            if resp.status == 200:
+                stats.ok(ep, time.perf_counter() - t_event)
+            else:
+                stats.err(ep, resp.status)
+        except (OSError, http.client.HTTPException) as e:
+            stats.err(ep, type(e).__name__)
+            if conn is not None:
+                conn.close()
+            conn = None
+    if conn is not None:
+        conn.close()
+
+
+def event_loop(args, deadline, q, rng):
+    """产生滑块拖动与按键事件，放入该客户端的连接队列。"""
+    now = time.monotonic()
+    next_drag = now + rng.expovariate(1.0 / args.drag_every) if args.drag else float("inf")
+    next_button = now + rng.expovariate(1.0 / args.button_every) if args.buttons else float("inf")
+    while True:
+        t = min(next_drag, next_button)
+        if t >= deadline:
+            break
+        time.sleep(max(0.0, t - time.monotonic()))
+        if t == next_button:
+            q.put(("button", "/api/button?btn=" + rng.choice(("up", "down")), time.perf_counter()))
+            next_button += rng.expovariate(1.0 / args.button_every)
+            continue
+        # 一次拖动：随机选一个滑块，值沿一个方向连续变化
+        ep = rng.choice(("rotation", "position"))
+        lo, hi = (-300, 300) if ep == "rotation" else (0, 8191)
+        value = rng.randint(lo, hi)
+        step = rng.choice((-1, 1)) * max(1, (hi - lo) // 200)
+        end = min(deadline, time.monotonic() + args.drag_ms / 1000.0)
+        period = 1.0 / args.drag_hz
+        t_next = time.monotonic()
+        while t_next < end:
+            value = max(lo, min(hi, value + step))
+            q.put((ep, f"/api/{ep}?value={value}", time.perf_counter()))
+            t_next += period
+            time.sleep(max(0.0, t_next - time.monotonic()))
+        next_drag = time.monotonic() + rng.expovariate(1.0 / args.drag_every)
+
+
+def estop_loop(args, deadline, stats, rng):
+    """按泊松间隔触发急停，保持一段时间后解除；客户端延迟为触发请求的往返时间。"""
+    conn = None
+    while True:
+        t = time.monotonic() + rng.expovariate(1.0 / args.estop_every)
+        if t + args.estop_hold / 1000.0 >= deadline:
+            break
+        time.sleep(max(0.0, t - time.monotonic()))
+        for path in ("/api/estop", "/api/estop?release=1"):
+            trigger = path == "/api/estop"
+            t0 = time.perf_counter()
+            try:
+                if conn is None:
+                    conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+                resp, _ = request(conn, path)
+                if trigger and resp.status == 200:
+                    stats.ok("estop", time.perf_counter() - t0)
+                elif resp.status != 200:
+                    stats.err("estop", resp.status)
+            except (OSError, http.client.HTTPException) as e:
+                stats.err("estop", type(e).__name__)
+                if conn is not None:
+                    conn.close()
+                conn = None
+            if trigger:
+                time.sleep(args.estop_hold / 1000.0)
+    if conn is not None:
+        conn.close()
+
+
+def device_get(args, path):
+    conn = http.client.HTTPConnection(args.host, args.port, timeout=args.timeout)
+    try:
+        _, body = request(conn, path)
+        return json.loads(body)
+    finally:
+        conn.close()
+
+
+def device_stats(args, reset=False):
+    return device_get(args, "/api/http/stats" + ("?reset=1" if reset else ""))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--host", default="192.168.4.1")
+    ap.add_argument("--port", type=int, default=80)
+    ap.add_argument("--clients", type=int, default=4)
+    ap.add_argument("--duration", type=float, default=60.0)
+    ap.add_argument("--interval", type=float, default=None,
+                    help="固定的 /api/status 轮询间隔（秒）；默认使用设备下发的 poll_ms")
+    ap.add_argument("--conns", type=int, default=6, help="每客户端用于控制请求的连接数")
+    ap.add_argument("--drag-every", type=float, default=5.0, help="平均拖动间隔（秒）")
+    ap.add_argument("--drag-ms", type=float, default=1500.0, help="每次拖动时长")
+    ap.add_argument("--drag-hz", type=float, default=60.0, help="拖动时 oninput 触发频率")
+    ap.add_argument("--no-drag", dest="drag", action="store_false")
+    ap.add_argument("--button-every", type=float, default=20.0, help="平均按键间隔（秒）")
+    ap.add_argument("--buttons", type=int, default=1, help="0 = 不按虚拟按键")
+    ap.add_argument("--estop-every", type=float, default=0.0, help="平均急停间隔（秒），0 = 不触发")
+    ap.add_argument("--estop-hold", type=float, default=500.0, help="急停保持时长（毫秒）后解除")
+    ap.add_argument("--timeout", type=float, default=5.0)
+    ap.add_argument("--seed", type=int, default=None)
+    args = ap.parse_args()
+
+    try:
+        device_stats(args, reset=True)
+    except (OSError, ValueError, http.client.HTTPException) as e:
+        print("device stats reset failed:", e)
+    if args.estop_every > 0:
+        try:
+            device_get(args, "/api/estop?reset=1")
+            device_get(args, "/api/estop?release=1")
+        except (OSError, ValueError, http.client.HTTPException) as e:
+            print("estop endpoint unavailable:", e)
+
+    stats = Stats()
+    rng = random.Random(args.seed)
+    deadline = time.monotonic() + args.duration
+    threads = []
+    workers = []
+    queues = []
+    for _ in range(args.clients):
+        q = queue.Queue()
+        queues.append(q)
+        threads.append(threading.Thread(target=status_loop, args=(args, deadline, stats)))
+        threads.append(threading.Thread(target=event_loop,
+                                        args=(args, deadline, q, random.Random(rng.random()))))
+        workers += [threading.Thread(target=conn_worker, args=(args, q, stats)) for _ in range(args.conns)]
+    if args.estop_every > 0:
+        threads.append(threading.Thread(target=estop_loop,
+                                        args=(args, deadline, stats, random.Random(rng.random()))))
+    t_start = time.monotonic()
+    for t in threads + workers:
+        t.start()
+    for t in threads:
+        t.join()
+    # 事件停止后排空队列中剩余的请求
+    for q in queues:
+        for _ in range(args.conns):
+            q.put(None)
+    for t in workers:
+        t.join()
+    elapsed = time.monotonic() - t_start
+
+    ms = lambda v: v * 1000.0
+    print(f"clients={args.clients} duration={elapsed:.1f}s conns/client={args.conns}")
+    print(f"{'endpoint':<10} {'ok':>7} {'err':>5} {'req/s':>7} {'p50':>8} {'p99':>8} {'p999':>8} {'max':>8}  (ms, client)")
+    for ep in ENDPOINTS:
+        lat = sorted(stats.lat[ep])
+        nerr = sum(stats.errors[ep].values())
+        if not lat and not nerr:
+            continue
+        row = f"{ep:<10} {len(lat):>7} {nerr:>5} {len(lat) / elapsed:>7.1f}"
+        if lat:
+            row += (f" {ms(percentile(lat, 50)):>8.1f} {ms(percentile(lat, 99)):>8.1f}"
+                    f" {ms(percentile(lat, 99.9)):>8.1f} {ms(lat[-1]):>8.1f}")
+        print(row)
+        if nerr:
+            print("           errors:", ", ".join(f"{k}={v}" for k, v in sorted(stats.errors[ep].items(), key=str)))
+    if stats.lat["status"]:
+        print(f"status 304: {stats.not_modified}/{len(stats.lat['status'])}")
+
+    try:
+        dev = device_stats(args)
+    except (OSError, ValueError, http.client.HTTPException) as e:
+        print("device stats unavailable:", e)
+        return
+    # 设备端百分位为 log2 桶上界
+    us = lambda v: v / 1000.0
+    print(f"device (ms, bucket upper bound)  async={dev.get('async_dispatched')} rejected={dev.get('async_rejected')}")
+    print(f"{'endpoint':<10} {'n':>7} {'svc p50':>8} {'p99':>8} {'p999':>8} {'max':>8} {'cmd p50':>8} {'p99':>8} {'p999':>8} {'max':>8}")
+    print(f"{'status':<10} {dev.get('status_requests', 0):>7} {us(dev.get('status_p50_us', 0)):>8.2f}"
+          f" {us(dev.get('status_p99_us', 0)):>8.2f} {us(dev.get('status_p999_us', 0)):>8.2f}"
+          f" {us(dev.get('status_max_us', 0)):>8.2f}")
+    for ep, c in dev.get("control", {}).items():
+        print(f"{ep:<10} {c['requests']:>7} {us(c['p50_us']):>8.2f} {us(c['p99_us']):>8.2f}"
+              f" {us(c['p999_us']):>8.2f} {us(c['max_us']):>8.2f} {us(c['cmd_p50_us']):>8.2f}"
+              f" {us(c['cmd_p99_us']):>8.2f} {us(c['cmd_p999_us']):>8.2f} {us(c['cmd_max_us']):>8.2f}")
+
+    if args.estop_every > 0:
+        try:
+            es = device_get(args, "/api/estop?status=1")
+        except (OSError, ValueError, http.client.HTTPException) as e:
+            print("estop stats unavailable:", e)
+            return
+        print(f"estop lane (trigger -> stop frames sent to all boards): sent={es['sent']}"
+              f" avg={us(es['avg_us']):.2f}ms max={us(es['max_us']):.2f}ms"
+              f" dropped_cmds={es['dropped_cmds']} latched={es['latched']}")
+
+
+if __name__ == "__main__":
+    main()
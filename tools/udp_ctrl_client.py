@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""上位机 UDP 通道示例客户端：订阅遥测，并可按固定频率下发设定点，统计丢包与往返时间。
+
+用法（连接到设备热点后）：
+    python3 tools/udp_ctrl_client.py --host 192.168.4.1 --duration 10
+    python3 tools/udp_ctrl_client.py --host 192.168.4.1 --rate 100 --motor 2 --mode 1 --amplitude 2000
+
+协议见 main/udp_ctrl.h。命令报文的 seq 逐条递增，遥测报文回显设备最近接受的命令序号，
+客户端据此计算命令往返时间（发送命令 -> 收到回显该序号的第一帧遥测，含等待下一帧遥测的时间）。
+"""
+import argparse
+import math
+import socket
+import struct
+import time
+
+MAGIC = 0x5544
+VERSION = 1
+T_CMD, T_SUB, T_UNSUB, T_ACK, T_TELEM = 1, 2, 3, 0x81, 0x82
+HDR = struct.Struct("<HBBI")
+
+
+def percentile(sorted_vals, p):
+    if not sorted_vals:
+        return 0.0
+    k = min(len(sorted_vals) - 1, max(0, int(round(p / 100.0 * len(sorted_vals) + 0.5)) - 1))
+    return sorted_vals[k]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--host", default="192.168.4.1")
+    ap.add_argument("--port", type=int, default=3191)
+    ap.add_argument("--duration", type=float, default=10.0)
+    ap.add_argument("--decim", type=int, default=1, help="每 N 个遥测帧接收一次")
+    ap.add_argument("--rate", type=float, default=0.0, help="命令频率 Hz（0 = 只订阅遥测）")
+    ap.add_argument("--motor", type=int, default=2)
+    ap.add_argument("--mode", type=int, default=1, help="0=速度 1=位置")
+    ap.add_argument("--amplitude", type=int, default=2000)
+    args = ap.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.settimeout(0.002)
+    dest = (args.host, args.port)
+
+    sub_seq = 0
+    cmd_seq = 0
+    sent_at = {}
+    rtts = []
+    telem = 0
+    telem_lost = 0
+    last_tseq = None
+    last_ack = 0
+    timeout_ms = 1000
+
+    def subscribe():
+        nonlocal sub_seq
+        sub_seq += 1
+        sock.sendto(HDR.pack(MAGIC, VERSION, T_SUB, sub_seq) + bytes([args.decim]), dest)
+
+    subscribe()
+    t0 = time.monotonic()
+    deadline = t0 + args.duration
+    next_sub = t0 + 0.25
+    next_cmd = t0
+    period = 1.0 / args.rate if args.rate > 0 else None
+
+    while True:
+        now = time.monotonic()
+        if now >= deadline:
+            break
+        if now >= next_sub:
+            subscribe()  # 兼作心跳，间隔远小于客户端超时
+            next_sub = now + timeout_ms / 4000.0
+        if period and now >= next_cmd:
+            cmd_seq += 1
+            v = int(args.amplitude * math.sin(2 * math.pi * 0.5 * (now - t0)))
+            if args.mode == 1:
+                v = (v + 8192) % 8192
+            speed, pos = (v, 0) if args.mode == 0 else (0, v)
+            body = bytes([1]) + struct.pack("<BBhh", args.motor, args.mode, speed, pos)
+            sock.sendto(HDR.pack(MAGIC, VERSION, T_CMD, cmd_seq) + body, dest)
+            sent_at[cmd_seq] = now
+            next_cmd += period
+        try:
+            data, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            continue
+        t_rx = time.monotonic()
+        if len(data) < HDR.size:
+            continue
+        magic, ver, typ, seq = HDR.unpack_from(data)
+        if magic != MAGIC or ver != VERSION:
+            continue
+        if typ == T_ACK:
+            timeout_ms, max_motors = struct.unpack_from("<HH", data, HDR.size)
+        elif typ == T_TELEM:
+            telem += 1
+            if last_tseq is not None and seq > last_tseq + 1:
+                telem_lost += seq - last_tseq - 1
+            last_tseq = seq
+            t_us, ack, cmd_lost, n = struct.unpack_from("<qIIB", data, HDR.size)
+            if ack != last_ack and ack in sent_at:
+                rtts.append((t_rx - sent_at.pop(ack)) * 1000.0)
+                for k in [k for k in sent_at if k < ack]:
+                    del sent_at[k]
+            last_ack = ack
+
+    sock.sendto(HDR.pack(MAGIC, VERSION, T_UNSUB, sub_seq + 1), dest)
+    elapsed = time.monotonic() - t0
+    print("telemetry: %d frames (%.1f/s) lost=%d (%.2f%%)" % (
+        telem, telem / elapsed, telem_lost, 100.0 * telem_lost / max(1, telem + telem_lost)))
+    if cmd_seq:
+        rtts.sort()
+        print("commands: sent=%d acked=%d rtt p50=%.1f ms p99=%.1f ms max=%.1f ms" % (
+            cmd_seq, len(rtts), percentile(rtts, 50), percentile(rtts, 99), rtts[-1] if rtts else 0.0))
+
+
+if __name__ == "__main__":
+    main()